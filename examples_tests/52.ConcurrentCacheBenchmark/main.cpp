@@ -0,0 +1,89 @@
+// Copyright (C) 2018-2020 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+
+#define _NBL_STATIC_LIB_
+#include <nabla.h>
+#include "CConcurrentObjectCache.h"
+
+#include <chrono>
+#include <random>
+#include <thread>
+#include <iostream>
+
+using namespace nbl;
+
+// mimics the asset cache, path-like string keys in a multimap
+using value_t = uint64_t*;
+using baseline_cache_t = core::CConcurrentMultiObjectCache<std::string,value_t,std::multimap>;
+using sharded_cache_t = core::CConcurrentShardedMultiObjectCache<std::string,value_t,std::multimap>;
+
+constexpr uint32_t KEY_COUNT = 1u<<16u;
+constexpr uint32_t OPS_PER_THREAD = 1u<<20u;
+
+static core::vector<std::string> makeKeys()
+{
+	core::vector<std::string> keys(KEY_COUNT);
+	for (uint32_t i=0u; i<KEY_COUNT; i++)
+		keys[i] = "../../media/some/deeply/nested/scene/directory/texture_"+std::to_string(i)+".png";
+	return keys;
+}
+
+//! every thread does `OPS_PER_THREAD` operations, `insertPercentage` of them are insert+remove pairs (to keep the size stable) and the rest are lookups
+template<class Cache>
+static double benchmark(const core::vector<std::string>& keys, const uint32_t threadCount, const uint32_t insertPercentage)
+{
+	Cache cache;
+	// half of the keys are already present
+	for (uint32_t i=0u; i<KEY_COUNT; i+=2u)
+		cache.insert(keys[i],reinterpret_cast<value_t>(uint64_t(i+1u)));
+
+	auto start = std::chrono::high_resolution_clock::now();
+	core::vector<std::thread> threads;
+	for (uint32_t t=0u; t<threadCount; t++)
+	threads.emplace_back([&,t]() -> void
+	{
+		std::mt19937 rng(t);
+		std::uniform_int_distribution<uint32_t> keyDist(0u,KEY_COUNT-1u);
+		std::uniform_int_distribution<uint32_t> opDist(0u,99u);
+		value_t found[4];
+		for (uint32_t i=0u; i<OPS_PER_THREAD; i++)
+		{
+			const auto& key = keys[keyDist(rng)];
+			if (opDist(rng)<insertPercentage)
+			{
+				const auto value = reinterpret_cast<value_t>((uint64_t(t)<<32ull)|uint64_t(i+1u));
+				cache.insert(key,value);
+				cache.removeObject(value,key);
+			}
+			else
+			{
+				size_t storageSize = 4u;
+				cache.findAndStoreRange(key,storageSize,found);
+			}
+		}
+	});
+	for (auto& thread : threads)
+		thread.join();
+	auto end = std::chrono::high_resolution_clock::now();
+
+	const double ops = double(threadCount)*double(OPS_PER_THREAD);
+	return ops/std::chrono::duration<double>(end-start).count();
+}
+
+int main()
+{
+	const auto keys = makeKeys();
+	const uint32_t maxThreads = core::max(std::thread::hardware_concurrency(),1u);
+
+	std::cout << "threads, insert %, baseline Mops/s, sharded Mops/s, speedup\n";
+	for (uint32_t threadCount=1u; threadCount<=maxThreads; threadCount*=2u)
+	for (uint32_t insertPercentage : {1u,10u,50u})
+	{
+		const double baseline = benchmark<baseline_cache_t>(keys,threadCount,insertPercentage);
+		const double sharded = benchmark<sharded_cache_t>(keys,threadCount,insertPercentage);
+		std::cout << threadCount << ", " << insertPercentage << ", " << baseline*1e-6 << ", " << sharded*1e-6 << ", " << sharded/baseline << "\n";
+	}
+
+	return 0;
+}
@@ -0,0 +1,116 @@
+// Copyright (C) 2018-2020 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+
+#define _NBL_STATIC_LIB_
+#include <nabla.h>
+
+#include <chrono>
+#include <random>
+#include <iostream>
+
+using namespace nbl;
+using namespace asset;
+
+constexpr uint32_t IMAGE_EXTENT = 4096u;
+constexpr E_FORMAT IMAGE_FORMAT = EF_R32G32B32A32_SFLOAT;
+
+//! 2D image with a full mip chain, only the first level is filled (with noise, so no kernel gets to skip work)
+static core::smart_refctd_ptr<ICPUImage> createImage()
+{
+	ICPUImage::SCreationParams params;
+	params.flags = static_cast<IImage::E_CREATE_FLAGS>(0u);
+	params.type = IImage::ET_2D;
+	params.format = IMAGE_FORMAT;
+	params.extent = {IMAGE_EXTENT,IMAGE_EXTENT,1u};
+	params.mipLevels = core::findMSB(IMAGE_EXTENT)+1u;
+	params.arrayLayers = 1u;
+	params.samples = IImage::ESCF_1_BIT;
+	auto image = ICPUImage::create(std::move(params));
+
+	const auto texelByteSize = getTexelOrBlockBytesize(IMAGE_FORMAT);
+	auto regions = core::make_refctd_dynamic_array<core::smart_refctd_dynamic_array<IImage::SBufferCopy>>(image->getCreationParameters().mipLevels);
+	size_t bufferSize = 0ull;
+	for (auto& region : *regions)
+	{
+		const uint32_t mipLevel = &region-regions->begin();
+		const auto mipSize = image->getMipSize(mipLevel);
+		region.bufferOffset = bufferSize;
+		region.bufferRowLength = mipSize.x;
+		region.bufferImageHeight = mipSize.y;
+		region.imageSubresource.aspectMask = static_cast<IImage::E_ASPECT_FLAGS>(0u);
+		region.imageSubresource.mipLevel = mipLevel;
+		region.imageSubresource.baseArrayLayer = 0u;
+		region.imageSubresource.layerCount = 1u;
+		region.imageOffset = {0u,0u,0u};
+		region.imageExtent = {mipSize.x,mipSize.y,mipSize.z};
+		bufferSize += size_t(mipSize.x)*mipSize.y*mipSize.z*texelByteSize;
+	}
+
+	auto buffer = core::make_smart_refctd_ptr<ICPUBuffer>(bufferSize);
+	std::mt19937 rng(0x45u);
+	std::uniform_real_distribution<float> dist(0.f,1.f);
+	auto* texels = reinterpret_cast<float*>(buffer->getPointer());
+	for (size_t i=0ull; i<size_t(IMAGE_EXTENT)*IMAGE_EXTENT*4ull; i++)
+		texels[i] = dist(rng);
+
+	image->setBufferAndRegions(std::move(buffer),regions);
+	return image;
+}
+
+//! returns the runtime in milliseconds
+template<class MipMapFilter, class ExecutionPolicy>
+static double generateMipMaps(ExecutionPolicy&& policy, ICPUImage* image)
+{
+	typename MipMapFilter::state_type state;
+	state.inOutImage = image;
+	state.baseLayer = 0u;
+	state.layerCount = 1u;
+	state.startMipLevel = 1u;
+	state.endMipLevel = image->getCreationParameters().mipLevels;
+	state.scratchMemoryByteSize = MipMapFilter::getRequiredScratchByteSize(&state);
+	state.scratchMemory = reinterpret_cast<uint8_t*>(_NBL_ALIGNED_MALLOC(state.scratchMemoryByteSize,32u));
+
+	const auto start = std::chrono::high_resolution_clock::now();
+	const bool success = MipMapFilter::execute(std::forward<ExecutionPolicy>(policy),&state);
+	const auto end = std::chrono::high_resolution_clock::now();
+
+	_NBL_ALIGNED_FREE(state.scratchMemory);
+	if (!success)
+	{
+		std::cout << "Mip-map generation failed!\n";
+		return 0.0;
+	}
+	return std::chrono::duration<double,std::milli>(end-start).count();
+}
+
+template<class Kernel>
+static void benchmark(const char* kernelName, const ICPUImage* reference)
+{
+	// no dithering, the parallel output must then match the sequential one bit for bit
+	using filter_t = CMipMapGenerationImageFilter<false,false,VoidSwizzle,IdentityDither,Kernel>;
+
+	auto sequentialImage = core::move_and_static_cast<ICPUImage>(reference->clone());
+	auto parallelImage = core::move_and_static_cast<ICPUImage>(reference->clone());
+	const double sequential = generateMipMaps<filter_t>(std::execution::seq,sequentialImage.get());
+	const double parallel = generateMipMaps<filter_t>(std::execution::par,parallelImage.get());
+
+	const auto* sequentialBuffer = sequentialImage->getBuffer();
+	const bool identical = memcmp(sequentialBuffer->getPointer(),parallelImage->getBuffer()->getPointer(),sequentialBuffer->getSize())==0;
+	std::cout << kernelName << ", " << sequential << ", " << parallel << ", " << sequential/parallel << ", " << (identical ? "yes":"NO") << "\n";
+}
+
+int main()
+{
+	const auto reference = createImage();
+
+	std::cout << "full mip chain of a " << IMAGE_EXTENT << "x" << IMAGE_EXTENT << " RGBA32F image\n";
+	std::cout << "kernel, sequential ms, parallel ms, speedup, bit-identical\n";
+	benchmark<CBoxImageFilterKernel>("Box",reference.get());
+	benchmark<CTriangleImageFilterKernel>("Triangle",reference.get());
+	benchmark<CGaussianImageFilterKernel<>>("Gaussian",reference.get());
+	benchmark<CKaiserImageFilterKernel<>>("Kaiser",reference.get());
+	benchmark<CMitchellImageFilterKernel<>>("Mitchell",reference.get());
+
+	return 0;
+}
@@ -0,0 +1,74 @@
+// Copyright (C) 2018-2020 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+
+#define _NBL_STATIC_LIB_
+#include <nabla.h>
+
+#include <chrono>
+#include <random>
+#include <iostream>
+
+using namespace nbl;
+
+//! returns the runtime in milliseconds
+template<typename F>
+static double measure(F&& f)
+{
+	const auto start = std::chrono::high_resolution_clock::now();
+	f();
+	const auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double,std::milli>(end-start).count();
+}
+
+//! `keyMask` limits the bits the random keys use, so the benchmark also shows the pass skipping
+static void benchmark(const size_t keyCount, const uint32_t keyMask)
+{
+	core::vector<uint32_t> reference(keyCount);
+	{
+		std::mt19937 rng(0x45u);
+		for (auto& key : reference)
+			key = rng()&keyMask;
+	}
+
+	core::vector<uint32_t> stdKeys(reference);
+	const double stdSort = measure([&]() -> void {std::sort(stdKeys.begin(),stdKeys.end());});
+
+	core::vector<uint32_t> keys(keyCount*2ull);
+	auto sort = [&](auto&& policy) -> double
+	{
+		std::copy(reference.begin(),reference.end(),keys.begin());
+		const uint32_t* sorted = nullptr;
+		const double retval = measure([&]() -> void {sorted = core::radix_sort(policy,keys.data(),keys.data()+keyCount,keyCount,core::impl::KeyAdaptor<uint32_t>());});
+		if (!std::equal(stdKeys.begin(),stdKeys.end(),sorted))
+			std::cout << "Radix sort output differs from std::sort!\n";
+		return retval;
+	};
+	const double sequential = sort(std::execution::seq);
+	const double parallel = sort(std::execution::par);
+
+	// key/value pairs, the values are the original positions so they're easy to validate
+	core::vector<uint32_t> values(keyCount*2ull);
+	std::copy(reference.begin(),reference.end(),keys.begin());
+	std::iota(values.begin(),values.begin()+keyCount,0u);
+	std::pair<uint32_t*,uint32_t*> sortedPairs;
+	const double keyValue = measure([&]() -> void {sortedPairs = core::radix_sort(std::execution::par,keys.data(),keys.data()+keyCount,values.data(),values.data()+keyCount,keyCount,core::impl::KeyAdaptor<uint32_t>());});
+	for (size_t i=0ull; i<keyCount; i++)
+	if (sortedPairs.first[i]!=reference[sortedPairs.second[i]] || i!=0ull&&sortedPairs.first[i-1ull]>sortedPairs.first[i])
+	{
+		std::cout << "Key/value radix sort output is wrong!\n";
+		break;
+	}
+
+	std::cout << keyCount << ", 0x" << std::hex << keyMask << std::dec << ", " << stdSort << ", " << sequential << ", " << parallel << ", " << keyValue << ", " << stdSort/parallel << "\n";
+}
+
+int main()
+{
+	std::cout << "keys, key mask, std::sort ms, sequential radix ms, parallel radix ms, parallel key/value radix ms, speedup over std::sort\n";
+	for (size_t keyCount : {1000000ull,10000000ull,100000000ull})
+	for (uint32_t keyMask : {0xffffffffu,0x00ffffffu,0x0000ffffu})
+		benchmark(keyCount,keyMask);
+
+	return 0;
+}
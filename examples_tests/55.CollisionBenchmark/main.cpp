@@ -0,0 +1,117 @@
+// Copyright (C) 2018-2020 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+
+#define _NBL_STATIC_LIB_
+#include <nabla.h>
+
+#include <chrono>
+#include <random>
+#include <iostream>
+
+using namespace nbl;
+
+//! returns the runtime in milliseconds
+template<typename F>
+static double measure(F&& f)
+{
+	const auto start = std::chrono::high_resolution_clock::now();
+	f();
+	const auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double,std::milli>(end-start).count();
+}
+
+//! a grid of bumpy terrain patches, every patch is a separate compound collider with a single triangle mesh
+static core::SCollisionEngine createScene(const uint32_t patchesPerSide, const uint32_t quadsPerSide, const bool buildBVH)
+{
+	core::SCollisionEngine engine;
+
+	std::mt19937 rng(0x45u);
+	std::uniform_real_distribution<float> height(0.f,0.5f);
+	core::vector<float> vertices((quadsPerSide+1u)*(quadsPerSide+1u)*3u);
+	core::vector<uint32_t> indices(quadsPerSide*quadsPerSide*6u);
+	for (uint32_t y=0u; y<quadsPerSide; y++)
+	for (uint32_t x=0u; x<quadsPerSide; x++)
+	{
+		const uint32_t corner = y*(quadsPerSide+1u)+x;
+		const uint32_t quad[6] = {corner,corner+1u,corner+quadsPerSide+2u,corner,corner+quadsPerSide+2u,corner+quadsPerSide+1u};
+		std::copy(quad,quad+6u,indices.begin()+(y*quadsPerSide+x)*6u);
+	}
+	for (uint32_t py=0u; py<patchesPerSide; py++)
+	for (uint32_t px=0u; px<patchesPerSide; px++)
+	{
+		for (uint32_t y=0u; y<=quadsPerSide; y++)
+		for (uint32_t x=0u; x<=quadsPerSide; x++)
+		{
+			float* vertex = vertices.data()+(y*(quadsPerSide+1u)+x)*3u;
+			vertex[0] = float(px)+float(x)/float(quadsPerSide);
+			vertex[1] = height(rng);
+			vertex[2] = float(py)+float(y)/float(quadsPerSide);
+		}
+
+		auto mesh = core::make_smart_refctd_ptr<core::STriangleMeshCollider>();
+		mesh->Init(std::execution::par,vertices.data(),indices.size(),indices.data(),buildBVH);
+		auto compound = core::make_smart_refctd_ptr<core::SCompoundCollider>();
+		compound->AddTriangleMesh(mesh.get());
+		core::SColliderData data;
+		data.instanceID = py*patchesPerSide+px;
+		compound->setColliderData(data);
+		engine.addCompoundCollider(std::move(compound));
+	}
+	return engine;
+}
+
+int main()
+{
+	constexpr uint32_t PatchesPerSide = 10u;
+	constexpr uint32_t QuadsPerSide = 50u; // 10*10 patches of 50*50*2 triangles makes 500k
+	constexpr uint32_t RaysPerSide = 64u;
+	constexpr float MaxRayLen = 100.f;
+
+	// rays from a camera above the scene, neighbouring rays are coherent like the ones through neighbouring pixels
+	core::vector<core::vectorSIMDf> origins(RaysPerSide*RaysPerSide),directions(RaysPerSide*RaysPerSide);
+	for (uint32_t y=0u; y<RaysPerSide; y++)
+	for (uint32_t x=0u; x<RaysPerSide; x++)
+	{
+		const uint32_t i = y*RaysPerSide+x;
+		origins[i] = core::vectorSIMDf(float(PatchesPerSide)*0.5f+0.01f,5.f,-2.f); // off the patch boundaries, no ray should be parallel to a box face
+		const core::vectorSIMDf target(float(PatchesPerSide*x)/float(RaysPerSide),0.f,float(PatchesPerSide*y)/float(RaysPerSide));
+		directions[i] = core::normalize(target-origins[i]);
+	}
+	const uint32_t rayCount = origins.size();
+
+	core::SCollisionEngine linear;
+	const double linearBuild = measure([&]() -> void {linear = createScene(PatchesPerSide,QuadsPerSide,false);});
+	core::SCollisionEngine accelerated;
+	const double triangleBVHBuild = measure([&]() -> void {accelerated = createScene(PatchesPerSide,QuadsPerSide,true);});
+	const double colliderBVHBuild = measure([&]() -> void {accelerated.buildBVH(std::execution::par);});
+
+	core::vector<float> linearDistances(rayCount),distances(rayCount),packetDistances(rayCount);
+	core::vector<core::SColliderData> linearHits(rayCount),hits(rayCount),packetHits(rayCount);
+	const double linearQuery = measure([&]() -> void
+	{
+		for (uint32_t i=0u; i<rayCount; i++)
+			linear.FastCollide(linearHits[i],linearDistances[i],origins[i],directions[i],MaxRayLen);
+	});
+	const double query = measure([&]() -> void
+	{
+		for (uint32_t i=0u; i<rayCount; i++)
+			accelerated.FastCollide(hits[i],distances[i],origins[i],directions[i],MaxRayLen);
+	});
+	const double packetQuery = measure([&]() -> void {accelerated.FastCollide(packetHits.data(),packetDistances.data(),origins.data(),directions.data(),rayCount,MaxRayLen);});
+	const double refit = measure([&]() -> void {accelerated.refit(std::execution::par);});
+
+	for (uint32_t i=0u; i<rayCount; i++)
+	if (core::abs(distances[i]-linearDistances[i])>0.0001f || core::abs(packetDistances[i]-linearDistances[i])>0.0001f ||
+		(distances[i]<MaxRayLen && (hits[i].instanceID!=linearHits[i].instanceID || packetHits[i].instanceID!=linearHits[i].instanceID)))
+	{
+		std::cout << "Hierarchy and linear search disagree for ray " << i << "!\n";
+		break;
+	}
+
+	std::cout << "triangles, rays, linear scene setup ms, scene setup with triangle BVHs ms, collider BVH build ms, collider BVH refit ms, linear query ms, BVH query ms, BVH packet query ms, speedup\n";
+	std::cout << PatchesPerSide*PatchesPerSide*QuadsPerSide*QuadsPerSide*2u << ", " << rayCount << ", " << linearBuild << ", " << triangleBVHBuild << ", " << colliderBVHBuild << ", " << refit << ", ";
+	std::cout << linearQuery << ", " << query << ", " << packetQuery << ", " << linearQuery/core::min(query,packetQuery) << "\n";
+
+	return 0;
+}
@@ -5,6 +5,10 @@
 #ifndef __NBL_C_CONCURRENT_OBJECT_CACHE_H_INCLUDED__
 #define __NBL_C_CONCURRENT_OBJECT_CACHE_H_INCLUDED__
 
+#include <array>
+#include <memory>
+#include <shared_mutex>
+
 #include "CObjectCache.h"
 #include "FW_Mutex.h"
 
@@ -159,6 +163,196 @@ namespace impl
             return r;
         }
     };
+
+    //! Same API as CMakeCacheConcurrent, but the keys are hashed into `ShardCount` independent caches each with its own reader/writer lock
+    /** Operations on different keys mostly don't contend at all and every shard's container only holds a fraction of the objects.
+    Operations which need to see every object (`contains`, `getSize`, `clear`, `outputAll`) visit the shards one by one,
+    so unlike in CMakeCacheConcurrent they are not atomic with respect to concurrent inserts and removals. */
+    template<typename CacheT, uint32_t ShardCount, class Hash=std::hash<std::remove_const_t<typename CacheT::KeyType> > >
+    class CMakeCacheConcurrentSharded : private Hash
+    {
+        static_assert(ShardCount>0u, "Need at least one shard!");
+
+        // CObjectCacheBase's destructor and implementation typedefs are protected
+        struct SCache final : CacheT
+        {
+            using CacheT::CacheT;
+
+            using KeyType_impl = typename CacheT::KeyType_impl;
+            using ValueType_impl = typename CacheT::ValueType_impl;
+            using ImmutableValueType_impl = typename CacheT::ImmutableValueType_impl;
+        };
+        using BaseCache = SCache;
+        using T = typename BaseCache::CachedType;
+        // every shard is a separate allocation, so locks of different shards don't share cachelines
+        struct SShard
+        {
+            template<typename... Args>
+            SShard(const Args&... args) : cache(args...) {}
+
+            SCache cache;
+            mutable std::shared_mutex lock;
+        };
+
+    public:
+        using IteratorType = typename BaseCache::IteratorType;
+        using ConstIteratorType = typename BaseCache::ConstIteratorType;
+        using RevIteratorType = typename BaseCache::RevIteratorType;
+        using ConstRevIteratorType = typename BaseCache::ConstRevIteratorType;
+        using RangeType = typename BaseCache::RangeType;
+        using ConstRangeType = typename BaseCache::ConstRangeType;
+        using PairType = typename BaseCache::PairType;
+        using MutablePairType = typename BaseCache::MutablePairType;
+        using CachedType = T;
+        using KeyType = typename BaseCache::KeyType;
+
+        //! Arguments (greet and dispose functions) are passed on to every shard
+        template<typename... Args>
+        explicit CMakeCacheConcurrentSharded(const Args&... args)
+        {
+            for (auto& shard : m_shards)
+                shard = std::make_unique<SShard>(args...);
+        }
+        CMakeCacheConcurrentSharded(const CMakeCacheConcurrentSharded&) = delete;
+        CMakeCacheConcurrentSharded(CMakeCacheConcurrentSharded&&) = delete;
+        CMakeCacheConcurrentSharded& operator=(const CMakeCacheConcurrentSharded&) = delete;
+        CMakeCacheConcurrentSharded& operator=(CMakeCacheConcurrentSharded&&) = delete;
+
+        inline bool insert(const typename BaseCache::KeyType_impl& _key, const typename BaseCache::ValueType_impl& _val)
+        {
+            auto& shard = getShard(_key);
+            std::unique_lock<std::shared_mutex> lock(shard.lock);
+            return shard.cache.insert(_key, _val);
+        }
+
+        inline bool contains(typename BaseCache::ImmutableValueType_impl& _object) const
+        {
+            for (const auto& shard : m_shards)
+            {
+                std::shared_lock<std::shared_mutex> lock(shard->lock);
+                if (shard->cache.contains(_object))
+                    return true;
+            }
+            return false;
+        }
+
+        inline size_t getSize() const
+        {
+            size_t r = 0ull;
+            for (const auto& shard : m_shards)
+            {
+                std::shared_lock<std::shared_mutex> lock(shard->lock);
+                r += shard->cache.getSize();
+            }
+            return r;
+        }
+
+        inline void clear()
+        {
+            for (auto& shard : m_shards)
+            {
+                std::unique_lock<std::shared_mutex> lock(shard->lock);
+                shard->cache.clear();
+            }
+        }
+
+        //! Returns true if had to insert
+        bool swapObjectValue(const typename BaseCache::KeyType_impl& _key, const typename BaseCache::ImmutableValueType_impl& _obj, const typename BaseCache::ValueType_impl& _val)
+        {
+            auto& shard = getShard(_key);
+            std::unique_lock<std::shared_mutex> lock(shard.lock);
+            return shard.cache.swapObjectValue(_key, _obj, _val);
+        }
+
+        bool getAndStoreKeyRangeOrReserve(const typename BaseCache::KeyType_impl& _key, size_t& _inOutStorageSize, typename BaseCache::ValueType_impl* _out, bool* _gotAll)
+        {
+            auto& shard = getShard(_key);
+            std::unique_lock<std::shared_mutex> lock(shard.lock);
+            return shard.cache.getAndStoreKeyRangeOrReserve(_key, _inOutStorageSize, _out, _gotAll);
+        }
+
+        inline bool removeObject(const typename BaseCache::ValueType_impl& _obj, const typename BaseCache::KeyType_impl& _key)
+        {
+            auto& shard = getShard(_key);
+            std::unique_lock<std::shared_mutex> lock(shard.lock);
+            return shard.cache.removeObject(_obj, _key);
+        }
+
+        inline bool findAndStoreRange(const typename BaseCache::KeyType_impl& _key, size_t& _inOutStorageSize, typename BaseCache::MutablePairType* _out) const
+        {
+            const auto& shard = getShard(_key);
+            std::shared_lock<std::shared_mutex> lock(shard.lock);
+            return shard.cache.findAndStoreRange(_key, _inOutStorageSize, _out);
+        }
+
+        inline bool findAndStoreRange(const typename BaseCache::KeyType_impl& _key, size_t& _inOutStorageSize, typename BaseCache::ValueType_impl* _out) const
+        {
+            const auto& shard = getShard(_key);
+            std::shared_lock<std::shared_mutex> lock(shard.lock);
+            return shard.cache.findAndStoreRange(_key, _inOutStorageSize, _out);
+        }
+
+        inline bool outputAll(size_t& _inOutStorageSize, MutablePairType* _out) const
+        {
+            if (!_out)
+            {
+                _inOutStorageSize = getSize();
+                return false;
+            }
+
+            size_t written = 0ull;
+            bool r = true;
+            for (const auto& shard : m_shards)
+            {
+                size_t shardStorageSize = _inOutStorageSize-written;
+                std::shared_lock<std::shared_mutex> lock(shard->lock);
+                r = shard->cache.outputAll(shardStorageSize, _out+written) && r;
+                written += shardStorageSize;
+            }
+            _inOutStorageSize = written;
+            return r;
+        }
+
+        inline bool changeObjectKey(const typename BaseCache::ValueType_impl& _obj, const typename BaseCache::KeyType_impl& _key, const typename BaseCache::KeyType_impl& _newKey)
+        {
+            auto& oldShard = getShard(_key);
+            auto& newShard = getShard(_newKey);
+            if (&oldShard == &newShard)
+            {
+                std::unique_lock<std::shared_mutex> lock(oldShard.lock);
+                return oldShard.cache.changeObjectKey(_obj, _key, _newKey);
+            }
+
+            // object moves between shards, no greet or dispose as its still the same cache from the outside
+            constexpr bool DoGreetOrDispose = false;
+            {
+                std::unique_lock<std::shared_mutex> lock(oldShard.lock);
+                if (!oldShard.cache.template removeObject<DoGreetOrDispose>(_obj, _key))
+                    return false;
+            }
+            std::unique_lock<std::shared_mutex> lock(newShard.lock);
+            newShard.cache.template insert<DoGreetOrDispose>(_newKey, _obj);
+            return true;
+        }
+
+    private:
+        //! `std::hash` of a pointer (or integer) is the identity, whose low bits are mostly zero due to alignment, so the hash gets mixed first
+        inline uint32_t getShardIndex(const typename BaseCache::KeyType_impl& _key) const
+        {
+            const uint64_t mixed = (static_cast<uint64_t>(Hash::operator()(_key))>>4ull)*0x9E3779B97F4A7C15ull; // Fibonacci hashing
+            return static_cast<uint32_t>(mixed>>32ull)%ShardCount;
+        }
+        inline SShard& getShard(const typename BaseCache::KeyType_impl& _key)
+        {
+            return *m_shards[getShardIndex(_key)];
+        }
+        inline const SShard& getShard(const typename BaseCache::KeyType_impl& _key) const
+        {
+            return *m_shards[getShardIndex(_key)];
+        }
+
+        std::array<std::unique_ptr<SShard>,ShardCount> m_shards;
+    };
 }
 
 template<
@@ -183,6 +377,31 @@ using CConcurrentMultiObjectCache =
         CMultiObjectCache<K, T, ContainerT_T, Alloc>
     >;
 
+//! Hashed-into-shards variants of the above, for caches with lots of concurrent traffic on different keys
+template<
+    typename K,
+    typename T,
+    template<typename...> class ContainerT_T = std::vector,
+    uint32_t ShardCount = 64u,
+    typename Alloc = core::allocator<typename impl::key_val_pair_type_for<ContainerT_T, K, T>::type>
+>
+using CConcurrentShardedObjectCache =
+    impl::CMakeCacheConcurrentSharded<
+        CObjectCache<K, T, ContainerT_T, Alloc>, ShardCount
+    >;
+
+template<
+    typename K,
+    typename T,
+    template<typename...> class ContainerT_T = std::vector,
+    uint32_t ShardCount = 64u,
+    typename Alloc = core::allocator<typename impl::key_val_pair_type_for<ContainerT_T, K, T>::type>
+>
+using CConcurrentShardedMultiObjectCache =
+    impl::CMakeCacheConcurrentSharded<
+        CMultiObjectCache<K, T, ContainerT_T, Alloc>, ShardCount
+    >;
+
 }}
 
 #endif
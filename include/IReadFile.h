@@ -44,6 +44,13 @@ namespace io
 		//! Get name of file.
 		/** \return File name as zero terminated character string. */
 		virtual const io::path& getFileName() const = 0;
+
+		//! Get the whole contents of the file, if they're already addressable in memory.
+		/** Memory-mapped and memory files can be parsed in place this way, without
+		any copies or `read` calls. The pointer stays valid for as long as the file lives.
+		\return Pointer to the first byte of the file (independent of the current
+		position), or nullptr if the file has to be read. */
+		virtual const void* getMappedPointer() const { return nullptr; }
 	};
 
 } // end namespace io
@@ -0,0 +1,400 @@
+// Copyright (C) 2018-2020 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+
+#ifndef __NBL_S_BOUNDING_VOLUME_HIERARCHY_H_INCLUDED__
+#define __NBL_S_BOUNDING_VOLUME_HIERARCHY_H_INCLUDED__
+
+#include <execution>
+#include <numeric>
+
+#include "vectorSIMD.h"
+#include "nbl/core/Types.h"
+
+namespace nbl
+{
+namespace core
+{
+
+//! Four rays stored as a structure of arrays, so every lane of a `vectorSIMDf` belongs to a different ray
+/** Works best when the rays are coherent (similar origins and directions), like the rays through neighbouring pixels.
+Lanes which are not used get a negative `tMax`, which makes them miss everything. */
+struct SRayPacket
+{
+        _NBL_STATIC_INLINE_CONSTEXPR uint32_t Width = 4u;
+
+        SRayPacket() {}
+        //! `count` can be less than `Width`, in that case the remaining lanes are disabled
+        SRayPacket(const vectorSIMDf* origins, const vectorSIMDf* directions, const float* maxDirMultipliers, uint32_t count)
+        {
+            for (uint32_t i=0u; i<3u; i++)
+            {
+                origin[i] = vectorSIMDf(0.f);
+                direction[i] = vectorSIMDf(1.f);
+            }
+            tMax = vectorSIMDf(-1.f);
+            for (uint32_t lane=0u; lane<count; lane++)
+            {
+                for (uint32_t i=0u; i<3u; i++)
+                {
+                    origin[i].pointer[lane] = origins[lane].pointer[i];
+                    direction[i].pointer[lane] = directions[lane].pointer[i];
+                }
+                tMax.pointer[lane] = maxDirMultipliers[lane];
+            }
+            computeReciprocalDirection();
+        }
+
+        inline void computeReciprocalDirection()
+        {
+            for (uint32_t i=0u; i<3u; i++)
+                reciprocalDirection[i] = vectorSIMDf(1.f).preciseDivision(direction[i]);
+        }
+
+        inline vectorSIMDf getOrigin(uint32_t lane) const {return vectorSIMDf(origin[0].pointer[lane],origin[1].pointer[lane],origin[2].pointer[lane]);}
+        inline vectorSIMDf getDirection(uint32_t lane) const {return vectorSIMDf(direction[0].pointer[lane],direction[1].pointer[lane],direction[2].pointer[lane]);}
+
+        //! slab test of all four rays against the box, the hits have to be closer than `tMax`
+        inline vector4db_SIMD intersectBox(const vectorSIMDf& minEdge, const vectorSIMDf& maxEdge) const
+        {
+            vectorSIMDf tNear(0.f);
+            vectorSIMDf tFar(tMax);
+            for (uint32_t i=0u; i<3u; i++)
+            {
+                const vectorSIMDf t0 = (vectorSIMDf(minEdge.pointer[i])-origin[i])*reciprocalDirection[i];
+                const vectorSIMDf t1 = (vectorSIMDf(maxEdge.pointer[i])-origin[i])*reciprocalDirection[i];
+                tNear = core::max<vectorSIMDf>(tNear,core::min<vectorSIMDf>(t0,t1));
+                tFar = core::min<vectorSIMDf>(tFar,core::max<vectorSIMDf>(t0,t1));
+            }
+            return tNear<=tFar;
+        }
+
+        vectorSIMDf origin[3];
+        vectorSIMDf direction[3];
+        vectorSIMDf reciprocalDirection[3];
+        //! the closest hit so far for every ray, as a multiple of the direction
+        vectorSIMDf tMax;
+};
+
+//! Bounding volume hierarchy over primitives known only by their axis aligned bounds
+/** Built top-down with the binned Surface Area Heuristic, all nodes of a tree level get split in parallel.
+Nodes are stored so that children always come after their parent and the two children of a node are adjacent,
+this lets `refit` recompute the bounds after the primitives moved without touching the topology.
+A refitted tree stays correct but gets slower the more the primitives moved relative to each other, rebuild then. */
+class SBoundingVolumeHierarchy
+{
+    public:
+        _NBL_STATIC_INLINE_CONSTEXPR uint32_t BinCount = 16u;
+        _NBL_STATIC_INLINE_CONSTEXPR uint32_t MaxLeafPrimitives = 4u;
+        _NBL_STATIC_INLINE_CONSTEXPR uint32_t MaxDepth = 64u;
+
+        struct SNode
+        {
+            inline bool isLeaf() const {return count!=0u;}
+
+            vectorSIMDf minEdge;
+            vectorSIMDf maxEdge;
+            //! first child for inner nodes (the second follows it), index into the primitive list for leaves
+            uint32_t first;
+            //! 0 for inner nodes
+            uint32_t count;
+            //! axis the node got split along, decides which child gets visited first
+            uint32_t axis;
+        };
+
+        inline bool empty() const {return nodes.empty();}
+        inline void clear()
+        {
+            nodes.clear();
+            primitives.clear();
+        }
+
+        inline const core::vector<SNode>& getNodes() const {return nodes;}
+        inline const core::vector<uint32_t>& getPrimitives() const {return primitives;}
+
+        //! (re)builds the tree over `primCount` primitives, the `i`-th of which is bounded by `primMinEdges[i]` and `primMaxEdges[i]`
+        template<class ExecutionPolicy>
+        inline void build(ExecutionPolicy&& policy, const vectorSIMDf* primMinEdges, const vectorSIMDf* primMaxEdges, uint32_t primCount)
+        {
+            clear();
+            if (primCount==0u)
+                return;
+
+            primitives.resize(primCount);
+            std::iota(primitives.begin(),primitives.end(),0u);
+            core::vector<vectorSIMDf> centroids(primCount);
+            std::transform(policy,primMinEdges,primMinEdges+primCount,primMaxEdges,centroids.begin(),[](const vectorSIMDf& minEdge, const vectorSIMDf& maxEdge) {return (minEdge+maxEdge)*0.5f;});
+
+            SNode& root = nodes.emplace_back();
+            root.first = 0u;
+            root.count = primCount;
+            root.axis = 0u;
+            computeLeafBounds(root,primMinEdges,primMaxEdges);
+
+            struct SSplit
+            {
+                bool valid = false;
+                uint32_t axis;
+                uint32_t leftCount;
+                vectorSIMDf bounds[2][2];
+            };
+            core::vector<uint32_t> level = {0u};
+            core::vector<SSplit> splits;
+            for (uint32_t depth=1u; !level.empty()&&depth<MaxDepth; depth++)
+            {
+                // each node owns a disjoint range of `primitives`, so they can all be partitioned at once
+                splits.clear();
+                splits.resize(level.size());
+                std::for_each(policy,level.begin(),level.end(),[&](const uint32_t& nodeIx) -> void
+                {
+                    splits[&nodeIx-level.data()] = findAndApplySplit<SSplit>(nodes[nodeIx],primMinEdges,primMaxEdges,centroids.data());
+                });
+
+                core::vector<uint32_t> nextLevel;
+                for (size_t i=0ull; i<level.size(); i++)
+                {
+                    const auto& split = splits[i];
+                    if (!split.valid)
+                        continue;
+
+                    const uint32_t firstChild = nodes.size();
+                    const uint32_t firstPrimitive = nodes[level[i]].first;
+                    const uint32_t primitiveCount = nodes[level[i]].count;
+                    for (uint32_t j=0u; j<2u; j++)
+                    {
+                        SNode& child = nodes.emplace_back();
+                        child.minEdge = split.bounds[j][0];
+                        child.maxEdge = split.bounds[j][1];
+                        child.first = j ? (firstPrimitive+split.leftCount):firstPrimitive;
+                        child.count = j ? (primitiveCount-split.leftCount):split.leftCount;
+                        child.axis = 0u;
+                        nextLevel.push_back(firstChild+j);
+                    }
+                    SNode& parent = nodes[level[i]];
+                    parent.first = firstChild;
+                    parent.count = 0u;
+                    parent.axis = split.axis;
+                }
+                level = std::move(nextLevel);
+            }
+        }
+
+        //! recomputes the node bounds from new primitive bounds, the primitive count and order must not have changed
+        template<class ExecutionPolicy>
+        inline void refit(ExecutionPolicy&& policy, const vectorSIMDf* primMinEdges, const vectorSIMDf* primMaxEdges)
+        {
+            std::for_each(policy,nodes.begin(),nodes.end(),[&](SNode& node) -> void
+            {
+                if (node.isLeaf())
+                    computeLeafBounds(node,primMinEdges,primMaxEdges);
+            });
+            for (auto it=nodes.rbegin(); it!=nodes.rend(); it++)
+            if (!it->isLeaf())
+            {
+                it->minEdge = core::min<vectorSIMDf>(nodes[it->first].minEdge,nodes[it->first+1u].minEdge);
+                it->maxEdge = core::max<vectorSIMDf>(nodes[it->first].maxEdge,nodes[it->first+1u].maxEdge);
+            }
+        }
+
+        //! Finds the closest hit along the ray
+        /** `intersect(primitiveIndex,tMax)` has to return whether the primitive was hit closer than `tMax`, and if so update `tMax`.
+        @param[in,out] tMax Ray length as a multiple of the direction, gets shortened with every closer hit. */
+        template<typename F>
+        inline bool traverse(const vectorSIMDf& origin, const vectorSIMDf& direction, const vectorSIMDf& reciprocalDirection, float& tMax, F&& intersect) const
+        {
+            if (nodes.empty())
+                return false;
+
+            bool retval = false;
+            uint32_t stack[MaxDepth*2u];
+            uint32_t stackSize = 0u;
+            stack[stackSize++] = 0u;
+            while (stackSize)
+            {
+                const SNode& node = nodes[stack[--stackSize]];
+                if (!intersectBox(node,origin,reciprocalDirection,tMax))
+                    continue;
+
+                if (node.isLeaf())
+                {
+                    for (uint32_t i=0u; i<node.count; i++)
+                        retval = intersect(primitives[node.first+i],tMax) || retval;
+                }
+                else
+                {
+                    // push the far child first, so the near one gets visited first and can shorten the ray
+                    const uint32_t nearChild = direction.pointer[node.axis]<0.f ? 1u:0u;
+                    stack[stackSize++] = node.first+(nearChild^1u);
+                    stack[stackSize++] = node.first+nearChild;
+                }
+            }
+            return retval;
+        }
+
+        //! Packet version of `traverse`, a node gets visited if any of the rays hits it
+        /** `intersect(primitiveIndex,packet)` has to shorten `packet.tMax` for the rays which hit the primitive.
+        The order of visiting the children is decided by the first ray in the packet. */
+        template<typename F>
+        inline void traverse(SRayPacket& packet, F&& intersect) const
+        {
+            if (nodes.empty())
+                return;
+
+            uint32_t stack[MaxDepth*2u];
+            uint32_t stackSize = 0u;
+            stack[stackSize++] = 0u;
+            while (stackSize)
+            {
+                const SNode& node = nodes[stack[--stackSize]];
+                if (!packet.intersectBox(node.minEdge,node.maxEdge).any())
+                    continue;
+
+                if (node.isLeaf())
+                {
+                    for (uint32_t i=0u; i<node.count; i++)
+                        intersect(primitives[node.first+i],packet);
+                }
+                else
+                {
+                    const uint32_t nearChild = packet.direction[node.axis].pointer[0]<0.f ? 1u:0u;
+                    stack[stackSize++] = node.first+(nearChild^1u);
+                    stack[stackSize++] = node.first+nearChild;
+                }
+            }
+        }
+
+    private:
+        static inline float surfaceArea(const vectorSIMDf& minEdge, const vectorSIMDf& maxEdge)
+        {
+            const vectorSIMDf extent = maxEdge-minEdge;
+            return extent.x*extent.y+extent.y*extent.z+extent.z*extent.x;
+        }
+
+        static inline bool intersectBox(const SNode& node, const vectorSIMDf& origin, const vectorSIMDf& reciprocalDirection, const float tMax)
+        {
+            const vectorSIMDf t0 = (node.minEdge-origin)*reciprocalDirection;
+            const vectorSIMDf t1 = (node.maxEdge-origin)*reciprocalDirection;
+            const vectorSIMDf tNear = core::min<vectorSIMDf>(t0,t1);
+            const vectorSIMDf tFar = core::max<vectorSIMDf>(t0,t1);
+            return core::max(core::max(tNear.x,tNear.y),core::max(tNear.z,0.f))<=core::min(core::min(tFar.x,tFar.y),core::min(tFar.z,tMax));
+        }
+
+        inline void computeLeafBounds(SNode& node, const vectorSIMDf* primMinEdges, const vectorSIMDf* primMaxEdges) const
+        {
+            node.minEdge = vectorSIMDf(FLT_MAX);
+            node.maxEdge = vectorSIMDf(-FLT_MAX);
+            for (uint32_t i=0u; i<node.count; i++)
+            {
+                const uint32_t primIx = primitives[node.first+i];
+                node.minEdge = core::min<vectorSIMDf>(node.minEdge,primMinEdges[primIx]);
+                node.maxEdge = core::max<vectorSIMDf>(node.maxEdge,primMaxEdges[primIx]);
+            }
+        }
+
+        //! picks the cheapest of the bin boundaries on all three axes and partitions the node's primitives accordingly
+        template<class SSplit>
+        inline SSplit findAndApplySplit(const SNode& node, const vectorSIMDf* primMinEdges, const vectorSIMDf* primMaxEdges, const vectorSIMDf* centroids)
+        {
+            SSplit retval;
+            if (node.count<=1u)
+                return retval;
+
+            const auto primBegin = primitives.begin()+node.first;
+            const auto primEnd = primBegin+node.count;
+
+            vectorSIMDf centroidMin(FLT_MAX),centroidMax(-FLT_MAX);
+            for (auto it=primBegin; it!=primEnd; it++)
+            {
+                centroidMin = core::min<vectorSIMDf>(centroidMin,centroids[*it]);
+                centroidMax = core::max<vectorSIMDf>(centroidMax,centroids[*it]);
+            }
+            const vectorSIMDf centroidExtent = centroidMax-centroidMin;
+
+            struct SBin
+            {
+                vectorSIMDf minEdge = vectorSIMDf(FLT_MAX);
+                vectorSIMDf maxEdge = vectorSIMDf(-FLT_MAX);
+                uint32_t count = 0u;
+            };
+            auto getBin = [&](uint32_t primIx, uint32_t axis) -> uint32_t
+            {
+                const float relative = (centroids[primIx].pointer[axis]-centroidMin.pointer[axis])/centroidExtent.pointer[axis];
+                return core::min<uint32_t>(static_cast<uint32_t>(relative*float(BinCount)),BinCount-1u);
+            };
+
+            // cost of a leaf is the primitive count, traversing an inner node is assumed to cost as much as a primitive test
+            float bestCost = float(node.count);
+            uint32_t bestBin = 0u;
+            for (uint32_t axis=0u; axis<3u; axis++)
+            {
+                if (centroidExtent.pointer[axis]<=0.f)
+                    continue;
+
+                SBin bins[BinCount];
+                for (auto it=primBegin; it!=primEnd; it++)
+                {
+                    SBin& bin = bins[getBin(*it,axis)];
+                    bin.minEdge = core::min<vectorSIMDf>(bin.minEdge,primMinEdges[*it]);
+                    bin.maxEdge = core::max<vectorSIMDf>(bin.maxEdge,primMaxEdges[*it]);
+                    bin.count++;
+                }
+
+                // sweep from the right to get the cost of everything right of every boundary
+                float rightArea[BinCount];
+                uint32_t rightCount[BinCount];
+                {
+                    SBin right;
+                    for (uint32_t i=BinCount-1u; i>0u; i--)
+                    {
+                        right.minEdge = core::min<vectorSIMDf>(right.minEdge,bins[i].minEdge);
+                        right.maxEdge = core::max<vectorSIMDf>(right.maxEdge,bins[i].maxEdge);
+                        right.count += bins[i].count;
+                        rightArea[i] = surfaceArea(right.minEdge,right.maxEdge);
+                        rightCount[i] = right.count;
+                    }
+                }
+                const float rcpParentArea = 1.f/surfaceArea(node.minEdge,node.maxEdge);
+                SBin left;
+                for (uint32_t i=1u; i<BinCount; i++)
+                {
+                    left.minEdge = core::min<vectorSIMDf>(left.minEdge,bins[i-1u].minEdge);
+                    left.maxEdge = core::max<vectorSIMDf>(left.maxEdge,bins[i-1u].maxEdge);
+                    left.count += bins[i-1u].count;
+                    if (left.count==0u || rightCount[i]==0u)
+                        continue;
+
+                    const float cost = 1.f+(surfaceArea(left.minEdge,left.maxEdge)*float(left.count)+rightArea[i]*float(rightCount[i]))*rcpParentArea;
+                    if (cost<bestCost || (!retval.valid&&node.count>MaxLeafPrimitives))
+                    {
+                        bestCost = cost;
+                        bestBin = i;
+                        retval.valid = true;
+                        retval.axis = axis;
+                    }
+                }
+            }
+            if (!retval.valid)
+                return retval;
+
+            const auto middle = std::partition(primBegin,primEnd,[&](uint32_t primIx) {return getBin(primIx,retval.axis)<bestBin;});
+            retval.leftCount = std::distance(primBegin,middle);
+            for (uint32_t j=0u; j<2u; j++)
+            {
+                SNode child;
+                child.first = j ? (node.first+retval.leftCount):node.first;
+                child.count = j ? (node.count-retval.leftCount):retval.leftCount;
+                computeLeafBounds(child,primMinEdges,primMaxEdges);
+                retval.bounds[j][0] = child.minEdge;
+                retval.bounds[j][1] = child.maxEdge;
+            }
+            return retval;
+        }
+
+        core::vector<SNode> nodes;
+        core::vector<uint32_t> primitives;
+};
+
+}
+}
+
+#endif
@@ -7,6 +7,7 @@
 
 #include "nabla.h"
 #include "SCompoundCollider.h"
+#include "SBoundingVolumeHierarchy.h"
 #include "SViewFrustum.h"
 
 namespace nbl
@@ -14,9 +15,28 @@ namespace nbl
 namespace core
 {
 
+//! Ray queries against a set of compound colliders
+/** Without a hierarchy every query tests every collider, call `buildBVH` once the colliders are added
+and `refit` whenever the scene nodes they are attached to move. */
 class SCollisionEngine : public AllocationOverrideDefault
 {
         core::vector<core::smart_refctd_ptr<SCompoundCollider> > colliders;
+        //! over the world space bounds of `colliders`, empty if it needs to be built again
+        SBoundingVolumeHierarchy bvh;
+
+        template<class ExecutionPolicy>
+        inline void computeColliderBounds(ExecutionPolicy&& policy, core::vector<vectorSIMDf>& minEdges, core::vector<vectorSIMDf>& maxEdges) const
+        {
+            minEdges.resize(colliders.size());
+            maxEdges.resize(colliders.size());
+            std::for_each(policy,minEdges.begin(),minEdges.end(),[&](vectorSIMDf& minEdge) -> void
+            {
+                const size_t i = &minEdge-minEdges.data();
+                const aabbox3df box = colliders[i]->getWorldBoundingBox();
+                minEdge.set(box.MinEdge);
+                maxEdges[i].set(box.MaxEdge);
+            });
+        }
 
     public:
 		//! Destructor.
@@ -114,6 +134,7 @@ class SCollisionEngine : public AllocationOverrideDefault
                 return;
 
             colliders.insert(found,std::move(collider));
+            bvh.clear();
         }
 
 		//! Removes collider pointed by `collider`
@@ -131,12 +152,40 @@ class SCollisionEngine : public AllocationOverrideDefault
 			}
 
             colliders.erase(found);
+            bvh.clear();
         }
 
 		//! Gets current amount of colliders
 		/** @rturns Current amount of colliders. */
         inline size_t getColliderCount() const { return colliders.size(); }
 
+		//! Builds the bounding volume hierarchy over the colliders, adding or removing a collider throws it away again
+		/** @param policy Execution policy for computing the bounds and splitting the nodes. */
+        template<class ExecutionPolicy>
+        inline void buildBVH(ExecutionPolicy&& policy)
+        {
+            core::vector<vectorSIMDf> minEdges,maxEdges;
+            computeColliderBounds(policy,minEdges,maxEdges);
+            bvh.build(policy,minEdges.data(),maxEdges.data(),colliders.size());
+        }
+        inline void buildBVH() { buildBVH(std::execution::seq); }
+
+        inline bool hasBVH() const { return !bvh.empty(); }
+
+		//! Updates the hierarchy after the scene nodes the colliders are attached to moved, or their bounding boxes changed
+		/** Much cheaper than `buildBVH`, but the queries get slower if the colliders moved a lot relative to each other. */
+        template<class ExecutionPolicy>
+        inline void refit(ExecutionPolicy&& policy)
+        {
+            if (bvh.empty())
+                return;
+
+            core::vector<vectorSIMDf> minEdges,maxEdges;
+            computeColliderBounds(policy,minEdges,maxEdges);
+            bvh.refit(policy,minEdges.data(),maxEdges.data());
+        }
+        inline void refit() { refit(std::execution::seq); }
+
 		//! Performs collision test with a given ray defined by `origin`, `direction` and `maxRayLen` parameters
 		/**
 		@param[out] hitPointObjectData Data of collider with which the collision occured. Does not get touched if no collision occured.
@@ -150,6 +199,28 @@ class SCollisionEngine : public AllocationOverrideDefault
             bool retval = false;
 
             collisionDistance = maxRayLen;
+            if (hasBVH())
+            {
+                const SCompoundCollider* hitCollider = nullptr;
+                bvh.traverse(origin,direction,vectorSIMDf(1.f).preciseDivision(direction),collisionDistance,[&](uint32_t colliderIx, float& tMax) -> bool
+                {
+                    float tmpDist;
+                    if (colliders[colliderIx]->CollideWithRay(tmpDist,origin,direction,tMax)&&tmpDist<tMax)
+                    {
+                        tMax = tmpDist;
+                        hitCollider = colliders[colliderIx].get();
+                        return true;
+                    }
+                    return false;
+                });
+                if (hitCollider)
+                {
+                    hitPointObjectData = hitCollider->getColliderData();
+                    retval = true;
+                }
+                return retval;
+            }
+
             for (size_t i=0; i<colliders.size(); i++)
             {
                 float tmpDist;
@@ -161,6 +232,57 @@ class SCollisionEngine : public AllocationOverrideDefault
                 }
             }
 
+            return retval;
+        }
+
+		//! Performs collision tests for a batch of rays, four at a time
+		/**
+		Same as calling the single ray version for every ray, but it goes much faster when neighbouring rays are coherent.
+		@param[out] hitPointObjectData Array of `rayCount`, entries for rays which hit nothing do not get touched.
+		@param[out] collisionDistances Array of `rayCount`, `maxRayLen` for rays which hit nothing.
+		@param[in] origins Start points of the rays.
+		@param[in] directions Normalized directions of the rays.
+		@param[in] rayCount
+		@param[in] maxRayLen Length of all the rays
+		@returns How many rays hit something.
+		*/
+        inline uint32_t FastCollide(SColliderData* hitPointObjectData, float* collisionDistances, const vectorSIMDf* origins, const vectorSIMDf* directions, uint32_t rayCount, const float& maxRayLen=FLT_MAX) const
+        {
+            uint32_t retval = 0u;
+
+            const float maxRayLens[SRayPacket::Width] = {maxRayLen,maxRayLen,maxRayLen,maxRayLen};
+            for (uint32_t first=0u; first<rayCount; first+=SRayPacket::Width)
+            {
+                const uint32_t count = core::min<uint32_t>(rayCount-first,SRayPacket::Width);
+                SRayPacket packet(origins+first,directions+first,maxRayLens,count);
+
+                const SCompoundCollider* hitColliders[SRayPacket::Width] = {nullptr,nullptr,nullptr,nullptr};
+                auto collide = [&](uint32_t colliderIx, SRayPacket& packet) -> void
+                {
+                    const uint32_t hitMask = _mm_movemask_ps(_mm_castsi128_ps(colliders[colliderIx]->CollideWithRays(packet).getAsRegister()));
+                    for (uint32_t lane=0u; lane<count; lane++)
+                    if (hitMask&(0x1u<<lane))
+                        hitColliders[lane] = colliders[colliderIx].get();
+                };
+                if (hasBVH())
+                    bvh.traverse(packet,collide);
+                else
+                {
+                    for (uint32_t i=0u; i<colliders.size(); i++)
+                        collide(i,packet);
+                }
+
+                for (uint32_t lane=0u; lane<count; lane++)
+                {
+                    collisionDistances[first+lane] = packet.tMax.pointer[lane];
+                    if (hitColliders[lane])
+                    {
+                        hitPointObjectData[first+lane] = hitColliders[lane]->getColliderData();
+                        retval++;
+                    }
+                }
+            }
+
             return retval;
         }
 };
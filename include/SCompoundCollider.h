@@ -42,8 +42,18 @@ class SCompoundCollider : public IReferenceCounted
     protected:
         SAABoxCollider BBox;
         vector<SCollisionShapeDef> Shapes;
+        //! local space bounds of every shape, the ones of triangle meshes get refreshed by `updateBoundingBox`
+        vector<aabbox3df> ShapeBounds;
         SColliderData colliderData;
 
+        //! transform from the space of the attached node to the space of the shapes
+        inline bool getWorldToLocal(matrix3x4SIMD& worldToLocal) const
+        {
+            matrix3x4SIMD absoluteTransform;
+            absoluteTransform.set(colliderData.attachedNode->getAbsoluteTransformation());
+            return absoluteTransform.getInverse(worldToLocal);
+        }
+
 		//! Destructor.
         ~SCompoundCollider()
         {
@@ -109,6 +119,7 @@ class SCompoundCollider : public IReferenceCounted
                             shape.object = new SEllipsoidCollider(*tmp);
                             shape.objectType = SCollisionShapeDef::ECST_ELLIPSOID;
                             coll->Shapes.push_back(shape);
+                            coll->ShapeBounds.push_back(ShapeBounds[i]);
                         }
                         break;
                     case SCollisionShapeDef::ECST_TRIANGLE:
@@ -118,6 +129,7 @@ class SCompoundCollider : public IReferenceCounted
                             shape.object = new STriangleCollider(*tmp);
                             shape.objectType = SCollisionShapeDef::ECST_TRIANGLE;
                             coll->Shapes.push_back(shape);
+                            coll->ShapeBounds.push_back(ShapeBounds[i]);
                         }
                         break;
                     case SCollisionShapeDef::ECST_TRIANGLE_MESH:
@@ -136,7 +148,7 @@ class SCompoundCollider : public IReferenceCounted
 
 		//! Performs collision test with given ray.
 		/**
-		@param[out] collisionDistance Distance between collider and ray.
+		@param[out] collisionDistance Distance to the closest hit, as a multiple of `direction`.
 		@param[in] origin Attachment point of the ray.
 		@param[in] direction Normalized drection vector of the ray.
 		@param[in] dirMaxMultiplier
@@ -146,9 +158,7 @@ class SCompoundCollider : public IReferenceCounted
             if (colliderData.attachedNode)
             {
 				matrix3x4SIMD absoluteTransform;
-				absoluteTransform.set(colliderData.attachedNode->getAbsoluteTransformation());
-                bool retval = absoluteTransform.makeInverse();
-                if (!retval)
+                if (!getWorldToLocal(absoluteTransform))
                     return false;
 
                 absoluteTransform.pseudoMulWith4x1(origin);
@@ -160,7 +170,7 @@ class SCompoundCollider : public IReferenceCounted
                     case scene::ESNT_MESH_INSTANCED:
                         {
 							matrix3x4SIMD instanceTform = static_cast<scene::IMeshSceneNodeInstanced*>(colliderData.attachedNode)->getInstanceTransform(colliderData.instanceID);
-                            retval = instanceTform.makeInverse();
+                            bool retval = instanceTform.makeInverse();
                             if (!retval)
                                 return false;
 
@@ -183,44 +193,147 @@ class SCompoundCollider : public IReferenceCounted
             }
 
 
+            float closest = dirMaxMultiplier;
+            bool retval = false;
             for (size_t i=0; i<Shapes.size(); i++)
             {
+                float tmpDist;
+                bool hit = false;
                 switch (Shapes[i].objectType)
                 {
                     case SCollisionShapeDef::ECST_AABOX:
-                        {
-                            SAABoxCollider* tmp = static_cast<SAABoxCollider*>(Shapes[i].object);
-                            if (tmp->CollideWithRay(collisionDistance,origin,direction,dirMaxMultiplier,direction_reciprocal))
-                                return true;
-                        }
+                        hit = static_cast<SAABoxCollider*>(Shapes[i].object)->CollideWithRay(tmpDist,origin,direction,closest,direction_reciprocal);
                         break;
                     case SCollisionShapeDef::ECST_ELLIPSOID:
-                        {
-                            SEllipsoidCollider* tmp = static_cast<SEllipsoidCollider*>(Shapes[i].object);
-                            if (tmp->CollideWithRay(collisionDistance,origin,direction,dirMaxMultiplier))
-                                return true;
-                        }
+                        hit = static_cast<SEllipsoidCollider*>(Shapes[i].object)->CollideWithRay(tmpDist,origin,direction,closest);
                         break;
                     case SCollisionShapeDef::ECST_TRIANGLE:
-                        {
-                            STriangleCollider* tmp = static_cast<STriangleCollider*>(Shapes[i].object);
-                            if (tmp->CollideWithRay(collisionDistance,origin,direction,dirMaxMultiplier))
-                                return true;
-                        }
+                        hit = static_cast<STriangleCollider*>(Shapes[i].object)->CollideWithRay(tmpDist,origin,direction,closest);
                         break;
                     case SCollisionShapeDef::ECST_TRIANGLE_MESH:
-                        {
-                            STriangleMeshCollider* tmp = static_cast<STriangleMeshCollider*>(Shapes[i].object);
-                            if (tmp->CollideWithRay(collisionDistance,origin,direction,dirMaxMultiplier))
-                                return true;
-                        }
+                        hit = static_cast<STriangleMeshCollider*>(Shapes[i].object)->CollideWithRay(tmpDist,origin,direction,closest,direction_reciprocal);
+                        break;
+                    case SCollisionShapeDef::ECST_COUNT:
+                        assert(0);
+                        break;
+                }
+                if (hit && tmpDist<closest)
+                {
+                    closest = tmpDist;
+                    retval = true;
+                }
+            }
+
+            if (retval)
+                collisionDistance = closest;
+            return retval;
+        }
+
+		//! Performs collision test with four rays at once.
+		/**
+		Triangles and triangle meshes are tested with the whole packet, boxes and ellipsoids one ray at a time.
+		@param[in,out] packet Rays in the space of the attached node, `tMax` gets shortened for the rays which hit.
+		@returns Mask of the rays which hit.
+		*/
+        inline vector4db_SIMD CollideWithRays(SRayPacket& packet) const
+        {
+            SRayPacket localPacket = packet;
+            if (colliderData.attachedNode)
+            {
+                matrix3x4SIMD worldToLocal;
+                if (!getWorldToLocal(worldToLocal))
+                    return vector4db_SIMD(false);
+
+                for (uint32_t lane=0u; lane<SRayPacket::Width; lane++)
+                {
+                    vectorSIMDf origin,direction;
+                    worldToLocal.pseudoMulWith4x1(origin,packet.getOrigin(lane));
+                    worldToLocal.mulSub3x3WithNx1(direction,packet.getDirection(lane));
+                    for (uint32_t i=0u; i<3u; i++)
+                    {
+                        localPacket.origin[i].pointer[lane] = origin.pointer[i];
+                        localPacket.direction[i].pointer[lane] = direction.pointer[i];
+                    }
+                }
+                localPacket.computeReciprocalDirection();
+            }
+
+            if (!localPacket.intersectBox(vectorSIMDf().set(BBox.Box.MinEdge),vectorSIMDf().set(BBox.Box.MaxEdge)).any())
+                return vector4db_SIMD(false);
+
+            for (size_t i=0; i<Shapes.size(); i++)
+            {
+                switch (Shapes[i].objectType)
+                {
+                    case SCollisionShapeDef::ECST_TRIANGLE:
+                        static_cast<STriangleCollider*>(Shapes[i].object)->CollideWithRays(localPacket);
+                        break;
+                    case SCollisionShapeDef::ECST_TRIANGLE_MESH:
+                        static_cast<STriangleMeshCollider*>(Shapes[i].object)->CollideWithRays(localPacket);
                         break;
                     case SCollisionShapeDef::ECST_COUNT:
                         assert(0);
                         break;
+                    default:
+                        for (uint32_t lane=0u; lane<SRayPacket::Width; lane++)
+                        {
+                            const float tMax = localPacket.tMax.pointer[lane];
+                            if (tMax<0.f)
+                                continue;
+
+                            const vectorSIMDf origin = localPacket.getOrigin(lane);
+                            const vectorSIMDf direction = localPacket.getDirection(lane);
+                            float tmpDist;
+                            bool hit;
+                            if (Shapes[i].objectType==SCollisionShapeDef::ECST_AABOX)
+                                hit = static_cast<SAABoxCollider*>(Shapes[i].object)->CollideWithRay(tmpDist,origin,direction,tMax,reciprocal_approxim(direction));
+                            else
+                                hit = static_cast<SEllipsoidCollider*>(Shapes[i].object)->CollideWithRay(tmpDist,origin,direction,tMax);
+                            if (hit && tmpDist<tMax)
+                                localPacket.tMax.pointer[lane] = tmpDist;
+                        }
+                        break;
                 }
             }
-            return false;
+
+            const vector4db_SIMD retval = localPacket.tMax<packet.tMax;
+            packet.tMax = localPacket.tMax;
+            return retval;
+        }
+
+		//! Bounds of the collider in the space of the attached node.
+        inline aabbox3df getWorldBoundingBox() const
+        {
+            if (!colliderData.attachedNode)
+                return BBox.Box;
+
+            matrix3x4SIMD absoluteTransform;
+            absoluteTransform.set(colliderData.attachedNode->getAbsoluteTransformation());
+            vectorSIMDf minEdge(FLT_MAX),maxEdge(-FLT_MAX);
+            for (uint32_t i=0u; i<8u; i++)
+            {
+                const vectorSIMDf corner((i&0x1u ? BBox.Box.MaxEdge:BBox.Box.MinEdge).X,(i&0x2u ? BBox.Box.MaxEdge:BBox.Box.MinEdge).Y,(i&0x4u ? BBox.Box.MaxEdge:BBox.Box.MinEdge).Z);
+                vectorSIMDf transformed;
+                absoluteTransform.pseudoMulWith4x1(transformed,corner);
+                minEdge = core::min<vectorSIMDf>(minEdge,transformed);
+                maxEdge = core::max<vectorSIMDf>(maxEdge,transformed);
+            }
+            return aabbox3df(minEdge.getAsVector3df(),maxEdge.getAsVector3df());
+        }
+
+		//! Recomputes the bounding box, needed after calling `UpdateTransformation` on any of the triangle meshes.
+        inline void updateBoundingBox()
+        {
+            for (size_t i=0; i<Shapes.size(); i++)
+            {
+                if (Shapes[i].objectType==SCollisionShapeDef::ECST_TRIANGLE_MESH)
+                    ShapeBounds[i] = static_cast<STriangleMeshCollider*>(Shapes[i].object)->getBoundingBox().Box;
+
+                if (i==0)
+                    BBox.Box = ShapeBounds[i];
+                else
+                    BBox.Box.addInternalBox(ShapeBounds[i]);
+            }
         }
 
 		inline size_t getShapeCount() const { return Shapes.size(); }
@@ -254,6 +367,7 @@ class SCompoundCollider : public IReferenceCounted
             newShape.object = tmp;
             newShape.objectType = SCollisionShapeDef::ECST_AABOX;
             Shapes.push_back(newShape);
+            ShapeBounds.push_back(collider.Box);
             return true;
         }
 		//! Adds ellipsoid collider previosly creating it from center point and three axis lengths.
@@ -286,6 +400,7 @@ class SCompoundCollider : public IReferenceCounted
             newShape.object = tmp;
             newShape.objectType = SCollisionShapeDef::ECST_ELLIPSOID;
             Shapes.push_back(newShape);
+            ShapeBounds.push_back(aabbox3df((centr-axisLengths).getAsVector3df(),(centr+axisLengths).getAsVector3df()));
             return true;
         }
 		//! Adds triangle collider previously creating it from three given points.
@@ -316,6 +431,10 @@ class SCompoundCollider : public IReferenceCounted
             newShape.object = tmp;
             newShape.objectType = SCollisionShapeDef::ECST_TRIANGLE;
             Shapes.push_back(newShape);
+            aabbox3df triangleBounds(A.getAsVector3df());
+            triangleBounds.addInternalPoint(B.getAsVector3df());
+            triangleBounds.addInternalPoint(C.getAsVector3df());
+            ShapeBounds.push_back(triangleBounds);
             return true;
         }
 		//! Adds triangle mesh collider.
@@ -337,6 +456,7 @@ class SCompoundCollider : public IReferenceCounted
             newShape.object = collider;
             newShape.objectType = SCollisionShapeDef::ECST_TRIANGLE_MESH;
             Shapes.push_back(newShape);
+            ShapeBounds.push_back(collider->getBoundingBox().Box);
             return true;
         }
 };
@@ -6,6 +6,8 @@
 #define __NBL_S_TRIANGLE_MESH_COLLIDER_H_INCLUDED__
 
 #include "SAABoxCollider.h"
+#include "SBoundingVolumeHierarchy.h"
+#include "matrix3x4SIMD.h"
 #include "nbl/core/IReferenceCounted.h"
 
 namespace nbl
@@ -44,7 +46,7 @@ class STriangleCollider// : public AllocationOverrideDefault EBO inheritance pro
 			origin.makeSafe3D();
 
             const float NdotD = dot(direction,planeEq).X;
-            if (NdotD!=0.f)
+            if (NdotD==0.f)
                 return false;
 
             const float NdotOrigin = dot(origin,planeEq).X;
@@ -59,8 +61,9 @@ class STriangleCollider// : public AllocationOverrideDefault EBO inheritance pro
             vectorSIMDf extraComponent(0.f,0.f,0.f,1.f);
             const vectorSIMDf outPointW1 = outPoint|reinterpret_cast<const vectorSIMDu32&>(extraComponent);
 
+            // the boundary planes are scaled so the distances are the barycentrics of the two vertices opposite to them
             const float distToEdge[2] ={dot(outPointW1,boundaryPlanes[0])[0],dot(outPointW1,boundaryPlanes[1])[0]};
-            if (distToEdge[0]<0.f||distToEdge[1]<0.f||(distToEdge[0]+distToEdge[1])>1.f)
+            if (distToEdge[0]>=0.f&&distToEdge[1]>=0.f&&(distToEdge[0]+distToEdge[1])<=1.f)
             {
                 collisionDistance = t;
                 return true;
@@ -69,19 +72,66 @@ class STriangleCollider// : public AllocationOverrideDefault EBO inheritance pro
                 return false;
         }
 
+        //! Same test as above, for four rays at once
+        /** Shortens `packet.tMax` for the rays which hit the triangle closer than it.
+        @returns Mask of the rays which hit. */
+        inline vector4db_SIMD CollideWithRays(SRayPacket& packet) const
+        {
+            vectorSIMDf NdotD(0.f),NdotOrigin(0.f);
+            vectorSIMDf distToEdge[2] = {vectorSIMDf(boundaryPlanes[0].W),vectorSIMDf(boundaryPlanes[1].W)};
+            for (uint32_t i=0u; i<3u; i++)
+            {
+                NdotD += packet.direction[i]*planeEq.pointer[i];
+                NdotOrigin += packet.origin[i]*planeEq.pointer[i];
+            }
+            const vectorSIMDf t = (vectorSIMDf(planeEq.W)-NdotOrigin).preciseDivision(NdotD);
+            for (uint32_t i=0u; i<3u; i++)
+            {
+                const vectorSIMDf outPoint = packet.origin[i]+packet.direction[i]*t;
+                distToEdge[0] += outPoint*boundaryPlanes[0].pointer[i];
+                distToEdge[1] += outPoint*boundaryPlanes[1].pointer[i];
+            }
+
+            // a ray parallel to the plane gets an infinite or NaN `t`, which fails the comparisons
+            const vector4db_SIMD hit = (t>=vectorSIMDf(0.f))&(t<packet.tMax)&(distToEdge[0]>=vectorSIMDf(0.f))&(distToEdge[1]>=vectorSIMDf(0.f))&(distToEdge[0]+distToEdge[1]<=vectorSIMDf(1.f));
+            const vectorSIMDf missed = packet.tMax&(~hit);
+            packet.tMax = (t&hit)|reinterpret_cast<const vectorSIMDu32&>(missed);
+            return hit;
+        }
+
         vectorSIMDf planeEq;
         vectorSIMDf boundaryPlanes[2];
 };
 
 
+//! Triangle soup collider, queries go through a bounding volume hierarchy over the triangles if one was built
 class STriangleMeshCollider : public IReferenceCounted
 {
 	    _NBL_INTERFACE_CHILD(STriangleMeshCollider) {}
 
         SAABoxCollider BBox;
-        ///matrix4x3 cachedTransformInverse;
-        ///matrix4x3 cachedTransform;
+        matrix3x4SIMD cachedTransform;
         vector<STriangleCollider> triangles;
+        //! untransformed corners, three per triangle, needed to redo the triangles and the bounds on `UpdateTransformation`
+        vector<vectorSIMDf> vertices;
+        SBoundingVolumeHierarchy bvh;
+
+        template<class ExecutionPolicy>
+        inline void computeTriangleBounds(ExecutionPolicy&& policy, vector<vectorSIMDf>& minEdges, vector<vectorSIMDf>& maxEdges) const
+        {
+            minEdges.resize(triangles.size());
+            maxEdges.resize(triangles.size());
+            std::for_each(policy,minEdges.begin(),minEdges.end(),[&](vectorSIMDf& minEdge) -> void
+            {
+                const size_t i = &minEdge-minEdges.data();
+                vectorSIMDf corners[3];
+                for (size_t j=0; j<3; j++)
+                    cachedTransform.pseudoMulWith4x1(corners[j],vertices[i*3+j]);
+                minEdge = core::min<vectorSIMDf>(core::min<vectorSIMDf>(corners[0],corners[1]),corners[2]);
+                maxEdges[i] = core::max<vectorSIMDf>(core::max<vectorSIMDf>(corners[0],corners[1]),corners[2]);
+            });
+        }
+
     public:
         STriangleMeshCollider() : BBox(core::aabbox3df()) {}
 
@@ -90,63 +140,61 @@ class STriangleMeshCollider : public IReferenceCounted
 
         inline size_t getTriangleCount() const {return triangles.size();}
 
-        inline bool Init(float* vertices, const size_t &indexCount, uint32_t* indices=NULL)
+        inline bool hasBVH() const {return !bvh.empty();}
+
+        //! `buildBVH` can be turned off for meshes with just a handful of triangles, a linear search is faster for them
+        inline bool Init(float* vertices, const size_t &indexCount, uint32_t* indices=NULL, bool buildBVH=true)
         {
-            bool firstPoint = true;
-            if (indices)
+            return Init(std::execution::seq,vertices,indexCount,indices,buildBVH);
+        }
+
+        //! `policy` is used to build the bounding volume hierarchy
+        template<class ExecutionPolicy>
+        inline bool Init(ExecutionPolicy&& policy, float* vertices, const size_t &indexCount, uint32_t* indices=NULL, bool buildBVH=true)
+        {
+            auto getVertex = [&](size_t i) -> vectorSIMDf
             {
-                for (size_t i=0; i<indexCount; i+=3)
-                {
-                    vectorSIMDf A(vertices[indices[i+0]*3+0],vertices[indices[i+0]*3+1],vertices[indices[i+0]*3+2]);
-                    vectorSIMDf B(vertices[indices[i+1]*3+0],vertices[indices[i+1]*3+1],vertices[indices[i+1]*3+2]);
-                    vectorSIMDf C(vertices[indices[i+2]*3+0],vertices[indices[i+2]*3+1],vertices[indices[i+2]*3+2]);
+                const size_t vertexIx = indices ? indices[i]:i;
+                return vectorSIMDf(vertices[vertexIx*3+0],vertices[vertexIx*3+1],vertices[vertexIx*3+2]);
+            };
 
-                    bool useful = false;
-                    STriangleCollider triangle(A,B,C,useful);
-                    if (useful)
-                    {
-                        if (firstPoint)
-                        {
-                            BBox.Box.reset(A.getAsVector3df());
-                            firstPoint = false;
-                        }
-                        else
-                            BBox.Box.addInternalPoint(A.getAsVector3df());
-                        BBox.Box.addInternalPoint(B.getAsVector3df());
-                        BBox.Box.addInternalPoint(C.getAsVector3df());
-                        triangles.push_back(triangle);
-                    }
-                }
-            }
-            else
+            bool firstPoint = true;
+            for (size_t i=0; i+2<indexCount; i+=3)
             {
-                for (size_t i=0; i<indexCount; i+=3)
-                {
-                    vectorSIMDf A(vertices[(i+0)*3+0],vertices[(i+0)*3+1],vertices[(i+0)*3+2]);
-                    vectorSIMDf B(vertices[(i+1)*3+0],vertices[(i+1)*3+1],vertices[(i+1)*3+2]);
-                    vectorSIMDf C(vertices[(i+2)*3+0],vertices[(i+2)*3+1],vertices[(i+2)*3+2]);
+                const vectorSIMDf A = getVertex(i+0);
+                const vectorSIMDf B = getVertex(i+1);
+                const vectorSIMDf C = getVertex(i+2);
 
-                    bool useful;
-                    STriangleCollider triangle(A,B,C,useful);
-                    if (useful)
+                bool useful = false;
+                STriangleCollider triangle(A,B,C,useful);
+                if (useful)
+                {
+                    if (firstPoint)
                     {
-                        if (firstPoint)
-                        {
-                            BBox.Box.reset(A.getAsVector3df());
-                            firstPoint = false;
-                        }
-                        else
-                            BBox.Box.addInternalPoint(A.getAsVector3df());
-                        BBox.Box.addInternalPoint(B.getAsVector3df());
-                        BBox.Box.addInternalPoint(C.getAsVector3df());
-                        triangles.push_back(triangle);
+                        BBox.Box.reset(A.getAsVector3df());
+                        firstPoint = false;
                     }
+                    else
+                        BBox.Box.addInternalPoint(A.getAsVector3df());
+                    BBox.Box.addInternalPoint(B.getAsVector3df());
+                    BBox.Box.addInternalPoint(C.getAsVector3df());
+                    triangles.push_back(triangle);
+                    this->vertices.push_back(A);
+                    this->vertices.push_back(B);
+                    this->vertices.push_back(C);
                 }
             }
 
+            if (buildBVH)
+            {
+                vector<vectorSIMDf> minEdges,maxEdges;
+                computeTriangleBounds(policy,minEdges,maxEdges);
+                bvh.build(policy,minEdges.data(),maxEdges.data(),triangles.size());
+            }
             return triangles.size();
         }
 
+        //! Finds the closest triangle the ray hits
         inline bool CollideWithRay(float& collisionDistance, const vectorSIMDf& origin, const vectorSIMDf& direction, const float& dirMaxMultiplier) const
         {
             return CollideWithRay(collisionDistance,origin,direction,dirMaxMultiplier,reciprocal_approxim(direction));
@@ -158,85 +206,94 @@ class STriangleMeshCollider : public IReferenceCounted
             if (!BBox.CollideWithRay(dummyDist,origin,direction,dirMaxMultiplier,direction_reciprocal))
                 return false;
 
-            for (size_t i=0; i<triangles.size(); i++)
+            float closest = dirMaxMultiplier;
+            bool retval = false;
+            if (hasBVH())
             {
-                if (triangles[i].CollideWithRay(collisionDistance,origin,direction,dirMaxMultiplier))
-                    return true;
+                // the approximate reciprocal is good enough for the bounding box above, but not for the tight boxes of the hierarchy
+                retval = bvh.traverse(origin,direction,vectorSIMDf(1.f).preciseDivision(direction),closest,[&](uint32_t triangleIx, float& tMax) -> bool
+                {
+                    return triangles[triangleIx].CollideWithRay(tMax,origin,direction,tMax);
+                });
+            }
+            else
+            {
+                for (size_t i=0; i<triangles.size(); i++)
+                    retval = triangles[i].CollideWithRay(closest,origin,direction,closest) || retval;
             }
 
-            return false;
+            if (retval)
+                collisionDistance = closest;
+            return retval;
         }
-/**
-        inline bool UpdateTransformation(const matrix4x3& newTransform)
+
+        //! Finds the closest triangle for four rays at once, shortens `packet.tMax` for the rays which hit one
+        /** @returns Mask of the rays which hit. */
+        inline vector4db_SIMD CollideWithRays(SRayPacket& packet) const
         {
-            if (newTransform==cachedTransform)
-                return false;
+            const vectorSIMDf initialTMax = packet.tMax;
+            if (!packet.intersectBox(vectorSIMDf().set(BBox.Box.MinEdge),vectorSIMDf().set(BBox.Box.MaxEdge)).any())
+                return vector4db_SIMD(false);
 
-            matrix4x3 newInverse;
-            if (!newTransform.getInverse(newInverse))
-                return false;
+            if (hasBVH())
+            {
+                bvh.traverse(packet,[&](uint32_t triangleIx, SRayPacket& packet) -> void
+                {
+                    triangles[triangleIx].CollideWithRays(packet);
+                });
+            }
+            else
+            {
+                for (size_t i=0; i<triangles.size(); i++)
+                    triangles[i].CollideWithRays(packet);
+            }
+            return packet.tMax<initialTMax;
+        }
 
-            matrix4x3 diffMatrix = newTransform*cachedTransformInverse;0AZ8I
-            diffMatrix[4] = 0.f;
-            diffMatrix[8] = 0.f;
-            diffMatrix[12] = 0.f;
-            diffMatrix[13] = 0.f;
-            diffMatrix[14] = 0.f;
-            diffMatrix[15] = 1.f;
+        //! Transforms the mesh from the space it was given to `Init` in, then refits the hierarchy
+        /** Cheaper than building the collider again, but the queries slow down if the transform differs a lot from the one
+        the hierarchy was built with (a rotation by 45 degrees is about the worst case).
+        @returns Whether anything changed. */
+        template<class ExecutionPolicy>
+        inline bool UpdateTransformation(ExecutionPolicy&& policy, const matrix3x4SIMD& newTransform)
+        {
+            if (cachedTransform==newTransform)
+                return false;
             cachedTransform = newTransform;
-            cachedTransformInverse = newInverse;
-
-            matrix4x3 diffMatrix_NormalMatrix;
-            diffMatrix.getInverse(diffMatrix_NormalMatrix);
-            diffMatrix_NormalMatrix = diffMatrix_NormalMatrix.getTransposed();
 
-            for (size_t i=0; i<triangles.size(); i++)
+            std::for_each(policy,triangles.begin(),triangles.end(),[&](STriangleCollider& triangle) -> void
+            {
+                const size_t i = &triangle-triangles.data();
+                vectorSIMDf corners[3];
+                for (size_t j=0; j<3; j++)
+                    cachedTransform.pseudoMulWith4x1(corners[j],vertices[i*3+j]);
+                bool valid;
+                triangle = STriangleCollider(corners[0],corners[1],corners[2],valid);
+            });
+
+            vector<vectorSIMDf> minEdges,maxEdges;
+            computeTriangleBounds(policy,minEdges,maxEdges);
+            if (triangles.size())
             {
-                matrix4x3 T_Old;
-                T_Old[0] = triangles[i].planeEq[0];
-                T_Old[4] = triangles[i].planeEq[1];
-                T_Old[8] = triangles[i].planeEq[2];
-                T_Old[1] = triangles[i].boundaryPlanes[0][0];
-                T_Old[5] = triangles[i].boundaryPlanes[0][1];
-                T_Old[9] = triangles[i].boundaryPlanes[0][2];
-                T_Old[2] = triangles[i].boundaryPlanes[1][0];
-                T_Old[6] = triangles[i].boundaryPlanes[1][1];
-                T_Old[10] = triangles[i].boundaryPlanes[1][2];
-                T_Old.makeInverse();
-
-                float D[3];
-                D[0] = triangles.planeEq[3];
-                D[1] = triangles.boundaryPlanes[0][3];
-                D[2] = triangles.boundaryPlanes[1][3];
-                vector3df A;
-                T_Old.rotateVect(A,(vector3df*)D);///this is actually multiply with 3x3 submatrix
-
-                diffMatrix_NormalMatrix(triangles[i].planeEq.getAsVector3df());
-                diffMatrix.rotateVect(triangles[i].boundaryPlanes[0].getAsVector3df());///this is actually multiply with 3x3 submatrix
-                diffMatrix.rotateVect(triangles[i].boundaryPlanes[1].getAsVector3df());///this is actually multiply with 3x3 submatrix
-                diffMatrix.transformVect(A);
-
-
-                matrix4x3 T;
-                T[0] = triangles[i].planeEq[0];
-                T[4] = triangles[i].planeEq[1];
-                T[8] = triangles[i].planeEq[2];
-                T[1] = triangles[i].boundaryPlanes[0][0];
-                T[5] = triangles[i].boundaryPlanes[0][1];
-                T[9] = triangles[i].boundaryPlanes[0][2];
-                T[2] = triangles[i].boundaryPlanes[1][0];
-                T[6] = triangles[i].boundaryPlanes[1][1];
-                T[10] = triangles[i].boundaryPlanes[1][2];
-
-                T.rotateVect(A);///this is actually multiply with 3x3 submatrix
-                triangles[i].planeEq[3] = A.X;
-                triangles[i].boundaryPlanes[0][3] = A.Y;
-                triangles[i].boundaryPlanes[1][3] = A.Z;
+                vectorSIMDf minEdge = minEdges.front(), maxEdge = maxEdges.front();
+                for (size_t i=1; i<triangles.size(); i++)
+                {
+                    minEdge = core::min<vectorSIMDf>(minEdge,minEdges[i]);
+                    maxEdge = core::max<vectorSIMDf>(maxEdge,maxEdges[i]);
+                }
+                BBox.Box.MinEdge = minEdge.getAsVector3df();
+                BBox.Box.MaxEdge = maxEdge.getAsVector3df();
             }
-        }**/
+            if (hasBVH())
+                bvh.refit(policy,minEdges.data(),maxEdges.data());
+            return true;
+        }
+        inline bool UpdateTransformation(const matrix3x4SIMD& newTransform)
+        {
+            return UpdateTransformation(std::execution::seq,newTransform);
+        }
 };
 
-
 }
 }
 
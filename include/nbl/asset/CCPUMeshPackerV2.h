@@ -19,6 +19,8 @@ class CCPUMeshPackerV2 final : public IMeshPackerV2<ICPUBuffer, ICPUMeshBuffer,
     using base_t = IMeshPackerV2<ICPUBuffer, ICPUMeshBuffer, MDIStructType>;
     using Triangle = typename base_t::Triangle;
     using TriangleBatch = typename base_t::TriangleBatch;
+    using TriangleBatches = typename base_t::TriangleBatches;
+    using VertexRemap = typename base_t::VertexRemap;
 
 public:
     using AllocationParams = IMeshPackerBase::AllocationParamsCommon;
@@ -64,14 +66,16 @@ bool CCPUMeshPackerV2<MDIStructType>::commit(IMeshPackerBase::PackedMeshBufferDa
 
         const auto& mbVtxInputParams = (*it)->getPipeline()->getVertexInputParams();
 
-        core::vector<TriangleBatch> triangleBatches = constructTriangleBatches(*it);
+        const TriangleBatches triangleBatches = constructTriangleBatches(*it);
+        VertexRemap vertexRemap(triangleBatches.vertexIDUpperBound);
 
         size_t batchFirstIdx = ramb.indexAllocationOffset;
         size_t verticesAddedCnt = 0u;
 
-        for (TriangleBatch& batch : triangleBatches)
+        for (uint32_t batchIx = 0u; batchIx < triangleBatches.getBatchCount(); batchIx++)
         {
-            core::unordered_map<uint32_t, uint16_t> usedVertices = constructNewIndicesFromTriangleBatch(batch, indexBuffPtr);
+            const TriangleBatch batch = triangleBatches.getBatch(batchIx);
+            constructNewIndicesFromTriangleBatch(batch, indexBuffPtr, vertexRemap);
 
             //copy deinterleaved vertices into unified vertex buffer
             for (uint16_t attrBit = 0x0001, location = 0; location < SVertexInputParams::MAX_ATTR_BUF_BINDING_COUNT; attrBit <<= 1, location++)
@@ -88,7 +92,7 @@ bool CCPUMeshPackerV2<MDIStructType>::commit(IMeshPackerBase::PackedMeshBufferDa
                 const uint32_t currBatchOffset = verticesAddedCnt * attribSize;
 
                 uint8_t* dstAttrPtr = static_cast<uint8_t*>(m_packerDataStore.vertexBuffer->getPointer()) + ramb.attribAllocParams[location].offset + currBatchOffset;
-                deinterleaveAndCopyAttribute(*it, location, usedVertices, dstAttrPtr);
+                deinterleaveAndCopyAttribute(*it, location, vertexRemap, dstAttrPtr);
 
                 auto vtxFormatInfo = virtualAttribConfig.map.find(attribFormat);
 
@@ -99,12 +103,12 @@ bool CCPUMeshPackerV2<MDIStructType>::commit(IMeshPackerBase::PackedMeshBufferDa
                 cdotOut->attribInfo[location].offset = ramb.attribAllocParams[location].offset / attribSize + verticesAddedCnt;
             }
 
-            verticesAddedCnt += usedVertices.size();
+            verticesAddedCnt += vertexRemap.usedVertices.size();
             cdotOut++;
 
             //construct mdi data
             MDIStructType MDIData;
-            MDIData.count = batch.triangles.size() * 3u;
+            MDIData.count = batch.size() * 3u;
             MDIData.instanceCount = (*it)->getInstanceCount();
             MDIData.firstIndex = batchFirstIdx;
             MDIData.baseVertex = 0u;
@@ -113,10 +117,10 @@ bool CCPUMeshPackerV2<MDIStructType>::commit(IMeshPackerBase::PackedMeshBufferDa
             *mdiBuffPtr = MDIData;
             mdiBuffPtr++;
 
-            batchFirstIdx += 3u * batch.triangles.size();
+            batchFirstIdx += 3u * batch.size();
         }
 
-        pmbd = { ramb.mdiAllocationOffset, static_cast<uint32_t>(triangleBatches.size()) };
+        pmbd = { ramb.mdiAllocationOffset, triangleBatches.getBatchCount() };
 
         i++;
     }
@@ -29,33 +29,79 @@ class IAnimationLibrary : public virtual core::IReferenceCounted
 
 		struct alignas(8) Keyframe
 		{
-				Keyframe() : scale(0ull) // TODO: initialize scale to 1.f
+				Keyframe() : scale(encodeScale(core::vectorSIMDf(1.f)))
 				{
 					translation[2] = translation[1] = translation[0] = 0.f;
-					quat = core::vectorSIMDu32(128u,128u,128u,255u); // should be (0,0,0,1) encoded
+					quat = core::vectorSIMDu32(0u,0u,0u,127u); // (0,0,0,1) encoded
 				}
-				Keyframe(const core::vectorSIMDf& _scale, const core::quaternion& _quat, const CQuantQuaternionCache* quantCache, const core::vectorSIMDf& _translation)
+				Keyframe(const core::vectorSIMDf& _scale, const core::quaternion& _quat, CQuantQuaternionCache* quantCache, const core::vectorSIMDf& _translation)
 				{
-					std::copy(translation,_translation.pointer,3u);
-					quat = quantCache->quantize(_quat);
-					// TODO: encode to RGB18E7S3
-					//scale = ;
+					std::copy(_translation.pointer,_translation.pointer+3u,translation);
+					quat = quantCache->template quantize<EF_R8G8B8A8_SNORM>(_quat);
+					scale = encodeScale(_scale);
+				}
+
+				inline core::vectorSIMDf getTranslation() const
+				{
+					return core::vectorSIMDf(translation[0],translation[1],translation[2]);
 				}
 
 				inline core::quaternion getRotation() const
 				{
-					const void* _pix[4] = {&quat,nullptr,nullptr,nullptr};
-					double out[4];
-					decodePixels<EF_R8G8B8A8_SNORM,double>(_pix,out,0u,0u);
-					return reinterpret_cast<const core::quaternion&>(core::normalize(core::vectorSIMDf(out[0],out[1],out[2],out[3])));
+					// EF_R8G8B8A8_SNORM, same as `nbl_glsl_decode8888Quaternion`
+					const auto encoded = quat.getValue();
+					const core::vectorSIMDf snorm(float(int8_t(encoded.x)),float(int8_t(encoded.y)),float(int8_t(encoded.z)),float(int8_t(encoded.w)));
+					const auto decoded = core::normalize(core::max<core::vectorSIMDf>(snorm/127.f,core::vectorSIMDf(-1.f)));
+					return core::quaternion(decoded.x,decoded.y,decoded.z,decoded.w);
 				}
 
 				inline core::vectorSIMDf getScale() const
 				{
-					return core::vectorSIMDf(0.f/0.f); // TODO: decode from RGB18E7S3
+					return decodeScale(scale);
+				}
+
+				//! RGB18E7S3 is three 18bit mantissas with a shared 7bit exponent and 3 sign bits, same layout as `nbl_glsl_decodeRGB18E7S3`
+				static inline uint64_t encodeScale(const core::vectorSIMDf& _scale)
+				{
+					const float maxAbs = core::max(core::max(core::abs(_scale.x),core::abs(_scale.y)),core::abs(_scale.z));
+					if (maxAbs==0.f)
+						return 0ull;
+
+					int exp;
+					std::frexp(maxAbs,&exp);
+					const int32_t biasedExp = core::clamp<int32_t,int32_t>(exp+ScaleExponentBias,0,(0x1<<ScaleExponentBits)-1);
+					const float mantissaScale = std::ldexp(1.f,ScaleMantissaBits-(biasedExp-ScaleExponentBias));
+
+					uint64_t retval = uint64_t(biasedExp)<<(ScaleMantissaBits*3u);
+					for (uint32_t i=0u; i<3u; i++)
+					{
+						const uint64_t mantissa = core::min<uint64_t>(uint64_t(core::abs(_scale.pointer[i])*mantissaScale+0.5f),(0x1ull<<ScaleMantissaBits)-1ull);
+						retval |= mantissa<<(ScaleMantissaBits*i);
+						if (_scale.pointer[i]<0.f)
+							retval |= 0x1ull<<(61u+i);
+					}
+					return retval;
+				}
+				static inline core::vectorSIMDf decodeScale(const uint64_t _scale)
+				{
+					const int32_t biasedExp = (_scale>>(ScaleMantissaBits*3u))&((0x1u<<ScaleExponentBits)-1u);
+					const float mantissaScale = std::ldexp(1.f,biasedExp-ScaleExponentBias-ScaleMantissaBits);
+
+					core::vectorSIMDf retval;
+					for (uint32_t i=0u; i<3u; i++)
+					{
+						retval.pointer[i] = float((_scale>>(ScaleMantissaBits*i))&((0x1ull<<ScaleMantissaBits)-1ull))*mantissaScale;
+						if ((_scale>>(61u+i))&0x1ull)
+							retval.pointer[i] = -retval.pointer[i];
+					}
+					return retval;
 				}
 
 			private:
+				_NBL_STATIC_INLINE_CONSTEXPR int32_t ScaleMantissaBits = 18;
+				_NBL_STATIC_INLINE_CONSTEXPR int32_t ScaleExponentBits = 7;
+				_NBL_STATIC_INLINE_CONSTEXPR int32_t ScaleExponentBias = 63;
+
 				float translation[3];
 				CQuantQuaternionCache::Vector8u4 quat;
 				uint64_t scale;
@@ -95,7 +141,7 @@ class IAnimationLibrary : public virtual core::IReferenceCounted
 				}
 				inline E_INTERPOLATION_MODE getInterpolationMode() const
 				{
-					return data[1]&EIM_MASK;
+					return static_cast<E_INTERPOLATION_MODE>(data[1]&EIM_MASK);
 				}
 
 			private:
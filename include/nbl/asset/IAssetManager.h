@@ -6,7 +6,10 @@
 #define __NBL_ASSET_I_ASSET_MANAGER_H_INCLUDED__
 
 #include <array>
+#include <atomic>
 #include <ostream>
+#include <future>
+#include <thread>
 
 #include "nbl/core/core.h"
 #include "CConcurrentObjectCache.h"
@@ -38,13 +41,18 @@ std::function<void(SAssetBundle&)> makeAssetDisposeFunc(const IAssetManager* con
 
 //! Class responsible for handling loading of assets from file system or other resources
 /**
-	It provides a loading, writing and creation functionality that is almost thread-safe.
-	There is one issue with threading, starting loading the same asset at the exact same time 
-	may end up with two copies in the cache.
+	It provides a loading, writing and creation functionality that is thread-safe.
+	Loads of the same cache key which overlap in time are deduplicated, the late requests
+	wait for the load already in-flight instead of producing a second copy in the cache.
+	Loads can also be issued asynchronously or in batches with getAssetAsync() and getAssets(),
+	these run on a worker pool owned by the manager (see getThreadPool()).
 
 	IAssetManager performs caching of CPU assets associated with resource handles such as names, 
 	filenames, UUIDs. However there are separate caches for each asset type.
 
+	On top of that buffers, images and shaders can be deduplicated by their contents (see setContentDeduplication()),
+	so the same texture or shader loaded from different paths ends up as one asset and one GPU object.
+
 	@see IAsset
 
 */
@@ -55,13 +63,14 @@ class IAssetManager : public core::IReferenceCounted, public core::QuitSignallin
         friend std::function<void(SAssetBundle&)> makeAssetDisposeFunc(const IAssetManager* const _mgr);
 
     public:
+        // parallel loads insert and look up a lot of different paths at the same time, so the caches are sharded by key hash
 #ifdef USE_MAPS_FOR_PATH_BASED_CACHE
-        using AssetCacheType = core::CConcurrentMultiObjectCache<std::string, SAssetBundle, std::multimap>;
+        using AssetCacheType = core::CConcurrentShardedMultiObjectCache<std::string, SAssetBundle, std::multimap>;
 #else
-        using AssetCacheType = core::CConcurrentMultiObjectCache<std::string, IAssetBundle, std::vector>;
+        using AssetCacheType = core::CConcurrentShardedMultiObjectCache<std::string, IAssetBundle, std::vector>;
 #endif //USE_MAPS_FOR_PATH_BASED_CACHE
 
-        using CpuGpuCacheType = core::CConcurrentObjectCache<const IAsset*, core::smart_refctd_ptr<core::IReferenceCounted> >;
+        using CpuGpuCacheType = core::CConcurrentShardedObjectCache<const IAsset*, core::smart_refctd_ptr<core::IReferenceCounted> >;
 
     private:
         struct WriterKey
@@ -126,11 +135,87 @@ class IAssetManager : public core::IReferenceCounted, public core::QuitSignallin
         // called as a part of constructor only
         void initializeMeshTools();
 
+        // created lazily, so that managers which never load anything asynchronously never spawn threads
+        const uint32_t m_threadPoolSize;
+        std::once_flag m_threadPoolCreated;
+        core::smart_refctd_ptr<core::CThreadPool> m_threadPool;
+
+        //! loads currently running, keyed by the same filename the result will get cached under
+        std::mutex m_inFlightMutex;
+        struct SInFlightLoad
+        {
+            std::shared_future<SAssetBundle> result;
+            //! other in-flight loads this one is (possibly) waiting on, so that a cycle spanning several threads can be detected
+            core::unordered_multiset<std::string> waitsFor;
+        };
+        core::unordered_map<std::string,SInFlightLoad> m_inFlightLoads;
+        //! filenames which the calling thread is in the middle of loading (innermost last), also carried over into the tasks it submits
+        inline static thread_local core::vector<std::string> s_loadChain;
+
+        //! whether `_from` transitively waits on `_to`, must be called with `m_inFlightMutex` held
+        bool inFlightLoadWaitsFor(const std::string& _from, const std::string& _to) const
+        {
+            core::vector<const std::string*> stack = { &_from };
+            core::unordered_set<std::string> visited;
+            while (!stack.empty())
+            {
+                const std::string& key = *stack.back();
+                stack.pop_back();
+                if (key==_to)
+                    return true;
+                if (!visited.insert(key).second)
+                    continue;
+                auto found = m_inFlightLoads.find(key);
+                if (found!=m_inFlightLoads.end())
+                for (const auto& dependency : found->second.waitsFor)
+                    stack.push_back(&dependency);
+            }
+            return false;
+        }
+        //! innermost load of the calling thread which is tracked as in-flight, must be called with `m_inFlightMutex` held
+        const std::string* getInFlightLoadOfThisThread() const
+        {
+            for (auto it=s_loadChain.rbegin(); it!=s_loadChain.rend(); it++)
+            if (m_inFlightLoads.find(*it)!=m_inFlightLoads.end())
+                return &(*it);
+            return nullptr;
+        }
+
+        //! XXHash_256 of the contents of an asset, see `computeContentHash`
+        struct SContentHash
+        {
+            uint64_t hash[4];
+
+            inline bool operator==(const SContentHash& other) const { return memcmp(hash,other.hash,sizeof(hash))==0; }
+
+            struct hasher
+            {
+                inline size_t operator()(const SContentHash& contentHash) const { return contentHash.hash[0]; }
+            };
+        };
+        std::atomic_bool m_contentDeduplication = false;
+        mutable std::mutex m_contentIndexMutex;
+        core::unordered_map<SContentHash,core::smart_refctd_ptr<IAsset>,SContentHash::hasher> m_contentIndex;
+        core::unordered_map<const IAsset*,SContentHash> m_contentIndexKeys; // for removal
+
+    public:
+        //! How much the content deduplication saved, every array is indexed by `IAsset::typeFlagToIndex`
+        struct SContentDeduplicationStats
+        {
+            std::array<uint64_t,IAsset::ET_STANDARD_TYPES_COUNT> duplicateCount = {};
+            std::array<uint64_t,IAsset::ET_STANDARD_TYPES_COUNT> bytesSaved = {};
+        };
+
+    private:
+        SContentDeduplicationStats m_contentDeduplicationStats;
+
     public:
         //! Constructor
-        explicit IAssetManager(core::smart_refctd_ptr<io::IFileSystem>&& _fs) :
+        /** @param _threadPoolSize number of workers used for asynchronous loads, 0 means as many as hardware threads. */
+        explicit IAssetManager(core::smart_refctd_ptr<io::IFileSystem>&& _fs, const uint32_t _threadPoolSize=0u) :
             m_fileSystem(std::move(_fs)),
-            m_defaultLoaderOverride(this)
+            m_defaultLoaderOverride(this),
+            m_threadPoolSize(_threadPoolSize)
         {
             initializeMeshTools();
 
@@ -149,9 +234,19 @@ class IAssetManager : public core::IReferenceCounted, public core::QuitSignallin
         IMeshManipulator* getMeshManipulator();
         IGLSLCompiler* getGLSLCompiler() const { return m_glslCompiler.get(); }
 
+        //! Pool running asynchronous and batched loads, loaders can also use it to parallelize their own work
+        inline core::CThreadPool* getThreadPool()
+        {
+            std::call_once(m_threadPoolCreated,[this]() -> void {m_threadPool = core::make_smart_refctd_ptr<core::CThreadPool>(m_threadPoolSize);});
+            return m_threadPool.get();
+        }
+
     protected:
 		virtual ~IAssetManager()
 		{
+            // joins the workers, so no load can touch the caches while they're being torn down
+            m_threadPool = nullptr;
+
             quitEventHandler.execute();
 
 			for (size_t i = 0u; i < m_assetCache.size(); ++i)
@@ -241,31 +336,106 @@ class IAssetManager : public core::IReferenceCounted, public core::QuitSignallin
             if (!file)
                 return {};//return empty bundle
 
-            auto capableLoadersRng = m_loaders.perFileExt.findRange(getFileExt(filename.c_str()));
-            // loaders associated with the file's extension tryout
-            for (auto& loader : capableLoadersRng)
+            // keeps `s_loadChain` up to date while this thread loads `filename`
+            struct SLoadChainGuard
             {
-                if (loader.second->isALoadableFileFormat(file) && !(bundle = loader.second->loadAsset(file, params, _override, _hierarchyLevel)).getContents().empty())
-                    break;
-            }
-            for (auto loaderItr = std::begin(m_loaders.vector); bundle.getContents().empty() && loaderItr != std::end(m_loaders.vector); ++loaderItr) // all loaders tryout
+                SLoadChainGuard(const std::string& _filename) { s_loadChain.push_back(_filename); }
+                ~SLoadChainGuard() { s_loadChain.pop_back(); }
+            };
+            // duplicating loads are requested to produce a separate copy, so only the ones which use the cache get deduplicated
+            if ((levelFlags & IAssetLoader::ECF_DUPLICATE_TOP_LEVEL) != IAssetLoader::ECF_DUPLICATE_TOP_LEVEL)
             {
-                if ((*loaderItr)->isALoadableFileFormat(file) && !(bundle = (*loaderItr)->loadAsset(file, params, _override, _hierarchyLevel)).getContents().empty())
-                    break;
-            }
+                std::promise<SAssetBundle> promise;
+                std::shared_future<SAssetBundle> inFlight;
+                std::string parentLoad; // in-flight load of this thread which needs `filename`
+                bool foundInCache = false;
+                bool recursiveLoad = false;
+                {
+                    std::unique_lock<std::mutex> lock(m_inFlightMutex);
+                    if (auto load = getInFlightLoadOfThisThread())
+                        parentLoad = *load;
+                    // the load we'd be waiting for could have finished and got cached between our lookup and taking the lock
+                    auto found = findAssets(filename);
+                    if (found->size())
+                    {
+                        bundle = _override->chooseRelevantFromFound(found->begin(), found->end(), ctx, _hierarchyLevel);
+                        foundInCache = true;
+                    }
+                    else
+                    {
+                        auto inFlightIt = m_inFlightLoads.find(filename);
+                        // an asset (indirectly) referencing itself, possibly through loads running on other threads, waiting would never finish
+                        if (inFlightIt != m_inFlightLoads.end())
+                            recursiveLoad = std::find(s_loadChain.begin(),s_loadChain.end(),filename)!=s_loadChain.end() || (!parentLoad.empty()&&inFlightLoadWaitsFor(filename,parentLoad));
+                        if (inFlightIt == m_inFlightLoads.end())
+                            m_inFlightLoads.emplace(filename, SInFlightLoad{promise.get_future().share(),{}});
+                        else if (!recursiveLoad)
+                            inFlight = inFlightIt->second.result;
+                        // conservatively assume that the parent waits for whatever it starts
+                        if (!recursiveLoad && !parentLoad.empty())
+                            m_inFlightLoads[parentLoad].waitsFor.insert(filename);
+                    }
+                }
 
-            if (!bundle.getContents().empty() && 
-                ((levelFlags & IAssetLoader::ECF_DONT_CACHE_TOP_LEVEL) != IAssetLoader::ECF_DONT_CACHE_TOP_LEVEL) &&
-                ((levelFlags & IAssetLoader::ECF_DUPLICATE_TOP_LEVEL) != IAssetLoader::ECF_DUPLICATE_TOP_LEVEL))
-            {
-                _override->insertAssetIntoCache(bundle, filename, ctx, _hierarchyLevel);
+                // stops tracking `filename` as a dependency of `parentLoad`
+                auto removeDependency = [this,&filename,&parentLoad]() -> void
+                {
+                    if (parentLoad.empty())
+                        return;
+                    std::unique_lock<std::mutex> lock(m_inFlightMutex);
+                    // a task started by the parent could outlive it
+                    auto found = m_inFlightLoads.find(parentLoad);
+                    if (found == m_inFlightLoads.end())
+                        return;
+                    auto dependency = found->second.waitsFor.find(filename);
+                    if (dependency != found->second.waitsFor.end())
+                        found->second.waitsFor.erase(dependency);
+                };
+                if (foundInCache)
+                {
+                    // nothing to load, but the bundle still needs restoring below
+                }
+                else if (recursiveLoad)
+                {
+                    SLoadChainGuard chainGuard(filename);
+                    bundle = loadAndCacheAsset_impl(file, filename, params, ctx, levelFlags, _hierarchyLevel, _override);
+                }
+                else if (inFlight.valid())
+                {
+                    bundle = inFlight.get();
+                    removeDependency();
+                }
+                else
+                {
+                    // publishes the result and stops tracking the load however the loader returns
+                    struct SInFlightGuard
+                    {
+                        ~SInFlightGuard()
+                        {
+                            // the bundle is already in the cache by now (if it was supposed to be), so late requests will find it there
+                            promise.set_value(bundle);
+                            {
+                                std::unique_lock<std::mutex> lock(manager->m_inFlightMutex);
+                                manager->m_inFlightLoads.erase(filename);
+                            }
+                            removeFromParent();
+                        }
+
+                        IAssetManager* manager;
+                        const std::string& filename;
+                        std::promise<SAssetBundle>& promise;
+                        const SAssetBundle& bundle;
+                        const decltype(removeDependency)& removeFromParent;
+                    };
+                    SInFlightGuard inFlightGuard{this,filename,promise,bundle,removeDependency};
+                    SLoadChainGuard chainGuard(filename);
+                    bundle = loadAndCacheAsset_impl(file, filename, params, ctx, levelFlags, _hierarchyLevel, _override);
+                }
             }
-            else if (bundle.getContents().empty())
+            else
             {
-                bool addToCache;
-                bundle = _override->handleLoadFail(addToCache, file, filename, filename, ctx, _hierarchyLevel);
-                if (!bundle.getContents().empty() && addToCache)
-                    _override->insertAssetIntoCache(bundle, filename, ctx, _hierarchyLevel);
+                SLoadChainGuard chainGuard(filename);
+                bundle = loadAndCacheAsset_impl(file, filename, params, ctx, levelFlags, _hierarchyLevel, _override);
             }
 
             auto whole_bundle_not_dummy = [restoreLevels](const SAssetBundle& _b) {
@@ -314,6 +484,41 @@ class IAssetManager : public core::IReferenceCounted, public core::QuitSignallin
             
             return bundle;
         }
+        //! Tries all capable loaders on the file and inserts the result into the cache if the caching flags allow for it
+        SAssetBundle loadAndCacheAsset_impl(io::IReadFile* _file, const std::string& _filename, const IAssetLoader::SAssetLoadParams& _params, const IAssetLoader::SAssetLoadContext& _ctx, const uint64_t _levelFlags, uint32_t _hierarchyLevel, IAssetLoader::IAssetLoaderOverride* _override)
+        {
+            SAssetBundle bundle;
+
+            auto capableLoadersRng = m_loaders.perFileExt.findRange(getFileExt(_filename.c_str()));
+            // loaders associated with the file's extension tryout
+            for (auto& loader : capableLoadersRng)
+            {
+                if (loader.second->isALoadableFileFormat(_file) && !(bundle = loader.second->loadAsset(_file, _params, _override, _hierarchyLevel)).getContents().empty())
+                    break;
+            }
+            for (auto loaderItr = std::begin(m_loaders.vector); bundle.getContents().empty() && loaderItr != std::end(m_loaders.vector); ++loaderItr) // all loaders tryout
+            {
+                if ((*loaderItr)->isALoadableFileFormat(_file) && !(bundle = (*loaderItr)->loadAsset(_file, _params, _override, _hierarchyLevel)).getContents().empty())
+                    break;
+            }
+
+            if (!bundle.getContents().empty() && 
+                ((_levelFlags & IAssetLoader::ECF_DONT_CACHE_TOP_LEVEL) != IAssetLoader::ECF_DONT_CACHE_TOP_LEVEL) &&
+                ((_levelFlags & IAssetLoader::ECF_DUPLICATE_TOP_LEVEL) != IAssetLoader::ECF_DUPLICATE_TOP_LEVEL))
+            {
+                _override->insertAssetIntoCache(bundle, _filename, _ctx, _hierarchyLevel);
+            }
+            else if (bundle.getContents().empty())
+            {
+                bool addToCache;
+                bundle = _override->handleLoadFail(addToCache, _file, _filename, _filename, _ctx, _hierarchyLevel);
+                if (!bundle.getContents().empty() && addToCache)
+                    _override->insertAssetIntoCache(bundle, _filename, _ctx, _hierarchyLevel);
+            }
+
+            return bundle;
+        }
+
         //TODO change name
         template <bool RestoreWholeBundle>
         SAssetBundle getAssetInHierarchy_impl(const std::string& _filePath, const IAssetLoader::SAssetLoadParams& _params, uint32_t _hierarchyLevel, IAssetLoader::IAssetLoaderOverride* _override)
@@ -364,6 +569,20 @@ class IAssetManager : public core::IReferenceCounted, public core::QuitSignallin
             return getAssetInHierarchy_impl<false>(_filename, _params, _hierarchyLevel);
         }
 
+        //! Runs getAssetInHierarchy() on the thread pool
+        /** Everything `_params` points to (relative directory, decryption key, mesh manipulator) and `_override` must outlive the load. */
+        core::CThreadPool::future_t<SAssetBundle> getAssetInHierarchyAsync(const std::string& _filePath, const IAssetLoader::SAssetLoadParams& _params, uint32_t _hierarchyLevel, IAssetLoader::IAssetLoaderOverride* _override)
+        {
+            // the task loads on behalf of whatever this thread is loading, which needs to be known to detect dependency cycles
+            return getThreadPool()->submit([this,_filePath,_params,_hierarchyLevel,_override,loadChain=s_loadChain]() -> SAssetBundle
+            {
+                auto outerLoadChain = std::exchange(s_loadChain,loadChain);
+                auto retval = getAssetInHierarchy(_filePath,_params,_hierarchyLevel,_override);
+                s_loadChain = std::move(outerLoadChain);
+                return retval;
+            });
+        }
+
         SAssetBundle getAssetInHierarchyWholeBundleRestore(io::IReadFile* _file, const std::string& _supposedFilename, const IAssetLoader::SAssetLoadParams& _params, uint32_t _hierarchyLevel, IAssetLoader::IAssetLoaderOverride* _override)
         {
             return getAssetInHierarchy_impl<true>(_file, _supposedFilename, _params, _hierarchyLevel, _override);
@@ -405,6 +624,40 @@ class IAssetManager : public core::IReferenceCounted, public core::QuitSignallin
             return getAsset(_file, _supposedFilename, _params, &m_defaultLoaderOverride);
         }
 
+        //! Starts loading the asset on the thread pool and returns immediately
+        /** Concurrent requests for the same file (sync or async) share a single load.
+        Everything `_params` points to (relative directory, decryption key, mesh manipulator) and `_override` must outlive the load,
+        and the IAssetManager must not be destroyed before the returned future becomes ready. */
+        core::CThreadPool::future_t<SAssetBundle> getAssetAsync(const std::string& _filename, const IAssetLoader::SAssetLoadParams& _params, IAssetLoader::IAssetLoaderOverride* _override)
+        {
+            return getAssetInHierarchyAsync(_filename, _params, 0u, _override);
+        }
+        core::CThreadPool::future_t<SAssetBundle> getAssetAsync(const std::string& _filename, const IAssetLoader::SAssetLoadParams& _params)
+        {
+            return getAssetAsync(_filename, _params, &m_defaultLoaderOverride);
+        }
+
+        //! Loads all the files in `[_begin,_end)` in parallel, the returned bundles are in the same order as the paths
+        template<typename PathIt>
+        core::vector<SAssetBundle> getAssets(PathIt _begin, PathIt _end, const IAssetLoader::SAssetLoadParams& _params, IAssetLoader::IAssetLoaderOverride* _override)
+        {
+            core::vector<core::CThreadPool::future_t<SAssetBundle> > futures;
+            futures.reserve(std::distance(_begin,_end));
+            for (auto it=_begin; it!=_end; it++)
+                futures.push_back(getAssetAsync(*it,_params,_override));
+
+            core::vector<SAssetBundle> retval;
+            retval.reserve(futures.size());
+            for (auto& future : futures)
+                retval.push_back(future.get());
+            return retval;
+        }
+        template<typename PathIt>
+        core::vector<SAssetBundle> getAssets(PathIt _begin, PathIt _end, const IAssetLoader::SAssetLoadParams& _params)
+        {
+            return getAssets(_begin, _end, _params, &m_defaultLoaderOverride);
+        }
+
         SAssetBundle getAssetWholeBundleRestore(const std::string& _filename, const IAssetLoader::SAssetLoadParams& _params, IAssetLoader::IAssetLoaderOverride* _override)
         {
             return getAssetInHierarchyWholeBundleRestore(_filename, _params, 0u, _override);
@@ -520,6 +773,9 @@ class IAssetManager : public core::IReferenceCounted, public core::QuitSignallin
         //TODO change name
         bool insertAssetIntoCache(SAssetBundle& _asset, IAsset::E_MUTABILITY _mutability = IAsset::EM_CPU_PERSISTENT)
         {
+            // a mutable asset could diverge from its duplicates later, so only the ones which will keep their contents get shared
+            if (m_contentDeduplication && _mutability!=IAsset::EM_MUTABLE)
+                deduplicateContents(_asset,_mutability);
             const uint32_t ix = IAsset::typeFlagToIndex(_asset.getAssetType());
             for (auto ass : _asset.getContents())
                 setAssetMutability(ass.get(), _mutability);
@@ -530,6 +786,7 @@ class IAssetManager : public core::IReferenceCounted, public core::QuitSignallin
         //TODO change key
         bool removeAssetFromCache(SAssetBundle& _asset) //will actually look up by asset's key instead
         {
+            removeFromContentIndex(_asset);
             const uint32_t ix = IAsset::typeFlagToIndex(_asset.getAssetType());
             return m_assetCache[ix]->removeObject(_asset, _asset.getCacheKey());
         }
@@ -540,7 +797,25 @@ class IAssetManager : public core::IReferenceCounted, public core::QuitSignallin
             for (size_t i = 0u; i < IAsset::ET_STANDARD_TYPES_COUNT; ++i)
                 if ((_assetTypeBitFlags>>i) & 1ull)
                     m_assetCache[i]->clear();
+            clearContentIndex(_assetTypeBitFlags);
+        }
+
+        //! Enables content-addressed deduplication of buffers, images and shaders, off by default
+        /** While enabled, every ICPUBuffer, ICPUImage and ICPUShader inserted into the cache gets hashed with XXHash_256.
+        If an asset with the same contents and mutability was inserted before (under any key) the bundle being inserted gets that existing instance instead.
+        Bundles with metadata and assets inserted as EM_MUTABLE are left alone, as the metadata is tied to the asset instances and mutable contents can change.
+        Disabling it keeps the index, so it can be re-enabled later, clearAllAssetCache() empties it. */
+        inline void setContentDeduplication(const bool _enable) { m_contentDeduplication = _enable; }
+        inline bool isContentDeduplicationEnabled() const { return m_contentDeduplication; }
+
+        //! how many assets got replaced by an already indexed duplicate and how much memory that saved, per asset type
+        inline SContentDeduplicationStats getContentDeduplicationStats() const
+        {
+            std::unique_lock<std::mutex> lock(m_contentIndexMutex);
+            return m_contentDeduplicationStats;
         }
+        //! Prints the number of duplicates found and the bytes saved per asset type
+        void dumpContentDeduplicationReport(std::ostream& _outs) const;
 
 
         //! This function does not free the memory consumed by IAssets, but allows you to cache GPU objects already created from given assets so that no unnecessary GPU-side duplicates get created.
@@ -817,6 +1092,13 @@ class IAssetManager : public core::IReferenceCounted, public core::QuitSignallin
 
         inline void setAssetMutability(IAsset* _asset, IAsset::E_MUTABILITY _val) const { _asset->m_mutability = _val; }
 
+        //! returns false for asset types which don't get deduplicated by content, or when the contents can't be read (dummy objects)
+        static bool computeContentHash(const IAsset* _asset, SContentHash& _outHash, size_t& _outSize);
+        //! replaces the contents of `_asset` with previously indexed assets of the same contents and mutability, indexes the rest
+        void deduplicateContents(SAssetBundle& _asset, const IAsset::E_MUTABILITY _mutability);
+        void removeFromContentIndex(const SAssetBundle& _asset);
+        void clearContentIndex(const uint64_t _assetTypeBitFlags);
+
 		//
 		void addLoadersAndWriters();
 
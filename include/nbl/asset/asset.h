@@ -21,6 +21,7 @@
 
 // base
 #include "nbl/asset/ICPUBuffer.h"
+#include "nbl/asset/utils/CCPUBufferArena.h"
 #include "nbl/asset/IAsset.h"
 #include "nbl/asset/IMesh.h"
 
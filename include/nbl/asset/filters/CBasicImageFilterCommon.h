@@ -7,7 +7,11 @@
 
 #include "nbl/core/core.h"
 
+#include <algorithm>
+#include <execution>
+
 #include "nbl/asset/filters/IImageFilter.h"
+#include "nbl/asset/format/encodeBlockCompressed.h"
 
 namespace nbl
 {
@@ -131,9 +135,85 @@ class CBasicImageFilterCommon
 			return executePerRegion<F,default_region_functor_t>(image,f,_begin,_end,voidFunctor);
 		}
 
+		//! Compresses every block of the `image` regions in `mipLevel` which overlap the range, block compressed formats can't be written texel by texel
+		/*
+			`fetch(core::vectorSIMDu32 texelCoordAndLayer, double* texel)` must write all 4 channels of a texel in the range,
+			the coordinates are relative to `offsetBaseLayer` and texels of partial blocks at the end of the range repeat the edge.
+			Rows of blocks are distributed according to the execution `policy`, so `fetch` needs to be thread-safe.
+
+			The offset of the range has to be aligned to the block size, which `validateBlockCompressedOutput` checks.
+		*/
+		template<class ExecutionPolicy, typename Fetch>
+		static inline void encodeBlockCompressedRange(	ExecutionPolicy&& policy, ICPUImage* image, uint32_t mipLevel,
+														const core::vectorSIMDu32& offsetBaseLayer, const core::vectorSIMDu32& extentLayerCount,
+														Fetch& fetch, E_BLOCK_COMPRESSION_QUALITY quality)
+		{
+			const E_FORMAT format = image->getCreationParameters().format;
+			const TexelBlockInfo blockInfo(format);
+			const auto& blockDims = blockInfo.getDimension();
+			assert(blockDims.x==4u && blockDims.y==4u && blockDims.z==1u);
+			uint8_t* const outData = reinterpret_cast<uint8_t*>(image->getBuffer()->getPointer());
+
+			struct SBlockRow
+			{
+				const IImage::SBufferCopy* region;
+				core::vectorSIMDu32 firstTexel; // of the first block in the row
+				uint32_t blockCount;
+			};
+			core::vector<SBlockRow> rows;
+			const auto rangeLimit = offsetBaseLayer+extentLayerCount;
+			for (const auto& region : image->getRegions(mipLevel))
+			{
+				const core::vectorSIMDu32 regionOffset(region.imageOffset.x,region.imageOffset.y,region.imageOffset.z,region.imageSubresource.baseArrayLayer);
+				const core::vectorSIMDu32 regionExtent(region.imageExtent.width,region.imageExtent.height,region.imageExtent.depth,region.imageSubresource.layerCount);
+				const auto begin = core::max<core::vectorSIMDu32>(offsetBaseLayer,regionOffset);
+				const auto limit = core::min<core::vectorSIMDu32>(rangeLimit,regionOffset+regionExtent);
+				if ((begin>=limit).any())
+					continue;
+
+				const uint32_t blockCount = (limit.x-begin.x+blockDims.x-1u)/blockDims.x;
+				for (uint32_t layer=begin.w; layer<limit.w; layer++)
+				for (uint32_t z=begin.z; z<limit.z; z+=blockDims.z)
+				for (uint32_t y=begin.y; y<limit.y; y+=blockDims.y)
+					rows.push_back({&region,core::vectorSIMDu32(begin.x,y,z,layer),blockCount});
+			}
+
+			const auto lastTexel = extentLayerCount-core::vectorSIMDu32(1u,1u,1u,1u);
+			std::for_each(policy,rows.begin(),rows.end(),[&](const SBlockRow& row) -> void
+			{
+				const auto& region = *row.region;
+				const core::vectorSIMDu32 regionOffset(region.imageOffset.x,region.imageOffset.y,region.imageOffset.z,region.imageSubresource.baseArrayLayer);
+				const auto byteStrides = region.getByteStrides(blockInfo);
+
+				constexpr uint32_t MaxChannels = 4u;
+				double texels[16u*MaxChannels];
+				for (uint32_t block=0u; block<row.blockCount; block++)
+				{
+					const auto blockTexel = row.firstTexel+core::vectorSIMDu32(block*blockDims.x,0u,0u,0u);
+					for (uint32_t y=0u; y<blockDims.y; y++)
+					for (uint32_t x=0u; x<blockDims.x; x++)
+						fetch(core::min<core::vectorSIMDu32>(blockTexel+core::vectorSIMDu32(x,y,0u,0u)-offsetBaseLayer,lastTexel),texels+(y*blockDims.x+x)*MaxChannels);
+
+					const auto localBlock = blockInfo.convertTexelsToBlocks(blockTexel-regionOffset);
+					encodeBlockCompressed(format,outData+region.getByteOffset(localBlock,byteStrides),texels,quality);
+				}
+			});
+		}
+
 	protected:
 		virtual ~CBasicImageFilterCommon() =0;
 
+		//! Block compressed outputs have to be encodable and get written whole blocks at a time
+		static inline bool validateBlockCompressedOutput(const ICPUImage* image, const VkOffset3D& offset)
+		{
+			const E_FORMAT format = image->getCreationParameters().format;
+			if (!isBlockCompressionEncodable(format))
+				return false;
+
+			const auto blockDims = getBlockDimensions(format);
+			return offset.x%blockDims.x==0u && offset.y%blockDims.y==0u && offset.z%blockDims.z==0u;
+		}
+
 		static inline bool validateSubresourceAndRange(	const ICPUImage::SSubresourceLayers& subresource,
 														const IImageFilter::IState::TexelRange& range,
 														const ICPUImage* image)
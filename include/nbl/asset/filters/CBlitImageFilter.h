@@ -9,6 +9,8 @@
 
 #include <type_traits>
 #include <algorithm>
+#include <numeric>
+#include <execution>
 
 #include "nbl/asset/filters/CMatchedSizeInOutImageFilterCommon.h"
 #include "nbl/asset/filters/CSwizzleAndConvertImageFilter.h"
@@ -51,6 +53,7 @@ class CBlitImageFilterBase : public impl::CSwizzleableAndDitherableFilterBase<No
 				E_ALPHA_SEMANTIC					alphaSemantic = EAS_NONE_OR_PREMULTIPLIED;
 				double								alphaRefValue = 0.5; // only required to make sense if `alphaSemantic==EAS_REFERENCE_OR_COVERAGE`
 				uint32_t							alphaChannel = 3u; // index of the alpha channel (could be different cause of swizzles)
+				E_BLOCK_COMPRESSION_QUALITY			compressionQuality = EBCQ_FAST; // only used when the output image has a block compressed format
 		};
 
 	protected:
@@ -232,14 +235,22 @@ class CBlitImageFilter : public CImageFilter<CBlitImageFilter<Normalize,Clamp,Sw
 			if (state->alphaSemantic!=CState::EAS_NONE_OR_PREMULTIPLIED && (getFormatChannelCount(inFormat)!=4u||getFormatChannelCount(outFormat)!=4u))
 				return false;
 
-			// TODO: remove this later when we can actually write/encode to block formats
-			if (isBlockCompressionFormat(outFormat))
+			if (isBlockCompressionFormat(outFormat) && !CBasicImageFilterCommon::validateBlockCompressedOutput(state->outImage,state->outOffset))
 				return false;
 
 			return state->kernelX.validate(state->inImage,state->outImage)&&state->kernelY.validate(state->inImage,state->outImage)&&state->kernelZ.validate(state->inImage,state->outImage);
 		}
 
 		static inline bool execute(state_type* state)
+		{
+			return execute(std::execution::seq,state);
+		}
+
+		// same as above but the scanlines of each separable pass get distributed according to the execution `policy`,
+		// every scanline is computed by the same code regardless of the policy, so the output is bit-identical to the sequential version
+		// (the dithers we ship only depend on the texel coordinate, so they don't break that either)
+		template<class ExecutionPolicy>
+		static inline bool execute(ExecutionPolicy&& policy, state_type* state)
 		{
 			if (!validate(state))
 				return false;
@@ -280,6 +291,7 @@ class CBlitImageFilter : public CImageFilter<CBlitImageFilter<Normalize,Clamp,Sw
 			const bool coverageSemantic = state->alphaSemantic==CState::EAS_REFERENCE_OR_COVERAGE;
 			const auto alphaRefValue = state->alphaRefValue;
 			const auto alphaChannel = state->alphaChannel;
+			const bool blockCompressedOutput = isBlockCompressionFormat(outFormat);
 			
 			// prepare kernel
 			const auto kernelX = state->contructScaledKernel(state->kernelX);
@@ -312,9 +324,12 @@ class CBlitImageFilter : public CImageFilter<CBlitImageFilter<Normalize,Clamp,Sw
 				core::vectorSIMDu32(MaxChannels*intermediateExtent[1].y*intermediateExtent[1].z,MaxChannels*intermediateExtent[1].z,MaxChannels,0u),
 				core::vectorSIMDu32(MaxChannels,MaxChannels*intermediateExtent[2].x,MaxChannels*intermediateExtent[2].x*intermediateExtent[2].y,0u)
 			};
+			// the X pass decodes a whole input scanline before filtering it, the second pong buffer is unused during that pass so we carve it up into decode buffers, one per task
+			const uint32_t decodeBufferTexels = inExtent.width+window_last.x;
+			const uint32_t decodeBufferCount = (getScratchOffset(state,true)-getScratchOffset(state,false))/(decodeBufferTexels*MaxChannels*sizeof(value_type));
 			// storage
 			core::RandomSampler sampler(std::chrono::high_resolution_clock::now().time_since_epoch().count());
-			auto storeToTexel = [state,nonPremultBlendSemantic,alphaChannel,outFormat](value_type* const sample, void* const dstPix, const core::vectorSIMDu32& localOutPos) -> void
+			auto unpremultiply = [nonPremultBlendSemantic,alphaChannel](value_type* const sample) -> void
 			{
 				if (nonPremultBlendSemantic && sample[alphaChannel]>FLT_MIN*1024.0*512.0)
 				{
@@ -322,11 +337,31 @@ class CBlitImageFilter : public CImageFilter<CBlitImageFilter<Normalize,Clamp,Sw
 					if (i!=alphaChannel)
 						sample[i] /= sample[alphaChannel];
 				}
-
+			};
+			auto storeToTexel = [state,unpremultiply,outFormat](value_type* const sample, void* const dstPix, const core::vectorSIMDu32& localOutPos) -> void
+			{
+				unpremultiply(sample);
 				impl::CSwizzleAndConvertImageFilterBase<Normalize, Clamp, Swizzle, Dither>::onEncode(outFormat, state, dstPix, sample, localOutPos, 0, 0, MaxChannels);
 			};
+			// block compressed outputs can only be written a whole block at a time, so they get encoded from the last pass' intermediate storage (without dithering)
+			auto encodeToImage = [&policy,state,outImg,outMipLevel,outExtent,intermediateStorage,intermediateStrides,alphaChannel,unpremultiply](const int axis, const core::vectorSIMDu32& outOffsetLayer, const value_type coverageScale) -> void
+			{
+				auto fetch = [&](const core::vectorSIMDu32& localOutPos, double* texel) -> void
+				{
+					value_type sample[MaxChannels];
+					const auto* const first = intermediateStorage[axis]+IImage::SBufferCopy::getLocalByteOffset(localOutPos,intermediateStrides[axis]);
+					std::copy(first,first+MaxChannels,sample);
+
+					sample[alphaChannel] *= coverageScale;
+					unpremultiply(sample);
+					for (auto i=0; i<4; i++)
+						texel[i] = i<MaxChannels ? double(sample[i]):(i==3 ? 1.0:0.0);
+				};
+				const core::vectorSIMDu32 outExtentLayer(outExtent.width,outExtent.height,outExtent.depth,1u);
+				CBasicImageFilterCommon::encodeBlockCompressedRange(policy,outImg,outMipLevel,outOffsetLayer,outExtentLayer,fetch,state->compressionQuality);
+			};
 			const core::SRange<const IImage::SBufferCopy> outRegions = outImg->getRegions(outMipLevel);
-			auto storeToImage = [coverageSemantic,outExtent,intermediateStorage,&sampler,outFormat,alphaRefValue,outData,intermediateStrides,alphaChannel,storeToTexel,outMipLevel,outOffset,outRegions,outImg](const core::rational<>& inverseCoverage, const int axis, const core::vectorSIMDu32& outOffsetLayer) -> void
+			auto storeToImage = [coverageSemantic,blockCompressedOutput,outExtent,intermediateStorage,&sampler,outFormat,alphaRefValue,outData,intermediateStrides,alphaChannel,storeToTexel,encodeToImage,outMipLevel,outOffset,outRegions,outImg](const core::rational<>& inverseCoverage, const int axis, const core::vectorSIMDu32& outOffsetLayer) -> void
 			{
 				// little thing for the coverage adjustment trick suggested by developer of The Witness
 				assert(coverageSemantic);
@@ -345,6 +380,11 @@ class CBlitImageFilter : public CImageFilter<CBlitImageFilter<Normalize,Clamp,Sw
 				std::nth_element(begin,nth,end);
 				// scale all alpha texels to work with new reference value
 				const auto coverageScale = alphaRefValue/(*nth);
+				if (blockCompressedOutput)
+				{
+					encodeToImage(axis,outOffsetLayer,coverageScale);
+					return;
+				}
 				auto scaleCoverage = [outData,outOffsetLayer,intermediateStrides,axis,intermediateStorage,alphaChannel,coverageScale,storeToTexel](uint32_t writeBlockArrayOffset, core::vectorSIMDu32 writeBlockPos) -> void
 				{
 					void* const dstPix = outData+writeBlockArrayOffset;
@@ -371,6 +411,60 @@ class CBlitImageFilter : public CImageFilter<CBlitImageFilter<Normalize,Clamp,Sw
 				return core::vectorSIMDi32(kernelX.getWindowMinCoord(halfTexelOffset).x-1,kernelY.getWindowMinCoord(halfTexelOffset).y-1,kernelZ.getWindowMinCoord(halfTexelOffset).z-1,0);
 			}();
 			const auto windowMinCoordBase = inOffsetBaseLayer+startCoord;
+			// the kernel weights only depend on the output texel's position along the axis, not on the scanline or layer, so evaluate them once per pass
+			SAxisWeights axisWeights[3];
+			auto computeAxisWeights = [&](IImage::E_TYPE axis, const auto& kernel, const IImageFilterKernel::UserData* otherUserData) -> void
+			{
+				if (axis>inImageType)
+					return;
+
+				auto& weights = axisWeights[axis];
+				weights.windowSize = kernel.getWindowSize()[axis];
+
+				IImageFilterKernel::ScaleFactorUserData scale(1.f/fScale[axis]);
+				if (const auto* otherScale=IImageFilterKernel::ScaleFactorUserData::cast(otherUserData))
+				for (auto k=0; k<MaxChannels; k++)
+					scale.factor[k] *= otherScale->factor[k];
+				for (auto k=0; k<MaxChannels; k++)
+					weights.scale[k] = scale.factor[k];
+
+				const uint32_t outCount = outExtentLayerCount[axis];
+				weights.windowOffset.resize(outCount);
+				weights.weights.resize(size_t(outCount)*weights.windowSize*MaxChannels);
+				auto* weight = weights.weights.data();
+				// evaluating on a sample of all ones gives us the bare weight, the scale factor gets applied in `convolve`
+				// as a separate multiplication so the rounding stays exactly the same as evaluating the kernel on the actual samples
+				auto loadOne = [](value_type* windowSample, const core::vectorSIMDf& unused0, const core::vectorSIMDi32& unused1, const IImageFilterKernel::UserData* unused2) -> void
+				{
+					std::fill(windowSample,windowSample+MaxChannels,value_type(1));
+				};
+				auto storeWeight = [&weight](const value_type* windowSample, const core::vectorSIMDf& unused0, const core::vectorSIMDi32& unused1, const IImageFilterKernel::UserData* unused2) -> void
+				{
+					std::copy(windowSample,windowSample+MaxChannels,weight);
+					weight += MaxChannels;
+				};
+				for (uint32_t i=0u; i<outCount; i++)
+				{
+					core::vectorSIMDf tmp;
+					tmp[axis] = float(i)+0.5f;
+					core::vectorSIMDi32 windowCoord;
+					windowCoord[axis] = kernel.getWindowMinCoord(tmp*fScale,tmp)[axis];
+					weights.windowOffset[i] = windowCoord[axis]-windowMinCoordBase[axis];
+					auto relativePos = tmp[axis]-float(windowCoord[axis]);
+					for (auto h=0; h<weights.windowSize; h++)
+					{
+						value_type windowSample[MaxChannels];
+
+						core::vectorSIMDf tmp(relativePos,0.f,0.f);
+						kernel.evaluateImpl(loadOne,storeWeight,windowSample,tmp,windowCoord,nullptr);
+						relativePos -= 1.f;
+						windowCoord[axis]++;
+					}
+				}
+			};
+			computeAxisWeights(IImage::ET_1D,kernelX,state->kernelX.getUserData());
+			computeAxisWeights(IImage::ET_2D,kernelY,state->kernelY.getUserData());
+			computeAxisWeights(IImage::ET_3D,kernelZ,state->kernelZ.getUserData());
 			for (uint32_t layer=0; layer!=layerCount; layer++)
 			{
 				const core::vectorSIMDi32 vLayer(0,0,0,layer);
@@ -379,54 +473,44 @@ class CBlitImageFilter : public CImageFilter<CBlitImageFilter<Normalize,Clamp,Sw
 				// reset coverage counter
 				core::rational inverseCoverage(0);
 				// filter lambda
-				auto filterAxis = [&](IImage::E_TYPE axis, auto& kernel) -> void
+				auto filterAxis = [&](IImage::E_TYPE axis) -> void
 				{
 					if (axis>inImageType)
 						return;
 
 					const bool lastPass = inImageType==axis;
-					const auto windowSize = kernel.getWindowSize()[axis];
-
-					IImageFilterKernel::ScaleFactorUserData scale(1.f/fScale[axis]);
-					const IImageFilterKernel::ScaleFactorUserData* otherScale = nullptr;
-					switch (axis)
-					{
-						case IImage::ET_1D:
-							otherScale = IImageFilterKernel::ScaleFactorUserData::cast(state->kernelX.getUserData());
-							break;
-						case IImage::ET_2D:
-							otherScale = IImageFilterKernel::ScaleFactorUserData::cast(state->kernelY.getUserData());
-							break;
-						case IImage::ET_3D:
-							otherScale = IImageFilterKernel::ScaleFactorUserData::cast(state->kernelZ.getUserData());
-							break;
-					}
-					if (otherScale)
-					for (auto k=0; k<MaxChannels; k++)
-						scale.factor[k] *= otherScale->factor[k];
+					const auto& weights = axisWeights[axis];
+					const uint32_t outCount = outExtentLayerCount[axis];
+					const uint32_t outStride = intermediateStrides[axis][axis];
 
 					// z y x output along x
 					// z x y output along y
 					// x y z output along z
 					const int loopCoordID[2] = {axis!=IImage::ET_3D ? 2:0,axis!=IImage::ET_2D ? 1:0/*,axis*/};
+					const uint32_t innerLineCount = intermediateExtent[axis][loopCoordID[1]];
+					const uint32_t lineCount = intermediateExtent[axis][loopCoordID[0]]*innerLineCount;
 
-					core::vectorSIMDi32 localTexCoord;
-					for (auto& k=(localTexCoord[loopCoordID[0]]=0); k<intermediateExtent[axis][loopCoordID[0]]; k++)
-					for (auto& j=(localTexCoord[loopCoordID[1]]=0); j<intermediateExtent[axis][loopCoordID[1]]; j++)
+					// returns the number of texels at or below the alpha reference value and the total number of texels considered for coverage
+					auto filterLine = [&](const uint32_t line, value_type* const decodeBuffer) -> std::pair<uint32_t,uint32_t>
 					{
+						std::pair<uint32_t,uint32_t> coverage(0u,0u);
+
+						core::vectorSIMDi32 localTexCoord(0,0,0,0);
+						localTexCoord[loopCoordID[0]] = line/innerLineCount;
+						localTexCoord[loopCoordID[1]] = line%innerLineCount;
 						// whole line plus window borders
-						value_type* lineBuffer;
-						localTexCoord[axis] = 0;
+						const value_type* lineBuffer;
 						if (axis!=IImage::ET_1D)
 							lineBuffer = intermediateStorage[axis-1]+core::dot(static_cast<const core::vectorSIMDi32&>(intermediateStrides[axis-1]),localTexCoord)[0];
 						else
 						{
-							lineBuffer = intermediateStorage[1];
-							const auto windowEnd = inExtent.width+window_last.x;
-							for (auto& i=localTexCoord.x; i<windowEnd; i++)
+							lineBuffer = decodeBuffer;
+							for (uint32_t i=0u; i<decodeBufferTexels; i++)
 							{
 								core::vectorSIMDi32 globalTexelCoord(localTexCoord+windowMinCoord);
+								globalTexelCoord.x += i;
 
+								auto sample = decodeBuffer+i*MaxChannels;
 								core::vectorSIMDu32 inBlockCoord;
 								const void* srcPix[] = { // multiple loads for texture boundaries aren't that bad
 									inImg->getTexelBlockData(inMipLevel,inImg->wrapTextureCoordinate(inMipLevel,globalTexelCoord,axisWraps),inBlockCoord),
@@ -434,10 +518,13 @@ class CBlitImageFilter : public CImageFilter<CBlitImageFilter<Normalize,Clamp,Sw
 									nullptr,
 									nullptr
 								};
+								// decode buffers get reused across scanlines, so don't leave stale values around
 								if (!srcPix[0])
+								{
+									std::fill(sample,sample+MaxChannels,value_type(0));
 									continue;
+								}
 
-								auto sample = lineBuffer+i*MaxChannels;
 								value_type swizzledSample[MaxChannels];
 
 								// TODO: make sure there is no leak due to MaxChannels!
@@ -452,68 +539,107 @@ class CBlitImageFilter : public CImageFilter<CBlitImageFilter<Normalize,Clamp,Sw
 								else if (coverageSemantic && globalTexelCoord[axis]>=inOffsetBaseLayer[axis] && globalTexelCoord[axis]<inLimit[axis])
 								{
 									if (sample[alphaChannel]<=alphaRefValue)
-										inverseCoverage.getNumerator()++;
-									inverseCoverage.getDenominator()++;
+										coverage.first++;
+									coverage.second++;
 								}
 							}
 						}
-						// TODO: this loop should probably get rewritten
-						for (auto& i=(localTexCoord[axis]=0); i<outExtentLayerCount[axis]; i++)
+						value_type* const lineOut = intermediateStorage[axis]+core::dot(static_cast<const core::vectorSIMDi32&>(intermediateStrides[axis]),localTexCoord)[0];
+						const value_type* weight = weights.weights.data();
+						for (uint32_t i=0u; i<outCount; i++,weight+=weights.windowSize*MaxChannels)
 						{
 							// get output pixel
-							auto* const value = intermediateStorage[axis]+core::dot(static_cast<const core::vectorSIMDi32&>(intermediateStrides[axis]),localTexCoord)[0];
-							std::fill(value,value+MaxChannels,value_type(0));
-							// kernel load functor
-							auto load = [axis,&windowMinCoord,lineBuffer](value_type* windowSample, const core::vectorSIMDf& unused0, const core::vectorSIMDi32& globalTexelCoord, const IImageFilterKernel::UserData* userData) -> void
-							{
-								for (auto h=0; h<MaxChannels; h++)
-									windowSample[h] = lineBuffer[(globalTexelCoord[axis]-windowMinCoord[axis])*MaxChannels+h];
-							};
-							// kernel evaluation functor
-							auto evaluate = [value](const value_type* windowSample, const core::vectorSIMDf& unused0, const core::vectorSIMDi32& unused1, const IImageFilterKernel::UserData* userData) -> void
-							{
-								for (auto h=0; h<MaxChannels; h++)
-									value[h] += windowSample[h];
-							};
-							// do the filtering 
-							core::vectorSIMDf tmp;
-							tmp[axis] = float(i)+0.5f;
-							core::vectorSIMDi32 windowCoord;
-							windowCoord[axis] = kernel.getWindowMinCoord(tmp*fScale,tmp)[axis];
-							auto relativePos = tmp[axis]-float(windowCoord[axis]);
-							for (auto h=0; h<windowSize; h++)
-							{
-								value_type windowSample[MaxChannels];
-
-								core::vectorSIMDf tmp(relativePos,0.f,0.f);
-								kernel.evaluateImpl(load,evaluate,windowSample,tmp,windowCoord,&scale);
-								relativePos -= 1.f;
-								windowCoord[axis]++;
-							}
-							if (!coverageSemantic && lastPass) // store to image, we're done
+							auto* const value = lineOut+i*outStride;
+							// do the filtering
+							convolve(value,lineBuffer+weights.windowOffset[i]*MaxChannels,weight,weights.scale,weights.windowSize);
+							if (!coverageSemantic && !blockCompressedOutput && lastPass) // store to image, we're done
 							{
+								localTexCoord[axis] = i;
 								core::vectorSIMDu32 dummy;
-								const core::vectorSIMDu32 localOutPos = localTexCoord + outOffsetBaseLayer;
+								const core::vectorSIMDu32 localOutPos = localTexCoord + outOffsetLayer;
 								storeToTexel(value,outImg->getTexelBlockData(outMipLevel,localOutPos,dummy),localOutPos);
 							}
 						}
+						return coverage;
+					};
+					// every task processes a contiguous range of scanlines, in the X pass the amount of tasks is limited by the decode buffers available
+					const uint32_t taskCount = axis!=IImage::ET_1D ? lineCount:core::min(lineCount,decodeBufferCount);
+					core::vector<uint32_t> tasks(taskCount);
+					std::iota(tasks.begin(),tasks.end(),0u);
+					core::vector<std::pair<uint32_t,uint32_t>> taskCoverage(taskCount,{0u,0u});
+					std::for_each(policy,tasks.begin(),tasks.end(),[&](const uint32_t task) -> void
+					{
+						// only the X pass decodes, the other passes have more tasks than decode buffers
+						value_type* const decodeBuffer = axis==IImage::ET_1D ? (intermediateStorage[1]+size_t(task)*decodeBufferTexels*MaxChannels):nullptr;
+						const uint32_t end = (uint64_t(task)+1ull)*lineCount/taskCount;
+						for (uint32_t line=uint64_t(task)*lineCount/taskCount; line<end; line++)
+						{
+							const auto coverage = filterLine(line,decodeBuffer);
+							taskCoverage[task].first += coverage.first;
+							taskCoverage[task].second += coverage.second;
+						}
+					});
+					for (const auto& coverage : taskCoverage)
+					{
+						inverseCoverage.getNumerator() += coverage.first;
+						inverseCoverage.getDenominator() += coverage.second;
 					}
-					// we'll only get here if we have to do coverage adjustment
+					// we'll only get here if we have to do coverage adjustment or encode blocks
 					if (coverageSemantic && lastPass)
 						storeToImage(inverseCoverage,axis,outOffsetLayer);
+					else if (blockCompressedOutput && lastPass)
+						encodeToImage(axis,outOffsetLayer,value_type(1));
 				};
 				// filter in X-axis
-				filterAxis(IImage::ET_1D,kernelX);
+				filterAxis(IImage::ET_1D);
 				// filter in Y-axis
-				filterAxis(IImage::ET_2D,kernelY);
+				filterAxis(IImage::ET_2D);
 				// filter in Z-axis
 				assert(inImageType!=IImage::ET_3D); // I need to test this in the future
-				filterAxis(IImage::ET_3D,kernelZ);
+				filterAxis(IImage::ET_3D);
 			}
 			return true;
 		}
 
 	private:
+		// precomputed kernel weights of a single separable pass
+		struct SAxisWeights
+		{
+			core::vector<int32_t>		windowOffset; // offset of the first window sample in the scanline, one per output texel
+			core::vector<value_type>	weights; // `windowSize*MaxChannels` per output texel
+			value_type					scale[MaxChannels];
+			int32_t						windowSize = 0;
+		};
+
+		// convolves a single output texel, same operation order as evaluating the kernel with an accumulating post-filter
+		static inline void convolve(value_type* const value, const value_type* samples, const value_type* weights, const value_type* const scale, const int32_t windowSize)
+		{
+#ifdef __NBL_COMPILE_WITH_X86_SIMD_
+			// the common case of 4 channels in double precision fits in two SSE2 registers
+			if constexpr (std::is_same<value_type,double>::value && MaxChannels==4)
+			{
+				const __m128d scaleRG = _mm_loadu_pd(scale);
+				const __m128d scaleBA = _mm_loadu_pd(scale+2);
+				__m128d sumRG = _mm_setzero_pd();
+				__m128d sumBA = _mm_setzero_pd();
+				for (int32_t h=0; h<windowSize; h++,samples+=MaxChannels,weights+=MaxChannels)
+				{
+					sumRG = _mm_add_pd(sumRG,_mm_mul_pd(_mm_mul_pd(_mm_loadu_pd(samples),_mm_loadu_pd(weights)),scaleRG));
+					sumBA = _mm_add_pd(sumBA,_mm_mul_pd(_mm_mul_pd(_mm_loadu_pd(samples+2),_mm_loadu_pd(weights+2)),scaleBA));
+				}
+				_mm_storeu_pd(value,sumRG);
+				_mm_storeu_pd(value+2,sumBA);
+			}
+			else
+#endif
+			{
+				std::fill(value,value+MaxChannels,value_type(0));
+				for (int32_t h=0; h<windowSize; h++,samples+=MaxChannels,weights+=MaxChannels)
+				for (auto c=0; c<MaxChannels; c++)
+					value[c] += samples[c]*weights[c]*scale[c];
+			}
+		}
+
 		// the blit filter will filter one axis at a time, hence necessitating "ping ponging" between two scratch buffers
 		static inline uint32_t getScratchOffset(const state_type* state, bool secondPong)
 		{
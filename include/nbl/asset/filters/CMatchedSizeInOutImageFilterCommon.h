@@ -128,6 +128,19 @@ class CMatchedSizeInOutImageFilterCommon : public CBasicImageFilterCommon
 		using state_type = CState;
 		
 		static inline bool validate(state_type* state)
+		{
+			if (!validateSubresourcesAndRanges(state))
+				return false;
+
+			// `commonExecute` writes texel by texel, filters which can encode blocks validate their outputs themselves
+			if (isBlockCompressionFormat(state->outImage->getCreationParameters().format))
+				return false;
+
+			return true;
+		}
+
+	protected:
+		static inline bool validateSubresourcesAndRanges(state_type* state)
 		{
 			if (!state)
 				return false;
@@ -142,14 +155,9 @@ class CMatchedSizeInOutImageFilterCommon : public CBasicImageFilterCommon
 			if (!CBasicImageFilterCommon::validateSubresourceAndRange(subresource,range,state->outImage))
 				return false;
 
-			// TODO: remove this later when we can actually write/encode to block formats
-			if (isBlockCompressionFormat(state->outImage->getCreationParameters().format))
-				return false;
-
 			return true;
 		}
 
-	protected:		
 		struct CommonExecuteData
 		{
 			const ICPUImage* const inImg;
@@ -200,7 +208,7 @@ class CMatchedSizeInOutImageFilterCommon : public CBasicImageFilterCommon
 			{
 				IImage::SSubresourceLayers subresource = {static_cast<IImage::E_ASPECT_FLAGS>(0u),state->inMipLevel,state->inBaseLayer,state->layerCount};
 				state_type::TexelRange range = {state->inOffset,state->extent};
-				CBasicImageFilterCommon::clip_region_functor_t clip(subresource,range,commonExecuteData.outFormat);
+				CBasicImageFilterCommon::clip_region_functor_t clip(subresource,range,commonExecuteData.inFormat);
 				// setup convert state
 				// I know my two's complement wraparound well enough to make this work
 				const auto& outRegionOffset = commonExecuteData.oit->imageOffset;
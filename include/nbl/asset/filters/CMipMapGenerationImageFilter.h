@@ -22,6 +22,8 @@ namespace asset
 // but iterative application of the filter will give you 2/originalResolution, 6/originalResolution, 14/originalResolution supports
 // the correct usage is to compute the first mip map with a 100% support kernel, then subsequent iterations with 50% smaller pixel supports
 // (actually in the case of using a Gaussian for both resampling and reconstruction, this is equivalent to using a single kernel of 3,3,5,9,..)
+// Block compressed images get their mip-maps computed in a temporary floating point image and only then encoded, so that the
+// compression error doesn't compound from one level to the next, the level before `startMipLevel` still needs to be decodable though.
 
 template<bool Normalize = false, bool Clamp = false, typename Swizzle = VoidSwizzle, typename Dither = IdentityDither, class ResamplingKernelX = CKaiserImageFilterKernel<>, class ReconstructionKernelX = CMitchellImageFilterKernel<>, class ResamplingKernelY = ResamplingKernelX, class ReconstructionKernelY = ReconstructionKernelX, class ResamplingKernelZ = ResamplingKernelY, class ReconstructionKernelZ = ReconstructionKernelY>
 class CMipMapGenerationImageFilter : public CImageFilter<CMipMapGenerationImageFilter<Normalize, Clamp, Swizzle, Dither, ResamplingKernelX, ReconstructionKernelX, ResamplingKernelY, ReconstructionKernelY, ResamplingKernelZ, ReconstructionKernelZ> >, public CBasicImageFilterCommon
@@ -70,9 +72,22 @@ class CMipMapGenerationImageFilter : public CImageFilter<CMipMapGenerationImageF
 			if (state->startMipLevel>=state->endMipLevel || state->endMipLevel>params.mipLevels)
 				return false;
 
-			// TODO: remove this later when we can actually write/encode to block formats
-			if (isBlockCompressionFormat(state->inOutImage->getCreationParameters().format))
-				return false;
+			if (isBlockCompressionFormat(params.format))
+			{
+				if (!isBlockCompressionEncodable(params.format))
+					return false;
+				// no CPU decoders for these yet
+				switch (params.format)
+				{
+					case EF_BC6H_UFLOAT_BLOCK:
+					case EF_BC6H_SFLOAT_BLOCK:
+					case EF_BC7_UNORM_BLOCK:
+					case EF_BC7_SRGB_BLOCK:
+						return false;
+					default:
+						break;
+				}
+			}
 			
 			for (auto inMipLevel=state->startMipLevel; inMipLevel!=state->endMipLevel; inMipLevel++)
 			{
@@ -84,32 +99,106 @@ class CMipMapGenerationImageFilter : public CImageFilter<CMipMapGenerationImageF
 		}
 
 		static inline bool execute(state_type* state)
+		{
+			return execute(std::execution::seq,state);
+		}
+
+		// every mip level depends on the previous one, so only the work within a level gets distributed according to the `policy`
+		template<class ExecutionPolicy>
+		static inline bool execute(ExecutionPolicy&& policy, state_type* state)
 		{
 			if (!validate(state))
 				return false;
 
+			if (isBlockCompressionFormat(state->inOutImage->getCreationParameters().format))
+				return executeBlockCompressed(policy,state);
+
 			for (auto inMipLevel=state->startMipLevel; inMipLevel!=state->endMipLevel; inMipLevel++)
 			{
 				auto blit = buildBlitState(state, inMipLevel);
-				if (!CBlitImageFilter<Normalize,Clamp,Swizzle,Dither,KernelX>::execute(&blit))
+				if (!CBlitImageFilter<Normalize,Clamp,Swizzle,Dither,KernelX>::execute(policy,&blit))
 					return false;
 			}
 			return true;
 		}
 
 	protected:
+		template<class ExecutionPolicy>
+		static inline bool executeBlockCompressed(ExecutionPolicy&& policy, state_type* state)
+		{
+			auto* const image = state->inOutImage;
+			const auto levelCount = state->endMipLevel-state->startMipLevel;
+
+			// mip level `i` of the temporary image corresponds to level `startMipLevel+i` of the output
+			constexpr auto TmpFormat = EF_R32G32B32A32_SFLOAT;
+			constexpr size_t TmpTexelSize = sizeof(float)*4ull;
+			ICPUImage::SCreationParams tmpParams = image->getCreationParameters();
+			tmpParams.flags = static_cast<IImage::E_CREATE_FLAGS>(0u);
+			tmpParams.format = TmpFormat;
+			const auto tmpExtent = image->getMipSize(state->startMipLevel);
+			tmpParams.extent = {tmpExtent.x,tmpExtent.y,tmpExtent.z};
+			tmpParams.mipLevels = levelCount;
+			tmpParams.arrayLayers = state->layerCount;
+
+			auto regions = core::make_refctd_dynamic_array<core::smart_refctd_dynamic_array<IImage::SBufferCopy>>(levelCount);
+			size_t bufferSize = 0ull;
+			for (uint32_t i=0u; i<levelCount; i++)
+			{
+				const auto mipSize = image->getMipSize(state->startMipLevel+i);
+				auto& region = regions->operator[](i);
+				region.bufferOffset = bufferSize;
+				region.bufferRowLength = 0u;
+				region.bufferImageHeight = 0u;
+				region.imageSubresource.aspectMask = static_cast<IImage::E_ASPECT_FLAGS>(0u);
+				region.imageSubresource.mipLevel = i;
+				region.imageSubresource.baseArrayLayer = 0u;
+				region.imageSubresource.layerCount = state->layerCount;
+				region.imageOffset = {0,0,0};
+				region.imageExtent = {mipSize.x,mipSize.y,mipSize.z};
+				bufferSize += size_t(mipSize.x)*mipSize.y*mipSize.z*state->layerCount*TmpTexelSize;
+			}
+			auto tmpImage = ICPUImage::create(std::move(tmpParams));
+			if (!tmpImage || !tmpImage->setBufferAndRegions(core::make_smart_refctd_ptr<ICPUBuffer>(bufferSize),regions))
+				return false;
+			const auto* const tmpData = reinterpret_cast<const uint8_t*>(tmpImage->getBuffer()->getPointer());
+
+			for (uint32_t i=0u; i<levelCount; i++)
+			{
+				auto blit = i ? buildBlitState(state,tmpImage.get(),i-1u,0u,tmpImage.get(),i,0u):buildBlitState(state,image,state->startMipLevel-1u,state->baseLayer,tmpImage.get(),0u,0u);
+				if (!CBlitImageFilter<Normalize,Clamp,Swizzle,Dither,KernelX>::execute(policy,&blit))
+					return false;
+
+				const auto& region = regions->operator[](i);
+				const core::vectorSIMDu32 extentLayerCount(region.imageExtent.width,region.imageExtent.height,region.imageExtent.depth,state->layerCount);
+				auto fetch = [&](const core::vectorSIMDu32& localPos, double* texel) -> void
+				{
+					const size_t index = ((size_t(localPos.w)*extentLayerCount.z+localPos.z)*extentLayerCount.y+localPos.y)*extentLayerCount.x+localPos.x;
+					const float* const src = reinterpret_cast<const float*>(tmpData+region.bufferOffset+index*TmpTexelSize);
+					std::copy(src,src+4,texel);
+				};
+				CBasicImageFilterCommon::encodeBlockCompressedRange(policy,image,state->startMipLevel+i,core::vectorSIMDu32(0u,0u,0u,state->baseLayer),extentLayerCount,fetch,state->compressionQuality);
+			}
+			return true;
+		}
+
 		static inline auto buildBlitState(const state_type* state, uint32_t inMipLevel)
 		{
-			const auto prevLevel = inMipLevel-1u;
+			return buildBlitState(state,state->inOutImage,inMipLevel-1u,state->baseLayer,state->inOutImage,inMipLevel,state->baseLayer);
+		}
 
+		static inline auto buildBlitState(	const state_type* state, ICPUImage* inImage, uint32_t inMipLevel, uint32_t inBaseLayer,
+											ICPUImage* outImage, uint32_t outMipLevel, uint32_t outBaseLayer)
+		{
 			typename CBlitImageFilter<Normalize,Clamp,Swizzle,Dither,KernelX>::state_type blit;
-			blit.inOffsetBaseLayer = blit.outOffsetBaseLayer = core::vectorSIMDu32(0, 0, 0, state->baseLayer);
-			blit.inExtentLayerCount = state->inOutImage->getMipSize(prevLevel);
-			blit.outExtentLayerCount = state->inOutImage->getMipSize(inMipLevel);
+			blit.inOffsetBaseLayer = core::vectorSIMDu32(0, 0, 0, inBaseLayer);
+			blit.outOffsetBaseLayer = core::vectorSIMDu32(0, 0, 0, outBaseLayer);
+			blit.inExtentLayerCount = inImage->getMipSize(inMipLevel);
+			blit.outExtentLayerCount = outImage->getMipSize(outMipLevel);
 			blit.inLayerCount = blit.outLayerCount = state->layerCount;
-			blit.inMipLevel = prevLevel;
-			blit.outMipLevel = inMipLevel;
-			blit.inImage = blit.outImage = state->inOutImage;
+			blit.inMipLevel = inMipLevel;
+			blit.outMipLevel = outMipLevel;
+			blit.inImage = inImage;
+			blit.outImage = outImage;
 			//not all kernels are default-constructible, this is going to be a problem (i already added appropriate ctor for blit filter state class though)
 			//blit.kernel = Kernel(); // gets default constructed, we should probably do a `static_assert` about this property
 			using state_base_t = typename CBlitImageFilterBase<typename KernelX::value_type, Normalize,Clamp,Swizzle,Dither>::CStateBase;
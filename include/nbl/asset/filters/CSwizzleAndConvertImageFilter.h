@@ -30,6 +30,8 @@ namespace impl
 				public:
 					CState() {}
 					virtual ~CState() {}
+
+					E_BLOCK_COMPRESSION_QUALITY compressionQuality = EBCQ_FAST;	//!< only used when the output image has a block compressed format
 			};
 
 			using state_type = CState;
@@ -39,15 +41,70 @@ namespace impl
 				if (!CSwizzleableAndDitherableFilterBase<Normalize, Clamp, Swizzle, Dither>::validate(state))
 					return false;
 
-				if (!CMatchedSizeInOutImageFilterCommon::validate(state))
+				if (!CMatchedSizeInOutImageFilterCommon::validateSubresourcesAndRanges(state))
 					return false;
 
-				// TODO: need to triple check it works when we finally enable this feature
 				if (isBlockCompressionFormat(state->outImage->getCreationParameters().format))
-					return false;
+					return CBasicImageFilterCommon::validateBlockCompressedOutput(state->outImage,state->outOffset);
 
 				return true;
 			}
+
+		protected:
+			//! Block compressed outputs get decoded and swizzled into a staging buffer first, then compressed a block at a time
+			/*
+				`decode(const void* srcPix[4], uint32_t blockX, uint32_t blockY, double* encodeBuffer)` has to decode and swizzle
+				a single input texel. There is no dithering, the encoder picks the quantization of the endpoints itself.
+			*/
+			template<typename Decode>
+			static inline bool executeBlockCompressed(state_type* state, Decode& decode)
+			{
+				const ICPUImage* const inImg = state->inImage;
+				const E_FORMAT inFormat = inImg->getCreationParameters().format;
+				const TexelBlockInfo inBlockInfo(inFormat);
+				const auto& blockDims = inBlockInfo.getDimension();
+				const uint8_t* const inData = reinterpret_cast<const uint8_t*>(inImg->getBuffer()->getPointer());
+
+				constexpr uint32_t MaxChannels = 4u;
+				const auto& extentLayerCount = state->extentLayerCount;
+				const size_t rowPitch = size_t(MaxChannels)*extentLayerCount.x;
+				const size_t slicePitch = rowPitch*extentLayerCount.y;
+				const size_t layerPitch = slicePitch*extentLayerCount.z;
+				core::vector<double> staging(layerPitch*extentLayerCount.w);
+				auto getStagedTexel = [&](const core::vectorSIMDu32& localPos) -> double*
+				{
+					return staging.data()+localPos.w*layerPitch+localPos.z*slicePitch+localPos.y*rowPitch+localPos.x*MaxChannels;
+				};
+
+				IImage::SSubresourceLayers subresource = {static_cast<IImage::E_ASPECT_FLAGS>(0u),state->inMipLevel,state->inBaseLayer,state->layerCount};
+				typename state_type::TexelRange range = {state->inOffset,state->extent};
+				CBasicImageFilterCommon::clip_region_functor_t clip(subresource,range,inFormat);
+				auto stage = [&](uint32_t readBlockArrayOffset, core::vectorSIMDu32 readBlockPos) -> void
+				{
+					constexpr auto MaxPlanes = 4;
+					const void* srcPix[MaxPlanes] = { inData+readBlockArrayOffset,nullptr,nullptr,nullptr };
+
+					for (auto blockY=0u; blockY<blockDims.y; blockY++)
+					for (auto blockX=0u; blockX<blockDims.x; blockX++)
+					{
+						// wraps around for texels of partially covered input blocks before the range
+						const auto localPos = readBlockPos*blockDims+core::vectorSIMDu32(blockX,blockY)-state->inOffsetBaseLayer;
+						if ((localPos>=extentLayerCount).any())
+							continue;
+						decode(srcPix,blockX,blockY,getStagedTexel(localPos));
+					}
+				};
+				const auto inRegions = inImg->getRegions(state->inMipLevel);
+				CBasicImageFilterCommon::executePerRegion(inImg,stage,inRegions.begin(),inRegions.end(),clip);
+
+				auto fetch = [&](const core::vectorSIMDu32& localPos, double* texel) -> void
+				{
+					const double* staged = getStagedTexel(localPos);
+					std::copy(staged,staged+MaxChannels,texel);
+				};
+				CBasicImageFilterCommon::encodeBlockCompressedRange(std::execution::seq,state->outImage,state->outMipLevel,state->outOffsetBaseLayer,extentLayerCount,fetch,state->compressionQuality);
+				return true;
+			}
 	};
 }
 
@@ -91,6 +148,16 @@ class CSwizzleAndConvertImageFilter : public CImageFilter<CSwizzleAndConvertImag
 
 			typedef std::conditional<asset::isIntegerFormat<inFormat>(), uint64_t, double>::type decodeBufferType;
 			typedef std::conditional<asset::isIntegerFormat<outFormat>(), uint64_t, double>::type encodeBufferType;
+
+			if constexpr (asset::isBlockCompressionFormat<outFormat>())
+			{
+				auto decode = [&state](const void* srcPix[4], uint32_t blockX, uint32_t blockY, double* encodeBuffer) -> void
+				{
+					decodeBufferType decodeBuffer[4] = {};
+					impl::CSwizzleAndConvertImageFilterBase<Normalize, Clamp, Swizzle, Dither>::onDecode<inFormat>(state, srcPix, decodeBuffer, encodeBuffer, blockX, blockY);
+				};
+				return impl::CSwizzleAndConvertImageFilterBase<Normalize, Clamp, Swizzle, Dither>::executeBlockCompressed(state, decode);
+			}
 			
 			auto perOutputRegion = [&blockDims,&state](const CMatchedSizeInOutImageFilterCommon::CommonExecuteData& commonExecuteData, CBasicImageFilterCommon::clip_region_functor_t& clip) -> bool
 			{
@@ -153,6 +220,17 @@ class CSwizzleAndConvertImageFilter<EF_UNKNOWN,EF_UNKNOWN,Swizzle,Normalize,Clam
 				assert(blockDims.z==1u);
 				assert(blockDims.w==1u);
 			#endif
+
+			if (asset::isBlockCompressionFormat(outFormat))
+			{
+				auto decode = [inFormat,&state](const void* srcPix[4], uint32_t blockX, uint32_t blockY, double* encodeBuffer) -> void
+				{
+					double decodeBuffer[4] = {};
+					impl::CSwizzleAndConvertImageFilterBase<Normalize, Clamp, Swizzle, Dither>::onDecode(inFormat, state, srcPix, decodeBuffer, encodeBuffer, blockX, blockY);
+				};
+				return impl::CSwizzleAndConvertImageFilterBase<Normalize, Clamp, Swizzle, Dither>::executeBlockCompressed(state, decode);
+			}
+
 			auto perOutputRegion = [&blockDims,inFormat,outFormat,outChannelsAmount,&state](const CMatchedSizeInOutImageFilterCommon::CommonExecuteData& commonExecuteData, CBasicImageFilterCommon::clip_region_functor_t& clip) -> bool
 			{
 				auto swizzle = [&commonExecuteData,&blockDims,inFormat,outFormat,outChannelsAmount,&state](uint32_t readBlockArrayOffset, core::vectorSIMDu32 readBlockPos)
@@ -220,6 +298,16 @@ class CSwizzleAndConvertImageFilter<EF_UNKNOWN,outFormat,Swizzle,Normalize,Clamp
 
 			typedef std::conditional<asset::isIntegerFormat<outFormat>(), uint64_t, double>::type encodeBufferType;
 
+			if constexpr (asset::isBlockCompressionFormat<outFormat>())
+			{
+				auto decode = [inFormat,&state](const void* srcPix[4], uint32_t blockX, uint32_t blockY, double* encodeBuffer) -> void
+				{
+					double decodeBuffer[4] = {};
+					impl::CSwizzleAndConvertImageFilterBase<Normalize, Clamp, Swizzle, Dither>::onDecode(inFormat, state, srcPix, decodeBuffer, encodeBuffer, blockX, blockY);
+				};
+				return impl::CSwizzleAndConvertImageFilterBase<Normalize, Clamp, Swizzle, Dither>::executeBlockCompressed(state, decode);
+			}
+
 			auto perOutputRegion = [&blockDims,inFormat,&state](const CMatchedSizeInOutImageFilterCommon::CommonExecuteData& commonExecuteData, CBasicImageFilterCommon::clip_region_functor_t& clip) -> bool
 			{
 				constexpr uint32_t outChannelsAmount = asset::getFormatChannelCount<outFormat>();
@@ -290,6 +378,16 @@ class CSwizzleAndConvertImageFilter<inFormat,EF_UNKNOWN,Swizzle,Normalize,Clamp,
 
 			typedef std::conditional<asset::isIntegerFormat<inFormat>(), uint64_t, double>::type decodeBufferType;
 
+			if (asset::isBlockCompressionFormat(outFormat))
+			{
+				auto decode = [&state](const void* srcPix[4], uint32_t blockX, uint32_t blockY, double* encodeBuffer) -> void
+				{
+					decodeBufferType decodeBuffer[4] = {};
+					impl::CSwizzleAndConvertImageFilterBase<Normalize, Clamp, Swizzle, Dither>::onDecode<inFormat>(state, srcPix, decodeBuffer, encodeBuffer, blockX, blockY);
+				};
+				return impl::CSwizzleAndConvertImageFilterBase<Normalize, Clamp, Swizzle, Dither>::executeBlockCompressed(state, decode);
+			}
+
 			auto perOutputRegion = [&blockDims,&outFormat,outChannelsAmount,&state](const CMatchedSizeInOutImageFilterCommon::CommonExecuteData& commonExecuteData, CBasicImageFilterCommon::clip_region_functor_t& clip) -> bool
 			{
 				const uint32_t outChannelsAmount = asset::getFormatChannelCount(outFormat);
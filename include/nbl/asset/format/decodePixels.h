@@ -1160,16 +1160,20 @@ namespace asset
 
             uint16_t r0, g0, b0, r1, g1, b1;
 
+            // BC1 endpoints have red in the most significant bits, so the B5G6R5 decode yields them in BGR order
             const void* input = &col.c0;
             decodePixels<asset::EF_B5G6R5_UNORM_PACK16, uint64_t>(&input, p[0].c, 0u, 0u);
+            std::swap(p[0].r, p[0].b);
 			r0 = static_cast<uint16_t>(p[0].r);
 			g0 = static_cast<uint16_t>(p[0].g);
 			b0 = static_cast<uint16_t>(p[0].b);
             input = &col.c1;
             decodePixels<asset::EF_B5G6R5_UNORM_PACK16, uint64_t>(&input, p[1].c, 0u, 0u);
+            std::swap(p[1].r, p[1].b);
 			r1 = static_cast<uint16_t>(p[1].r);
 			g1 = static_cast<uint16_t>(p[1].g);
 			b1 = static_cast<uint16_t>(p[1].b);
+            p[0].a = p[1].a = 0xff;
             if (col.c0 > col.c1)
             {
                 p[2].r = (2 * r0 + 1 * r1) / 3;
@@ -1256,10 +1260,46 @@ namespace asset
             else
             {
                 int lut = int(b.lut[3]) | int(b.lut[4] << 8) | int(b.lut[5] << 16);
-                int aw = 7 & (lut >> (3 * idx));
+                int aw = 7 & (lut >> (3 * (idx - 8u)));
                 _output[_offset] = a[aw];
             }
         }
+        // same as decodeBC4 but with two's complement endpoints, as used by the SNORM variants of BC4 and BC5
+        template<typename T>
+        inline void decodeBC4Signed(const void* _pix, T* _output, int _offset, uint32_t _x, uint32_t _y)
+        {
+            struct
+            {
+                int8_t a0, a1;
+                uint8_t lut[6];
+            } b;
+            int16_t a0, a1;
+            int8_t a[8];
+            memcpy(&b, _pix, sizeof(b));
+
+            // -128 is an alias of -127
+            a0 = core::max<int16_t>(b.a0, -127);
+            a1 = core::max<int16_t>(b.a1, -127);
+            a[0] = (int8_t)a0;
+            a[1] = (int8_t)a1;
+            if (a0 > a1)
+            {
+                for (int i = 1; i < 7; ++i)
+                    a[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+            }
+            else
+            {
+                for (int i = 1; i < 5; ++i)
+                    a[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+                a[6] = -127;
+                a[7] = 127;
+            }
+
+            const uint32_t idx = 4u*_y + _x;
+            const uint8_t* lut = b.lut + (idx < 8u ? 0 : 3);
+            const int bits = int(lut[0]) | int(lut[1] << 8) | int(lut[2] << 16);
+            _output[_offset] = a[7 & (bits >> (3 * (idx & 7u)))];
+        }
 
         // TODO: just template the core::srgb2lin and core::lin2srgb functions to work on vectors or something
         template<typename T>
@@ -1334,6 +1374,7 @@ namespace asset
         _output[0] /= 31.;
         _output[1] /= 63.;
         _output[2] /= 31.;
+        _output[3] /= 255.;
     }
 
     template<>
@@ -1367,7 +1408,7 @@ namespace asset
         memcpy(pix, _pix, sizeof(pix));
         pix[0] = reinterpret_cast<const uint8_t*>(pix[0])+8;
         decodePixels<asset::EF_BC1_RGBA_UNORM_BLOCK, double>(pix, _output, _x, _y);
-        impl::decodeBC4(_pix, _output, 3, _x, _y);
+        impl::decodeBC4(_pix[0], _output, 3, _x, _y);
         _output[3] /= 255.;
     }
 
@@ -1378,6 +1419,40 @@ namespace asset
         impl::SRGB2lin(_output);
     }
 
+    template<>
+    inline void decodePixels<asset::EF_BC4_UNORM_BLOCK, double>(const void* _pix[4], double* _output, uint32_t _x, uint32_t _y)
+    {
+        impl::decodeBC4(_pix[0], _output, 0, _x, _y);
+        _output[0] /= 255.;
+    }
+
+    template<>
+    inline void decodePixels<asset::EF_BC4_SNORM_BLOCK, double>(const void* _pix[4], double* _output, uint32_t _x, uint32_t _y)
+    {
+        impl::decodeBC4Signed(_pix[0], _output, 0, _x, _y);
+        _output[0] /= 127.;
+    }
+
+    template<>
+    inline void decodePixels<asset::EF_BC5_UNORM_BLOCK, double>(const void* _pix[4], double* _output, uint32_t _x, uint32_t _y)
+    {
+        const uint8_t* pix = reinterpret_cast<const uint8_t*>(_pix[0]);
+        impl::decodeBC4(pix, _output, 0, _x, _y);
+        impl::decodeBC4(pix+8, _output, 1, _x, _y);
+        _output[0] /= 255.;
+        _output[1] /= 255.;
+    }
+
+    template<>
+    inline void decodePixels<asset::EF_BC5_SNORM_BLOCK, double>(const void* _pix[4], double* _output, uint32_t _x, uint32_t _y)
+    {
+        const uint8_t* pix = reinterpret_cast<const uint8_t*>(_pix[0]);
+        impl::decodeBC4Signed(pix, _output, 0, _x, _y);
+        impl::decodeBC4Signed(pix+8, _output, 1, _x, _y);
+        _output[0] /= 127.;
+        _output[1] /= 127.;
+    }
+
     template<>
     inline void decodePixels<asset::EF_ASTC_4x4_UNORM_BLOCK, double>(const void* _pix[4], double* _output, uint32_t _x, uint32_t _y)
     {
@@ -1658,6 +1733,10 @@ namespace asset
             case asset::EF_BC2_SRGB_BLOCK: decodePixels<asset::EF_BC2_SRGB_BLOCK, double>(_pix, _output, _blockX, _blockY); return true;
             case asset::EF_BC3_UNORM_BLOCK: decodePixels<asset::EF_BC3_UNORM_BLOCK, double>(_pix, _output, _blockX, _blockY); return true;
             case asset::EF_BC3_SRGB_BLOCK: decodePixels<asset::EF_BC3_SRGB_BLOCK, double>(_pix, _output, _blockX, _blockY); return true;
+            case asset::EF_BC4_UNORM_BLOCK: decodePixels<asset::EF_BC4_UNORM_BLOCK, double>(_pix, _output, _blockX, _blockY); return true;
+            case asset::EF_BC4_SNORM_BLOCK: decodePixels<asset::EF_BC4_SNORM_BLOCK, double>(_pix, _output, _blockX, _blockY); return true;
+            case asset::EF_BC5_UNORM_BLOCK: decodePixels<asset::EF_BC5_UNORM_BLOCK, double>(_pix, _output, _blockX, _blockY); return true;
+            case asset::EF_BC5_SNORM_BLOCK: decodePixels<asset::EF_BC5_SNORM_BLOCK, double>(_pix, _output, _blockX, _blockY); return true;
             case asset::EF_G8_B8_R8_3PLANE_420_UNORM: decodePixels<asset::EF_G8_B8_R8_3PLANE_420_UNORM, double>(_pix, _output, _blockX, _blockY); return true;
             case asset::EF_G8_B8R8_2PLANE_420_UNORM: decodePixels<asset::EF_G8_B8R8_2PLANE_420_UNORM, double>(_pix, _output, _blockX, _blockY); return true;
             case asset::EF_G8_B8_R8_3PLANE_422_UNORM: decodePixels<asset::EF_G8_B8_R8_3PLANE_422_UNORM, double>(_pix, _output, _blockX, _blockY); return true;
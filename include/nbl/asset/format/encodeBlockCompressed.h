@@ -0,0 +1,46 @@
+// Copyright (C) 2018-2020 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+
+#ifndef __NBL_ASSET_ENCODE_BLOCK_COMPRESSED_H_INCLUDED__
+#define __NBL_ASSET_ENCODE_BLOCK_COMPRESSED_H_INCLUDED__
+
+#include <cstdint>
+
+#include "nbl/core/core.h"
+#include "nbl/asset/format/EFormat.h"
+
+namespace nbl
+{
+namespace asset
+{
+
+//! Trade-off between encoding speed and quality for the CPU block compressors
+enum E_BLOCK_COMPRESSION_QUALITY : uint8_t
+{
+	//! single principal-axis fit per block, BC7 only uses mode 6 and BC6H only mode 11
+	EBCQ_FAST = 0u,
+	//! least-squares endpoint refinement and a search over the modes (and BC7 partitions) the encoder knows about
+	EBCQ_HIGH
+};
+
+//! Whether `encodeBlockCompressed` can produce blocks of `_fmt`, currently all of BC1 to BC7
+bool isBlockCompressionEncodable(E_FORMAT _fmt);
+
+//! Compresses a single 4x4 block
+/**
+	`_texels` are 16 texels with 4 channels each, texel `x,y` of the block starts at `_texels[(4u*y+x)*4u]`.
+	The values follow the same conventions as the `double` overloads of `encodePixels`, so
+	they are normalized for UNORM and SNORM formats, linear for SRGB formats (the encoder applies the
+	transfer function) and unnormalized for BC6H. Channels a format doesn't have get ignored.
+
+	`_block` must point to `getTexelOrBlockBytesize(_fmt)` writable bytes.
+
+	@returns false if `_fmt` is not a format we can encode.
+*/
+bool encodeBlockCompressed(E_FORMAT _fmt, void* _block, const double* _texels, E_BLOCK_COMPRESSION_QUALITY _quality=EBCQ_FAST);
+
+}
+}
+
+#endif
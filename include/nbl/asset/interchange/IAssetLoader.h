@@ -9,6 +9,7 @@
 #include "IFileSystem.h"
 
 #include "nbl/asset/interchange/SAssetBundle.h"
+#include "nbl/asset/utils/CCPUBufferArena.h"
 #include "IReadFile.h"
 
 namespace nbl
@@ -83,6 +84,8 @@ public:
 		a way that it'll look correctly in right-handed camera system. If it isn't set, compatibility with 
 		left-handed coordinate camera is assumed.
 		E_LOADER_PARAMETER_FLAGS::ELPF_DONT_COMPILE_GLSL means that GLSL won't be compiled to SPIR-V if it is loaded or generated.
+		E_LOADER_PARAMETER_FLAGS::ELPF_ADOPT_MAPPED_FILES lets a loader hand out buffers which alias the memory mapping of the file (see `io::IReadFile::getMappedPointer`),
+		the mapping is read-only so the contents of such buffers must not be modified.
 	*/
 
 	enum E_LOADER_PARAMETER_FLAGS : uint64_t
@@ -90,7 +93,8 @@ public:
 		ELPF_NONE = 0,											//!< default value, it doesn't do anything
 		ELPF_RIGHT_HANDED_MESHES = 0x1,							//!< specifies that a mesh will be flipped in such a way that it'll look correctly in right-handed camera system
 		ELPF_DONT_COMPILE_GLSL = 0x2,							//!< it states that GLSL won't be compiled to SPIR-V if it is loaded or generated
-		ELPF_LOAD_METADATA_ONLY = 0x4							//!< it forces the loader to not load the entire scene for performance in special cases to fetch metadata.
+		ELPF_LOAD_METADATA_ONLY = 0x4,							//!< it forces the loader to not load the entire scene for performance in special cases to fetch metadata.
+		ELPF_ADOPT_MAPPED_FILES = 0x8							//!< loaders which can will make buffers point straight into memory mapped files instead of copying, such buffers must not be written to and keep the file open
 	};
 
     struct SAssetLoadParams
@@ -111,6 +115,10 @@ public:
 			loaderFlags(rhs.loaderFlags),
 			meshManipulatorOverride(rhs.meshManipulatorOverride),
 			restoreLevels(rhs.restoreLevels),
+			bufferArena(rhs.bufferArena),
+			imageBaseMipLevel(rhs.imageBaseMipLevel),
+			imageMipLevelCount(rhs.imageMipLevelCount),
+			workerThreadCount(rhs.workerThreadCount),
 			reload(_reload)
 		{
 		}
@@ -122,6 +130,12 @@ public:
         E_LOADER_PARAMETER_FLAGS loaderFlags;				//!< Flags having an impact on extraordinary tasks during loading process
 		IMeshManipulator* meshManipulatorOverride = nullptr;    //!< pointer used for specifying custom mesh manipulator to use, if nullptr - default mesh manipulator will be used
 		uint32_t restoreLevels = 0u;
+		CCPUBufferArena* bufferArena = nullptr;		//!< if not nullptr, loaders sub-allocate their ICPUBuffers from it, needs to stay alive only for the duration of the load
+		//! Image loaders which support it only load mip levels `[imageBaseMipLevel,imageBaseMipLevel+imageMipLevelCount)`, clamped to the levels in the file
+		/** The loaded image's extent is the one of `imageBaseMipLevel`, which becomes its mip level 0. Useful for texture streaming. */
+		uint32_t imageBaseMipLevel = 0u;
+		uint32_t imageMipLevelCount = ~0u;
+		uint32_t workerThreadCount = 0u;		//!< loaders which decode in parallel (like OpenEXR) use up to this many threads, 0 means `std::thread::hardware_concurrency()`
 		const bool reload = false;
     };
 
@@ -311,11 +325,23 @@ protected:
 	SAssetBundle interm_getAssetInHierarchy(IAssetManager* _mgr, io::IReadFile* _file, const std::string& _supposedFilename, const IAssetLoader::SAssetLoadParams& _params, uint32_t _hierarchyLevel);
 	SAssetBundle interm_getAssetInHierarchy(IAssetManager* _mgr, const std::string& _filename, const IAssetLoader::SAssetLoadParams& _params, uint32_t _hierarchyLevel);
 
+	//! Lets a loader fan out the loading of its dependencies to the asset manager's thread pool
+	/** Everything `_params` points to and `_override` must stay alive until the returned future is waited upon. */
+	core::CThreadPool::future_t<SAssetBundle> interm_getAssetInHierarchyAsync(IAssetManager* _mgr, const std::string& _filename, const IAssetLoader::SAssetLoadParams& _params, uint32_t _hierarchyLevel, IAssetLoader::IAssetLoaderOverride* _override);
+
 	SAssetBundle interm_getAssetInHierarchyWholeBundleRestore(IAssetManager* _mgr, io::IReadFile* _file, const std::string& _supposedFilename, const IAssetLoader::SAssetLoadParams& _params, uint32_t _hierarchyLevel, IAssetLoader::IAssetLoaderOverride* _override);
 	SAssetBundle interm_getAssetInHierarchyWholeBundleRestore(IAssetManager* _mgr, const std::string& _filename, const IAssetLoader::SAssetLoadParams& _params, uint32_t _hierarchyLevel, IAssetLoader::IAssetLoaderOverride* _override);
 	SAssetBundle interm_getAssetInHierarchyWholeBundleRestore(IAssetManager* _mgr, io::IReadFile* _file, const std::string& _supposedFilename, const IAssetLoader::SAssetLoadParams& _params, uint32_t _hierarchyLevel);
 	SAssetBundle interm_getAssetInHierarchyWholeBundleRestore(IAssetManager* _mgr, const std::string& _filename, const IAssetLoader::SAssetLoadParams& _params, uint32_t _hierarchyLevel);
 
+	//! Loaders should create the buffers they return through this, so they end up in `_params.bufferArena` when one was provided
+	static inline core::smart_refctd_ptr<ICPUBuffer> interm_createBuffer(const IAssetLoader::SAssetLoadParams& _params, size_t _sizeInBytes)
+	{
+		if (_params.bufferArena)
+			return _params.bufferArena->createBuffer(_sizeInBytes);
+		return core::make_smart_refctd_ptr<ICPUBuffer>(_sizeInBytes);
+	}
+
     void interm_setAssetMutability(const IAssetManager* _mgr, IAsset* _asset, IAsset::E_MUTABILITY _val);
 	//void interm_restoreDummyAsset(IAssetManager* _mgr, SAssetBundle& _bundle);
 	//void interm_restoreDummyAsset(IAssetManager* _mgr, IAsset* _asset, const std::string _path);
@@ -611,14 +611,43 @@ public:
 				auto texture = asset::ICPUVirtualTexture::createPoTPaddedSquareImageWithMipLevels(cm.image.get(), cm.uwrap, cm.vwrap, cm.border).first;
 				return vt->commit(cm.addr, texture.get(), cm.subresource, cm.uwrap, cm.vwrap, cm.border);
 			}
+			//! upper bound on the source texel data whose padded and mip-mapped copies `commitAll` keeps alive at once
+			_NBL_STATIC_INLINE_CONSTEXPR size_t CommitBatchByteBudget = 256ull<<20ull;
 			//! @returns if all commits succeeded
 			bool commitAll()
 			{
 				vt->shrink();
 
 				bool success = true;
-				for (commit_t& cm : pendingCommits)
-					success &= commit(cm);
+				// padding to PoT and generating the mips is independent per texture, and so are the page copies of the batched commit,
+				// but the padded copies are much larger than their sources so they're made and committed in bounded batches
+				core::vector<core::smart_refctd_ptr<asset::ICPUImage>> textures;
+				core::vector<asset::ICPUVirtualTexture::SCommitRequest> requests;
+				for (auto batchBegin=pendingCommits.begin(); batchBegin!=pendingCommits.end();)
+				{
+					auto batchEnd = batchBegin;
+					for (size_t batchBytes=0ull; batchEnd!=pendingCommits.end() && (batchEnd==batchBegin || batchBytes<CommitBatchByteBudget); batchEnd++)
+						batchBytes += batchEnd->image->getImageDataSizeInBytes();
+
+					textures.resize(std::distance(batchBegin,batchEnd));
+					std::transform(std::execution::par,batchBegin,batchEnd,textures.begin(),[](const commit_t& cm)
+					{
+						return asset::ICPUVirtualTexture::createPoTPaddedSquareImageWithMipLevels(cm.image.get(), cm.uwrap, cm.vwrap, cm.border).first;
+					});
+					requests.resize(textures.size());
+					for (size_t i=0ull; i<requests.size(); i++)
+					{
+						const commit_t& cm = batchBegin[i];
+						requests[i] = {cm.addr, textures[i].get(), cm.subresource, cm.uwrap, cm.vwrap, cm.border};
+					}
+					success = vt->commit(std::execution::par, requests.data(), requests.size()) && success;
+
+					// the pages are in the VT now, nothing needs the batch's images anymore
+					textures.clear();
+					for (auto it=batchBegin; it!=batchEnd; it++)
+						it->image = nullptr;
+					batchBegin = batchEnd;
+				}
 				pendingCommits.clear();
 				return success;
 			}
@@ -672,8 +701,10 @@ public:
 		core::unordered_set<instr_stream::E_OPCODE> opcodes;
 		core::unordered_set<instr_stream::E_NDF> NDFs;
 
-		//one element for each input IR root node
+		//one element for each input IR root node, structurally identical roots share the same streams
 		core::unordered_map<const IR::INode*, instr_streams_t> streams;
+		//number of roots which had their streams compiled, the rest are duplicates of those
+		uint32_t uniqueRootCount;
 
 		//has to go after #version and before required user-provided descriptors and functions
 		std::string fragmentShaderSource_declarations;
@@ -0,0 +1,239 @@
+// Copyright (C) 2018-2021 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+
+#ifndef __NBL_ASSET_C_ANIMATION_SAMPLER_H_INCLUDED__
+#define __NBL_ASSET_C_ANIMATION_SAMPLER_H_INCLUDED__
+
+#include <execution>
+
+#include "nbl/core/core.h"
+
+#include "nbl/asset/ICPUAnimationLibrary.h"
+
+namespace nbl
+{
+namespace asset
+{
+
+//! Evaluates animations of an ICPUAnimationLibrary on the CPU, the counterpart of `nbl/builtin/glsl/scene/keyframe.glsl`
+/**
+	Keyframes get decoded straight from the library's buffers, nothing is cached or converted up front.
+
+	Requests are processed four at a time, one per SIMD lane: after the timestamp search and the keyframe decode
+	(which are per request) the interpolation and the matrix construction run on all four at once.
+	Every interpolation mode is a weighted sum of (up to) four consecutive keyframes, so requests with different modes
+	can share a batch. Cubic interpolation is a uniform Catmull-Rom spline, linear interpolation uses `quaternion::flerp`
+	for the rotation like the GLSL does.
+
+	All methods are thread-safe, the library is only read.
+*/
+class CAnimationSampler
+{
+	public:
+		using animation_t = ICPUAnimationLibrary::animation_t;
+		using timestamp_t = ICPUAnimationLibrary::timestamp_t;
+
+		struct SRequest
+		{
+			animation_t animation;
+			timestamp_t timestamp;
+		};
+
+		//! Writes `scale`, then `rotation`, then `translation` applied to a vertex as a matrix for every request
+		/** Timestamps outside an animation clamp to its first or last keyframe, an animation without keyframes gives an identity matrix. */
+		template<class ExecutionPolicy>
+		static inline void sample(ExecutionPolicy&& policy, const ICPUAnimationLibrary* library, const SRequest* requests, const uint32_t count, core::matrix3x4SIMD* out)
+		{
+			core::vector<uint32_t> batches((count+BatchSize-1u)/BatchSize);
+			std::iota(batches.begin(),batches.end(),0u);
+			std::for_each(policy,batches.begin(),batches.end(),[&](const uint32_t batch) -> void
+			{
+				const uint32_t first = batch*BatchSize;
+				sampleBatch(library,requests+first,core::min(count-first,BatchSize),out+first);
+			});
+		}
+		//! Samples many animations at the same timestamp, for example all the joints of a skeleton
+		template<class ExecutionPolicy>
+		static inline void sample(ExecutionPolicy&& policy, const ICPUAnimationLibrary* library, const animation_t* animations, const uint32_t count, const timestamp_t timestamp, core::matrix3x4SIMD* out)
+		{
+			core::vector<uint32_t> batches((count+BatchSize-1u)/BatchSize);
+			std::iota(batches.begin(),batches.end(),0u);
+			std::for_each(policy,batches.begin(),batches.end(),[&](const uint32_t batch) -> void
+			{
+				const uint32_t first = batch*BatchSize;
+				const uint32_t batchCount = core::min(count-first,BatchSize);
+				SRequest requests[BatchSize];
+				for (uint32_t i=0u; i<batchCount; i++)
+					requests[i] = {animations[first+i],timestamp};
+				sampleBatch(library,requests,batchCount,out+first);
+			});
+		}
+		//!
+		static inline core::matrix3x4SIMD sample(const ICPUAnimationLibrary* library, const animation_t animation, const timestamp_t timestamp)
+		{
+			const SRequest request = {animation,timestamp};
+			core::matrix3x4SIMD retval;
+			sampleBatch(library,&request,1u,&retval);
+			return retval;
+		}
+
+	private:
+		_NBL_STATIC_INLINE_CONSTEXPR uint32_t BatchSize = 4u;
+		//! keyframe before the previous one, previous, next and the one after that
+		_NBL_STATIC_INLINE_CONSTEXPR uint32_t KeyframeSlots = 4u;
+
+		//! `count` is at most `BatchSize`, unused lanes get computed too but not written out
+		static inline void sampleBatch(const ICPUAnimationLibrary* library, const SRequest* requests, const uint32_t count, core::matrix3x4SIMD* out)
+		{
+			// decoded keyframes as [slot][component][lane], so every component of a slot loads as one vector
+			alignas(16) float translations[KeyframeSlots][3][BatchSize] = {};
+			alignas(16) float rotations[KeyframeSlots][4][BatchSize] = {};
+			alignas(16) float scales[KeyframeSlots][3][BatchSize] = {};
+			alignas(16) float weights[KeyframeSlots][BatchSize] = {};
+			alignas(16) float rotationWeights[KeyframeSlots][BatchSize] = {};
+			for (uint32_t lane=0u; lane<BatchSize; lane++)
+			{
+				uint32_t keyframes[KeyframeSlots];
+				float laneWeights[KeyframeSlots];
+				bool flerp;
+				if (lane>=count || !findKeyframes(library,requests[lane],keyframes,laneWeights,flerp))
+				{
+					// identity
+					rotations[1][3][lane] = 1.f;
+					scales[1][0][lane] = scales[1][1][lane] = scales[1][2][lane] = 1.f;
+					weights[1][lane] = rotationWeights[1][lane] = 1.f;
+					continue;
+				}
+
+				core::vectorSIMDf laneRotations[KeyframeSlots];
+				for (uint32_t slot=0u; slot<KeyframeSlots; slot++)
+				{
+					const auto& keyframe = library->getKeyframe(keyframes[slot]);
+					const auto translation = keyframe.getTranslation();
+					const auto scale = keyframe.getScale();
+					const auto rotation = keyframe.getRotation();
+					laneRotations[slot] = reinterpret_cast<const core::vectorSIMDf&>(rotation);
+					for (uint32_t i=0u; i<3u; i++)
+					{
+						translations[slot][i][lane] = translation.pointer[i];
+						scales[slot][i][lane] = scale.pointer[i];
+					}
+					weights[slot][lane] = rotationWeights[slot][lane] = laneWeights[slot];
+				}
+				for (uint32_t slot=0u; slot<KeyframeSlots; slot++)
+				{
+					// q and -q are the same rotation, blend with the ones on the same side of the 4D sphere as the previous keyframe
+					if (core::dot<core::vectorSIMDf>(laneRotations[slot],laneRotations[1u]).x<0.f)
+						laneRotations[slot] = -laneRotations[slot];
+					for (uint32_t i=0u; i<4u; i++)
+						rotations[slot][i][lane] = laneRotations[slot].pointer[i];
+				}
+				if (flerp)
+				{
+					const float angle = core::dot<core::vectorSIMDf>(laneRotations[1],laneRotations[2]).x;
+					const float fraction = laneWeights[2];
+					const float adjusted = core::quaternion::flerp_adjustedinterpolant(core::abs(angle),fraction,(fraction-0.5f)*(fraction-0.5f),fraction*(fraction-0.5f)*(fraction-1.f));
+					rotationWeights[1][lane] = 1.f-adjusted;
+					rotationWeights[2][lane] = adjusted;
+				}
+			}
+
+			// the weighted sums, for all four requests at once
+			core::vectorSIMDf translation[3],rotation[4],scale[3];
+			for (uint32_t slot=0u; slot<KeyframeSlots; slot++)
+			{
+				const core::vectorSIMDf weight(weights[slot],true);
+				const core::vectorSIMDf rotationWeight(rotationWeights[slot],true);
+				for (uint32_t i=0u; i<3u; i++)
+				{
+					translation[i] += core::vectorSIMDf(translations[slot][i],true)*weight;
+					scale[i] += core::vectorSIMDf(scales[slot][i],true)*weight;
+				}
+				for (uint32_t i=0u; i<4u; i++)
+					rotation[i] += core::vectorSIMDf(rotations[slot][i],true)*rotationWeight;
+			}
+			{
+				const core::vectorSIMDf rcpLen = core::inversesqrt(rotation[0]*rotation[0]+rotation[1]*rotation[1]+rotation[2]*rotation[2]+rotation[3]*rotation[3]);
+				for (uint32_t i=0u; i<4u; i++)
+					rotation[i] *= rcpLen;
+			}
+
+			// same as `matrix3x4SIMD::setScaleRotationAndTranslation`, but for four transforms at once
+			const auto& x = rotation[0];
+			const auto& y = rotation[1];
+			const auto& z = rotation[2];
+			const auto& w = rotation[3];
+			const core::vectorSIMDf one(1.f),two(2.f);
+			const core::vectorSIMDf matrix[3][3] = {
+				{one-two*(y*y+z*z),two*(x*y-w*z),two*(x*z+w*y)},
+				{two*(x*y+w*z),one-two*(x*x+z*z),two*(y*z-w*x)},
+				{two*(x*z-w*y),two*(y*z+w*x),one-two*(x*x+y*y)}
+			};
+			for (uint32_t lane=0u; lane<count; lane++)
+			for (uint32_t row=0u; row<3u; row++)
+			{
+				auto& outRow = out[lane].rows[row];
+				for (uint32_t column=0u; column<3u; column++)
+					outRow.pointer[column] = matrix[row][column].pointer[lane]*scale[column].pointer[lane];
+				outRow.pointer[3] = translation[row].pointer[lane];
+			}
+		}
+
+		//! Binary searches the timestamps and works out the keyframes and their weights for the interpolation mode
+		/**
+		@param[out] flerp Whether the rotation should be interpolated with `flerp`, then slots 1 and 2 are the keyframes and the weight of slot 2 is the fraction.
+		@returns False if the animation has no keyframes.
+		*/
+		static inline bool findKeyframes(const ICPUAnimationLibrary* library, const SRequest& request, uint32_t* keyframes, float* weights, bool& flerp)
+		{
+			using Animation = ICPUAnimationLibrary::Animation;
+
+			const auto& animation = library->getAnimation(request.animation);
+			const uint32_t offset = animation.getKeyframeOffset();
+			const uint32_t keyframeCount = animation.getKeyframeCount();
+			if (keyframeCount==0u)
+				return false;
+
+			const timestamp_t* timestamps = &library->getTimestamp(animation.getTimestampOffset());
+			const uint32_t next = std::upper_bound(timestamps,timestamps+keyframeCount,request.timestamp)-timestamps;
+			const uint32_t prev = next ? (next-1u):0u;
+			const uint32_t clampedNext = core::min(next,keyframeCount-1u);
+			const float fraction = prev!=clampedNext ? float(request.timestamp-timestamps[prev])/float(timestamps[clampedNext]-timestamps[prev]):0.f;
+
+			keyframes[0] = offset+(prev ? (prev-1u):prev);
+			keyframes[1] = offset+prev;
+			keyframes[2] = offset+clampedNext;
+			keyframes[3] = offset+core::min(clampedNext+1u,keyframeCount-1u);
+			std::fill_n(weights,KeyframeSlots,0.f);
+			flerp = false;
+			switch (animation.getInterpolationMode())
+			{
+				case Animation::EIM_NEAREST:
+					weights[fraction<0.5f ? 1:2] = 1.f;
+					break;
+				case Animation::EIM_CUBIC:
+				{
+					// uniform Catmull-Rom
+					const float fraction2 = fraction*fraction;
+					const float fraction3 = fraction2*fraction;
+					weights[0] = 0.5f*(-fraction3+2.f*fraction2-fraction);
+					weights[1] = 0.5f*(3.f*fraction3-5.f*fraction2+2.f);
+					weights[2] = 0.5f*(-3.f*fraction3+4.f*fraction2+fraction);
+					weights[3] = 0.5f*(fraction3-fraction2);
+					break;
+				}
+				default:
+					weights[1] = 1.f-fraction;
+					weights[2] = fraction;
+					flerp = true;
+					break;
+			}
+			return true;
+		}
+};
+
+}
+}
+
+#endif
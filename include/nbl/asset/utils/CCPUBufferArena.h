@@ -0,0 +1,152 @@
+// Copyright (C) 2018-2021 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+
+#ifndef __NBL_ASSET_C_CPU_BUFFER_ARENA_H_INCLUDED__
+#define __NBL_ASSET_C_CPU_BUFFER_ARENA_H_INCLUDED__
+
+#include <mutex>
+
+#include "nbl/core/core.h"
+#include "nbl/core/alloc/LinearAddressAllocator.h"
+#include "nbl/core/alloc/SimpleBlockBasedAllocator.h"
+
+#include "nbl/asset/ICPUBuffer.h"
+
+namespace nbl
+{
+namespace asset
+{
+
+//! Sub-allocates ICPUBuffers out of a few large blocks, instead of doing one heap allocation per buffer
+/**
+	Meant to be passed to loaders via `IAssetLoader::SAssetLoadParams::bufferArena` when loading files with lots of small meshes.
+
+	Memory is never reclaimed piecemeal, every buffer created from the arena holds a reference to it (until it's converted
+	to a dummy or destroyed) and all the blocks get freed at once when the arena and the last of its buffers die.
+	So you can drop your own reference right after the load, the arena will live exactly as long as the loaded bundle.
+
+	Buffers larger than a quarter of a block still get their own allocation, so a few huge buffers don't waste block space.
+	All methods are thread-safe.
+*/
+class CCPUBufferArena : public core::IReferenceCounted
+{
+	public:
+		_NBL_STATIC_INLINE_CONSTEXPR uint32_t DefaultBlockSize = 0x1u<<22u;
+		_NBL_STATIC_INLINE_CONSTEXPR uint32_t DefaultMaxBlockCount = 1024u;
+
+		//! Allocator handed to CCustomAllocatorCPUBuffer, keeps the arena alive until the buffer's memory gets "freed"
+		class allocator;
+
+		CCPUBufferArena(const uint32_t blockSize=DefaultBlockSize, const uint32_t maxBlockCount=DefaultMaxBlockCount) :
+			m_blocks(blockSize,maxBlockCount), m_blockSize(blockSize) {}
+
+		//! Uninitialized buffer of `sizeInBytes` with the usual `_NBL_SIMD_ALIGNMENT`
+		inline core::smart_refctd_ptr<ICPUBuffer> createBuffer(const size_t sizeInBytes);
+
+		//! Number of buffers sub-allocated from the blocks
+		inline uint32_t getArenaAllocationCount() const
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			return m_arenaAllocationCount;
+		}
+		//! Number of buffers which were too large (or didn't fit anymore) and got allocated on the heap on their own
+		inline uint32_t getFallbackAllocationCount() const
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			return m_fallbackAllocationCount;
+		}
+		//! Heap allocations made for the blocks, compare against `getArenaAllocationCount()`
+		inline uint32_t getBlockCount() const
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			return m_blocks.getBlockCount();
+		}
+		//! Bytes handed out to buffers, including the alignment padding
+		inline size_t getAllocatedSize() const
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			return m_allocatedSize;
+		}
+		//! Bytes reserved by the blocks
+		inline size_t getReservedSize() const
+		{
+			return size_t(getBlockCount())*m_blockSize;
+		}
+
+	protected:
+		virtual ~CCPUBufferArena() = default;
+
+		inline void* allocate(const size_t sizeInBytes)
+		{
+			const size_t paddedSize = core::roundUp<size_t>(sizeInBytes,_NBL_SIMD_ALIGNMENT);
+			std::unique_lock<std::mutex> lock(m_mutex);
+			void* retval = m_blocks.allocate(paddedSize,_NBL_SIMD_ALIGNMENT);
+			if (retval)
+			{
+				m_arenaAllocationCount++;
+				m_allocatedSize += paddedSize;
+			}
+			return retval;
+		}
+
+		class block_allocator_t : public core::SimpleBlockBasedAllocator<core::LinearAddressAllocator<uint32_t>,core::aligned_allocator>
+		{
+				using base_t = core::SimpleBlockBasedAllocator<core::LinearAddressAllocator<uint32_t>,core::aligned_allocator>;
+			public:
+				using base_t::base_t;
+
+				inline uint32_t getBlockCount() const
+				{
+					return std::count_if(blocks,blocks+maxBlockCount,[](const auto* block){return block!=nullptr;});
+				}
+		};
+		block_allocator_t m_blocks;
+		const uint32_t m_blockSize;
+
+		mutable std::mutex m_mutex;
+		uint32_t m_arenaAllocationCount = 0u;
+		uint32_t m_fallbackAllocationCount = 0u;
+		size_t m_allocatedSize = 0ull;
+};
+
+class CCPUBufferArena::allocator
+{
+	public:
+		using value_type = uint8_t;
+		using pointer = uint8_t*;
+
+		allocator(CCPUBufferArena* _arena) : arena(_arena) {}
+
+		inline pointer allocate(size_t n)
+		{
+			return reinterpret_cast<pointer>(arena->allocate(n));
+		}
+		//! the memory is only reclaimed with the whole arena
+		inline void deallocate(pointer, size_t)
+		{
+			arena = nullptr;
+		}
+
+	private:
+		core::smart_refctd_ptr<CCPUBufferArena> arena;
+};
+
+inline core::smart_refctd_ptr<ICPUBuffer> CCPUBufferArena::createBuffer(const size_t sizeInBytes)
+{
+	void* data = nullptr;
+	if (sizeInBytes<=m_blockSize/4u)
+		data = allocate(sizeInBytes);
+	if (!data)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_fallbackAllocationCount++;
+		return core::make_smart_refctd_ptr<ICPUBuffer>(sizeInBytes);
+	}
+	return core::make_smart_refctd_ptr<CCustomAllocatorCPUBuffer<allocator>>(sizeInBytes,data,core::adopt_memory,allocator(this));
+}
+
+}
+}
+
+#endif
@@ -70,6 +70,8 @@ class CCPUMeshPackerV1 final : public IMeshPacker<ICPUMeshBuffer, MDIStructType>
 	using base_t = IMeshPacker<ICPUMeshBuffer, MDIStructType>;
 	using Triangle = typename base_t::Triangle;
 	using TriangleBatch = typename base_t::TriangleBatch;
+	using TriangleBatches = typename base_t::TriangleBatches;
+	using VertexRemap = typename base_t::VertexRemap;
 
 public:
 	struct AllocationParams : IMeshPackerBase::AllocationParamsCommon
@@ -455,11 +457,13 @@ IMeshPackerBase::PackedMeshBufferData CCPUMeshPackerV1<MDIStructType>::commit(co
 	for (auto it = mbBegin; it != mbEnd; it++)
 	{
 		const size_t idxCnt = (*it)->getIndexCount();
-		core::vector<TriangleBatch> triangleBatches = constructTriangleBatches(*it);
+		const TriangleBatches triangleBatches = constructTriangleBatches(*it);
+		VertexRemap vertexRemap(triangleBatches.vertexIDUpperBound);
 
-		for (TriangleBatch& batch : triangleBatches)
+		for (uint32_t batchIx = 0u; batchIx < triangleBatches.getBatchCount(); batchIx++)
 		{
-			core::unordered_map<uint32_t, uint16_t> usedVertices = constructNewIndicesFromTriangleBatch(batch, indexBuffPtr);
+			const TriangleBatch batch = triangleBatches.getBatch(batchIx);
+			constructNewIndicesFromTriangleBatch(batch, indexBuffPtr, vertexRemap);
 
 			//copy deinterleaved vertices into unified vertex buffer
 			for (uint16_t attrBit = 0x0001, location = 0; location < SVertexInputParams::MAX_ATTR_BUF_BINDING_COUNT; attrBit <<= 1, location++)
@@ -473,14 +477,14 @@ IMeshPackerBase::PackedMeshBufferData CCPUMeshPackerV1<MDIStructType>::commit(co
 				const size_t attrSize = asset::getTexelOrBlockBytesize(static_cast<E_FORMAT>(attrib.format));
 				dstAttrPtr += (ramb.vertexAllocationOffset + verticesAddedToUnifiedBufferCnt) * attrSize;
 
-				deinterleaveAndCopyAttribute(*it, location, usedVertices, dstAttrPtr);
+				deinterleaveAndCopyAttribute(*it, location, vertexRemap, dstAttrPtr);
 			}
 
-			verticesAddedToUnifiedBufferCnt += usedVertices.size();
+			verticesAddedToUnifiedBufferCnt += vertexRemap.usedVertices.size();
 
 			//construct mdi data
 			MDIStructType MDIData;
-			MDIData.count = batch.triangles.size() * 3;
+			MDIData.count = batch.size() * 3;
 			MDIData.instanceCount = (*it)->getInstanceCount();
 			MDIData.firstIndex = batchFirstIdx;
 			MDIData.baseVertex = batchBaseVtx; //possible overflow?
@@ -490,8 +494,8 @@ IMeshPackerBase::PackedMeshBufferData CCPUMeshPackerV1<MDIStructType>::commit(co
 			mdiBuffPtr++;
 			MDIStructsAddedCnt++;
 
-			batchFirstIdx += 3 * batch.triangles.size();
-			batchBaseVtx += usedVertices.size();
+			batchFirstIdx += 3 * batch.size();
+			batchBaseVtx += vertexRemap.usedVertices.size();
 		}
 	}
 
@@ -8,6 +8,8 @@
 
 #include <iostream>
 #include <limits>
+#include <shared_mutex>
+#include <execution>
 
 
 #include "parallel-hashmap/parallel_hashmap/phmap_dump.h"
@@ -267,6 +269,7 @@ class CDirQuantCacheBase : public impl::CDirQuantCacheBase
 		template<E_FORMAT CacheFormat>
 		inline void insertIntoCache(const Key& key, const value_type_t<CacheFormat>& value)
 		{
+			std::unique_lock lock(cacheMutex);
 			std::get<cache_type_t<CacheFormat>>(cache).insert(std::make_pair(key,value));		
 		}
 
@@ -278,6 +281,7 @@ class CDirQuantCacheBase : public impl::CDirQuantCacheBase
 			if (!validateSerializedCache<CacheFormat>(buffer))
 				return false;
 
+			std::unique_lock lock(cacheMutex);
 			auto& particularCache = std::get<cache_type_t<CacheFormat>>(cache);
 			cache_type_t<CacheFormat> backup;
 			if (!replaceCurrentContents)
@@ -327,6 +331,7 @@ class CDirQuantCacheBase : public impl::CDirQuantCacheBase
 			if (bufferSize+offset>getSerializedCacheSizeInBytes<CacheFormat>())
 				return false;
 
+			std::shared_lock lock(cacheMutex);
 			CBufferPhmapOutputArchive buffWrap(buffer);
 			return std::get<cache_type_t<CacheFormat>>(cache).dump(buffWrap);
 		}
@@ -364,114 +369,232 @@ class CDirQuantCacheBase : public impl::CDirQuantCacheBase
 
 	protected:
 		std::tuple<cache_type_t<Formats>...> cache;
+		//! lookups share the lock, so only inserting the misses serializes threads
+		std::shared_mutex cacheMutex;
 		
 		template<uint32_t dimensions, E_FORMAT CacheFormat>
 		value_type_t<CacheFormat> quantize(const core::vectorSIMDf& value)
 		{
-			const auto negativeMask = value < core::vectorSIMDf(0.0f);
-
 			const core::vectorSIMDf absValue = abs(value);
 			const auto key = Key(absValue);
 
-			constexpr auto quantizationBits = quantization_bits_v<CacheFormat>;
 			value_type_t<CacheFormat> quantized;
+			bool found;
 			{
-				auto& particularCache = std::get<cache_type_t<CacheFormat>>(cache);
-				auto found = particularCache.find(key);
-				if (found != particularCache.end() && (found->first == key))
-					quantized = found->second;
-				else
+				std::shared_lock lock(cacheMutex);
+				const auto& particularCache = std::get<cache_type_t<CacheFormat>>(cache);
+				auto foundIt = particularCache.find(key);
+				found = foundIt!=particularCache.end() && (foundIt->first == key);
+				if (found)
+					quantized = foundIt->second;
+			}
+			if (!found)
+			{
+				const core::vectorSIMDf fit = findBestFit<dimensions,quantization_bits_v<CacheFormat>>(absValue);
+
+				quantized = core::vectorSIMDu32(core::abs(fit));
+				insertIntoCache<CacheFormat>(key,quantized);
+			}
+
+			return restoreSigns<CacheFormat>(quantized,value);
+		}
+
+		//! Quantizes `count` directions (`getValue(i)` returns the i-th) into `out`
+		/**
+			All cache lookups happen at once and the best fit searches for the unique misses get spread across threads by `policy`,
+			then the new entries get merged into the cache in one go. Safe to call concurrently with any other quantization.
+		*/
+		template<uint32_t dimensions, E_FORMAT CacheFormat, class ExecutionPolicy, typename F>
+		void quantize(ExecutionPolicy&& policy, const size_t count, F&& getValue, value_type_t<CacheFormat>* out)
+		{
+			core::vector<core::vectorSIMDf> values(count);
+			core::vector<value_type_t<CacheFormat>> quantized(count);
+			// index of the unique miss which holds the value, or ~0u if the cache had it
+			core::vector<uint32_t> missIx(count);
+			{
+				std::shared_lock lock(cacheMutex);
+				const auto& particularCache = std::get<cache_type_t<CacheFormat>>(cache);
+				std::for_each(policy,missIx.begin(),missIx.end(),[&](uint32_t& miss) -> void
 				{
-					const core::vectorSIMDf fit = findBestFit<dimensions,quantizationBits>(absValue);
+					const size_t i = &miss-missIx.data();
+					values[i] = getValue(i);
+					const auto key = Key(abs(values[i]));
+					auto foundIt = particularCache.find(key);
+					if (foundIt!=particularCache.end() && (foundIt->first == key))
+					{
+						quantized[i] = foundIt->second;
+						miss = ~0u;
+					}
+					else
+						miss = 0u;
+				});
+			}
 
-					quantized = core::vectorSIMDu32(core::abs(fit));
-					insertIntoCache<CacheFormat>(key,quantized);
-				}
+			// the same direction tends to repeat a lot, so only search for the best fit once per key
+			core::unordered_map<Key,uint32_t,Hash> uniqueMisses;
+			core::vector<size_t> uniqueMissValues;
+			for (size_t i=0u; i<count; i++)
+			if (missIx[i]!=~0u)
+			{
+				auto inserted = uniqueMisses.emplace(Key(abs(values[i])),static_cast<uint32_t>(uniqueMissValues.size()));
+				if (inserted.second)
+					uniqueMissValues.push_back(i);
+				missIx[i] = inserted.first->second;
+			}
+			if (uniqueMissValues.empty())
+			{
+				std::transform(policy,quantized.begin(),quantized.end(),values.begin(),out,restoreSigns<CacheFormat>);
+				return;
+			}
+
+			core::vector<value_type_t<CacheFormat>> fits(uniqueMissValues.size());
+			std::for_each(policy,fits.begin(),fits.end(),[&](value_type_t<CacheFormat>& fit) -> void
+			{
+				const core::vectorSIMDf absValue = abs(values[uniqueMissValues[&fit-fits.data()]]);
+				fit = core::vectorSIMDu32(core::abs(findBestFit<dimensions,quantization_bits_v<CacheFormat>>(absValue)));
+			});
+			{
+				std::unique_lock lock(cacheMutex);
+				auto& particularCache = std::get<cache_type_t<CacheFormat>>(cache);
+				for (const auto& miss : uniqueMisses)
+					particularCache.insert(std::make_pair(miss.first,fits[miss.second]));
 			}
 
+			std::for_each(policy,missIx.begin(),missIx.end(),[&](const uint32_t& miss) -> void
+			{
+				const size_t i = &miss-missIx.data();
+				out[i] = restoreSigns<CacheFormat>(miss!=~0u ? fits[miss]:quantized[i],values[i]);
+			});
+		}
+
+		//! turns the quantized absolute value back into a signed one with the signs of `value`
+		template<E_FORMAT CacheFormat>
+		static inline value_type_t<CacheFormat> restoreSigns(const value_type_t<CacheFormat>& quantized, const core::vectorSIMDf& value)
+		{
+			const auto negativeMask = value < core::vectorSIMDf(0.0f);
+
+			constexpr auto quantizationBits = quantization_bits_v<CacheFormat>;
 			const core::vectorSIMDu32 xorflag((0x1u<<(quantizationBits+1u))-1u);
 			auto restoredAsVec = quantized.getValue()^core::mix(core::vectorSIMDu32(0u),xorflag,negativeMask);
 			restoredAsVec += core::mix(core::vectorSIMDu32(0u),core::vectorSIMDu32(1u),negativeMask);
 			return value_type_t<CacheFormat>(restoredAsVec&xorflag);
 		}
 
+		//! Finds the integer vector with components no bigger than `2^quantizationBits-1` closest in angle to `value`
+		/**
+			Goes through every scale `n` the largest component can have, the other components can only be the floor or ceiling of their scaled value.
+			The candidates get compared by their sine squared in double precision (Lagrange's identity keeps it precise for tiny angles).
+
+			Most scales get rejected without looking at their candidates: if `r` is the largest distance of a scaled
+			component to an integer, no candidate at that scale can have a sine smaller than `r/(sqrt(2)*(n*|fit|+sqrt(D-1)))`.
+			Once a good fit is found that rejects nearly everything, so it's many times faster than checking all candidates.
+		*/
 		template<uint32_t dimensions, uint32_t quantizationBits>
 		static inline core::vectorSIMDf findBestFit(const core::vectorSIMDf& value)
 		{
 			static_assert(dimensions>1u,"No point");
 			static_assert(dimensions<=4u,"High Dimensions are Hard!");
-			// precise normalize
-			const auto vectorForDots = value.preciseDivision(length(value));
 
+			uint32_t maxDirCompIndex = 0u;
+			for (auto i=1u; i<dimensions; i++)
+			if (value[i]>value[maxDirCompIndex])
+				maxDirCompIndex = i;
 			//
-			core::vectorSIMDf fittingVector;
-			core::vectorSIMDf floorOffset;
-			constexpr uint32_t cornerCount = (0x1u<<(dimensions-1u))-1u;
-			core::vectorSIMDf corners[cornerCount] = {};
+			const float maxDirectionComp = value[maxDirCompIndex];
+			//max component of 3d normal cannot be less than sqrt(1/D)
+			if (maxDirectionComp <= std::sqrtf(1.f/float(dimensions)))
 			{
-				uint32_t maxDirCompIndex = 0u;
-				for (auto i=1u; i<dimensions; i++)
-				if (value[i]>value[maxDirCompIndex])
-					maxDirCompIndex = i;
-				//
-				const float maxDirectionComp = value[maxDirCompIndex];
-				//max component of 3d normal cannot be less than sqrt(1/D)
-				if (maxDirectionComp <= std::sqrtf(1.f/float(dimensions)))
-				{
-					_NBL_DEBUG_BREAK_IF(true);
-					return core::vectorSIMDf(0.f);
-				}
-				fittingVector = value.preciseDivision(core::vectorSIMDf(maxDirectionComp));
-				floorOffset[maxDirCompIndex] = 0.499f;
-				const uint32_t localCorner[7][3] = {
-					{1,0,0},
-					{0,1,0},
-					{1,1,0},
-					{0,0,1},
-					{1,0,1},
-					{0,1,1},
-					{1,1,1}
-				};
-				for (auto corn=0u; corn<cornerCount; corn++)
+				_NBL_DEBUG_BREAK_IF(true);
+				return core::vectorSIMDf(0.f);
+			}
+
+			// precise normalize
+			double direction[dimensions];
+			double fittingVector[dimensions];
+			double fittingVectorLen = 0.0;
+			{
+				double len = 0.0;
+				for (auto i=0u; i<dimensions; i++)
+					len += double(value[i])*double(value[i]);
+				len = std::sqrt(len);
+				for (auto i=0u; i<dimensions; i++)
 				{
-					const auto* coordIt = localCorner[corn];
-					for (auto i=0; i<dimensions; i++)
-					if (i!=maxDirCompIndex)
-						corners[corn][i] = *(coordIt++);
+					direction[i] = double(value[i])/len;
+					fittingVector[i] = double(value[i])/double(maxDirectionComp);
+					fittingVectorLen += fittingVector[i]*fittingVector[i];
 				}
+				fittingVectorLen = std::sqrt(fittingVectorLen);
 			}
-
-			core::vectorSIMDf bestFit;
-			float closestTo1 = -1.f;
-			auto evaluateFit = [&](const core::vectorSIMDf& newFit) -> void
+			auto sineSquared = [&direction](const double* candidate) -> double
 			{
-				auto newFitLen = core::length(newFit);
-				const float dp = core::dot<core::vectorSIMDf>(newFit,vectorForDots).preciseDivision(newFitLen)[0];
-				if (dp > closestTo1)
+				double cross = 0.0, lenSq = 0.0;
+				for (auto i=0u; i<dimensions; i++)
 				{
-					closestTo1 = dp;
-					bestFit = newFit;
+					lenSq += candidate[i]*candidate[i];
+					for (auto j=i+1u; j<dimensions; j++)
+					{
+						const double tmp = candidate[i]*direction[j]-candidate[j]*direction[i];
+						cross += tmp*tmp;
+					}
 				}
+				return cross/lenSq;
 			};
 
 			constexpr uint32_t cubeHalfSize = (0x1u << quantizationBits) - 1u;
-			const core::vectorSIMDf cubeHalfSizeND = core::vectorSIMDf(cubeHalfSize);
+			const double boundFactor = 1.0/std::sqrt(2.0);
+			const double cornerOffsetLen = std::sqrt(double(dimensions-1u));
+
+			double bestFit[dimensions] = {};
+			double bestSineSquared = std::numeric_limits<double>::infinity();
 			for (uint32_t n=cubeHalfSize; n>0u; n--)
 			{
-				//we'd use float addition in the interest of speed, to increment the loop
-				//but adding a small number to a large one loses precision, so multiplication preferrable
-				core::vectorSIMDf bottomFit = core::floor(fittingVector*float(n)+floorOffset);
-				if ((bottomFit<=cubeHalfSizeND).all())
-					evaluateFit(bottomFit);
-				for (auto i=0u; i<cornerCount; i++)
+				double bottomFit[dimensions];
+				double maxResidual = 0.0;
+				for (auto i=0u; i<dimensions; i++)
+				{
+					if (i==maxDirCompIndex)
+					{
+						bottomFit[i] = double(n);
+						continue;
+					}
+					const double scaled = fittingVector[i]*double(n);
+					bottomFit[i] = std::floor(scaled);
+					maxResidual = core::max(maxResidual,core::min(scaled-bottomFit[i],bottomFit[i]+1.0-scaled));
+				}
+				// a hair of slack so rounding can't make us skip the true best fit
+				const double bound = maxResidual*boundFactor/(double(n)*fittingVectorLen+cornerOffsetLen);
+				if (bound*bound>bestSineSquared*(1.0+1e-6))
+					continue;
+
+				// the floor and every combination of ceilings of the non-max components
+				for (uint32_t corner=0u; corner<(0x1u<<(dimensions-1u)); corner++)
 				{
-					auto bottomFitTmp = bottomFit+corners[i];
-					if ((bottomFitTmp<=cubeHalfSizeND).all())
-						evaluateFit(bottomFitTmp);
+					double candidate[dimensions];
+					bool valid = true;
+					for (auto i=0u,bit=0u; i<dimensions; i++)
+					{
+						candidate[i] = bottomFit[i];
+						if (i==maxDirCompIndex)
+							continue;
+						candidate[i] += double((corner>>(bit++))&0x1u);
+						valid = valid && candidate[i]<=double(cubeHalfSize);
+					}
+					if (!valid)
+						continue;
+
+					const double sinSq = sineSquared(candidate);
+					if (sinSq<bestSineSquared)
+					{
+						bestSineSquared = sinSq;
+						std::copy(candidate,candidate+dimensions,bestFit);
+					}
 				}
 			}
 
-			return bestFit;
+			core::vectorSIMDf retval(0.f);
+			for (auto i=0u; i<dimensions; i++)
+				retval[i] = float(bestFit[i]);
+			return retval;
 		}
 		
 		template<E_FORMAT CacheFormat>
@@ -61,6 +61,19 @@ class CQuantNormalCache : public CDirQuantCacheBase<impl::VectorUV,impl::QuantNo
 			normal.makeSafe3D();
 			return Base::quantize<3u,CacheFormat>(normal);
 		}
+
+		//! Quantizes a whole array of normals, spreading the work across threads according to `policy`
+		template<E_FORMAT CacheFormat, class ExecutionPolicy>
+		void quantize(ExecutionPolicy&& policy, const core::vectorSIMDf* normals, const size_t count, value_type_t<CacheFormat>* out)
+		{
+			auto getNormal = [normals](const size_t i) -> core::vectorSIMDf
+			{
+				core::vectorSIMDf normal = normals[i];
+				normal.makeSafe3D();
+				return normal;
+			};
+			Base::quantize<3u,CacheFormat>(std::forward<ExecutionPolicy>(policy),count,getNormal,out);
+		}
 };
 
 }
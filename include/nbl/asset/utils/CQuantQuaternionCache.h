@@ -64,6 +64,14 @@ class CQuantQuaternionCache : public CDirQuantCacheBase<impl::Projection,impl::Q
 		{
 			return Base::quantize<4u,CacheFormat>(reinterpret_cast<const core::vectorSIMDf&>(quat));
 		}
+
+		//! Quantizes a whole array of quaternions, spreading the work across threads according to `policy`
+		template<E_FORMAT CacheFormat, class ExecutionPolicy>
+		void quantize(ExecutionPolicy&& policy, const core::quaternion* quats, const size_t count, value_type_t<CacheFormat>* out)
+		{
+			auto getQuat = [quats](const size_t i) -> core::vectorSIMDf {return reinterpret_cast<const core::vectorSIMDf&>(quats[i]);};
+			Base::quantize<4u,CacheFormat>(std::forward<ExecutionPolicy>(policy),count,getQuat,out);
+		}
 };
 
 }
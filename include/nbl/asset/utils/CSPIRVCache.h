@@ -0,0 +1,150 @@
+// Copyright (C) 2018-2021 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+
+#ifndef __NBL_ASSET_C_SPIRV_CACHE_H_INCLUDED__
+#define __NBL_ASSET_C_SPIRV_CACHE_H_INCLUDED__
+
+#include <mutex>
+
+#include "nbl/core/core.h"
+#include "nbl/core/xxHash256.h"
+
+#include "IReadFile.h"
+#include "IWriteFile.h"
+#include "IFileSystem.h"
+
+#include "nbl/asset/ICPUBuffer.h"
+#include "nbl/asset/ISpecializedShader.h"
+#include "nbl/asset/utils/ISPIRVOptimizer.h"
+
+namespace nbl
+{
+namespace asset
+{
+
+//! Content addressed cache of compiled SPIR-V, meant to be set on an IGLSLCompiler
+/**
+	Entries are keyed by a hash of everything that influences the compiler output: the GLSL source (which has to
+	have its #include directives resolved and its defines injected already, just like IGLSLCompiler requires), the shader
+	stage, entry point, whether debug info was requested and the optimizer passes. So a changed shader simply misses
+	and an old entry ages out, there is no need to ever invalidate anything by hand.
+
+	The cache lives in memory and can be loaded from and saved to a single file, usually once at startup and once at exit.
+	When the total size of the SPIR-V goes over the budget the least recently used entries are evicted, the use order
+	is saved along with the entries so it carries over between runs.
+
+	All methods are thread-safe.
+*/
+class CSPIRVCache : public core::IReferenceCounted
+{
+	public:
+		struct SKey
+		{
+			inline bool operator==(const SKey& other) const
+			{
+				return hash[0]==other.hash[0] && hash[1]==other.hash[1] && hash[2]==other.hash[2] && hash[3]==other.hash[3];
+			}
+
+			uint64_t hash[4];
+		};
+
+		struct SStatistics
+		{
+			uint64_t hits = 0ull;
+			uint64_t misses = 0ull;
+			uint64_t evictions = 0ull;
+			//! time spent compiling the shaders which missed
+			double compileMillisecondsSpent = 0.0;
+			//! how long the shaders which hit took to compile when they were inserted, an estimate of the time the cache saved
+			double compileMillisecondsSaved = 0.0;
+		};
+
+		//! `maxSize` is the budget for the SPIR-V bytes kept in the cache
+		CSPIRVCache(size_t maxSize=64ull<<20ull) : m_maxSize(maxSize) {}
+
+		//! `_glslCode` must have its #include directives resolved, same as for IGLSLCompiler::createSPIRVFromGLSL
+		static SKey createKey(const char* _glslCode, ISpecializedShader::E_SHADER_STAGE _stage, const char* _entryPoint, bool _genDebugInfo, const ISPIRVOptimizer* _opt);
+
+		//! returns a copy of the cached SPIR-V or nullptr on a miss, updates the statistics
+		core::smart_refctd_ptr<ICPUBuffer> find(const SKey& key);
+
+		//! copies `spirv` into the cache, `compileMilliseconds` is how long it took to produce it
+		void insert(const SKey& key, const ICPUBuffer* spirv, double compileMilliseconds);
+
+		//!
+		void clear();
+
+		//! Loaded entries are merged with the current contents, entries which don't fit the budget get evicted right away
+		bool loadFromFile(io::IReadFile* file);
+		inline bool loadFromFile(io::IFileSystem* fs, const io::path& path)
+		{
+			auto file = core::smart_refctd_ptr<io::IReadFile>(fs->createAndOpenFile(path),core::dont_grab);
+			return loadFromFile(file.get());
+		}
+
+		//!
+		bool saveToFile(io::IWriteFile* file) const;
+		inline bool saveToFile(io::IFileSystem* fs, const io::path& path) const
+		{
+			auto file = core::smart_refctd_ptr<io::IWriteFile>(fs->createAndWriteFile(path),core::dont_grab);
+			return saveToFile(file.get());
+		}
+
+		//!
+		inline SStatistics getStatistics() const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_stats;
+		}
+		inline void resetStatistics()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stats = {};
+		}
+
+		//! total size of the cached SPIR-V
+		inline size_t getSize() const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_size;
+		}
+		inline size_t getMaxSize() const { return m_maxSize; }
+		//! shrinking the budget evicts straight away
+		void setMaxSize(size_t maxSize);
+
+	protected:
+		virtual ~CSPIRVCache() = default;
+
+		struct Hash
+		{
+			inline size_t operator()(const SKey& key) const
+			{
+				return key.hash[0];
+			}
+		};
+		struct SEntry
+		{
+			core::vector<uint8_t> spirv;
+			uint64_t lastUse;
+			double compileMilliseconds;
+		};
+
+		//! both expect `m_mutex` to be locked
+		void insert_impl(const SKey& key, SEntry&& entry);
+		void evict_impl();
+
+		mutable std::mutex m_mutex;
+		core::unordered_map<SKey,SEntry,Hash> m_entries;
+		//! orders the entries by last use, so we can find the ones to evict
+		core::map<uint64_t,SKey> m_useOrder;
+		uint64_t m_useCounter = 0ull;
+		size_t m_size = 0ull;
+		size_t m_maxSize;
+		SStatistics m_stats;
+};
+
+}
+}
+
+#endif
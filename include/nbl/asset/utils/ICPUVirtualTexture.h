@@ -10,6 +10,10 @@
 #include <nbl/asset/ICPUDescriptorSet.h>
 
 #include "nbl/asset/filters/CMipMapGenerationImageFilter.h"
+#include "nbl/asset/filters/CConvertFormatImageFilter.h"
+
+#include <atomic>
+#include <execution>
 
 namespace nbl {
 namespace asset
@@ -169,6 +173,63 @@ public:
         return std::make_pair(std::move(paddedImg), originalExtent);
     }
 
+    //! Converts the levels and layer of `_img` which a commit reads to `_format`, the mip level and layer indices stay the same
+    static core::smart_refctd_ptr<ICPUImage> convertImageForCommit(const ICPUImage* _img, E_FORMAT _format, const IImage::SSubresourceRange& _subres, uint32_t _levelCount)
+    {
+        // TODO: eventually remove when we can encode blocks
+        if (isBlockCompressionFormat(_img->getCreationParameters().format) || isBlockCompressionFormat(_format))
+            return nullptr;
+
+        ICPUImage::SCreationParams params = _img->getCreationParameters();
+        params.format = _format;
+        auto converted = ICPUImage::create(std::move(params));
+        {
+            const uint32_t texelBytesize = getTexelOrBlockBytesize(_format);
+            const auto& convertedParams = converted->getCreationParameters();
+
+            auto regions = core::make_refctd_dynamic_array<core::smart_refctd_dynamic_array<IImage::SBufferCopy>>(convertedParams.mipLevels);
+            size_t bufoffset = 0ull;
+            for (uint32_t i = 0u; i < regions->size(); ++i)
+            {
+                const auto mipSize = converted->getMipSize(i);
+
+                auto& region = (*regions)[i];
+                region.bufferImageHeight = 0u;
+                region.bufferOffset = bufoffset;
+                region.bufferRowLength = mipSize.x;
+                region.imageExtent = {mipSize.x,mipSize.y,mipSize.z};
+                region.imageOffset = {0u,0u,0u};
+                region.imageSubresource.baseArrayLayer = 0u;
+                region.imageSubresource.layerCount = convertedParams.arrayLayers;
+                region.imageSubresource.mipLevel = i;
+
+                bufoffset += size_t(texelBytesize)*mipSize.x*mipSize.y*mipSize.z*convertedParams.arrayLayers;
+            }
+            converted->setBufferAndRegions(core::make_smart_refctd_ptr<ICPUBuffer>(bufoffset), regions);
+        }
+
+        using convert_filter_t = CConvertFormatImageFilter<>;
+        convert_filter_t::state_type conv;
+        conv.inImage = _img;
+        conv.outImage = converted.get();
+        conv.inOffset = {0u,0u,0u};
+        conv.outOffset = {0u,0u,0u};
+        conv.inBaseLayer = _subres.baseArrayLayer;
+        conv.outBaseLayer = _subres.baseArrayLayer;
+        conv.layerCount = 1u;
+        for (uint32_t i = 0u; i < _levelCount; ++i)
+        {
+            const uint32_t level = _subres.baseMipLevel + i;
+            const auto mipSize = converted->getMipSize(level);
+            conv.inMipLevel = level;
+            conv.outMipLevel = level;
+            conv.extent = {mipSize.x,mipSize.y,mipSize.z};
+            if (!convert_filter_t::execute(&conv))
+                return nullptr;
+        }
+        return converted;
+    }
+
     ICPUVirtualTexture(
         physical_tiles_per_dim_log2_callback_t&& _callback,
         const base_t::IVTResidentStorage::SCreationParams* _residentStorageParams,
@@ -195,129 +256,233 @@ public:
 
     }
 
+    //! One texture of a batched `commit`, the members mean the same as the parameters of the single texture `commit`
+    struct SCommitRequest
+    {
+        SMasterTextureData addr;
+        const ICPUImage* image;
+        IImage::SSubresourceRange subresource;
+        ISampler::E_TEXTURE_CLAMP uwrap;
+        ISampler::E_TEXTURE_CLAMP vwrap;
+        ISampler::E_TEXTURE_BORDER_COLOR borderColor;
+    };
+
     bool commit(const SMasterTextureData& _addr, const ICPUImage* _img, const IImage::SSubresourceRange& _subres, ISampler::E_TEXTURE_CLAMP _uwrap, ISampler::E_TEXTURE_CLAMP _vwrap, ISampler::E_TEXTURE_BORDER_COLOR _borderColor) override
     {
-        if (!validateCommit(_addr, _subres, _uwrap, _vwrap))
-            return false;
+        const SCommitRequest request = {_addr,_img,_subres,_uwrap,_vwrap,_borderColor};
+        return commit(std::execution::seq,&request,1u);
+    }
 
-        const page_tab_offset_t pgtOffset(_addr.pgTab_x, _addr.pgTab_y, _addr.pgTab_layer);
+    //! Commits many textures at once, @returns if all of them succeeded
+    /**
+        Physical pages for all the textures get allocated with a single call per resident storage and the page table is filled in
+        the order of `_requests`, so the result is exactly the same as committing them one by one. Then the padded page copies
+        get distributed across textures according to `policy`.
+        An image which isn't in the format its texture got allocated with is converted to it in the same task which copies its pages.
+    */
+    template<class ExecutionPolicy>
+    bool commit(ExecutionPolicy&& policy, const SCommitRequest* _requests, const uint32_t _count)
+    {
+        using phys_pg_addr_alctr_t = ICPUVTResidentStorage::phys_pg_addr_alctr_t;
 
-        ICPUVTResidentStorage* storage = nullptr;
+        struct SPreparedCommit
         {
-            uint32_t layer = pgtOffset.z;
-            E_FORMAT format = getFormatInLayer(pgtOffset.z);
-            E_FORMAT_CLASS fc = getFormatClass(format);
-            auto found = m_storage.find(fc);
+            const SCommitRequest* request;
+            ICPUVTResidentStorage* storage = nullptr;
+            E_FORMAT format;
+            uint32_t levelsTakingAtLeastOnePageCount;
+            uint32_t levelsToPack;
+            uint32_t firstPage;
+            uint32_t pageCount;
+            uint32_t firstCopy;
+            uint32_t copyCount;
+        };
+        core::vector<SPreparedCommit> prepared(_count);
+
+        // count the pages every texture needs
+        bool success = true;
+        core::unordered_map<ICPUVTResidentStorage*,core::vector<uint32_t> > pageAddresses;
+        for (uint32_t r = 0u; r < _count; ++r)
+        {
+            const SCommitRequest& request = _requests[r];
+            SPreparedCommit& entry = prepared[r];
+            entry.request = &request;
+            if (!validateCommit(request.addr, request.subresource, request.uwrap, request.vwrap))
+            {
+                success = false;
+                continue;
+            }
+
+            entry.format = getFormatInLayer(request.addr.pgTab_layer);
+            auto found = m_storage.find(getFormatClass(entry.format));
             if (found==m_storage.end())
-                return false;
-            storage = static_cast<ICPUVTResidentStorage*>(found->second.get());
+            {
+                success = false;
+                continue;
+            }
+            entry.storage = static_cast<ICPUVTResidentStorage*>(found->second.get());
+
+            const VkExtent3D extent = {static_cast<uint32_t>(request.addr.origsize_x), static_cast<uint32_t>(request.addr.origsize_y), 1u};
+            entry.levelsTakingAtLeastOnePageCount = countLevelsTakingAtLeastOnePage(extent);
+            entry.levelsToPack = std::min<uint32_t>(request.subresource.levelCount, m_pageTable->getCreationParameters().mipLevels+m_pgSzxy_log2);
+            entry.pageCount = 0u;
+            for (uint32_t i = 0u; i < std::min(entry.levelsToPack,entry.levelsTakingAtLeastOnePageCount); ++i)
+                entry.pageCount += neededPageCountForSide(extent.width, i)*neededPageCountForSide(extent.height, i);
+            if (entry.levelsTakingAtLeastOnePageCount<=entry.levelsToPack && entry.levelsTakingAtLeastOnePageCount<request.subresource.levelCount)
+                entry.pageCount++; // miptail
+
+            auto& addresses = pageAddresses[entry.storage];
+            entry.firstPage = addresses.size();
+            addresses.resize(addresses.size()+entry.pageCount, phys_pg_addr_alctr_t::invalid_address);
         }
 
-        const VkExtent3D extent = {static_cast<uint32_t>(_addr.origsize_x), static_cast<uint32_t>(_addr.origsize_y), 1u};
+        // one allocation per storage, a pool allocator hands out the same addresses as it would have one by one
+        for (auto& storageAddresses : pageAddresses)
+        {
+            auto& addresses = storageAddresses.second;
+            const core::vector<uint32_t> szAndAlignment(addresses.size(), 1u);
+            core::address_allocator_traits<phys_pg_addr_alctr_t>::multi_alloc_addr(storageAddresses.first->tileAlctr, addresses.size(), addresses.data(), szAndAlignment.data(), szAndAlignment.data(), nullptr);
+        }
 
-        const uint32_t levelsTakingAtLeastOnePageCount = countLevelsTakingAtLeastOnePage(extent);
-        const uint32_t levelsToPack = std::min<uint32_t>(_subres.levelCount, m_pageTable->getCreationParameters().mipLevels+m_pgSzxy_log2);
+        // fill the page table and set up the copies, serially because the miptail page is shared between levels
+        struct SPageCopy
+        {
+            core::vector3du32_SIMD physPg;
+            uint32_t level, x, y, w, h;
+        };
+        core::vector<SPageCopy> copies;
+        for (SPreparedCommit& entry : prepared)
+        {
+            if (!entry.storage)
+                continue;
 
-        uint32_t miptailPgAddr = SPhysPgOffset::invalid_addr;
+            const SCommitRequest& request = *entry.request;
+            const page_tab_offset_t pgtOffset(request.addr.pgTab_x, request.addr.pgTab_y, request.addr.pgTab_layer);
+            const VkExtent3D extent = {static_cast<uint32_t>(request.addr.origsize_x), static_cast<uint32_t>(request.addr.origsize_y), 1u};
+            const uint32_t levelsTakingAtLeastOnePageCount = entry.levelsTakingAtLeastOnePageCount;
 
-        using phys_pg_addr_alctr_t = ICPUVTResidentStorage::phys_pg_addr_alctr_t;
-        //TODO up to this line, it's kinda common code for CPU and GPU, refactor later
+            const uint32_t* nextPage = pageAddresses[entry.storage].data()+entry.firstPage;
+            auto takePage = [&]() -> uint32_t
+            {
+                const uint32_t addr = *(nextPage++);
+                return (addr==phys_pg_addr_alctr_t::invalid_address) ? SPhysPgOffset::invalid_addr : entry.storage->encodePageAddress(addr);
+            };
 
-        for (uint32_t i = 0u; i < levelsToPack; ++i)
-        {
-            const uint32_t w = neededPageCountForSide(extent.width, i);
-            const uint32_t h = neededPageCountForSide(extent.height, i);
+            uint32_t miptailPgAddr = SPhysPgOffset::invalid_addr;
+            entry.firstCopy = copies.size();
+            for (uint32_t i = 0u; i < entry.levelsToPack; ++i)
+            {
+                const uint32_t w = neededPageCountForSide(extent.width, i);
+                const uint32_t h = neededPageCountForSide(extent.height, i);
 
-            for (uint32_t y = 0u; y < h; ++y)
-                for (uint32_t x = 0u; x < w; ++x)
-                {
-                    uint32_t physPgAddr = phys_pg_addr_alctr_t::invalid_address;
-                    if (i>=levelsTakingAtLeastOnePageCount)
-                        physPgAddr = miptailPgAddr;
-                    else
+                for (uint32_t y = 0u; y < h; ++y)
+                    for (uint32_t x = 0u; x < w; ++x)
                     {
-                        const uint32_t szAndAlignment = 1u;
-                        core::address_allocator_traits<phys_pg_addr_alctr_t>::multi_alloc_addr(storage->tileAlctr, 1u, &physPgAddr, &szAndAlignment, &szAndAlignment, nullptr);
-                        if (physPgAddr == phys_pg_addr_alctr_t::invalid_address)
-                            physPgAddr = SPhysPgOffset::invalid_addr;
-                        else
-                            physPgAddr = storage->encodePageAddress(physPgAddr);
+                        uint32_t physPgAddr = (i>=levelsTakingAtLeastOnePageCount) ? miptailPgAddr:takePage();
+
+                        if (i==(levelsTakingAtLeastOnePageCount-1u) && levelsTakingAtLeastOnePageCount<request.subresource.levelCount)
+                        {
+                            assert(w==1u && h==1u);
+                            const uint32_t miptailPgAddr_tmp = takePage();
+                            
+                            physPgAddr |= (miptailPgAddr_tmp<<SPhysPgOffset::PAGE_ADDR_BITLENGTH);
+
+                            miptailPgAddr = miptailPgAddr_tmp;
+                        }
+                        else 
+                            physPgAddr |= (SPhysPgOffset::invalid_addr<<SPhysPgOffset::PAGE_ADDR_BITLENGTH);
+                        if (i < levelsTakingAtLeastOnePageCount)
+                        {
+                            const auto texelPos = core::vectorSIMDu32(pgtOffset.x>>i, pgtOffset.y>>i, 0u, pgtOffset.z) + core::vectorSIMDu32(x, y, 0u, 0u);
+                            const auto* region = m_pageTable->getRegion(i, texelPos);
+                            const uint64_t byteoffset = region->getByteOffset(texelPos, region->getByteStrides(m_pageTable->getTexelBlockInfo()));
+                            uint8_t* bufptr = reinterpret_cast<uint8_t*>(m_pageTable->getBuffer()->getPointer()) + byteoffset;
+                            reinterpret_cast<uint32_t*>(bufptr)[0] = physPgAddr;
+                        }
+
+                        if (!SPhysPgOffset(physPgAddr).valid())
+                            continue;
+
+                        core::vector3du32_SIMD physPg = ICPUVTResidentStorage::pageCoords(physPgAddr, m_pgSzxy, m_tilePadding);
+                        physPg -= core::vector2du32_SIMD(m_tilePadding, m_tilePadding);
+
+                        const core::vector2du32_SIMD miptailOffset = (i>=levelsTakingAtLeastOnePageCount) ? core::vector2du32_SIMD(m_miptailOffsets[i-levelsTakingAtLeastOnePageCount].x,m_miptailOffsets[i-levelsTakingAtLeastOnePageCount].y) : core::vector2du32_SIMD(0u,0u);
+                        physPg += miptailOffset;
+
+                        copies.push_back({physPg,i,x,y,w,h});
                     }
+            }
+            entry.copyCount = copies.size()-entry.firstCopy;
+        }
 
-                    if (i==(levelsTakingAtLeastOnePageCount-1u) && levelsTakingAtLeastOnePageCount<_subres.levelCount)
-                    {
-                        assert(w==1u && h==1u);
-                        uint32_t miptailPgAddr_tmp = phys_pg_addr_alctr_t::invalid_address;
-                        const uint32_t szAndAlignment = 1u;
-                        core::address_allocator_traits<phys_pg_addr_alctr_t>::multi_alloc_addr(storage->tileAlctr, 1u, &miptailPgAddr_tmp, &szAndAlignment, &szAndAlignment, nullptr);
-                        miptailPgAddr_tmp = (miptailPgAddr_tmp==phys_pg_addr_alctr_t::invalid_address) ? SPhysPgOffset::invalid_addr : storage->encodePageAddress(miptailPgAddr_tmp);
-                        
-                        physPgAddr |= (miptailPgAddr_tmp<<SPhysPgOffset::PAGE_ADDR_BITLENGTH);
-
-                        miptailPgAddr = miptailPgAddr_tmp;
-                    }
-                    else 
-                        physPgAddr |= (SPhysPgOffset::invalid_addr<<SPhysPgOffset::PAGE_ADDR_BITLENGTH);
-                    if (i < levelsTakingAtLeastOnePageCount)
-                    {
-                        const auto texelPos = core::vectorSIMDu32(pgtOffset.x>>i, pgtOffset.y>>i, 0u, pgtOffset.z) + core::vectorSIMDu32(x, y, 0u, 0u);
-                        const auto* region = m_pageTable->getRegion(i, texelPos);
-                        const uint64_t byteoffset = region->getByteOffset(texelPos, region->getByteStrides(m_pageTable->getTexelBlockInfo()));
-                        uint8_t* bufptr = reinterpret_cast<uint8_t*>(m_pageTable->getBuffer()->getPointer()) + byteoffset;
-                        reinterpret_cast<uint32_t*>(bufptr)[0] = physPgAddr;
-                    }
+        // every texture writes to its own pages only (the miptail levels share one, but they stay in one task)
+        std::atomic_bool copiesSucceeded(true);
+        std::for_each(std::forward<ExecutionPolicy>(policy), prepared.begin(), prepared.end(), [&](const SPreparedCommit& entry) -> void
+        {
+            if (!entry.storage || entry.copyCount==0u)
+                return;
+
+            const SCommitRequest& request = *entry.request;
+            core::smart_refctd_ptr<ICPUImage> converted;
+            if (request.image->getCreationParameters().format!=entry.format)
+            {
+                converted = convertImageForCommit(request.image, entry.format, request.subresource, entry.levelsToPack);
+                if (!converted)
+                {
+                    copiesSucceeded = false;
+                    return;
+                }
+            }
 
-                    if (!SPhysPgOffset(physPgAddr).valid())
-                        continue;
-
-                    core::vector3du32_SIMD physPg = ICPUVTResidentStorage::pageCoords(physPgAddr, m_pgSzxy, m_tilePadding);
-                    physPg -= core::vector2du32_SIMD(m_tilePadding, m_tilePadding);
-
-                    const core::vector2du32_SIMD miptailOffset = (i>=levelsTakingAtLeastOnePageCount) ? core::vector2du32_SIMD(m_miptailOffsets[i-levelsTakingAtLeastOnePageCount].x,m_miptailOffsets[i-levelsTakingAtLeastOnePageCount].y) : core::vector2du32_SIMD(0u,0u);
-                    physPg += miptailOffset;
-
-                    CPaddedCopyImageFilter::state_type copy;
-                    copy.outOffsetBaseLayer = (physPg).xyzz();/*physPg.z is layer*/ copy.outOffset.z = 0u;
-                    copy.inOffsetBaseLayer = core::vector2du32_SIMD(x,y)*m_pgSzxy;
-                    copy.extentLayerCount = core::vectorSIMDu32(m_pgSzxy, m_pgSzxy, 1u, 1u);
-                    copy.relativeOffset = {0u,0u,0u};
-                    if (x == w-1u)
-                        copy.extentLayerCount.x = std::max<uint32_t>(extent.width>>i,1u)-copy.inOffsetBaseLayer.x;
-                    if (y == h-1u)
-                        copy.extentLayerCount.y = std::max<uint32_t>(extent.height>>i,1u)-copy.inOffsetBaseLayer.y;
-                    memcpy(&copy.paddedExtent.width,(copy.extentLayerCount+core::vectorSIMDu32(2u*m_tilePadding)).pointer, 2u*sizeof(uint32_t));
-                    copy.paddedExtent.depth = 1u;
-                    if (w>1u)
-                        copy.extentLayerCount.x += m_tilePadding;
-                    if (x>0u && x<w-1u)
-                        copy.extentLayerCount.x += m_tilePadding;
-                    if (h>1u)
-                        copy.extentLayerCount.y += m_tilePadding;
-                    if (y>0u && y<h-1u)
-                        copy.extentLayerCount.y += m_tilePadding;
-                    if (x == 0u)
-                        copy.relativeOffset.x = m_tilePadding;
-                    else
-                        copy.inOffsetBaseLayer.x -= m_tilePadding;
-                    if (y == 0u)
-                        copy.relativeOffset.y = m_tilePadding;
-                    else
-                        copy.inOffsetBaseLayer.y -= m_tilePadding;
-                    copy.inOffsetBaseLayer.w = _subres.baseArrayLayer;
-                    copy.inMipLevel = _subres.baseMipLevel + i;
-                    copy.outMipLevel = 0u;
-                    copy.inImage = _img;
-                    copy.outImage = storage->image.get();
-                    copy.axisWraps[0] = _uwrap;
-                    copy.axisWraps[1] = _vwrap;
-                    copy.axisWraps[2] = ISampler::ETC_CLAMP_TO_EDGE;
-                    copy.borderColor = _borderColor;
-                    if (!CPaddedCopyImageFilter::execute(&copy))
-                        assert(false);
+            const VkExtent3D extent = {static_cast<uint32_t>(request.addr.origsize_x), static_cast<uint32_t>(request.addr.origsize_y), 1u};
+            for (uint32_t c = entry.firstCopy; c < entry.firstCopy+entry.copyCount; ++c)
+            {
+                const SPageCopy& page = copies[c];
+                CPaddedCopyImageFilter::state_type copy;
+                copy.outOffsetBaseLayer = (page.physPg).xyzz();/*physPg.z is layer*/ copy.outOffset.z = 0u;
+                copy.inOffsetBaseLayer = core::vector2du32_SIMD(page.x,page.y)*m_pgSzxy;
+                copy.extentLayerCount = core::vectorSIMDu32(m_pgSzxy, m_pgSzxy, 1u, 1u);
+                copy.relativeOffset = {0u,0u,0u};
+                if (page.x == page.w-1u)
+                    copy.extentLayerCount.x = std::max<uint32_t>(extent.width>>page.level,1u)-copy.inOffsetBaseLayer.x;
+                if (page.y == page.h-1u)
+                    copy.extentLayerCount.y = std::max<uint32_t>(extent.height>>page.level,1u)-copy.inOffsetBaseLayer.y;
+                memcpy(&copy.paddedExtent.width,(copy.extentLayerCount+core::vectorSIMDu32(2u*m_tilePadding)).pointer, 2u*sizeof(uint32_t));
+                copy.paddedExtent.depth = 1u;
+                if (page.w>1u)
+                    copy.extentLayerCount.x += m_tilePadding;
+                if (page.x>0u && page.x<page.w-1u)
+                    copy.extentLayerCount.x += m_tilePadding;
+                if (page.h>1u)
+                    copy.extentLayerCount.y += m_tilePadding;
+                if (page.y>0u && page.y<page.h-1u)
+                    copy.extentLayerCount.y += m_tilePadding;
+                if (page.x == 0u)
+                    copy.relativeOffset.x = m_tilePadding;
+                else
+                    copy.inOffsetBaseLayer.x -= m_tilePadding;
+                if (page.y == 0u)
+                    copy.relativeOffset.y = m_tilePadding;
+                else
+                    copy.inOffsetBaseLayer.y -= m_tilePadding;
+                copy.inOffsetBaseLayer.w = request.subresource.baseArrayLayer;
+                copy.inMipLevel = request.subresource.baseMipLevel + page.level;
+                copy.outMipLevel = 0u;
+                copy.inImage = converted ? converted.get():request.image;
+                copy.outImage = entry.storage->image.get();
+                copy.axisWraps[0] = request.uwrap;
+                copy.axisWraps[1] = request.vwrap;
+                copy.axisWraps[2] = ISampler::ETC_CLAMP_TO_EDGE;
+                copy.borderColor = request.borderColor;
+                if (!CPaddedCopyImageFilter::execute(&copy))
+                {
+                    assert(false);
+                    copiesSucceeded = false;
                 }
-        }
+            }
+        });
 
-        return true;
+        return success && copiesSucceeded;
     }
 
     SViewAliasTextureData createAlias(const SMasterTextureData& _addr, E_FORMAT _viewingFormat, const IImage::SSubresourceRange& _subresRelativeToMaster) override
@@ -15,6 +15,7 @@
 #include "nbl/asset/utils/IIncludeHandler.h"
 
 #include "nbl/asset/utils/ISPIRVOptimizer.h"
+#include "nbl/asset/utils/CSPIRVCache.h"
 
 namespace nbl
 {
@@ -32,6 +33,7 @@ class IGLSLCompiler final : public core::IReferenceCounted
 {
 		core::smart_refctd_ptr<IIncludeHandler> m_inclHandler;
 		const io::IFileSystem* m_fs;
+		core::smart_refctd_ptr<CSPIRVCache> m_spirvCache;
 
 	protected:
 		friend class video::COpenGLDriver;
@@ -43,6 +45,12 @@ class IGLSLCompiler final : public core::IReferenceCounted
 		IIncludeHandler* getIncludeHandler() { return m_inclHandler.get(); }
 		const IIncludeHandler* getIncludeHandler() const { return m_inclHandler.get(); }
 
+		//! When set, `createSPIRVFromGLSL` looks the shader up in the cache before compiling it and puts whatever it compiles in there
+		/** Calls requesting the SPIR-V assembly always compile. Pass nullptr to stop using a cache. */
+		void setSPIRVCache(core::smart_refctd_ptr<CSPIRVCache>&& _cache) { m_spirvCache = std::move(_cache); }
+		CSPIRVCache* getSPIRVCache() { return m_spirvCache.get(); }
+		const CSPIRVCache* getSPIRVCache() const { return m_spirvCache.get(); }
+
 		/**
 		If _stage is ESS_UNKNOWN, then compiler will try to deduce shader stage from #pragma annotation, i.e.:
 		#pragma shader_stage(vertex),       or
@@ -5,6 +5,9 @@
 #ifndef __NBL_ASSET_I_MESH_PACKER_H_INCLUDED__
 #define __NBL_ASSET_I_MESH_PACKER_H_INCLUDED__
 
+#include <execution>
+
+#include "nbl/core/math/morton.h"
 #include "nbl/asset/utils/IMeshManipulator.h"
 
 namespace nbl
@@ -148,127 +151,156 @@ protected:
         uint32_t oldIndices[3];
     };
 
-    struct TriangleBatch
+    using TriangleBatch = core::SRange<const Triangle>;
+
+    //! All triangles of a meshbuffer in one flat array, consecutive batches are delimited by `batchBegins` (nested vectors are evil)
+    struct TriangleBatches
     {
+        TriangleBatches(uint32_t triCnt) : triangles(triCnt), vertexIDUpperBound(0u) {}
+
+        inline uint32_t getBatchCount() const { return batchBegins.size()>1u ? batchBegins.size()-1u:0u; }
+        inline TriangleBatch getBatch(uint32_t batchIx) const { return TriangleBatch(triangles.data()+batchBegins[batchIx],triangles.data()+batchBegins[batchIx+1u]); }
+
         core::vector<Triangle> triangles;
+        core::vector<uint32_t> batchBegins; // has one extra element marking the end of the last batch
+        uint32_t vertexIDUpperBound;
     };
 
-    core::vector<TriangleBatch> constructTriangleBatches(const MeshBufferType* meshBuffer) const
+    /*
+    Sorts the triangles by the Morton code of their centroids and then greedily splits the sorted list into
+    spatially coherent batches (good for cluster culling), a batch ends when it reaches `m_maxTriangleCountPerMDIData`
+    triangles or when it has at least `m_minTriangleCountPerMDIData` triangles and the next one would push its unique
+    vertex count over `m_maxTriangleCountPerMDIData`. Every batch but the last having at least the minimum triangle
+    count keeps the batch count within `calcBatchCountBound`, which the allocations were reserved with.
+    */
+    TriangleBatches constructTriangleBatches(const MeshBufferType* meshBuffer) const
     {
         uint32_t triCnt;
         const bool success = IMeshManipulator::getPolyCount(triCnt,meshBuffer);
         assert(success);
 
-        const uint32_t batchCount = calcBatchCountBound(triCnt);
-        /*
-        TODO:
-
-        //struct TriangleMortonCodePair
-        //{
-        //	Triangle triangle;
-        //	//uint64_t mortonCode; TODO after benchmarks
-        //};
-        
-        core::vector<TriangleMortonCodePair> triangles(triCnt);
-        uint32_t ix=0u;
-        for (auto it=triangles.begin(); it!=triangles.end(); it++)
+        TriangleBatches output(triCnt);
+        output.batchBegins.reserve(calcBatchCountBound(triCnt)+1u);
+        output.batchBegins.push_back(0u);
+        if (triCnt==0u)
+            return output;
+
+        // second half is the scratch memory for the radix sort
+        core::vector<TriangleMortonCodePair> sortData(size_t(triCnt)*2ull);
+        auto triangles = core::SRange<TriangleMortonCodePair>(sortData.data(),sortData.data()+triCnt);
+        core::vector<core::vectorSIMDf> centroids(triCnt);
+        // not `par_unseq`, fetching indices and positions goes through virtual calls which mustn't be interleaved in one thread
+        std::for_each(std::execution::par,triangles.begin(),triangles.end(),[&](TriangleMortonCodePair& pair) -> void
         {
-            *it = IMeshManipulator::getTriangleIndices(meshbuffer,ix++);
-        }
-
-        std::sort(triangles.begin(),triangles.end(),[]()->bool{return lhs.mortonCode<rhs.mortonCode;}); // maybe use our new core::radix_sort?
-
-        // do batch splitting
-        core::vector<const TriangleMortonCodePair*> batches;
-        batches.reserve(calcBatchCountBound(triCnt)+1u); // actual batch count will be different
+            const uint32_t triIx = &pair-sortData.data();
+            const auto indices = IMeshManipulator::getTriangleIndices(meshBuffer,triIx);
+            std::copy(indices.begin(),indices.end(),pair.triangle.oldIndices);
+            centroids[triIx] = (meshBuffer->getPosition(indices[0])+meshBuffer->getPosition(indices[1])+meshBuffer->getPosition(indices[2]))/3.f;
+        });
+
+        // quantize the centroids to a 1024^3 grid over their bounding box
+        core::vectorSIMDf minCentroid = centroids.front();
+        core::vectorSIMDf maxCentroid = centroids.front();
+        for (const auto& centroid : centroids)
         {
-            // use batches.push_back();
+            minCentroid = core::min(minCentroid,centroid);
+            maxCentroid = core::max(maxCentroid,centroid);
         }
-        batches.push_back(triangles.data()+triangles.size());
+        const core::vectorSIMDf extent = maxCentroid-minCentroid;
+        core::vectorSIMDf scale;
+        for (uint32_t i=0u; i<3u; i++)
+            scale.pointer[i] = extent.pointer[i]>0.f ? float(MortonAxisMax)/extent.pointer[i]:0.f;
+        std::for_each(std::execution::par,triangles.begin(),triangles.end(),[&](TriangleMortonCodePair& pair) -> void
+        {
+            const core::vectorSIMDf quantized = (centroids[&pair-sortData.data()]-minCentroid)*scale+core::vectorSIMDf(0.5f);
+            uint32_t coords[3];
+            for (uint32_t i=0u; i<3u; i++)
+                coords[i] = core::min(static_cast<uint32_t>(quantized.pointer[i]),MortonAxisMax);
+            pair.mortonCode = core::morton3d_encode<uint32_t,MortonBitsPerAxis>(coords[0],coords[1],coords[2]);
+        });
+
+        const TriangleMortonCodePair* sorted = core::radix_sort(std::execution::par,sortData.data(),sortData.data()+triCnt,triCnt,MortonCodeKeyAccessor());
+
+        output.vertexIDUpperBound = IMeshManipulator::upperBoundVertexID(meshBuffer);
+        // flat "last batch to use this vertex" table to count the unique vertices of the batch being built
+        core::vector<uint32_t> lastBatchUsingVertex(output.vertexIDUpperBound,~0u);
+        const uint32_t maxVertexCountPerBatch = m_maxTriangleCountPerMDIData;
+        uint32_t batchIx = 0u;
+        uint32_t batchVertexCount = 0u;
+        for (uint32_t i=0u; i<triCnt; i++)
+        {
+            const Triangle& triangle = sorted[i].triangle;
 
-        return {std::move(triangles),std::move(batches)};
-        */
-        core::vector<TriangleBatch> output(batchCount); // nested vectors are evil
+            uint32_t newVertexCount = 0u;
+            for (uint32_t j=0u; j<3u; j++)
+            if (lastBatchUsingVertex[triangle.oldIndices[j]]!=batchIx)
+                newVertexCount++;
 
-        for (uint32_t i = 0u; i < batchCount; i++)
-        {
-            if (i == (batchCount - 1))
+            const uint32_t batchTriCount = i-output.batchBegins.back();
+            if (batchTriCount>=m_maxTriangleCountPerMDIData || batchTriCount>=m_minTriangleCountPerMDIData&&batchVertexCount+newVertexCount>maxVertexCountPerBatch)
             {
-                const auto lastBatchLen = triCnt % uint32_t(m_maxTriangleCountPerMDIData);
-                if (lastBatchLen)
-                {
-                    output[i].triangles = core::vector<Triangle>(lastBatchLen);
-                    continue;
-                }
+                output.batchBegins.push_back(i);
+                batchIx++;
+                batchVertexCount = 0u;
             }
 
-            output[i].triangles = core::vector<Triangle>(m_maxTriangleCountPerMDIData);
-        }
-
-        //TODO: triangle reordering
-
-        const auto& srcIdxBuffer = meshBuffer->getIndexBufferBinding();
-        auto idxBufferPtr32Bit = static_cast<const uint32_t*>(srcIdxBuffer.buffer->getPointer()) + (srcIdxBuffer.offset / sizeof(uint32_t)); //will be changed after benchmarks
-        auto idxBufferPtr16Bit = static_cast<const uint16_t*>(srcIdxBuffer.buffer->getPointer()) + (srcIdxBuffer.offset / sizeof(uint16_t));
-        for (TriangleBatch& batch : output)
-        {
-            for (Triangle& tri : batch.triangles)
+            for (uint32_t j=0u; j<3u; j++)
             {
-                if (meshBuffer->getIndexType() == EIT_32BIT)
+                uint32_t& lastBatch = lastBatchUsingVertex[triangle.oldIndices[j]];
+                if (lastBatch!=batchIx)
                 {
-                    tri.oldIndices[0] = *idxBufferPtr32Bit;
-                    tri.oldIndices[1] = *(++idxBufferPtr32Bit);
-                    tri.oldIndices[2] = *(++idxBufferPtr32Bit);
-                    idxBufferPtr32Bit++;
-                }
-                else if (meshBuffer->getIndexType() == EIT_16BIT)
-                {
-
-                    tri.oldIndices[0] = *idxBufferPtr16Bit;
-                    tri.oldIndices[1] = *(++idxBufferPtr16Bit);
-                    tri.oldIndices[2] = *(++idxBufferPtr16Bit);
-                    idxBufferPtr16Bit++;
+                    lastBatch = batchIx;
+                    batchVertexCount++;
                 }
             }
+            output.triangles[i] = triangle;
         }
+        output.batchBegins.push_back(triCnt);
 
         return output;
     }
 
-    static core::unordered_map<uint32_t, uint16_t> constructNewIndicesFromTriangleBatch(TriangleBatch& batch, uint16_t*& indexBuffPtr)
+    //! Old to new vertex index mapping of a batch, the flat table is sized for the whole meshbuffer and reused by all of its batches
+    struct VertexRemap
     {
-        core::unordered_map<uint32_t, uint16_t> usedVertices;
-        core::vector<Triangle> newIdxTris = batch.triangles;
+        _NBL_STATIC_INLINE_CONSTEXPR uint16_t INVALID_INDEX = 0xffffu;
 
-        uint32_t newIdx = 0u;
-        for (uint32_t i = 0u; i < batch.triangles.size(); i++)
-        {
-            const Triangle& triangle = batch.triangles[i];
-            for (int32_t j = 0; j < 3; j++)
-            {
-                const uint32_t oldIndex = triangle.oldIndices[j];
-                auto result = usedVertices.insert(std::make_pair(oldIndex, newIdx));
+        VertexRemap(uint32_t vertexIDUpperBound) : newIndices(vertexIDUpperBound,INVALID_INDEX) {}
 
-                newIdxTris[i].oldIndices[j] = result.second ? newIdx++ : result.first->second;
-            }
-        }
+        core::vector<uint16_t> newIndices;
+        // old indices of the batch's vertices, ordered by their new index
+        core::vector<uint32_t> usedVertices;
+    };
+
+    static void constructNewIndicesFromTriangleBatch(const TriangleBatch& batch, uint16_t*& indexBuffPtr, VertexRemap& remap)
+    {
+        // only reset what the previous batch touched
+        for (const uint32_t oldIndex : remap.usedVertices)
+            remap.newIndices[oldIndex] = VertexRemap::INVALID_INDEX;
+        remap.usedVertices.clear();
 
         //TODO: cache optimization
 
-        //copy indices into unified index buffer
-        for (size_t i = 0; i < batch.triangles.size(); i++)
+        //write remapped indices straight into the unified index buffer
+        for (const Triangle& triangle : batch)
         {
-            for (int j = 0; j < 3; j++)
+            for (int32_t j = 0; j < 3; j++)
             {
-                *indexBuffPtr = newIdxTris[i].oldIndices[j];
+                const uint32_t oldIndex = triangle.oldIndices[j];
+                uint16_t& newIndex = remap.newIndices[oldIndex];
+                if (newIndex == VertexRemap::INVALID_INDEX)
+                {
+                    newIndex = static_cast<uint16_t>(remap.usedVertices.size());
+                    remap.usedVertices.push_back(oldIndex);
+                }
+
+                *indexBuffPtr = newIndex;
                 indexBuffPtr++;
             }
         }
-
-        return usedVertices;
     }
 
-    static void deinterleaveAndCopyAttribute(MeshBufferType* meshBuffer, uint16_t attrLocation, const core::unordered_map<uint32_t, uint16_t>& usedVertices, uint8_t* dstAttrPtr)
+    static void deinterleaveAndCopyAttribute(MeshBufferType* meshBuffer, uint16_t attrLocation, const VertexRemap& remap, uint8_t* dstAttrPtr)
     {
         uint8_t* srcAttrPtr = meshBuffer->getAttribPointer(attrLocation);
         SVertexInputParams& mbVtxInputParams = meshBuffer->getPipeline()->getVertexInputParams();
@@ -277,11 +309,11 @@ protected:
         const size_t attrSize = asset::getTexelOrBlockBytesize(static_cast<E_FORMAT>(MBAttrib.format));
         const size_t stride = (attribBinding.stride) == 0 ? attrSize : attribBinding.stride;
 
-        for (auto index : usedVertices)
+        for (const uint32_t oldIndex : remap.usedVertices)
         {
-            const uint8_t* attrSrc = srcAttrPtr + (index.first * stride);
-            uint8_t* attrDest = dstAttrPtr + (index.second * attrSize);
-            memcpy(attrDest, attrSrc, attrSize);
+            const uint8_t* attrSrc = srcAttrPtr + (oldIndex * stride);
+            memcpy(dstAttrPtr, attrSrc, attrSize);
+            dstAttrPtr += attrSize;
         }
     }
 
@@ -301,6 +333,27 @@ protected:
 
     _NBL_STATIC_INLINE_CONSTEXPR uint32_t INVALID_ADDRESS = core::GeneralpurposeAddressAllocator<uint32_t>::invalid_address;
 
+private:
+    _NBL_STATIC_INLINE_CONSTEXPR uint32_t MortonBitsPerAxis = 10u;
+    _NBL_STATIC_INLINE_CONSTEXPR uint32_t MortonAxisMax = (0x1u<<MortonBitsPerAxis)-1u;
+
+    struct TriangleMortonCodePair
+    {
+        Triangle triangle;
+        uint32_t mortonCode;
+    };
+
+    struct MortonCodeKeyAccessor
+    {
+        _NBL_STATIC_INLINE_CONSTEXPR size_t key_bit_count = MortonBitsPerAxis*3u;
+
+        template<auto bit_offset, auto radix_mask>
+        inline decltype(radix_mask) operator()(const TriangleMortonCodePair& item) const
+        {
+            return static_cast<decltype(radix_mask)>(item.mortonCode>>static_cast<uint32_t>(bit_offset))&radix_mask;
+        }
+    };
+
 };
 
 }
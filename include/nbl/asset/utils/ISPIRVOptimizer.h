@@ -38,13 +38,16 @@ public:
         EOP_COUNT
     };
 
-    ISPIRVOptimizer(std::initializer_list<E_OPTIMIZER_PASS> _passes) : m_passes(std::move(_passes)) {}
+    ISPIRVOptimizer(std::initializer_list<E_OPTIMIZER_PASS> _passes) : m_passes(_passes) {}
 
     core::smart_refctd_ptr<ICPUBuffer> optimize(const uint32_t* _spirv, uint32_t _dwordCount) const;
     core::smart_refctd_ptr<ICPUBuffer> optimize(const ICPUBuffer* _spirv) const;
 
+    const core::vector<E_OPTIMIZER_PASS>& getPasses() const { return m_passes; }
+
 protected:
-    const std::initializer_list<E_OPTIMIZER_PASS> m_passes;
+    // an initializer_list doesn't own its elements, so they need copying
+    const core::vector<E_OPTIMIZER_PASS> m_passes;
 };
 
 }
@@ -6,11 +6,17 @@
 #define __NBL_CORE_RADIX_SORT_H_INCLUDED__
 
 #include <algorithm>
+#include <array>
 #include <bitset>
 #include <cstdint>
+#include <execution>
+#include <limits>
 #include <numeric>
+#include <thread>
+#include <utility>
 
 #include "nbl/macros.h"
+#include "nbl/core/Types.h"
 
 namespace nbl
 {
@@ -45,72 +51,219 @@ constexpr uint8_t find_msb(const T& a_variable)
     {
         if (variable_bitset[msb] == 1)
             return msb + 1;
-    }        
+    }
     return 0;
 }
 
+//! Marks a sort without a payload
+struct NoValues {};
+
+//! LSD sort, every pass counts per-chunk histograms, turns them into per-chunk scatter offsets and scatters the chunks concurrently
+/**
+	Chunks are contiguous and their offsets within a bucket follow the chunk order, so every pass is stable no matter how many threads run it.
+	With a sequenced policy there's only one chunk, which degenerates into the classic serial algorithm.
+*/
 template<size_t key_bit_count, typename histogram_t>
 struct RadixSorter
 {
 		_NBL_STATIC_INLINE_CONSTEXPR uint16_t histogram_bytesize = 8192u;
 		_NBL_STATIC_INLINE_CONSTEXPR size_t histogram_size = size_t(histogram_bytesize)/sizeof(histogram_t);
-		_NBL_STATIC_INLINE_CONSTEXPR uint8_t radix_bits = find_msb(histogram_size);
-		_NBL_STATIC_INLINE_CONSTEXPR size_t last_pass = (key_bit_count-1ull)/size_t(radix_bits);
+		_NBL_STATIC_INLINE_CONSTEXPR uint8_t radix_bits = find_msb(histogram_size)-1u;
+		_NBL_STATIC_INLINE_CONSTEXPR size_t pass_count = (key_bit_count-1ull)/size_t(radix_bits)+1ull;
 		_NBL_STATIC_INLINE_CONSTEXPR uint16_t radix_mask = (1u<<radix_bits)-1u;
+		//! below this many elements per thread the histogram clears and merges cost more than the threads save
+		_NBL_STATIC_INLINE_CONSTEXPR size_t min_chunk_size = 0x1ull<<16ull;
 
-		template<class RandomIt, class KeyAccessor>
-		inline RandomIt operator()(RandomIt input, RandomIt output, const histogram_t rangeSize, const KeyAccessor& comp)
+		template<class ExecutionPolicy, class KeyIt, class ValueIt, class KeyAccessor>
+		inline std::pair<KeyIt,ValueIt> operator()(ExecutionPolicy&& policy, KeyIt input, KeyIt output, ValueIt valuesIn, ValueIt valuesOut, const histogram_t rangeSize, const KeyAccessor& comp)
 		{
-			return pass<RandomIt,KeyAccessor,0ull>(input,output,rangeSize,comp);
+			if (rangeSize==0u)
+				return {input,valuesIn};
+
+			uint32_t chunkCount = 1u;
+			if constexpr (!std::is_same_v<std::decay_t<ExecutionPolicy>,std::execution::sequenced_policy>)
+				chunkCount = static_cast<uint32_t>(std::clamp<size_t>(size_t(rangeSize)/min_chunk_size,1ull,std::max(std::thread::hardware_concurrency(),1u)));
+			m_chunkSize = (rangeSize-1u)/chunkCount+1u;
+			m_chunks.resize(chunkCount);
+			std::iota(m_chunks.begin(),m_chunks.end(),0u);
+			m_histograms.resize(size_t(chunkCount)*histogram_size);
+
+			// passes whose digit is the same for every key would be a plain copy, so find them upfront
+			std::fill(m_digitDifferences.begin(),m_digitDifferences.end(),static_cast<uint16_t>(0u));
+			core::vector<std::array<uint16_t,pass_count> > chunkDigitDifferences(chunkCount);
+			std::for_each(policy,m_chunks.begin(),m_chunks.end(),[&](const uint32_t chunk) -> void
+			{
+				auto& differences = chunkDigitDifferences[chunk];
+				std::fill(differences.begin(),differences.end(),static_cast<uint16_t>(0u));
+				const histogram_t end = getChunkEnd(chunk,rangeSize);
+				for (histogram_t i=getChunkBegin(chunk); i<end; i++)
+					accumulateDigitDifferences(differences,input[0],input[i],comp,std::make_index_sequence<pass_count>());
+			});
+			for (const auto& differences : chunkDigitDifferences)
+			for (size_t i=0ull; i<pass_count; i++)
+				m_digitDifferences[i] |= differences[i];
+
+			pass<ExecutionPolicy,KeyIt,ValueIt,KeyAccessor,0ull>(policy,input,output,valuesIn,valuesOut,rangeSize,comp);
+			return {input,valuesIn};
 		}
 	private:
-		template<class RandomIt, class KeyAccessor, size_t pass_ix>
-		inline RandomIt pass(RandomIt input, RandomIt output, const histogram_t rangeSize, const KeyAccessor& comp)
+		inline histogram_t getChunkBegin(const uint32_t chunk) const
 		{
-			// clear
-			std::fill_n(histogram,histogram_size,static_cast<histogram_t>(0u));
-			// count
-			constexpr histogram_t shift = static_cast<histogram_t>(radix_bits*pass_ix);
-			for (histogram_t i=0u; i<rangeSize; i++)
-				++histogram[comp.operator()<shift,radix_mask>(input[i])];
-			// prefix sum
-			std::inclusive_scan(histogram,histogram+histogram_size,histogram);
-			// scatter
-			for (histogram_t i=0u; i<rangeSize; i++)
-				output[--histogram[comp.operator()<shift,radix_mask>(input[i])]] = input[i];
-
-			if constexpr (pass_ix != last_pass)
-				return pass<RandomIt,KeyAccessor,pass_ix+1ull>(output,input,rangeSize,comp);
-			else
-				return output;
+			return static_cast<histogram_t>(chunk*m_chunkSize);
+		}
+		inline histogram_t getChunkEnd(const uint32_t chunk, const histogram_t rangeSize) const
+		{
+			return static_cast<histogram_t>(std::min<size_t>(size_t(chunk+1u)*m_chunkSize,rangeSize));
 		}
-	
-		alignas(sizeof(histogram_t)) histogram_t histogram[histogram_size];
-};
 
-}
+		template<class Key, class KeyAccessor, size_t... pass_ixs>
+		static inline void accumulateDigitDifferences(std::array<uint16_t,pass_count>& differences, const Key& reference, const Key& item, const KeyAccessor& comp, std::index_sequence<pass_ixs...>)
+		{
+			((differences[pass_ixs] |= comp.operator()<static_cast<histogram_t>(radix_bits*pass_ixs),radix_mask>(reference)^comp.operator()<static_cast<histogram_t>(radix_bits*pass_ixs),radix_mask>(item)),...);
+		}
 
-template<class RandomIt, class KeyAccessor>
-inline RandomIt radix_sort(RandomIt input, RandomIt scratch, const size_t rangeSize, const KeyAccessor& comp)
+		//! on return `input` and `valuesIn` point at the sorted data
+		template<class ExecutionPolicy, class KeyIt, class ValueIt, class KeyAccessor, size_t pass_ix>
+		inline void pass(ExecutionPolicy&& policy, KeyIt& input, KeyIt& output, ValueIt& valuesIn, ValueIt& valuesOut, const histogram_t rangeSize, const KeyAccessor& comp)
+		{
+			if (m_digitDifferences[pass_ix])
+			{
+				constexpr histogram_t shift = static_cast<histogram_t>(radix_bits*pass_ix);
+				const uint32_t chunkCount = static_cast<uint32_t>(m_chunks.size());
+				// count
+				std::for_each(policy,m_chunks.begin(),m_chunks.end(),[&](const uint32_t chunk) -> void
+				{
+					histogram_t* histogram = m_histograms.data()+size_t(chunk)*histogram_size;
+					std::fill_n(histogram,histogram_size,static_cast<histogram_t>(0u));
+					const histogram_t end = getChunkEnd(chunk,rangeSize);
+					for (histogram_t i=getChunkBegin(chunk); i<end; i++)
+						++histogram[comp.operator()<shift,radix_mask>(input[i])];
+				});
+				// exclusive prefix sum in bucket-major, chunk-minor order turns the counts into scatter offsets
+				if (chunkCount>1u)
+				{
+					// every chunk sums up a slice of the buckets across all histograms, then the bucket totals get scanned serially
+					std::array<histogram_t,histogram_size> bucketOffsets;
+					const size_t bucketsPerChunk = (histogram_size-1ull)/chunkCount+1ull;
+					std::for_each(policy,m_chunks.begin(),m_chunks.end(),[&](const uint32_t chunk) -> void
+					{
+						const size_t end = std::min<size_t>((chunk+1u)*bucketsPerChunk,histogram_size);
+						for (size_t bucket=chunk*bucketsPerChunk; bucket<end; bucket++)
+						{
+							histogram_t total = 0u;
+							for (uint32_t c=0u; c<chunkCount; c++)
+								total += m_histograms[size_t(c)*histogram_size+bucket];
+							bucketOffsets[bucket] = total;
+						}
+					});
+					std::exclusive_scan(bucketOffsets.begin(),bucketOffsets.end(),bucketOffsets.begin(),static_cast<histogram_t>(0u));
+					std::for_each(policy,m_chunks.begin(),m_chunks.end(),[&](const uint32_t chunk) -> void
+					{
+						const size_t end = std::min<size_t>((chunk+1u)*bucketsPerChunk,histogram_size);
+						for (size_t bucket=chunk*bucketsPerChunk; bucket<end; bucket++)
+						{
+							histogram_t offset = bucketOffsets[bucket];
+							for (uint32_t c=0u; c<chunkCount; c++)
+							{
+								histogram_t& count = m_histograms[size_t(c)*histogram_size+bucket];
+								const histogram_t chunkOffset = offset;
+								offset += count;
+								count = chunkOffset;
+							}
+						}
+					});
+				}
+				else
+					std::exclusive_scan(m_histograms.begin(),m_histograms.end(),m_histograms.begin(),static_cast<histogram_t>(0u));
+				// scatter
+				std::for_each(policy,m_chunks.begin(),m_chunks.end(),[&](const uint32_t chunk) -> void
+				{
+					histogram_t* offsets = m_histograms.data()+size_t(chunk)*histogram_size;
+					const histogram_t end = getChunkEnd(chunk,rangeSize);
+					for (histogram_t i=getChunkBegin(chunk); i<end; i++)
+					{
+						const histogram_t dst = offsets[comp.operator()<shift,radix_mask>(input[i])]++;
+						output[dst] = input[i];
+						if constexpr (!std::is_same_v<ValueIt,NoValues*>)
+							valuesOut[dst] = valuesIn[i];
+					}
+				});
+
+				std::swap(input,output);
+				std::swap(valuesIn,valuesOut);
+			}
+
+			if constexpr (pass_ix+1ull != pass_count)
+				pass<ExecutionPolicy,KeyIt,ValueIt,KeyAccessor,pass_ix+1ull>(policy,input,output,valuesIn,valuesOut,rangeSize,comp);
+		}
+
+		core::vector<histogram_t> m_histograms;
+		core::vector<uint32_t> m_chunks;
+		size_t m_chunkSize;
+		std::array<uint16_t,pass_count> m_digitDifferences;
+};
+
+template<class ExecutionPolicy, class KeyIt, class ValueIt, class KeyAccessor>
+inline std::pair<KeyIt,ValueIt> dispatch_radix_sort(ExecutionPolicy&& policy, KeyIt input, KeyIt scratch, ValueIt valuesIn, ValueIt valuesScratch, const size_t rangeSize, const KeyAccessor& comp)
 {
 	assert(std::abs(std::distance(input,scratch))>=rangeSize);
 
 	if (rangeSize<static_cast<decltype(rangeSize)>(0x1ull<<16ull))
-		return impl::RadixSorter<KeyAccessor::key_bit_count,uint16_t>()(input,scratch,static_cast<uint16_t>(rangeSize),comp);
+		return impl::RadixSorter<KeyAccessor::key_bit_count,uint16_t>()(policy,input,scratch,valuesIn,valuesScratch,static_cast<uint16_t>(rangeSize),comp);
 	if (rangeSize<static_cast<decltype(rangeSize)>(0x1ull<<32ull))
-		return impl::RadixSorter<KeyAccessor::key_bit_count,uint32_t>()(input,scratch,static_cast<uint16_t>(rangeSize),comp);
+		return impl::RadixSorter<KeyAccessor::key_bit_count,uint32_t>()(policy,input,scratch,valuesIn,valuesScratch,static_cast<uint32_t>(rangeSize),comp);
 	else
-		return impl::RadixSorter<KeyAccessor::key_bit_count,size_t>()(input,scratch,rangeSize,comp);
+		return impl::RadixSorter<KeyAccessor::key_bit_count,size_t>()(policy,input,scratch,valuesIn,valuesScratch,rangeSize,comp);
+}
+
 }
 
 //! Because Radix Sort needs O(2n) space and a number of passes dependant on the key length, the final sorted range can be either in `input` or `scratch`
+/**
+	Passes whose digit is the same for all keys get skipped, so keys which only use their low bits sort faster.
+	A parallel `policy` splits the input into one chunk per hardware thread (as long as the chunks stay big enough).
+*/
+template<class ExecutionPolicy, class RandomIt, class KeyAccessor, typename=std::enable_if_t<std::is_execution_policy_v<std::decay_t<ExecutionPolicy> > > >
+inline RandomIt radix_sort(ExecutionPolicy&& policy, RandomIt input, RandomIt scratch, const size_t rangeSize, const KeyAccessor& comp)
+{
+	return impl::dispatch_radix_sort(policy,input,scratch,static_cast<impl::NoValues*>(nullptr),static_cast<impl::NoValues*>(nullptr),rangeSize,comp).first;
+}
+
+template<class RandomIt, class KeyAccessor>
+inline RandomIt radix_sort(RandomIt input, RandomIt scratch, const size_t rangeSize, const KeyAccessor& comp)
+{
+	return radix_sort(std::execution::seq,input,scratch,rangeSize,comp);
+}
+
 template<class RandomIt>
 inline RandomIt radix_sort(RandomIt input, RandomIt scratch, const size_t rangeSize)
 {
-	return radix_sort<RandomIt>(input,scratch,rangeSize,impl::KeyAdaptor<decltype(*input)>());
+	return radix_sort<RandomIt>(input,scratch,rangeSize,impl::KeyAdaptor<std::remove_cv_t<std::remove_reference_t<decltype(*input)> > >());
+}
+
+//! Sorts a separate payload array along with the keys, handy when the values are much bigger than the keys
+/**
+	The sorted keys and values always end up on the same side, so either `{keys,values}` or `{keyScratch,valueScratch}` gets returned.
+*/
+template<class ExecutionPolicy, class KeyIt, class ValueIt, class KeyAccessor, typename=std::enable_if_t<std::is_execution_policy_v<std::decay_t<ExecutionPolicy> > > >
+inline std::pair<KeyIt,ValueIt> radix_sort(ExecutionPolicy&& policy, KeyIt keys, KeyIt keyScratch, ValueIt values, ValueIt valueScratch, const size_t rangeSize, const KeyAccessor& comp)
+{
+	return impl::dispatch_radix_sort(policy,keys,keyScratch,values,valueScratch,rangeSize,comp);
+}
+
+template<class KeyIt, class ValueIt, class KeyAccessor>
+inline std::pair<KeyIt,ValueIt> radix_sort(KeyIt keys, KeyIt keyScratch, ValueIt values, ValueIt valueScratch, const size_t rangeSize, const KeyAccessor& comp)
+{
+	return radix_sort(std::execution::seq,keys,keyScratch,values,valueScratch,rangeSize,comp);
+}
+
+template<class KeyIt, class ValueIt>
+inline std::pair<KeyIt,ValueIt> radix_sort(KeyIt keys, KeyIt keyScratch, ValueIt values, ValueIt valueScratch, const size_t rangeSize)
+{
+	return radix_sort<KeyIt,ValueIt>(keys,keyScratch,values,valueScratch,rangeSize,impl::KeyAdaptor<std::remove_cv_t<std::remove_reference_t<decltype(*keys)> > >());
 }
 
 }
 }
 
-#endif
\ No newline at end of file
+#endif
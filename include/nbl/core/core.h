@@ -55,6 +55,7 @@
 // parallel
 #include "nbl/core/parallel/IThreadBound.h"
 #include "nbl/core/parallel/unlock_guard.h"
+#include "nbl/core/parallel/CThreadPool.h"
 // string
 #include "nbl/core/string/stringutil.h"
 #include "nbl/core/string/UniqueStringLiteralType.h"
@@ -71,6 +71,39 @@ namespace impl
 
         return x;
     }
+
+    template <typename T>
+    constexpr T morton3d_mask(uint32_t _n)
+    {
+        constexpr uint64_t mask[5] =
+        {
+            0x1249249249249249ull,
+            0x10C30C30C30C30C3ull,
+            0x100F00F00F00F00Full,
+            0x001F0000FF0000FFull,
+            0x001F00000000FFFFull
+        };
+        return static_cast<T>(mask[_n]);
+    }
+
+    //! Puts bits on every third position filling gaps with 0s
+    template <typename T, uint32_t bitDepth>
+    inline T separate_bits_3d(T x)
+    {
+        if constexpr (bitDepth>16u)
+        {
+            x = (x | (x << 32)) & morton3d_mask<T>(4);
+        }
+        if constexpr (bitDepth>8u)
+        {
+            x = (x | (x << 16)) & morton3d_mask<T>(3);
+        }
+        x = (x | (x << 8)) & morton3d_mask<T>(2);
+        x = (x | (x << 4)) & morton3d_mask<T>(1);
+        x = (x | (x << 2)) & morton3d_mask<T>(0);
+
+        return x;
+    }
 }
 
 template<typename T, uint32_t bitDepth=sizeof(T)*8u>
@@ -81,6 +114,10 @@ T morton2d_decode_y(T _morton) { return impl::morton2d_decode<T,bitDepth>(_morto
 template<typename T, uint32_t bitDepth=sizeof(T)*8u>
 T morton2d_encode(T x, T y) { return impl::separate_bits_2d<T,bitDepth>(x) | (impl::separate_bits_2d<T,bitDepth>(y)<<1); }
 
+//! `bitDepth` is per coordinate, so at most 10 for `uint32_t` and 21 for `uint64_t`
+template<typename T, uint32_t bitDepth=sizeof(T)*8u/3u>
+T morton3d_encode(T x, T y, T z) { return impl::separate_bits_3d<T,bitDepth>(x) | (impl::separate_bits_3d<T,bitDepth>(y)<<1) | (impl::separate_bits_3d<T,bitDepth>(z)<<2); }
+
 }}
 
 #endif
\ No newline at end of file
@@ -0,0 +1,189 @@
+// Copyright (C) 2018-2020 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+
+#ifndef __NBL_CORE_C_THREAD_POOL_H_INCLUDED__
+#define __NBL_CORE_C_THREAD_POOL_H_INCLUDED__
+
+#include "nbl/core/IReferenceCounted.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <future>
+#include <functional>
+#include <type_traits>
+#include <condition_variable>
+
+namespace nbl
+{
+namespace core
+{
+
+//! Fixed-size pool of worker threads consuming a single FIFO of tasks
+/**
+	Tasks are allowed to submit more tasks and wait on them. Waiting on a task which no worker
+	has picked up yet runs it inline on the waiting thread, so recursive fan-out (like an asset
+	loader loading its dependencies) can never starve the pool, and a thread only ever executes
+	work it actually depends on (no unrelated task can end up nested on its stack).
+*/
+class CThreadPool : public IReferenceCounted
+{
+		template<typename R>
+		struct SSharedState
+		{
+			template<typename F>
+			SSharedState(F&& f) : task(std::forward<F>(f)) {}
+
+			//! whoever claims the task first gets to run it
+			inline void tryRun()
+			{
+				if (!claimed.exchange(true,std::memory_order_acq_rel))
+					task();
+			}
+
+			std::packaged_task<R()> task;
+			std::atomic_bool claimed{false};
+		};
+
+	public:
+		//! Handle to a submitted task, `wait()` and `get()` run the task inline if it hasn't started yet
+		template<typename R>
+		class future_t
+		{
+				friend class CThreadPool;
+
+				std::shared_ptr<SSharedState<R> > m_state;
+				std::future<R> m_future;
+
+			public:
+				future_t() = default;
+				future_t(future_t<R>&&) = default;
+				future_t<R>& operator=(future_t<R>&&) = default;
+
+				inline bool valid() const { return m_future.valid(); }
+
+				inline void wait()
+				{
+					m_state->tryRun();
+					m_future.wait();
+				}
+
+				inline R get()
+				{
+					wait();
+					return m_future.get();
+				}
+		};
+
+		//! `_threadCount==0u` means as many workers as hardware threads
+		explicit CThreadPool(uint32_t _threadCount=0u)
+		{
+			if (_threadCount==0u)
+				_threadCount = std::max(std::thread::hardware_concurrency(),1u);
+
+			m_workers.reserve(_threadCount);
+			for (uint32_t i=0u; i<_threadCount; i++)
+				m_workers.emplace_back([this]() -> void {workerLoop();});
+		}
+
+		inline uint32_t getThreadCount() const { return static_cast<uint32_t>(m_workers.size()); }
+
+		//! Enqueue a callable, the returned future will hold its result
+		template<typename F>
+		inline future_t<std::invoke_result_t<F> > submit(F&& f)
+		{
+			using result_t = std::invoke_result_t<F>;
+
+			future_t<result_t> retval;
+			retval.m_state = std::make_shared<SSharedState<result_t> >(std::forward<F>(f));
+			retval.m_future = retval.m_state->task.get_future();
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				// `std::function` needs a copyable target, so the state is shared
+				m_tasks.emplace_back([state=retval.m_state]() -> void {state->tryRun();});
+			}
+			m_cv.notify_one();
+			return retval;
+		}
+
+		//! Invokes `f(i)` for every `i` in `[0,count)`, split into contiguous chunks, returns after all have finished
+		/** If `f` returns `bool` then so does `parallelFor`, with `false` if any invocation failed. */
+		template<typename F>
+		inline auto parallelFor(const size_t count, F&& f, size_t grainSize=0ull)
+		{
+			constexpr bool ReportsFailure = std::is_same_v<std::invoke_result_t<F&,size_t>,bool>;
+			using retval_t = std::conditional_t<ReportsFailure,bool,void>;
+
+			if (count==0ull)
+				return retval_t(ReportsFailure);
+			if (grainSize==0ull)
+				grainSize = std::max<size_t>(count/(size_t(getThreadCount())*4ull),1ull);
+
+			core::vector<future_t<bool> > chunks;
+			chunks.reserve((count+grainSize-1ull)/grainSize);
+			for (size_t begin=0ull; begin<count; begin+=grainSize)
+			{
+				const size_t end = std::min(begin+grainSize,count);
+				chunks.push_back(submit([&f,begin,end]() -> bool
+				{
+					bool success = true;
+					for (size_t i=begin; i<end; i++)
+					{
+						if constexpr (ReportsFailure)
+							success = f(i) && success;
+						else
+							f(i);
+					}
+					return success;
+				}));
+			}
+			// need to wait for all before returning, as the chunks reference `f`
+			bool success = true;
+			for (auto& chunk : chunks)
+				success = chunk.get() && success;
+			return retval_t(success);
+		}
+
+	protected:
+		virtual ~CThreadPool()
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_quit = true;
+			}
+			m_cv.notify_all();
+			for (auto& worker : m_workers)
+				worker.join();
+		}
+
+	private:
+		inline void workerLoop()
+		{
+			while (true)
+			{
+				std::function<void()> task;
+				{
+					std::unique_lock<std::mutex> lock(m_mutex);
+					m_cv.wait(lock,[this]() -> bool {return m_quit||!m_tasks.empty();});
+					// drain the queue before quitting so no future is left without a value
+					if (m_tasks.empty())
+						return;
+					task = std::move(m_tasks.front());
+					m_tasks.pop_front();
+				}
+				task();
+			}
+		}
+
+		core::vector<std::thread> m_workers;
+		core::deque<std::function<void()> > m_tasks;
+		std::mutex m_mutex;
+		std::condition_variable m_cv;
+		bool m_quit = false;
+};
+
+} // end namespace core
+} // end namespace nbl
+
+#endif
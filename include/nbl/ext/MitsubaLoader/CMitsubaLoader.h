@@ -35,8 +35,17 @@ class CMitsubaLoader : public asset::IRenderpassIndependentPipelineLoader
 
 		void initialize() override;
 
+		//! When enabled (the default) the independent parts of a scene (model files, textures, derived images and per-shape mesh processing) get prepared concurrently
+		/** The final meshes, metadata and descriptor set come out the same either way, the switch is there for debugging and for overrides which aren't thread-safe. */
+		inline void setParallelInstantiation(bool enable) { m_parallelInstantiation = enable; }
+		inline bool getParallelInstantiation() const { return m_parallelInstantiation; }
+
 	protected:
 		io::IFileSystem* m_filesystem;
+		//! used directly to only decode the shapes a scene references, instead of whole `.serialized` files
+		core::smart_refctd_ptr<CSerializedLoader> m_serializedLoader;
+		//! whether `prepareScene` runs its tasks on the asset manager's thread pool
+		bool m_parallelInstantiation = true;
 
 		//! Destructor
 		virtual ~CMitsubaLoader() = default;
@@ -44,11 +53,16 @@ class CMitsubaLoader : public asset::IRenderpassIndependentPipelineLoader
 		static core::smart_refctd_ptr<asset::ICPUPipelineLayout> createPipelineLayout(asset::IAssetManager* _manager, asset::ICPUVirtualTexture* _vt);
 
 		//
+		void									prepareScene(SContext& ctx, uint32_t hierarchyLevel, const core::vector<std::pair<CElementShape*,std::string> >& shapes);
 		core::vector<SContext::shape_ass_type>	getMesh(SContext& ctx, uint32_t hierarchyLevel, CElementShape* shape);
 		core::vector<SContext::shape_ass_type>	loadShapeGroup(SContext& ctx, uint32_t hierarchyLevel, const CElementShape::ShapeGroup* shapegroup, const core::matrix3x4SIMD& relTform);
 		SContext::shape_ass_type				loadBasicShape(SContext& ctx, uint32_t hierarchyLevel, CElementShape* shape, const core::matrix3x4SIMD& relTform);
+		SContext::shape_ass_type				createShapeMesh(SContext& ctx, uint32_t hierarchyLevel, CElementShape* shape);
 		
+		core::smart_refctd_ptr<asset::ICPUImageView>	cacheTextureView(SContext& ctx, uint32_t hierarchyLevel, const CElementTexture* bitmap, bool _restore = false);
 		SContext::tex_ass_type					cacheTexture(SContext& ctx, uint32_t hierarchyLevel, const CElementTexture* texture, bool _restore = false);
+		void									cacheDerivMap(SContext& ctx, const CElementTexture* bumpmap);
+		void									cacheBlendWeightImage(SContext& ctx, const CElementTexture* weight);
 
 		SContext::bsdf_type getBSDFtreeTraversal(SContext& ctx, const CElementBSDF* bsdf);
 		SContext::bsdf_type genBSDFtreeTraversal(SContext& ctx, const CElementBSDF* bsdf);
@@ -48,6 +48,11 @@ class CSerializedLoader final : public asset::IRenderpassIndependentPipelineLoad
 		//! creates/loads an animated mesh from the file.
 		asset::SAssetBundle loadAsset(io::IReadFile* _file, const asset::IAssetLoader::SAssetLoadParams& _params, asset::IAssetLoader::IAssetLoaderOverride* _override = nullptr, uint32_t _hierarchyLevel = 0u) override;
 
+		//! Lazy variant of `loadAsset`, only decodes the meshes whose shape index (position in the file's offset table) is in `_shapeIndices`
+		/** The bundle holds the meshes which decoded successfully in ascending shape index order, `CMitsubaSerializedMetadata::CMesh::m_id` tells which is which.
+		Such a partial bundle must not be inserted into the asset cache under the file's name. */
+		asset::SAssetBundle loadShapes(io::IReadFile* _file, const core::SRange<const uint32_t>& _shapeIndices, const asset::IAssetLoader::SAssetLoadParams& _params, asset::IAssetLoader::IAssetLoaderOverride* _override = nullptr, uint32_t _hierarchyLevel = 0u);
+
 	private:
 
 		struct FileHeader
@@ -66,8 +71,29 @@ class CSerializedLoader final : public asset::IRenderpassIndependentPipelineLoad
 		{
 			IAssetLoader::SAssetLoadContext inner;
 			uint32_t meshCount;
+			//! first `meshCount` elements are the offsets of the meshes' compressed data, the next `meshCount` are its sizes
 			core::smart_refctd_dynamic_array<uint64_t> meshOffsets;
 		};
+
+		//! a mesh inflated and converted to an interleaved vertex buffer followed by the index buffer
+		struct SDecodedMesh
+		{
+			core::smart_refctd_ptr<asset::ICPUBuffer> buffer;
+			std::string name;
+			uint32_t flags;
+			size_t typeSize;
+			size_t vertexSize;
+			uint64_t vertexCount;
+			uint64_t triangleCount;
+			core::aabbox3df aabb;
+		};
+
+		//! reads the header and the offset table at the end of the file
+		bool readOffsetTable(SContext& ctx) const;
+		//! the actual loading, `shapeIndices` must be sorted and unique
+		asset::SAssetBundle loadShapes_impl(SContext& ctx, const core::vector<uint32_t>& shapeIndices, asset::IAssetLoader::IAssetLoaderOverride* _override, uint32_t _hierarchyLevel);
+		//! only touches its arguments, so it can run on any thread
+		static SDecodedMesh decodeMesh(const asset::IAssetLoader::SAssetLoadParams& _params, const uint8_t* compressed, size_t compressedSize, uint32_t shapeIndex);
 };
 
 
@@ -47,6 +47,8 @@ namespace MitsubaLoader
 		//
 		using shape_ass_type = core::smart_refctd_ptr<asset::ICPUMesh>;
 		core::map<const CElementShape*, shape_ass_type> shapeCache;
+		//! model files loaded up front (`.serialized` ones with only the shapes the scene references), keyed by the filename used in the scene
+		core::unordered_map<std::string, asset::SAssetBundle> modelCache;
 		//image, sampler
 		using tex_ass_type = std::tuple<core::smart_refctd_ptr<asset::ICPUImageView>, core::smart_refctd_ptr<asset::ICPUSampler>>;
 
@@ -0,0 +1,180 @@
+// Copyright (C) 2018-2021 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+
+#ifndef __NBL_SCENE_C_CPU_INSTANCE_CULLER_H_INCLUDED__
+#define __NBL_SCENE_C_CPU_INSTANCE_CULLER_H_INCLUDED__
+
+#include <execution>
+
+#include "nbl/core/core.h"
+
+#include "aabbox3d.h"
+#include "SViewFrustum.h"
+
+namespace nbl
+{
+namespace scene
+{
+
+//! Frustum culling and LoD selection of instances on the CPU, does the same job as the transform feedback pass of the instanced mesh nodes
+/**
+	The instance bounding boxes are stored SoA and tested against the frustum planes four at a time.
+	An instance gets the first LoD whose squared switch distance is larger than the squared distance from the camera to its box center,
+	instances further away than the last LoD's distance get culled.
+
+	The output is a single list of instance IDs sorted by LoD (and by ID within a LoD), in the same order regardless of the thread count.
+	Just like the other scene managers this is not thread-safe, only `cull` spreads its work over threads.
+*/
+class CCPUInstanceCuller
+{
+	public:
+		using instance_t = uint32_t;
+
+		//
+		inline uint32_t getInstanceCapacity() const {return m_minX.size();}
+		//! new instances start with an empty box, which always gets culled
+		inline void setInstanceCapacity(const uint32_t capacity)
+		{
+			const uint32_t paddedCapacity = core::roundUp(capacity,BatchSize);
+			for (auto* bound : {&m_minX,&m_minY,&m_minZ})
+				bound->resize(paddedCapacity,FLT_MAX);
+			for (auto* bound : {&m_maxX,&m_maxY,&m_maxZ})
+				bound->resize(paddedCapacity,-FLT_MAX);
+		}
+
+		//!
+		inline void setInstanceBox(const instance_t instance, const core::aabbox3df& box)
+		{
+			m_minX[instance] = box.MinEdge.X;
+			m_minY[instance] = box.MinEdge.Y;
+			m_minZ[instance] = box.MinEdge.Z;
+			m_maxX[instance] = box.MaxEdge.X;
+			m_maxY[instance] = box.MaxEdge.Y;
+			m_maxZ[instance] = box.MaxEdge.Z;
+		}
+		inline core::aabbox3df getInstanceBox(const instance_t instance) const
+		{
+			return core::aabbox3df(m_minX[instance],m_minY[instance],m_minZ[instance],m_maxX[instance],m_maxY[instance],m_maxZ[instance]);
+		}
+		//! a removed instance keeps its slot but never passes the culling
+		inline void removeInstance(const instance_t instance)
+		{
+			m_minX[instance] = m_minY[instance] = m_minZ[instance] = FLT_MAX;
+			m_maxX[instance] = m_maxY[instance] = m_maxZ[instance] = -FLT_MAX;
+		}
+
+		//! Culls all the instances, the boxes, the frustum and the camera position need to be in the same space
+		/**
+		@param lodDistancesSQ Squared LoD switch distances in increasing order, one per LoD.
+		@param outInstances Gets resized to the number of instances which passed.
+		@param outLoDOffsets `lodCount+1` entries, the instances drawn with LoD `i` are in `[outLoDOffsets[i],outLoDOffsets[i+1])` of `outInstances`.
+		*/
+		template<class ExecutionPolicy>
+		inline void cull(	ExecutionPolicy&& policy, const SViewFrustum& frustum, const core::vectorSIMDf& cameraPosition,
+							const float* lodDistancesSQ, const uint32_t lodCount, core::vector<instance_t>& outInstances, uint32_t* outLoDOffsets)
+		{
+			const uint32_t capacity = getInstanceCapacity();
+			const uint32_t chunkCount = (capacity+ChunkSize-1u)/ChunkSize;
+			// one counter per LoD and chunk, so the output can be placed without any atomics
+			m_lods.resize(capacity);
+			m_chunkLoDCounts.resize(chunkCount*lodCount);
+			std::fill(m_chunkLoDCounts.begin(),m_chunkLoDCounts.end(),0u);
+
+			core::vector<uint32_t> chunks(chunkCount);
+			std::iota(chunks.begin(),chunks.end(),0u);
+			std::for_each(policy,chunks.begin(),chunks.end(),[&](const uint32_t chunk) -> void
+			{
+				uint32_t* lodCounts = m_chunkLoDCounts.data()+chunk*lodCount;
+				const uint32_t end = core::min((chunk+1u)*ChunkSize,capacity);
+				for (uint32_t batch=chunk*ChunkSize; batch<end; batch+=BatchSize)
+				{
+					uint32_t* lods = m_lods.data()+batch;
+					selectLoDs(frustum,cameraPosition,lodDistancesSQ,lodCount,batch,lods);
+					for (uint32_t i=0u; i<BatchSize; i++)
+					if (lods[i]<lodCount)
+						lodCounts[lods[i]]++;
+				}
+			});
+
+			// exclusive scan with the LoD as the major and the chunk as the minor key
+			uint32_t offset = 0u;
+			for (uint32_t lod=0u; lod<lodCount; lod++)
+			{
+				outLoDOffsets[lod] = offset;
+				for (uint32_t chunk=0u; chunk<chunkCount; chunk++)
+				{
+					auto& count = m_chunkLoDCounts[chunk*lodCount+lod];
+					const uint32_t chunkOffset = offset;
+					offset += count;
+					count = chunkOffset;
+				}
+			}
+			outLoDOffsets[lodCount] = offset;
+
+			outInstances.resize(offset);
+			std::for_each(policy,chunks.begin(),chunks.end(),[&](const uint32_t chunk) -> void
+			{
+				uint32_t* lodCursors = m_chunkLoDCounts.data()+chunk*lodCount;
+				const uint32_t end = core::min((chunk+1u)*ChunkSize,capacity);
+				for (uint32_t instance=chunk*ChunkSize; instance<end; instance++)
+				{
+					const uint32_t lod = m_lods[instance];
+					if (lod<lodCount)
+						outInstances[lodCursors[lod]++] = instance;
+				}
+			});
+		}
+
+	protected:
+		_NBL_STATIC_INLINE_CONSTEXPR uint32_t BatchSize = 4u;
+		//! instances processed by one task, a multiple of `BatchSize`
+		_NBL_STATIC_INLINE_CONSTEXPR uint32_t ChunkSize = 4096u;
+
+		//! writes `lodCount` for instances which get culled
+		inline void selectLoDs(const SViewFrustum& frustum, const core::vectorSIMDf& cameraPosition, const float* lodDistancesSQ, const uint32_t lodCount, const uint32_t batch, uint32_t* outLoDs) const
+		{
+			const core::vectorSIMDf minEdge[3] = {core::vectorSIMDf(m_minX.data()+batch,true),core::vectorSIMDf(m_minY.data()+batch,true),core::vectorSIMDf(m_minZ.data()+batch,true)};
+			const core::vectorSIMDf maxEdge[3] = {core::vectorSIMDf(m_maxX.data()+batch,true),core::vectorSIMDf(m_maxY.data()+batch,true),core::vectorSIMDf(m_maxZ.data()+batch,true)};
+
+			// empty boxes (and the padding) fail this
+			auto visible = minEdge[0]<=maxEdge[0];
+			for (uint32_t i=0u; i<SViewFrustum::VF_PLANE_COUNT; i++)
+			{
+				// the plane is the same for all lanes, so the corner furthest along its normal can be picked per axis
+				const auto& plane = reinterpret_cast<const core::vectorSIMDf&>(frustum.planes[i]);
+				core::vectorSIMDf distance(plane.w);
+				for (uint32_t axis=0u; axis<3u; axis++)
+					distance += (plane.pointer[axis]>0.f ? maxEdge[axis]:minEdge[axis])*plane.pointer[axis];
+				visible = visible&(distance>=core::vectorSIMDf(0.f));
+			}
+
+			core::vectorSIMDf distanceSQ(0.f);
+			for (uint32_t axis=0u; axis<3u; axis++)
+			{
+				const auto delta = (minEdge[axis]+maxEdge[axis])*0.5f-core::vectorSIMDf(cameraPosition.pointer[axis]);
+				distanceSQ += delta*delta;
+			}
+			// the LoD is the count of switch distances not further than the instance, a true lane is all ones so it subtracts -1
+			__m128i lod = _mm_setzero_si128();
+			for (uint32_t i=0u; i<lodCount; i++)
+				lod = _mm_sub_epi32(lod,(distanceSQ>=core::vectorSIMDf(lodDistancesSQ[i])).getAsRegister());
+			// culled instances get `lodCount`
+			const __m128i visibleMask = visible.getAsRegister();
+			lod = _mm_or_si128(_mm_and_si128(visibleMask,lod),_mm_andnot_si128(visibleMask,_mm_set1_epi32(lodCount)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(outLoDs),lod);
+		}
+
+		core::vector<float> m_minX,m_minY,m_minZ;
+		core::vector<float> m_maxX,m_maxY,m_maxZ;
+
+		// scratch
+		core::vector<uint32_t> m_lods;
+		core::vector<uint32_t> m_chunkLoDCounts;
+};
+
+
+} // end namespace scene
+} // end namespace nbl
+
+#endif
@@ -0,0 +1,256 @@
+// Copyright (C) 2018-2021 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+
+#ifndef __NBL_SCENE_I_CPU_TRANSFORM_TREE_MANAGER_H_INCLUDED__
+#define __NBL_SCENE_I_CPU_TRANSFORM_TREE_MANAGER_H_INCLUDED__
+
+#include <execution>
+
+#include "nbl/core/core.h"
+
+#include "nbl/scene/ITransformTreeManager.h"
+
+namespace nbl
+{
+namespace scene
+{
+
+//! Reference implementation of `ITransformTreeManager` which keeps and evaluates the tree on the CPU
+/**
+	The node properties are stored in one memory block laid out exactly like the `ITransformTreeManager::property_pool_t`
+	of the same capacity, so a downloaded GPU pool can be compared against `getMemoryBlock()` directly.
+
+	A node's global transform only gets recomputed if its relative transform was modified after its last recompute,
+	or its parent's global transform was recomputed after it. The nodes are kept sorted by their depth in the tree,
+	every depth level only depends on the previous one and gets processed in parallel.
+
+	Just like the property pools this is not thread-safe, only `recomputeGlobalTransforms` spreads its work over threads.
+*/
+class ICPUTransformTreeManager : public virtual core::IReferenceCounted
+{
+	public:
+		using node_t = ITransformTreeManager::node_t;
+		_NBL_STATIC_INLINE_CONSTEXPR node_t invalid_node = ITransformTreeManager::invalid_node;
+
+		using timestamp_t = ITransformTreeManager::timestamp_t;
+		_NBL_STATIC_INLINE_CONSTEXPR timestamp_t min_timestamp = ITransformTreeManager::min_timestamp;
+		_NBL_STATIC_INLINE_CONSTEXPR timestamp_t max_timestamp = ITransformTreeManager::max_timestamp;
+
+		using parent_t = ITransformTreeManager::parent_t;
+		using relative_transform_t = ITransformTreeManager::relative_transform_t;
+		using modified_stamp_t = ITransformTreeManager::modified_stamp_t;
+		using global_transform_t = ITransformTreeManager::global_transform_t;
+		using recomputed_stamp_t = ITransformTreeManager::recomputed_stamp_t;
+
+		using RelativeTransformModificationRequest = ITransformTreeManager::RelativeTransformModificationRequest;
+
+		//
+		static inline core::smart_refctd_ptr<ICPUTransformTreeManager> create(const uint32_t capacity)
+		{
+			if (capacity==0u || capacity==invalid_node)
+				return nullptr;
+
+			auto* ttm = new ICPUTransformTreeManager(capacity);
+			return core::smart_refctd_ptr<ICPUTransformTreeManager>(ttm,core::dont_grab);
+		}
+
+		//
+		inline uint32_t getCapacity() const {return m_nodeAllocator.get_total_size();}
+		inline uint32_t getAllocated() const {return m_nodeAllocator.get_allocated_size();}
+		inline uint32_t getFree() const {return m_nodeAllocator.get_free_size();}
+
+		//! same offsets as `CPropertyPool::getPropertyOffset` for a memory block starting at 0
+		inline size_t getPropertyOffset(const uint32_t ix) const {return m_propertyOffsets[ix];}
+		inline const uint8_t* getMemoryBlock() const {return m_memoryBlock;}
+		inline size_t getMemoryBlockSize() const {return m_propertyOffsets[PropertyCount-1u]+PropertySizes[PropertyCount-1u]*size_t(getCapacity());}
+
+		//
+		inline const parent_t* getParents() const {return getProperty<parent_t,ITransformTreeManager::parent_prop_ix>();}
+		inline const relative_transform_t* getRelativeTransforms() const {return getProperty<relative_transform_t,ITransformTreeManager::relative_transform_prop_ix>();}
+		inline const modified_stamp_t* getModifiedTimestamps() const {return getProperty<modified_stamp_t,ITransformTreeManager::modified_stamp_prop_ix>();}
+		inline const global_transform_t* getGlobalTransforms() const {return getProperty<global_transform_t,ITransformTreeManager::global_transform_prop_ix>();}
+		inline const recomputed_stamp_t* getRecomputedTimestamps() const {return getProperty<recomputed_stamp_t,ITransformTreeManager::recomputed_stamp_prop_ix>();}
+
+		//
+		struct AllocationRequest
+		{
+			core::SRange<node_t> outNodes = {nullptr,nullptr};
+			//! a parent needs to be allocated before its children, `nullptr` makes all the nodes roots
+			const parent_t* parents = nullptr;
+			//! `nullptr` initializes the relative transforms to identity
+			const relative_transform_t* relativeTransforms = nullptr;
+		};
+		//! New nodes always get their global transforms computed by the next `recomputeGlobalTransforms`
+		/** @returns False and allocates nothing if there's not enough free nodes. */
+		inline bool addNodes(const AllocationRequest& request)
+		{
+			const uint32_t count = request.outNodes.size();
+			if (count>getFree())
+				return false;
+
+			auto parents = getProperty<parent_t,ITransformTreeManager::parent_prop_ix>();
+			auto relativeTransforms = getProperty<relative_transform_t,ITransformTreeManager::relative_transform_prop_ix>();
+			auto modifiedStamps = getProperty<modified_stamp_t,ITransformTreeManager::modified_stamp_prop_ix>();
+			auto globalTransforms = getProperty<global_transform_t,ITransformTreeManager::global_transform_prop_ix>();
+			auto recomputedStamps = getProperty<recomputed_stamp_t,ITransformTreeManager::recomputed_stamp_prop_ix>();
+			for (uint32_t i=0u; i<count; i++)
+			{
+				const node_t node = m_nodeAllocator.alloc_addr(1u,1u);
+				assert(node!=invalid_node);
+				request.outNodes.begin()[i] = node;
+
+				const parent_t parent = request.parents ? request.parents[i]:invalid_node;
+				assert(parent==invalid_node || m_depths[parent]!=invalid_depth);
+				parents[node] = parent;
+				m_depths[node] = parent!=invalid_node ? (m_depths[parent]+1u):0u;
+				relativeTransforms[node] = request.relativeTransforms ? request.relativeTransforms[i]:relative_transform_t();
+				modifiedStamps[node] = ITransformTreeManager::initial_modified_timestamp;
+				globalTransforms[node] = global_transform_t();
+				recomputedStamps[node] = ITransformTreeManager::initial_recomputed_timestamp;
+			}
+			m_levelsOutdated = true;
+			return true;
+		}
+		//! Children need to be removed together with their parents
+		inline void removeNodes(const node_t* begin, const node_t* end)
+		{
+			for (auto it=begin; it!=end; it++)
+			if (*it!=invalid_node)
+			{
+				m_nodeAllocator.free_addr(*it,1u);
+				m_depths[*it] = invalid_depth;
+			}
+			m_levelsOutdated = true;
+		}
+		//
+		inline void clearNodes()
+		{
+			m_nodeAllocator.reset();
+			std::fill(m_depths.begin(),m_depths.end(),invalid_depth);
+			m_levelsOutdated = true;
+		}
+
+		//! Applies the requests in order, several requests for the same node accumulate
+		/** `timestamp` needs to be newer than the one of the last `recomputeGlobalTransforms` for the modified nodes to get recomputed. */
+		inline void updateLocalTransforms(const node_t* nodes, const RelativeTransformModificationRequest* requests, const uint32_t count, const timestamp_t timestamp)
+		{
+			assert(timestamp<=max_timestamp);
+			auto relativeTransforms = getProperty<relative_transform_t,ITransformTreeManager::relative_transform_prop_ix>();
+			auto modifiedStamps = getProperty<modified_stamp_t,ITransformTreeManager::modified_stamp_prop_ix>();
+			for (uint32_t i=0u; i<count; i++)
+			{
+				const node_t node = nodes[i];
+				assert(m_depths[node]!=invalid_depth);
+				requests[i].apply(relativeTransforms[node]);
+				// a node which was never recomputed stays marked as such
+				if (modifiedStamps[node]!=ITransformTreeManager::initial_modified_timestamp)
+					modifiedStamps[node] = timestamp;
+			}
+		}
+
+		//! Recomputes the outdated global transforms and marks them with `timestamp`
+		/** @returns The number of recomputed nodes. */
+		template<class ExecutionPolicy>
+		inline uint32_t recomputeGlobalTransforms(ExecutionPolicy&& policy, const timestamp_t timestamp)
+		{
+			assert(timestamp<=max_timestamp);
+			if (m_levelsOutdated)
+				sortNodesByDepth();
+
+			const auto parents = getParents();
+			const auto relativeTransforms = getRelativeTransforms();
+			auto modifiedStamps = getProperty<modified_stamp_t,ITransformTreeManager::modified_stamp_prop_ix>();
+			auto globalTransforms = getProperty<global_transform_t,ITransformTreeManager::global_transform_prop_ix>();
+			auto recomputedStamps = getProperty<recomputed_stamp_t,ITransformTreeManager::recomputed_stamp_prop_ix>();
+			std::atomic<uint32_t> recomputed = 0u;
+			for (uint32_t level=0u; level+1u<m_levelOffsets.size(); level++)
+			{
+				const auto levelBegin = m_sortedNodes.begin()+m_levelOffsets[level];
+				const auto levelEnd = m_sortedNodes.begin()+m_levelOffsets[level+1u];
+				std::for_each(policy,levelBegin,levelEnd,[&](const node_t node) -> void
+				{
+					const parent_t parent = parents[node];
+					const recomputed_stamp_t lastRecompute = recomputedStamps[node];
+					// a new node has both stamps set to the reserved values which compare as modified after recompute
+					const bool outdated = modifiedStamps[node]>lastRecompute || (parent!=invalid_node&&recomputedStamps[parent]>lastRecompute);
+					if (!outdated)
+						return;
+
+					if (parent!=invalid_node)
+						globalTransforms[node] = core::concatenateBFollowedByA(globalTransforms[parent],relativeTransforms[node]);
+					else
+						globalTransforms[node] = relativeTransforms[node];
+					recomputedStamps[node] = timestamp;
+					if (modifiedStamps[node]==ITransformTreeManager::initial_modified_timestamp)
+						modifiedStamps[node] = timestamp;
+					recomputed.fetch_add(1u,std::memory_order_relaxed);
+				});
+			}
+			return recomputed.load();
+		}
+
+	protected:
+		_NBL_STATIC_INLINE_CONSTEXPR uint32_t PropertyCount = 5u;
+		_NBL_STATIC_INLINE_CONSTEXPR size_t PropertySizes[PropertyCount] = {sizeof(parent_t),sizeof(relative_transform_t),sizeof(modified_stamp_t),sizeof(global_transform_t),sizeof(recomputed_stamp_t)};
+		_NBL_STATIC_INLINE_CONSTEXPR uint32_t invalid_depth = ~0u;
+
+		using NodeAllocator = core::PoolAddressAllocatorST<node_t>;
+
+		ICPUTransformTreeManager(const uint32_t capacity) : m_nodeAllocatorReserved(core::roundUp<size_t>(NodeAllocator::reserved_size(1u,capacity,1u),sizeof(uint32_t))/sizeof(uint32_t)),
+			m_nodeAllocator(m_nodeAllocatorReserved.data(),0u,0u,1u,capacity,1u), m_depths(capacity,invalid_depth)
+		{
+			m_propertyOffsets[0] = 0ull;
+			for (uint32_t i=1u; i<PropertyCount; i++)
+				m_propertyOffsets[i] = core::roundUp(m_propertyOffsets[i-1u]+PropertySizes[i-1u]*size_t(capacity),PropertySizes[i]);
+			m_memoryBlock = reinterpret_cast<uint8_t*>(_NBL_ALIGNED_MALLOC(getMemoryBlockSize(),_NBL_SIMD_ALIGNMENT));
+		}
+		~ICPUTransformTreeManager()
+		{
+			_NBL_ALIGNED_FREE(m_memoryBlock);
+		}
+
+		template<typename T, uint32_t ix>
+		inline T* getProperty() {return reinterpret_cast<T*>(m_memoryBlock+m_propertyOffsets[ix]);}
+		template<typename T, uint32_t ix>
+		inline const T* getProperty() const {return reinterpret_cast<const T*>(m_memoryBlock+m_propertyOffsets[ix]);}
+
+		//! counting sort of all the allocated nodes by depth, within a level the nodes stay in the order of their indices
+		inline void sortNodesByDepth()
+		{
+			m_levelOffsets.clear();
+			for (const auto depth : m_depths)
+			if (depth!=invalid_depth)
+			{
+				if (depth+1u>=m_levelOffsets.size())
+					m_levelOffsets.resize(depth+2u,0u);
+				m_levelOffsets[depth+1u]++;
+			}
+			std::partial_sum(m_levelOffsets.begin(),m_levelOffsets.end(),m_levelOffsets.begin());
+
+			m_sortedNodes.resize(getAllocated());
+			core::vector<uint32_t> levelCursors(m_levelOffsets);
+			for (node_t node=0u; node<m_depths.size(); node++)
+			if (m_depths[node]!=invalid_depth)
+				m_sortedNodes[levelCursors[m_depths[node]]++] = node;
+			m_levelsOutdated = false;
+		}
+
+		core::vector<uint32_t> m_nodeAllocatorReserved;
+		NodeAllocator m_nodeAllocator;
+		size_t m_propertyOffsets[PropertyCount];
+		uint8_t* m_memoryBlock;
+
+		//! only for the CPU, the depth of every allocated node
+		core::vector<uint32_t> m_depths;
+		//! allocated nodes sorted by depth, nodes at depth `i` are in `[m_levelOffsets[i],m_levelOffsets[i+1])`
+		core::vector<node_t> m_sortedNodes;
+		core::vector<uint32_t> m_levelOffsets;
+		bool m_levelsOutdated = true;
+};
+
+
+} // end namespace scene
+} // end namespace nbl
+
+#endif
@@ -24,17 +24,22 @@ class ITransformTreeManager : public virtual core::IReferenceCounted
 		// two timestamp values are reserved for initialization
 		_NBL_STATIC_INLINE_CONSTEXPR timestamp_t min_timestamp = 0u;
 		_NBL_STATIC_INLINE_CONSTEXPR timestamp_t max_timestamp = 0xfffffffdu;
+		// a new node has never been recomputed and counts as modified after everything
+		_NBL_STATIC_INLINE_CONSTEXPR timestamp_t initial_recomputed_timestamp = max_timestamp+1u;
+		_NBL_STATIC_INLINE_CONSTEXPR timestamp_t initial_modified_timestamp = max_timestamp+2u;
 
 		_NBL_STATIC_INLINE_CONSTEXPR uint32_t parent_prop_ix = 0u;
+		_NBL_STATIC_INLINE_CONSTEXPR uint32_t relative_transform_prop_ix = 1u;
+		_NBL_STATIC_INLINE_CONSTEXPR uint32_t modified_stamp_prop_ix = 2u;
 		_NBL_STATIC_INLINE_CONSTEXPR uint32_t global_transform_prop_ix = 3u;
-	private:
+		_NBL_STATIC_INLINE_CONSTEXPR uint32_t recomputed_stamp_prop_ix = 4u;
+
 		using parent_t = node_t;
 		using relative_transform_t = core::matrix3x4SIMD;
 		using modified_stamp_t = timestamp_t;
 		using global_transform_t = core::matrix3x4SIMD;
 		using recomputed_stamp_t = timestamp_t;
 
-	public:
 		using property_pool_t = video::CPropertyPool<core::allocator,
 			parent_t,
 			relative_transform_t,modified_stamp_t,
@@ -73,6 +78,37 @@ class ITransformTreeManager : public virtual core::IReferenceCounted
 					retval |= (reinterpret_cast<const uint32_t&>(storage.rows[2].z)&0x1u)<<1u;
 					return static_cast<E_TYPE>(retval);
 				}
+				//! the (weighted) modification without the type bits
+				inline core::matrix3x4SIMD getModification() const
+				{
+					auto retval = storage;
+					reinterpret_cast<uint32_t&>(retval.rows[0].x) &= ~0x1u;
+					reinterpret_cast<uint32_t&>(retval.rows[2].z) &= ~0x1u;
+					return retval;
+				}
+				//! applies the modification to a relative transform
+				inline void apply(core::matrix3x4SIMD& relativeTransform) const
+				{
+					const auto modification = getModification();
+					switch (getType())
+					{
+						case ET_OVERWRITE:
+							relativeTransform = modification;
+							break;
+						case ET_CONCATENATE_AFTER:
+							relativeTransform = core::concatenateBFollowedByA(modification,relativeTransform);
+							break;
+						case ET_CONCATENATE_BEFORE:
+							relativeTransform = core::concatenateBFollowedByA(relativeTransform,modification);
+							break;
+						case ET_WEIGHTED_ACCUMULATE:
+							relativeTransform += modification;
+							break;
+						default:
+							assert(false);
+							break;
+					}
+				}
 			private:
 				core::matrix3x4SIMD storage;
 		};
@@ -159,7 +195,7 @@ class ITransformTreeManager : public virtual core::IReferenceCounted
 		{
 			// TODO: do it properly
 			auto out = getGlobalTransformationBufferRange();
-			m_driver->copyBuffer(m_nodeStorage->getMemoryBlock().buffer.get(),out.buffer.get(),m_nodeStorage->getPropertyOffset(1u),out.offset,out.size);
+			m_driver->copyBuffer(m_nodeStorage->getMemoryBlock().buffer.get(),out.buffer.get(),m_nodeStorage->getPropertyOffset(relative_transform_prop_ix),out.offset,out.size);
 		}
 		//
 		template<typename... Args>
@@ -175,7 +211,7 @@ class ITransformTreeManager : public virtual core::IReferenceCounted
 			request.download = true;
 			request.pool = m_nodeStorage.get();
 			request.indices = {begin,end};
-			request.propertyID = 3u;
+			request.propertyID = global_transform_prop_ix;
 			//m_nodeStorage->transferProperties();
 			assert(false); // TODO: Need a transfer to GPU mem
 		}
@@ -12,6 +12,8 @@
 //
 #include "nbl/scene/IAnimationBlendManager.h"
 #include "nbl/scene/IRenderpassManager.h"
+#include "nbl/scene/ICPUTransformTreeManager.h"
+#include "nbl/scene/CCPUInstanceCuller.h"
 //#include "nbl/scene/ISensor.h" or asset? or a struct?
 //#include "nbl/scene/ICamera.h" or do we stick it inside the renderpass?
 //#include "nbl/scene/ISceneManager.h" do we need this?
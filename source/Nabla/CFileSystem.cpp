@@ -6,6 +6,7 @@
 #include <list>
 #include "CFileSystem.h"
 #include "CReadFile.h"
+#include "CMappedReadFile.h"
 #include "IWriteFile.h"
 #include "CZipReader.h"
 #include "CMountPointReader.h"
@@ -104,12 +105,28 @@ IReadFile* CFileSystem::createAndOpenFile(const io::path& filename)
 
 	// Create the file using an absolute path so that it matches
 	// the scheme used by CNullDriver::getTexture().
-    file = new CReadFile(getAbsolutePath(filename));
-    if (static_cast<CReadFile*>(file)->isOpen())
-        return file;
-
-    file->drop();
-    return 0;
+    const io::path absolutePath = getAbsolutePath(filename);
+    file = new CReadFile(absolutePath);
+    if (!static_cast<CReadFile*>(file)->isOpen())
+    {
+        file->drop();
+        return 0;
+    }
+
+    // big files get memory-mapped instead, so loaders can parse them in place
+    if (file->getSize() >= MinMappedFileSize)
+    {
+        auto mappedFile = new CMappedReadFile(absolutePath);
+        if (mappedFile->isOpen())
+        {
+            file->drop();
+            return mappedFile;
+        }
+        // keep the regular file if mapping fails (out of address space, special files, etc.)
+        mappedFile->drop();
+    }
+
+    return file;
 }
 
 
@@ -114,6 +114,8 @@ class CFileSystem : public IFileSystem
         virtual bool existFile(const io::path& filename) const;
 
     private:
+        //! files at least this big get opened as `CMappedReadFile`, below it the mapping setup and page faults cost more than buffered reads
+        _NBL_STATIC_INLINE_CONSTEXPR size_t MinMappedFileSize = 0x1ull<<20ull;
 
         // don't expose, needs refactoring
         bool changeArchivePassword(const path& filename,
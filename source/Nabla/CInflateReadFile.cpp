@@ -0,0 +1,195 @@
+// Copyright (C) 2018-2020 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+
+#include "CInflateReadFile.h"
+
+#ifdef _NBL_COMPILE_WITH_ZLIB_
+
+#include "os.h"
+
+namespace nbl
+{
+namespace io
+{
+
+
+CInflateReadFile::CInflateReadFile(IReadFile* compressed, size_t uncompressedSize, const io::path& fileName, size_t seekPointSpan)
+: Compressed(compressed), UncompressedSize(uncompressedSize), Pos(0), StreamPos(0), InputEnd(0), SeekPointSpan(seekPointSpan),
+	Initialized(false), StreamEnded(false), Filename(fileName)
+{
+	#ifdef _NBL_DEBUG
+	setDebugName("CInflateReadFile");
+	#endif
+
+	memset(&Stream, 0, sizeof(z_stream));
+	if (!Compressed)
+		return;
+
+	Compressed->grab();
+	Input.resize(InputBufferSize);
+	restart(nullptr);
+}
+
+
+CInflateReadFile::~CInflateReadFile()
+{
+	if (Initialized)
+		inflateEnd(&Stream);
+	if (Compressed)
+		Compressed->drop();
+}
+
+
+//! returns how much was read
+int32_t CInflateReadFile::read(void* buffer, uint32_t sizeToRead)
+{
+	if (!Initialized || Pos >= UncompressedSize)
+		return 0;
+
+	if (Pos != StreamPos)
+	{
+		// resume from the closest seek point before `Pos`, unless the stream is already closer
+		const SSeekPoint* point = nullptr;
+		auto found = std::upper_bound(SeekPoints.begin(), SeekPoints.end(), Pos, [](size_t pos, const SSeekPoint& p) { return pos < p.outPos; });
+		if (found != SeekPoints.begin())
+			point = &*(found-1);
+
+		if (Pos < StreamPos || (point && point->outPos > StreamPos))
+		{
+			if (!restart(point))
+				return 0;
+		}
+		inflateTo(nullptr, Pos-StreamPos);
+		if (StreamPos != Pos)
+			return 0;
+	}
+
+	const size_t amount = inflateTo(reinterpret_cast<uint8_t*>(buffer), core::min<size_t>(sizeToRead, UncompressedSize-Pos));
+	Pos += amount;
+	return static_cast<int32_t>(amount);
+}
+
+
+//! changes position in file, returns true if successful
+//! if relativeMovement==true, the pos is changed relative to current pos,
+//! otherwise from begin of file
+bool CInflateReadFile::seek(const size_t& finalPos, bool relativeMovement)
+{
+	if (!Initialized)
+		return false;
+
+	// nothing gets inflated until the next read
+	const size_t newPos = relativeMovement ? (Pos + finalPos) : finalPos;
+	if (newPos > UncompressedSize)
+		return false;
+
+	Pos = newPos;
+	return true;
+}
+
+
+bool CInflateReadFile::restart(const SSeekPoint* point)
+{
+	if (Initialized)
+		inflateEnd(&Stream);
+	memset(&Stream, 0, sizeof(z_stream));
+	// negative window bits mean a raw deflate stream without a zlib header
+	Initialized = inflateInit2(&Stream, -MAX_WBITS) == Z_OK;
+	StreamEnded = false;
+	if (!Initialized)
+	{
+		os::Printer::log("Could not initialize inflate stream for", Filename.c_str(), ELL_ERROR);
+		return false;
+	}
+
+	StreamPos = point ? point->outPos : 0u;
+	InputEnd = point ? (point->inPos - (point->bits ? 1u : 0u)) : 0u;
+	if (!Compressed->seek(InputEnd))
+		return false;
+
+	if (point)
+	{
+		// a block boundary doesn't have to be on a byte boundary
+		if (point->bits)
+		{
+			uint8_t byte;
+			if (Compressed->read(&byte, 1u) != 1)
+				return false;
+			InputEnd++;
+			inflatePrime(&Stream, point->bits, byte >> (8 - point->bits));
+		}
+		inflateSetDictionary(&Stream, SeekPointWindows.data() + point->windowOffset, point->windowSize);
+	}
+	return true;
+}
+
+
+size_t CInflateReadFile::inflateTo(uint8_t* dst, size_t size)
+{
+	if (!dst && Discard.empty())
+		Discard.resize(WindowSize);
+
+	size_t produced = 0u;
+	while (produced < size && !StreamEnded)
+	{
+		if (Stream.avail_in == 0u)
+		{
+			const int32_t amount = Compressed->read(Input.data(), static_cast<uint32_t>(Input.size()));
+			if (amount <= 0)
+				break;
+			InputEnd += amount;
+			Stream.next_in = Input.data();
+			Stream.avail_in = amount;
+		}
+
+		const size_t chunk = dst ? core::min<size_t>(size - produced, 0x7fffffffu) : core::min<size_t>(size - produced, Discard.size());
+		Stream.next_out = dst ? (dst + produced) : Discard.data();
+		Stream.avail_out = static_cast<uInt>(chunk);
+		// Z_BLOCK makes zlib stop at deflate block boundaries, which are the only places we can put a seek point at
+		const int err = inflate(&Stream, SeekPointSpan ? Z_BLOCK : Z_NO_FLUSH);
+		const size_t amount = chunk - Stream.avail_out;
+		produced += amount;
+		StreamPos += amount;
+
+		if (err == Z_STREAM_END)
+			StreamEnded = true;
+		// running out of input is fine, anything else means the data is broken
+		else if (err != Z_OK && (err != Z_BUF_ERROR || Stream.avail_in))
+		{
+			os::Printer::log("Error inflating", Filename.c_str(), ELL_ERROR);
+			StreamEnded = true;
+		}
+		// bit 7 of `data_type` means we're at a block boundary, bit 6 that it's the last block
+		else if (SeekPointSpan && (Stream.data_type & 128) && !(Stream.data_type & 64))
+		{
+			if (StreamPos >= (SeekPoints.empty() ? SeekPointSpan : (SeekPoints.back().outPos + SeekPointSpan)))
+				addSeekPoint();
+		}
+	}
+	return produced;
+}
+
+
+void CInflateReadFile::addSeekPoint()
+{
+	SSeekPoint point;
+	point.outPos = StreamPos;
+	point.inPos = InputEnd - Stream.avail_in;
+	point.bits = Stream.data_type & 7;
+	point.windowOffset = SeekPointWindows.size();
+
+	SeekPointWindows.resize(point.windowOffset + WindowSize);
+	uInt windowSize = WindowSize;
+	inflateGetDictionary(&Stream, SeekPointWindows.data() + point.windowOffset, &windowSize);
+	SeekPointWindows.resize(point.windowOffset + windowSize);
+	point.windowSize = windowSize;
+
+	SeekPoints.push_back(point);
+}
+
+
+} // end namespace io
+} // end namespace nbl
+
+#endif // _NBL_COMPILE_WITH_ZLIB_
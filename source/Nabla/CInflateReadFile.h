@@ -0,0 +1,102 @@
+// Copyright (C) 2018-2020 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+
+#ifndef __NBL_C_INFLATE_READ_FILE_H_INCLUDED__
+#define __NBL_C_INFLATE_READ_FILE_H_INCLUDED__
+
+#include "nbl/asset/compile_config.h"
+
+#ifdef _NBL_COMPILE_WITH_ZLIB_
+
+#include "IReadFile.h"
+
+#include "nbl/core/core.h"
+
+#include "zlib/zlib.h"
+
+namespace nbl
+{
+
+namespace io
+{
+
+	/*!
+		Class for reading a raw deflate stream (as found in ZIP and GZIP archives) while inflating it on the fly.
+		Memory use is bounded by a fixed size input buffer and zlib's own 32kb window, no matter how big the entry is.
+
+		Seeking forward inflates and discards, seeking backward has to restart inflation. To make that cheap
+		the file can remember a seek point every `seekPointSpan` bytes of output as it goes past them, a seek point
+		is the inflate state at a deflate block boundary together with the 32kb of output preceding it.
+	*/
+	class CInflateReadFile : public IReadFile
+	{
+        protected:
+            virtual ~CInflateReadFile();
+
+        public:
+            //! `compressed` must contain just the deflate stream and should be a handle nobody else reads from, it gets grabbed
+            /** A `seekPointSpan` of 0 means no seek points, so every backward seek restarts from the beginning. */
+            CInflateReadFile(IReadFile* compressed, size_t uncompressedSize, const io::path& fileName, size_t seekPointSpan=0u);
+
+            //! returns how much was read
+            virtual int32_t read(void* buffer, uint32_t sizeToRead) override;
+
+            //! changes position in file, returns true if successful
+            virtual bool seek(const size_t& finalPos, bool relativeMovement = false) override;
+
+            //! returns size of file
+            virtual size_t getSize() const override { return UncompressedSize; }
+
+            //! returns if the inflate stream could be set up
+            inline bool isOpen() const
+            {
+                return Initialized;
+            }
+
+            //! returns where in the file we are.
+            virtual size_t getPos() const override { return Pos; }
+
+            //! returns name of file
+            virtual const io::path& getFileName() const override { return Filename; }
+
+        private:
+            _NBL_STATIC_INLINE_CONSTEXPR size_t InputBufferSize = 0x10000u;
+            _NBL_STATIC_INLINE_CONSTEXPR size_t WindowSize = 0x8000u;
+
+            struct SSeekPoint
+            {
+                size_t outPos; // offset in the inflated data
+                size_t inPos; // offset in the deflate stream of the first whole byte after the block boundary
+                int bits; // number of bits of the previous byte which belong to the next block
+                size_t windowOffset; // the output preceding `outPos` lives in `SeekPointWindows`
+                uint32_t windowSize;
+            };
+
+            //! resets the inflate stream to the start of the data or to `point`
+            bool restart(const SSeekPoint* point);
+            //! inflates up to `size` bytes to `dst` (or discards them if `dst` is null), returns how much was produced
+            size_t inflateTo(uint8_t* dst, size_t size);
+            void addSeekPoint();
+
+            IReadFile* Compressed;
+            size_t UncompressedSize;
+            size_t Pos;
+            size_t StreamPos; // how far the inflate stream is
+            size_t InputEnd; // offset in `Compressed` right after the data in `Input`
+            size_t SeekPointSpan;
+            z_stream Stream;
+            bool Initialized;
+            bool StreamEnded;
+            core::vector<uint8_t> Input;
+            core::vector<uint8_t> Discard;
+            core::vector<SSeekPoint> SeekPoints;
+            core::vector<uint8_t> SeekPointWindows;
+            io::path Filename;
+	};
+
+} // end namespace io
+} // end namespace nbl
+
+#endif // _NBL_COMPILE_WITH_ZLIB_
+#endif
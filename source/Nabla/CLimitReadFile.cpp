@@ -46,14 +46,25 @@ int32_t CLimitReadFile::read(void* buffer, uint32_t sizeToRead)
 	if (0 == File)
 		return 0;
 
-	int32_t r = AreaStart + Pos;
-	int32_t toRead = core::min<int32_t>(AreaEnd, r + sizeToRead) - core::max<int32_t>(AreaStart, r);
-	if (toRead < 0)
+	// 64bit offsets so areas past the first 2GB of multi-GB archives work
+	const size_t r = AreaStart + Pos;
+	if (r >= AreaEnd)
 		return 0;
+	const uint32_t toRead = static_cast<uint32_t>(core::min<size_t>(AreaEnd - r, sizeToRead));
+
+	// mapped files get read without touching their position, so any number of limit files (and threads) can share one
+	if (const uint8_t* mapped = reinterpret_cast<const uint8_t*>(File->getMappedPointer()))
+	{
+		memcpy(buffer, mapped + r, toRead);
+		Pos += toRead;
+		return static_cast<int32_t>(toRead);
+	}
+
 	File->seek(r);
-	r = File->read(buffer, toRead);
-	Pos += r;
-	return r;
+	const int32_t amount = File->read(buffer, toRead);
+	if (amount > 0)
+		Pos += amount;
+	return amount;
 #else
 	const size_t pos = File->getPos();
 
@@ -72,7 +83,8 @@ int32_t CLimitReadFile::read(void* buffer, uint32_t sizeToRead)
 bool CLimitReadFile::seek(const size_t& finalPos, bool relativeMovement)
 {
 #if 1
-	Pos = core::clamp<int32_t,int32_t>(finalPos + (relativeMovement ? Pos : 0 ), 0, AreaEnd - AreaStart);
+	// relative seeks backwards come in as wrapped around `size_t`
+	Pos = core::clamp<int64_t,int64_t>(static_cast<int64_t>(finalPos) + (relativeMovement ? static_cast<int64_t>(Pos) : 0ll), 0ll, AreaEnd - AreaStart);
 	return true;
 #else
 	const size_t pos = File->getPos();
@@ -119,6 +131,20 @@ const io::path& CLimitReadFile::getFileName() const
 }
 
 
+//! the area of the underlying file, if that one is mapped
+const void* CLimitReadFile::getMappedPointer() const
+{
+	if (0 == File)
+		return nullptr;
+
+	const void* mapped = File->getMappedPointer();
+	if (!mapped)
+		return nullptr;
+
+	return static_cast<const uint8_t*>(mapped) + AreaStart;
+}
+
+
 } // end namespace io
 } // end namespace nbl
 
@@ -46,6 +46,9 @@ namespace io
             //! returns name of file
             virtual const io::path& getFileName() const;
 
+            //! the area of the underlying file, if that one is mapped
+            virtual const void* getMappedPointer() const;
+
         private:
 
             io::path Filename;
@@ -0,0 +1,140 @@
+// Copyright (C) 2018-2020 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+
+#include "CMappedReadFile.h"
+
+#if defined(_NBL_WINDOWS_API_)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace nbl
+{
+namespace io
+{
+
+
+CMappedReadFile::CMappedReadFile(const io::path& fileName)
+: Mapping(nullptr), FileSize(0), Pos(0), Filename(fileName)
+#if defined(_NBL_WINDOWS_API_)
+, MappingHandle(nullptr)
+#endif
+{
+	#ifdef _NBL_DEBUG
+	setDebugName("CMappedReadFile");
+	#endif
+
+	openFile();
+}
+
+
+CMappedReadFile::~CMappedReadFile()
+{
+	if (!Mapping)
+		return;
+
+#if defined(_NBL_WINDOWS_API_)
+	UnmapViewOfFile(Mapping);
+	CloseHandle(MappingHandle);
+#else
+	munmap(const_cast<uint8_t*>(Mapping), FileSize);
+#endif
+}
+
+
+//! returns how much was read
+int32_t CMappedReadFile::read(void* buffer, uint32_t sizeToRead)
+{
+	if (!isOpen() || Pos >= FileSize)
+		return 0;
+
+	const size_t amount = core::min<size_t>(sizeToRead, FileSize - Pos);
+	memcpy(buffer, Mapping + Pos, amount);
+	Pos += amount;
+	return static_cast<int32_t>(amount);
+}
+
+
+//! changes position in file, returns true if successful
+//! if relativeMovement==true, the pos is changed relative to current pos,
+//! otherwise from begin of file
+bool CMappedReadFile::seek(const size_t& finalPos, bool relativeMovement)
+{
+	if (!isOpen())
+		return false;
+
+	// relative seeks backwards come in as wrapped around `size_t`, so this works for them too
+	const size_t newPos = relativeMovement ? (Pos + finalPos) : finalPos;
+	if (newPos > FileSize)
+		return false;
+
+	Pos = newPos;
+	return true;
+}
+
+
+//! opens and maps the file, the file handles get closed right away as the mapping keeps the file alive
+void CMappedReadFile::openFile()
+{
+	if (Filename.size() == 0)
+		return;
+
+#if defined(_NBL_WINDOWS_API_)
+	#if defined(_NBL_WCHAR_FILESYSTEM)
+	HANDLE file = CreateFileW(Filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL|FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	#else
+	HANDLE file = CreateFileA(Filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL|FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	#endif
+	if (file == INVALID_HANDLE_VALUE)
+		return;
+
+	LARGE_INTEGER size;
+	// empty files can't be mapped
+	if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+	{
+		MappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (MappingHandle)
+		{
+			Mapping = static_cast<const uint8_t*>(MapViewOfFile(MappingHandle, FILE_MAP_READ, 0, 0, 0));
+			if (Mapping)
+				FileSize = static_cast<size_t>(size.QuadPart);
+			else
+			{
+				CloseHandle(MappingHandle);
+				MappingHandle = nullptr;
+			}
+		}
+	}
+	CloseHandle(file);
+#else
+	const int file = open(Filename.c_str(), O_RDONLY);
+	if (file < 0)
+		return;
+
+	struct stat info;
+	// empty files can't be mapped
+	if (fstat(file, &info) == 0 && info.st_size > 0)
+	{
+		void* mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+		if (mapping != MAP_FAILED)
+		{
+			// loaders mostly go through the file front to back
+			madvise(mapping, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+			Mapping = static_cast<const uint8_t*>(mapping);
+			FileSize = static_cast<size_t>(info.st_size);
+		}
+	}
+	close(file);
+#endif
+}
+
+
+} // end namespace io
+} // end namespace nbl
+
@@ -155,6 +155,8 @@ namespace io
             return static_cast<int32_t>(amount);
         }
 
+        virtual const void* getMappedPointer() const override { return m_storage; }
+
         const void* getData() const {return m_storage;}
 
     protected:
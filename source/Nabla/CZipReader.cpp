@@ -25,6 +25,7 @@ extern "C" void bz_internal_error(int errorCode)
 
 #ifdef _NBL_COMPILE_WITH_ZLIB_
 	#include "zlib/zlib.h"
+	#include "CInflateReadFile.h"
 
 	#ifdef _NBL_COMPILE_WITH_ZIP_ENCRYPTION_
 	#include "aesGladman/fileenc.h"
@@ -439,11 +440,13 @@ IReadFile* CZipReader::createAndOpenFile(const io::path& filename)
 		os::Printer::log("Reading encrypted file.");
 		uint8_t salt[16]={0};
 		const uint16_t saltSize = (((e.header.Sig & 0x00ff0000) >>16)+1)*4;
-		File->seek(e.Offset);
-		File->read(salt, saltSize);
+		IReadFile* handle = openArchiveHandle();
+		IReadFile* archive = new CLimitReadFile(handle, e.Offset, e.header.DataDescriptor.CompressedSize, found->FullName);
+		handle->drop();
+		archive->read(salt, saltSize);
 		char pwVerification[2];
 		char pwVerificationFile[2];
-		File->read(pwVerification, 2);
+		archive->read(pwVerification, 2);
 		fcrypt_ctx zctx; // the encryption context
 		int rc = fcrypt_init(
 			(e.header.Sig & 0x00ff0000) >>16,
@@ -455,6 +458,7 @@ IReadFile* CZipReader::createAndOpenFile(const io::path& filename)
 		if (strncmp(pwVerificationFile, pwVerification, 2))
 		{
 			os::Printer::log("Wrong password");
+			archive->drop();
 			return 0;
 		}
 		decryptedSize= e.header.DataDescriptor.CompressedSize-saltSize-12;
@@ -462,14 +466,14 @@ IReadFile* CZipReader::createAndOpenFile(const io::path& filename)
 		uint32_t c = 0;
 		while ((c+32768)<=decryptedSize)
 		{
-			File->read(decryptedBuf+c, 32768);
+			archive->read(decryptedBuf+c, 32768);
 			fcrypt_decrypt(
 				decryptedBuf+c, // pointer to the data to decrypt
 				32768,   // how many bytes to decrypt
 				&zctx); // decryption context
 			c+=32768;
 		}
-		File->read(decryptedBuf+c, decryptedSize-c);
+		archive->read(decryptedBuf+c, decryptedSize-c);
 		fcrypt_decrypt(
 			decryptedBuf+c, // pointer to the data to decrypt
 			decryptedSize-c,   // how many bytes to decrypt
@@ -484,9 +488,11 @@ IReadFile* CZipReader::createAndOpenFile(const io::path& filename)
 		{
 			os::Printer::log("Error on encryption closing");
 			delete [] decryptedBuf;
+			archive->drop();
 			return 0;
 		}
-		File->read(fileMAC, 10);
+		archive->read(fileMAC, 10);
+		archive->drop();
 		if (strncmp(fileMAC, resMAC, 10))
 		{
 			os::Printer::log("Error on encryption check");
@@ -517,14 +523,34 @@ IReadFile* CZipReader::createAndOpenFile(const io::path& filename)
             delete[] decryptedBuf;
 			if (decrypted)
 				return decrypted;
-			else
-                return new CLimitReadFile(File, e.Offset, decryptedSize, found->FullName);
+
+			IReadFile* archive = openArchiveHandle();
+			IReadFile* ret = new CLimitReadFile(archive, e.Offset, decryptedSize, found->FullName);
+			archive->drop();
+			return ret;
 		}
 	case 8:
 		{
   			#ifdef _NBL_COMPILE_WITH_ZLIB_
 
 			const uint32_t uncompressedSize = e.header.DataDescriptor.UncompressedSize;
+			// inflate big entries on the fly, they'd need a buffer as big as themselves otherwise
+			if (!decrypted && uncompressedSize >= MinStreamedEntrySize)
+			{
+				IReadFile* archive = openArchiveHandle();
+				IReadFile* compressed = new CLimitReadFile(archive, e.Offset, decryptedSize, found->FullName);
+				archive->drop();
+				auto ret = new CInflateReadFile(compressed, uncompressedSize, found->FullName, InflateSeekPointSpan);
+				compressed->drop();
+				if (ret->isOpen())
+					return ret;
+
+				ret->drop();
+				swprintf ( buf, 64, L"Error decompressing %s", found->FullName.c_str() );
+				os::Printer::log( buf, ELL_ERROR);
+				return 0;
+			}
+
 			char* pBuf = new char[ uncompressedSize ];
 			if (!pBuf)
 			{
@@ -550,8 +576,7 @@ IReadFile* CZipReader::createAndOpenFile(const io::path& filename)
 				}
 
 				//memset(pcData, 0, decryptedSize);
-				File->seek(e.Offset);
-				File->read(pcData, decryptedSize);
+				readArchiveRange(pcData, e.Offset, decryptedSize);
 			}
 
 			// Setup the inflate stream.
@@ -631,8 +656,7 @@ IReadFile* CZipReader::createAndOpenFile(const io::path& filename)
 				}
 
 				//memset(pcData, 0, decryptedSize);
-				File->seek(e.Offset);
-				File->read(pcData, decryptedSize);
+				readArchiveRange(pcData, e.Offset, decryptedSize);
 			}
 
 			bz_stream bz_ctx={0};
@@ -711,8 +735,7 @@ IReadFile* CZipReader::createAndOpenFile(const io::path& filename)
 				}
 
 				//memset(pcData, 0, decryptedSize);
-				File->seek(e.Offset);
-				File->read(pcData, decryptedSize);
+				readArchiveRange(pcData, e.Offset, decryptedSize);
 			}
 
 			ELzmaStatus status;
@@ -761,6 +784,40 @@ IReadFile* CZipReader::createAndOpenFile(const io::path& filename)
 	};
 }
 
+IReadFile* CZipReader::openArchiveHandle() const
+{
+	// mapped and memory files never get their position touched by the entries, so they can be shared
+	if (!File->getMappedPointer())
+	{
+		if (dynamic_cast<CReadFile*>(File))
+		{
+			CReadFile* handle = new CReadFile(File->getFileName());
+			if (handle->isOpen())
+				return handle;
+			handle->drop();
+		}
+		os::Printer::log("Could not reopen archive, its entries can't be read from more than one thread at once", File->getFileName().c_str(), ELL_WARNING);
+	}
+	File->grab();
+	return File;
+}
+
+bool CZipReader::readArchiveRange(void* dst, size_t offset, size_t size) const
+{
+	if (offset+size > File->getSize())
+		return false;
+	if (const uint8_t* mapped = reinterpret_cast<const uint8_t*>(File->getMappedPointer()))
+	{
+		memcpy(dst, mapped+offset, size);
+		return true;
+	}
+
+	IReadFile* archive = openArchiveHandle();
+	const bool ok = archive->seek(offset) && archive->read(dst, static_cast<uint32_t>(size)) == static_cast<int32_t>(size);
+	archive->drop();
+	return ok;
+}
+
 #ifdef _NBL_COMPILE_WITH_LZMA_
 //! Used for LZMA decompression. The lib has no default memory management
 namespace
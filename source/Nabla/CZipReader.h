@@ -129,7 +129,7 @@ namespace io
 	struct SZipFileEntry
 	{
 		//! Position of data in the archive file
-		int32_t Offset;
+		uint32_t Offset;
 
 		//! The header for this file containing compression info etc
 		SZIPFileHeader header;
@@ -207,6 +207,17 @@ namespace io
 
             bool scanCentralDirectoryHeader();
 
+            //! every opened entry reads through a handle to the archive of its own, so several threads can read entries at once
+            IReadFile* openArchiveHandle() const;
+
+            //! reads `size` bytes at `offset` in the archive without touching `File`'s position
+            bool readArchiveRange(void* dst, size_t offset, size_t size) const;
+
+            //! deflated entries at least this big get inflated on the fly with bounded buffers instead of all at once
+            _NBL_STATIC_INLINE_CONSTEXPR size_t MinStreamedEntrySize = 0x1ull<<20ull;
+            //! how much inflated data lies between the seek points of a streamed entry, each one costs 32kb
+            _NBL_STATIC_INLINE_CONSTEXPR size_t InflateSeekPointSpan = 0x1ull<<23ull;
+
             IReadFile* File;
 
             // holds extended info about files
@@ -82,6 +82,8 @@
 #include "nbl/asset/utils/CGeometryCreator.h"
 #include "nbl/asset/utils/CMeshManipulator.h"
 
+#include "nbl/core/xxHash256.h"
+
 
 using namespace nbl;
 using namespace asset;
@@ -419,3 +421,164 @@ void IAssetManager::insertBuiltinAssets()
             addBuiltInToCaches(pipelineLayout, path);
     }
 }
+
+
+namespace
+{
+//! the small, fixed part of an asset's contents gets compared as-is, the payload buffer can be large so it only gets hashed first
+struct SContentDescription
+{
+    core::vector<uint8_t> header;
+    const ICPUBuffer* payload = nullptr;
+};
+bool describeContents(const IAsset* _asset, SContentDescription& _outDesc)
+{
+    if (_asset->isADummyObjectForCache())
+        return false;
+
+    const auto type = _asset->getAssetType();
+    auto appendToHeader = [&_outDesc](const void* data, const size_t size) -> void
+    {
+        const auto* bytes = reinterpret_cast<const uint8_t*>(data);
+        _outDesc.header.insert(_outDesc.header.end(),bytes,bytes+size);
+    };
+    appendToHeader(&type,sizeof(type));
+    switch (type)
+    {
+        case IAsset::ET_BUFFER:
+            _outDesc.payload = static_cast<const ICPUBuffer*>(_asset);
+            break;
+        case IAsset::ET_IMAGE:
+        {
+            const auto* image = static_cast<const ICPUImage*>(_asset);
+            const auto& params = image->getCreationParameters();
+            const auto regions = image->getRegions();
+            appendToHeader(&params,sizeof(params));
+            appendToHeader(regions.begin(),sizeof(IImage::SBufferCopy)*regions.size());
+            _outDesc.payload = image->getBuffer();
+            break;
+        }
+        case IAsset::ET_SHADER:
+        {
+            const auto* shader = static_cast<const ICPUShader*>(_asset);
+            const bool containsGLSL = shader->containsGLSL();
+            appendToHeader(&containsGLSL,sizeof(containsGLSL));
+            _outDesc.payload = shader->getSPVorGLSL();
+            break;
+        }
+        default:
+            return false;
+    }
+    return _outDesc.payload && !_outDesc.payload->isADummyObjectForCache() && _outDesc.payload->getPointer();
+}
+}
+
+bool IAssetManager::computeContentHash(const IAsset* _asset, SContentHash& _outHash, size_t& _outSize)
+{
+    SContentDescription desc;
+    if (!describeContents(_asset,desc))
+        return false;
+
+    const uint64_t payloadSize = desc.payload->getSize();
+    uint64_t payloadHash[4];
+    core::XXHash_256(desc.payload->getPointer(),payloadSize,payloadHash);
+    _outSize = desc.header.size()+payloadSize;
+
+    const auto* sizeBytes = reinterpret_cast<const uint8_t*>(&payloadSize);
+    desc.header.insert(desc.header.end(),sizeBytes,sizeBytes+sizeof(payloadSize));
+    const auto* hashBytes = reinterpret_cast<const uint8_t*>(payloadHash);
+    desc.header.insert(desc.header.end(),hashBytes,hashBytes+sizeof(payloadHash));
+    core::XXHash_256(desc.header.data(),desc.header.size(),_outHash.hash);
+    return true;
+}
+
+void IAssetManager::deduplicateContents(SAssetBundle& _asset, const IAsset::E_MUTABILITY _mutability)
+{
+    if (_asset.getMetadata())
+        return;
+
+    const auto contents = _asset.getContents();
+    for (uint32_t i=0u; i<contents.size(); i++)
+    {
+        IAsset* asset = contents.begin()[i].get();
+        SContentHash contentHash;
+        size_t size;
+        if (!computeContentHash(asset,contentHash,size))
+            continue;
+
+        std::unique_lock<std::mutex> lock(m_contentIndexMutex);
+        auto found = m_contentIndex.find(contentHash);
+        if (found!=m_contentIndex.end())
+        {
+            IAsset* existing = found->second.get();
+            if (existing==asset)
+                continue;
+            // XXHash_256 is not cryptographic, so the match needs confirming
+            SContentDescription desc,existingDesc;
+            // the original's contents are gone (it became a dummy for a GPU object), so it can't be confirmed and the new asset takes its place in the index
+            if (!describeContents(existing,existingDesc))
+            {
+                m_contentIndexKeys.erase(existing);
+                m_contentIndex.erase(found);
+            }
+            else
+            {
+                describeContents(asset,desc);
+                if (existing->getMutability()!=_mutability || desc.header!=existingDesc.header || desc.payload->getSize()!=existingDesc.payload->getSize() ||
+                    memcmp(desc.payload->getPointer(),existingDesc.payload->getPointer(),desc.payload->getSize())!=0)
+                    continue;
+
+                const uint32_t typeIx = IAsset::typeFlagToIndex(asset->getAssetType());
+                m_contentDeduplicationStats.duplicateCount[typeIx]++;
+                m_contentDeduplicationStats.bytesSaved[typeIx] += size;
+                _asset.setAsset(i,core::smart_refctd_ptr<IAsset>(existing));
+                continue;
+            }
+        }
+        m_contentIndex.emplace(contentHash,core::smart_refctd_ptr<IAsset>(asset));
+        m_contentIndexKeys.emplace(asset,contentHash);
+    }
+}
+
+void IAssetManager::removeFromContentIndex(const SAssetBundle& _asset)
+{
+    std::unique_lock<std::mutex> lock(m_contentIndexMutex);
+    for (const auto& asset : _asset.getContents())
+    {
+        auto found = m_contentIndexKeys.find(asset.get());
+        if (found==m_contentIndexKeys.end())
+            continue;
+        m_contentIndex.erase(found->second);
+        m_contentIndexKeys.erase(found);
+    }
+}
+
+void IAssetManager::clearContentIndex(const uint64_t _assetTypeBitFlags)
+{
+    std::unique_lock<std::mutex> lock(m_contentIndexMutex);
+    for (auto it=m_contentIndexKeys.begin(); it!=m_contentIndexKeys.end();)
+    {
+        if (_assetTypeBitFlags&it->first->getAssetType())
+        {
+            m_contentIndex.erase(it->second);
+            it = m_contentIndexKeys.erase(it);
+        }
+        else
+            it++;
+    }
+}
+
+void IAssetManager::dumpContentDeduplicationReport(std::ostream& _outs) const
+{
+    const auto stats = getContentDeduplicationStats();
+    const std::pair<IAsset::E_TYPE,const char*> types[] = {{IAsset::ET_BUFFER,"buffers"},{IAsset::ET_IMAGE,"images"},{IAsset::ET_SHADER,"shaders"}};
+    uint64_t totalBytesSaved = 0ull;
+    _outs << "Content deduplication:\n";
+    for (const auto& type : types)
+    {
+        const uint32_t typeIx = IAsset::typeFlagToIndex(type.first);
+        _outs << '\t' << type.second << ": " << stats.duplicateCount[typeIx] << " duplicates, " << stats.bytesSaved[typeIx] << " bytes saved\n";
+        totalBytesSaved += stats.bytesSaved[typeIx];
+    }
+    _outs << "\ttotal: " << totalBytesSaved << " bytes saved\n";
+}
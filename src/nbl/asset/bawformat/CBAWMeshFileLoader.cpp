@@ -104,13 +104,17 @@ SAssetBundle CBAWMeshFileLoader::loadAsset(io::IReadFile* _file, const asset::IA
         _override,
 		{}
     };
-	core::stack<SBlobData*> toLoad, toFinalize;
-	toLoad.push(&meshBlobDataIter->second);
-    toLoad.top()->hierarchyLvl = 0u;
+	// a vector instead of a stack, so the blobs about to be loaded can be decoded ahead of time
+	core::vector<SBlobData*> toLoad;
+	core::stack<SBlobData*> toFinalize;
+	toLoad.push_back(&meshBlobDataIter->second);
+    toLoad.back()->hierarchyLvl = 0u;
 	while (!toLoad.empty())
 	{
-		SBlobData* data = toLoad.top();
-		toLoad.pop();
+		SBlobData* data = toLoad.back();
+		toLoad.pop_back();
+		if (!data->heapBlob)
+			prefetchBlobs(ctx, data, toLoad);
 
 		const uint64_t handle = data->header->handle;
         const uint32_t size = data->header->blobSizeDecompr;
@@ -125,7 +129,9 @@ SAssetBundle CBAWMeshFileLoader::loadAsset(io::IReadFile* _file, const asset::IA
         // todo: supposedFilename arg is missing (empty string) - what is it?
         while (_override->getDecryptionKey(decrKey, decrKeyLen, attempt, ctx.inner.mainFile, "", thisCacheKey, ctx.inner, hierLvl))
         {
-            if (!((data->header->compressionType & asset::Blob::EBCT_AES128_GCM) && decrKeyLen != 16u))
+            if (data->heapBlob) // already decoded by `prefetchBlobs`
+                blob = data->heapBlob;
+            else if (!((data->header->compressionType & asset::Blob::EBCT_AES128_GCM) && decrKeyLen != 16u))
                 blob = data->heapBlob = tryReadBlobOnStack(*data, ctx, decrKey);
             if (blob)
                 break;
@@ -142,8 +148,8 @@ SAssetBundle CBAWMeshFileLoader::loadAsset(io::IReadFile* _file, const asset::IA
         {
             if (ctx.createdObjs.find(*it) == ctx.createdObjs.end())
             {
-                toLoad.push(&ctx.blobs[*it]);
-                toLoad.top()->hierarchyLvl = hierLvl+1u;
+                toLoad.push_back(&ctx.blobs[*it]);
+                toLoad.back()->hierarchyLvl = hierLvl+1u;
             }
         }
 
@@ -151,6 +157,8 @@ SAssetBundle CBAWMeshFileLoader::loadAsset(io::IReadFile* _file, const asset::IA
         if (foundBundle.first!=foundBundle.second)
         {
             ctx.createdObjs[handle] = toAddrUsedByBlobsLoadingMgr(foundBundle.first->get(), blobType);
+            _NBL_ALIGNED_FREE(data->heapBlob);
+            data->heapBlob = nullptr;
             continue;
         }
 
@@ -187,6 +195,8 @@ SAssetBundle CBAWMeshFileLoader::loadAsset(io::IReadFile* _file, const asset::IA
         const std::string thisCacheKey = genSubAssetCacheKey(rootCacheKey, handle);
 
 		retval = ctx.loadingMgr.finalize(blobType, ctx.createdObjs[handle], blob, size, ctx.createdObjs, params); // last one will always be mesh
+        _NBL_ALIGNED_FREE(data->heapBlob);
+        data->heapBlob = nullptr;
         if (!toFinalize.empty()) // don't cache root-asset (mesh) as sub-asset because it'll be cached by asset manager directly (and there's only one IAsset::cacheKey)
             insertAssetIntoCache(ctx, _override, retval, blobType, hierLvl, thisCacheKey);
 	}
@@ -360,6 +370,81 @@ bool CBAWMeshFileLoader::safeRead(io::IReadFile * _file, void * _buf, size_t _si
 	return true;
 }
 
+void CBAWMeshFileLoader::prefetchBlobs(SContext& _ctx, SBlobData* _next, const core::vector<SBlobData*>& _toLoad) const
+{
+	// the blobs get popped from the back of `_toLoad`, so those are the ones needed next
+	core::vector<SBlobData*> toDecode;
+	core::unordered_set<SBlobData*> batch;
+	size_t batchBytes = 0ull;
+	auto addToBatch = [&](SBlobData* data) -> bool
+	{
+		// the blobs below an already decoded one were there before the last batch got made, they're not needed soon
+		if (data->heapBlob)
+			return false;
+		// the key comes from the override and it wants the blob's hierarchy level which we only know while walking the dependencies
+		if (data->header->compressionType & asset::Blob::EBCT_AES128_GCM)
+			return true;
+		const size_t blobBytes = data->header->effectiveSize()+data->header->blobSizeDecompr;
+		if (!toDecode.empty() && batchBytes+blobBytes>PrefetchBatchByteBudget)
+			return false;
+		// on anything unexpected just leave the blob to the serial path which reports errors properly
+		if (data->absOffset+data->header->effectiveSize() > _ctx.inner.mainFile->getSize())
+			return true;
+		if (batch.insert(data).second)
+		{
+			toDecode.push_back(data);
+			batchBytes += blobBytes;
+		}
+		return true;
+	};
+	if (!addToBatch(_next))
+		return;
+	for (auto it=_toLoad.rbegin(); it!=_toLoad.rend() && addToBatch(*it); it++) {}
+	if (toDecode.empty())
+		return;
+
+	// memory mapped files need no reads at all, otherwise the batch's raw blobs get read one after another into a single allocation
+	const uint8_t* mapped = reinterpret_cast<const uint8_t*>(_ctx.inner.mainFile->getMappedPointer());
+	core::vector<const uint8_t*> raw(toDecode.size());
+	void* rawCopy = nullptr;
+	if (mapped)
+	{
+		for (size_t i=0ull; i<toDecode.size(); i++)
+			raw[i] = mapped+toDecode[i]->absOffset;
+	}
+	else
+	{
+		core::vector<size_t> rawOffsets(toDecode.size());
+		size_t rawSize = 0ull;
+		for (size_t i=0ull; i<toDecode.size(); i++)
+		{
+			rawOffsets[i] = rawSize;
+			rawSize = core::roundUp<size_t>(rawSize+toDecode[i]->header->effectiveSize(), _NBL_SIMD_ALIGNMENT);
+		}
+		rawCopy = _NBL_ALIGNED_MALLOC(rawSize, _NBL_SIMD_ALIGNMENT);
+		for (size_t i=0ull; i<toDecode.size(); i++)
+		{
+			const uint32_t size = toDecode[i]->header->effectiveSize();
+			raw[i] = reinterpret_cast<const uint8_t*>(rawCopy)+rawOffsets[i];
+			_ctx.inner.mainFile->seek(toDecode[i]->absOffset);
+			if (_ctx.inner.mainFile->read(const_cast<uint8_t*>(raw[i]), size) != static_cast<int32_t>(size))
+			{
+				_NBL_ALIGNED_FREE(rawCopy);
+				return;
+			}
+		}
+	}
+
+	// every blob carries its own size, hash and compression so they decode independently
+	m_manager->getThreadPool()->parallelFor(toDecode.size(), [&](const size_t i) -> void
+	{
+		toDecode[i]->heapBlob = decodeBlob(toDecode[i]->header, raw[i], nullptr, _ctx.iv);
+	}, 1ull);
+
+	if (rawCopy)
+		_NBL_ALIGNED_FREE(rawCopy);
+}
+
 bool CBAWMeshFileLoader::decompressLzma(void* _dst, size_t _dstSize, const void* _src, size_t _srcSize) const
 {
 	SizeT dstSize = _dstSize;
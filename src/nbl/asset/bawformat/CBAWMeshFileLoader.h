@@ -164,6 +164,15 @@ private:
 		/** @returns `_stackPtr` if blob was read to it or pointer to malloc'd memory otherwise.*/
 		template<typename HeaderT>
 		void* tryReadBlobOnStack(const SBlobData_t<HeaderT>& _data, SContext& _ctx, const unsigned char pwd[16], void* _stackPtr=NULL, size_t _stackSize=0) const;
+		//! Validates, decrypts and decompresses a blob from its raw bytes as stored in the file. Doesn't touch the file so it's safe to call from many threads at once.
+		/** @returns pointer to malloc'd decoded blob or nullptr on failure.*/
+		template<typename HeaderT>
+		void* decodeBlob(HeaderT* _header, const void* _raw, const unsigned char _pwd[16], const unsigned char _iv[16]) const;
+		//! Upper bound on the raw and decoded bytes of the blobs `prefetchBlobs` decodes at once.
+		_NBL_STATIC_INLINE_CONSTEXPR size_t PrefetchBatchByteBudget = 64ull<<20ull;
+		//! Decodes `_next` and the blobs at the back of `_toLoad` (the ones the dependency walk reaches next) on the asset manager's thread pool.
+		//! Blobs which need a decryption key are left to the serial path, decoded blobs land in `SBlobData::heapBlob` and are freed as soon as their asset is built.
+		void prefetchBlobs(SContext& _ctx, SBlobData* _next, const core::vector<SBlobData*>& _toLoad) const;
 
 		bool decompressLzma(void* _dst, size_t _dstSize, const void* _src, size_t _srcSize) const;
 		bool decompressLz4(void* _dst, size_t _dstSize, const void* _src, size_t _srcSize) const;
@@ -490,6 +499,69 @@ void* CBAWMeshFileLoader::tryReadBlobOnStack(const SBlobData_t<HeaderT> & _data,
     return dst;
 }
 
+template<typename HeaderT>
+void* CBAWMeshFileLoader::decodeBlob(HeaderT* _header, const void* _raw, const unsigned char _pwd[16], const unsigned char _iv[16]) const
+{
+    if (!_header->validate(_raw))
+    {
+#ifdef _NBL_DEBUG
+        os::Printer::log("Blob validation failed!", ELL_ERROR);
+#endif
+        return nullptr;
+    }
+
+    const bool encrypted = (_header->compressionType & asset::Blob::EBCT_AES128_GCM);
+    const bool compressed = (_header->compressionType & asset::Blob::EBCT_LZ4) || (_header->compressionType & asset::Blob::EBCT_LZMA);
+
+    const void* src = _raw;
+    void* decrypted = nullptr;
+    if (encrypted)
+    {
+#ifdef _NBL_COMPILE_WITH_OPENSSL_
+        const size_t size = _header->effectiveSize();
+        decrypted = _NBL_ALIGNED_MALLOC(size, _NBL_SIMD_ALIGNMENT);
+        if (!asset::decAes128gcm(_raw, size, decrypted, size, _pwd, _iv, _header->gcmTag))
+        {
+            _NBL_ALIGNED_FREE(decrypted);
+#ifdef _NBL_DEBUG
+            os::Printer::log("Blob decryption failed!", ELL_ERROR);
+#endif
+            return nullptr;
+        }
+        if (!compressed)
+            return decrypted;
+        src = decrypted;
+#else
+        return nullptr;
+#endif
+    }
+
+    void* dst = _NBL_ALIGNED_MALLOC(BlobHeaderVn<_NBL_FORMAT_VERSION>::calcEncSize(_header->blobSizeDecompr), _NBL_SIMD_ALIGNMENT);
+    if (compressed)
+    {
+        bool res = false;
+        if (_header->compressionType & asset::Blob::EBCT_LZ4)
+            res = decompressLz4(dst, _header->blobSizeDecompr, src, _header->blobSize);
+        else if (_header->compressionType & asset::Blob::EBCT_LZMA)
+            res = decompressLzma(dst, _header->blobSizeDecompr, src, _header->blobSize);
+
+        if (decrypted)
+            _NBL_ALIGNED_FREE(decrypted);
+        if (!res)
+        {
+            _NBL_ALIGNED_FREE(dst);
+#ifdef _NBL_DEBUG
+            os::Printer::log("Blob decompression failed!", ELL_ERROR);
+#endif
+            return nullptr;
+        }
+    }
+    else
+        memcpy(dst, src, _header->blobSize);
+
+    return dst;
+}
+
 }
 }
 
@@ -0,0 +1,1058 @@
+// Copyright (C) 2018-2020 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+
+#include "nbl/asset/format/encodeBlockCompressed.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "nbl/core/core.h"
+
+namespace nbl
+{
+namespace asset
+{
+
+namespace
+{
+
+constexpr uint32_t BlockTexelCount = 16u;
+constexpr uint32_t FullBlockMask = 0xffffu;
+
+using block_texels_t = double[BlockTexelCount][4];
+
+//! LSB-first bit packing as used by the BC6H and BC7 block layouts
+class CBitWriter
+{
+	public:
+		CBitWriter(uint8_t* _out, uint32_t _byteSize) : m_out(_out)
+		{
+			memset(m_out,0,_byteSize);
+		}
+
+		inline void write(uint32_t value, uint32_t bitCount)
+		{
+			for (uint32_t i=0u; i<bitCount; i++,m_pos++)
+			if ((value>>i)&0x1u)
+				m_out[m_pos>>3u] |= uint8_t(0x1u<<(m_pos&7u));
+		}
+
+	private:
+		uint8_t* m_out;
+		uint32_t m_pos = 0u;
+};
+
+inline bool isInMask(uint32_t mask, uint32_t texel)
+{
+	return (mask>>texel)&0x1u;
+}
+
+//! Best fitting line through the masked texels, channels outside `[firstChannel,firstChannel+channelCount)` are left alone
+struct SLineFit
+{
+	double mean[4] = {};
+	double axis[4] = {};
+	double tMin = 0.0;
+	double tMax = 0.0;
+	double residual = 0.0;
+
+	inline void getEndpoints(double (&e0)[4], double (&e1)[4]) const
+	{
+		for (uint32_t c=0u; c<4u; c++)
+		{
+			e0[c] = mean[c]+axis[c]*tMin;
+			e1[c] = mean[c]+axis[c]*tMax;
+		}
+	}
+};
+
+SLineFit fitLine(const block_texels_t& texels, uint32_t firstChannel, uint32_t channelCount, uint32_t mask)
+{
+	SLineFit fit;
+	const uint32_t endChannel = firstChannel+channelCount;
+
+	uint32_t count = 0u;
+	double lo[4],hi[4];
+	std::fill_n(lo,4u,std::numeric_limits<double>::max());
+	std::fill_n(hi,4u,-std::numeric_limits<double>::max());
+	for (uint32_t i=0u; i<BlockTexelCount; i++)
+	if (isInMask(mask,i))
+	{
+		for (uint32_t c=firstChannel; c<endChannel; c++)
+		{
+			fit.mean[c] += texels[i][c];
+			lo[c] = std::min(lo[c],texels[i][c]);
+			hi[c] = std::max(hi[c],texels[i][c]);
+		}
+		count++;
+	}
+	if (count==0u)
+		return fit;
+	for (uint32_t c=firstChannel; c<endChannel; c++)
+		fit.mean[c] /= double(count);
+
+	double covariance[4][4] = {};
+	double totalVariance = 0.0;
+	for (uint32_t i=0u; i<BlockTexelCount; i++)
+	if (isInMask(mask,i))
+	for (uint32_t a=firstChannel; a<endChannel; a++)
+	{
+		const double da = texels[i][a]-fit.mean[a];
+		for (uint32_t b=firstChannel; b<endChannel; b++)
+			covariance[a][b] += da*(texels[i][b]-fit.mean[b]);
+		totalVariance += da*da;
+	}
+
+	auto normalize = [](double (&v)[4]) -> bool
+	{
+		const double len = std::sqrt(v[0]*v[0]+v[1]*v[1]+v[2]*v[2]+v[3]*v[3]);
+		if (len<=std::numeric_limits<double>::epsilon())
+			return false;
+		for (uint32_t c=0u; c<4u; c++)
+			v[c] /= len;
+		return true;
+	};
+	// the bounding box diagonal is a good starting guess for the power iteration
+	for (uint32_t c=firstChannel; c<endChannel; c++)
+		fit.axis[c] = hi[c]-lo[c];
+	if (!normalize(fit.axis))
+		return fit;
+	for (uint32_t iteration=0u; iteration<8u; iteration++)
+	{
+		double next[4] = {};
+		for (uint32_t a=firstChannel; a<endChannel; a++)
+		for (uint32_t b=firstChannel; b<endChannel; b++)
+			next[a] += covariance[a][b]*fit.axis[b];
+		// the diagonal can be orthogonal to the principal axis, just keep it then
+		if (!normalize(next))
+			break;
+		std::copy_n(next,4u,fit.axis);
+	}
+
+	fit.tMin = std::numeric_limits<double>::max();
+	fit.tMax = -std::numeric_limits<double>::max();
+	double projectedVariance = 0.0;
+	for (uint32_t i=0u; i<BlockTexelCount; i++)
+	if (isInMask(mask,i))
+	{
+		double t = 0.0;
+		for (uint32_t c=firstChannel; c<endChannel; c++)
+			t += (texels[i][c]-fit.mean[c])*fit.axis[c];
+		fit.tMin = std::min(fit.tMin,t);
+		fit.tMax = std::max(fit.tMax,t);
+		projectedVariance += t*t;
+	}
+	fit.residual = std::max(totalVariance-projectedVariance,0.0);
+	return fit;
+}
+
+//! Least squares endpoints for fixed indices, `weights[index]` is the fraction of the second endpoint
+bool refineEndpoints(
+	const block_texels_t& texels, uint32_t firstChannel, uint32_t channelCount, uint32_t mask,
+	const uint8_t* indices, const double* weights, double (&e0)[4], double (&e1)[4]
+)
+{
+	double aa = 0.0, ab = 0.0, bb = 0.0;
+	double ax[4] = {}, bx[4] = {};
+	for (uint32_t i=0u; i<BlockTexelCount; i++)
+	if (isInMask(mask,i))
+	{
+		const double b = weights[indices[i]];
+		const double a = 1.0-b;
+		aa += a*a;
+		ab += a*b;
+		bb += b*b;
+		for (uint32_t c=firstChannel; c<firstChannel+channelCount; c++)
+		{
+			ax[c] += a*texels[i][c];
+			bx[c] += b*texels[i][c];
+		}
+	}
+	const double determinant = aa*bb-ab*ab;
+	if (std::abs(determinant)<=std::numeric_limits<double>::epsilon())
+		return false;
+	for (uint32_t c=firstChannel; c<firstChannel+channelCount; c++)
+	{
+		e0[c] = (bb*ax[c]-ab*bx[c])/determinant;
+		e1[c] = (aa*bx[c]-ab*ax[c])/determinant;
+	}
+	return true;
+}
+
+
+// BC1 color block, also used by BC2 and BC3
+inline uint16_t packRGB565(const double (&color)[4])
+{
+	auto quantize = [](double v, double maxValue) -> uint32_t {return static_cast<uint32_t>(std::clamp(v,0.0,1.0)*maxValue+0.5);};
+	return uint16_t((quantize(color[0],31.0)<<11u)|(quantize(color[1],63.0)<<5u)|quantize(color[2],31.0));
+}
+
+inline void unpackRGB565(uint16_t packed, double (&color)[4])
+{
+	const uint32_t r = packed>>11u;
+	const uint32_t g = (packed>>5u)&0x3fu;
+	const uint32_t b = packed&0x1fu;
+	// same bit replication as the hardware
+	color[0] = double((r<<3u)|(r>>2u))/255.0;
+	color[1] = double((g<<2u)|(g>>4u))/255.0;
+	color[2] = double((b<<3u)|(b>>2u))/255.0;
+	color[3] = 1.0;
+}
+
+//! Picks the closest palette entry for all texels in `mask`, texels outside get the transparent index
+double evaluateBC1(const block_texels_t& texels, uint32_t mask, uint16_t c0, uint16_t c1, bool threeColor, uint8_t (&indices)[BlockTexelCount])
+{
+	double palette[4][4];
+	unpackRGB565(c0,palette[0]);
+	unpackRGB565(c1,palette[1]);
+	for (uint32_t c=0u; c<3u; c++)
+	{
+		if (threeColor)
+			palette[2][c] = (palette[0][c]+palette[1][c])/2.0;
+		else
+		{
+			palette[2][c] = (2.0*palette[0][c]+palette[1][c])/3.0;
+			palette[3][c] = (palette[0][c]+2.0*palette[1][c])/3.0;
+		}
+	}
+
+	const uint32_t entryCount = threeColor ? 3u:4u;
+	double error = 0.0;
+	for (uint32_t i=0u; i<BlockTexelCount; i++)
+	{
+		indices[i] = 3u;
+		if (!isInMask(mask,i))
+			continue;
+
+		double bestDistance = std::numeric_limits<double>::max();
+		for (uint32_t k=0u; k<entryCount; k++)
+		{
+			double distance = 0.0;
+			for (uint32_t c=0u; c<3u; c++)
+			{
+				const double d = palette[k][c]-texels[i][c];
+				distance += d*d;
+			}
+			if (distance<bestDistance)
+			{
+				bestDistance = distance;
+				indices[i] = k;
+			}
+		}
+		error += bestDistance;
+	}
+	return error;
+}
+
+//! `transparentMask` texels get the transparent black entry, which forces the 3 color mode, BC2 and BC3 must pass 0
+void encodeBC1Color(const block_texels_t& texels, uint32_t transparentMask, E_BLOCK_COMPRESSION_QUALITY quality, uint8_t* out)
+{
+	const bool threeColor = transparentMask!=0u;
+	const uint32_t mask = (~transparentMask)&FullBlockMask;
+
+	uint16_t best0 = 0u, best1 = 0u;
+	uint8_t bestIndices[BlockTexelCount];
+	std::fill_n(bestIndices,BlockTexelCount,3u);
+	double bestError = std::numeric_limits<double>::max();
+	auto tryEndpoints = [&](const double (&e0)[4], const double (&e1)[4]) -> void
+	{
+		uint16_t c0 = packRGB565(e0);
+		uint16_t c1 = packRGB565(e1);
+		// the order of the endpoints selects the mode
+		if (threeColor ? (c0>c1):(c0<c1))
+			std::swap(c0,c1);
+
+		uint8_t indices[BlockTexelCount];
+		const double error = evaluateBC1(texels,mask,c0,c1,threeColor,indices);
+		if (error<bestError)
+		{
+			bestError = error;
+			best0 = c0;
+			best1 = c1;
+			std::copy_n(indices,BlockTexelCount,bestIndices);
+		}
+	};
+
+	if (mask)
+	{
+		double e0[4],e1[4];
+		fitLine(texels,0u,3u,mask).getEndpoints(e0,e1);
+		tryEndpoints(e0,e1);
+		if (quality==EBCQ_HIGH)
+		{
+			const double fourColorWeights[4] = {0.0,1.0,1.0/3.0,2.0/3.0};
+			const double threeColorWeights[4] = {0.0,1.0,0.5,0.0};
+			for (uint32_t iteration=0u; iteration<3u; iteration++)
+			{
+				if (!refineEndpoints(texels,0u,3u,mask,bestIndices,threeColor ? threeColorWeights:fourColorWeights,e0,e1))
+					break;
+				tryEndpoints(e0,e1);
+			}
+		}
+	}
+
+	uint32_t lut = 0u;
+	for (uint32_t i=0u; i<BlockTexelCount; i++)
+		lut |= uint32_t(bestIndices[i])<<(2u*i);
+	memcpy(out,&best0,2u);
+	memcpy(out+2,&best1,2u);
+	memcpy(out+4,&lut,4u);
+}
+
+
+// BC4 single channel block, also used by BC3 alpha and BC5
+//! `values` are already scaled to the endpoint range, so [0,255] or [-127,127] when `isSigned`
+void encodeBC4Channel(const double (&values)[BlockTexelCount], bool isSigned, E_BLOCK_COMPRESSION_QUALITY quality, uint8_t* out)
+{
+	const int32_t lo = isSigned ? -127:0;
+	const int32_t hi = isSigned ? 127:255;
+	auto quantize = [lo,hi](double v) -> int32_t {return std::clamp(static_cast<int32_t>(std::floor(v+0.5)),lo,hi);};
+
+	int32_t best0 = 0, best1 = 0;
+	uint8_t bestIndices[BlockTexelCount] = {};
+	double bestError = std::numeric_limits<double>::max();
+	auto tryEndpoints = [&](int32_t e0, int32_t e1) -> void
+	{
+		e0 = std::clamp(e0,lo,hi);
+		e1 = std::clamp(e1,lo,hi);
+
+		double palette[8];
+		palette[0] = e0;
+		palette[1] = e1;
+		if (e0>e1)
+		{
+			for (int32_t k=2; k<8; k++)
+				palette[k] = double((8-k)*e0+(k-1)*e1)/7.0;
+		}
+		else
+		{
+			for (int32_t k=2; k<6; k++)
+				palette[k] = double((6-k)*e0+(k-1)*e1)/5.0;
+			palette[6] = lo;
+			palette[7] = hi;
+		}
+
+		uint8_t indices[BlockTexelCount];
+		double error = 0.0;
+		for (uint32_t i=0u; i<BlockTexelCount; i++)
+		{
+			double bestDistance = std::numeric_limits<double>::max();
+			for (uint32_t k=0u; k<8u; k++)
+			{
+				const double d = palette[k]-values[i];
+				if (d*d<bestDistance)
+				{
+					bestDistance = d*d;
+					indices[i] = k;
+				}
+			}
+			error += bestDistance;
+		}
+		if (error<bestError)
+		{
+			bestError = error;
+			best0 = e0;
+			best1 = e1;
+			std::copy_n(indices,BlockTexelCount,bestIndices);
+		}
+	};
+
+	const double minValue = *std::min_element(values,values+BlockTexelCount);
+	const double maxValue = *std::max_element(values,values+BlockTexelCount);
+	const int32_t e0 = quantize(maxValue);
+	const int32_t e1 = quantize(minValue);
+	tryEndpoints(e0,e1);
+	if (quality==EBCQ_HIGH && e0!=e1)
+	{
+		// 8 interpolated values, the rounding of the extremes is not necessarily optimal
+		for (int32_t d0=-2; d0<=2; d0++)
+		for (int32_t d1=-2; d1<=2; d1++)
+		if (e0+d0>e1+d1)
+			tryEndpoints(e0+d0,e1+d1);
+		// 6 interpolated values, with the range extremes coming from the two fixed entries instead
+		double innerMin = std::numeric_limits<double>::max();
+		double innerMax = -std::numeric_limits<double>::max();
+		for (uint32_t i=0u; i<BlockTexelCount; i++)
+		if (values[i]>double(lo)+0.5 && values[i]<double(hi)-0.5)
+		{
+			innerMin = std::min(innerMin,values[i]);
+			innerMax = std::max(innerMax,values[i]);
+		}
+		if (innerMin<=innerMax)
+		for (int32_t d0=-1; d0<=1; d0++)
+		for (int32_t d1=-1; d1<=1; d1++)
+		if (quantize(innerMin)+d0<=quantize(innerMax)+d1)
+			tryEndpoints(quantize(innerMin)+d0,quantize(innerMax)+d1);
+	}
+
+	out[0] = static_cast<uint8_t>(best0);
+	out[1] = static_cast<uint8_t>(best1);
+	uint64_t lut = 0ull;
+	for (uint32_t i=0u; i<BlockTexelCount; i++)
+		lut |= uint64_t(bestIndices[i])<<(3ull*i);
+	for (uint32_t b=0u; b<6u; b++)
+		out[2u+b] = static_cast<uint8_t>(lut>>(8ull*b));
+}
+
+
+// BC7
+//! bit `i` set means texel `i` belongs to the second subset
+constexpr uint16_t BC7Partitions2[64] =
+{
+	0xcccc,0x8888,0xeeee,0xecc8,0xc880,0xfeec,0xfec8,0xec80,
+	0xc800,0xffec,0xfe80,0xe800,0xffe8,0xff00,0xfff0,0xf000,
+	0xf710,0x008e,0x7100,0x08ce,0x008c,0x7310,0x3100,0x8cce,
+	0x088c,0x3110,0x6666,0x366c,0x17e8,0x0ff0,0x718e,0x399c,
+	0xaaaa,0xf0f0,0x5a5a,0x33cc,0x3c3c,0x55aa,0x9696,0xa55a,
+	0x73ce,0x13c8,0x324c,0x3bdc,0x6996,0xc33c,0x9966,0x0660,
+	0x0272,0x04e4,0x4e40,0x2720,0xc936,0x936c,0x39c6,0x639c,
+	0x9336,0x9cc9,0x817e,0xe718,0xccf0,0x0fcc,0x7744,0xee22
+};
+//! texel of the second subset whose index has an implicit zero MSB
+constexpr uint8_t BC7Anchors2[64] =
+{
+	15,15,15,15,15,15,15,15,
+	15,15,15,15,15,15,15,15,
+	15, 2, 8, 2, 2, 8, 8,15,
+	 2, 8, 2, 2, 8, 8, 2, 2,
+	15,15, 6, 8, 2, 8,15,15,
+	 2, 8, 2, 2, 2,15,15, 6,
+	 6, 2, 6, 8,15,15, 2, 2,
+	15,15,15,15,15, 2, 2,15
+};
+constexpr uint8_t BC7Weights2[4] = {0,21,43,64};
+constexpr uint8_t BC7Weights3[8] = {0,9,18,27,37,46,55,64};
+constexpr uint8_t BC7Weights4[16] = {0,4,9,13,17,21,26,30,34,38,43,47,51,55,60,64};
+
+inline const uint8_t* getBC7Weights(uint32_t indexBits)
+{
+	switch (indexBits)
+	{
+		case 2u: return BC7Weights2;
+		case 3u: return BC7Weights3;
+		default: return BC7Weights4;
+	}
+}
+
+enum E_BC7_PBIT : uint8_t
+{
+	EBP_NONE,
+	EBP_SHARED,
+	EBP_UNIQUE
+};
+
+//! How a subset gets stored by a particular mode
+struct SBC7SubsetParams
+{
+	uint32_t firstChannel;
+	uint32_t channelCount;
+	uint32_t colorBits;
+	uint32_t alphaBits;
+	E_BC7_PBIT pbits;
+	uint32_t indexBits;
+
+	inline uint32_t getBits(uint32_t channel) const {return channel<3u ? colorBits:alphaBits;}
+};
+
+struct SBC7Endpoints
+{
+	uint32_t quantized[2][4] = {};
+	uint32_t pbits[2] = {};
+	uint32_t decoded[2][4] = {};
+};
+
+inline uint32_t expandBC7(uint32_t value, uint32_t bits)
+{
+	return bits>=8u ? value:((value<<(8u-bits))|(value>>(2u*bits-8u)));
+}
+
+inline uint32_t dequantizeBC7(uint32_t value, uint32_t bits, int32_t pbit)
+{
+	return pbit<0 ? expandBC7(value,bits):expandBC7((value<<1u)|uint32_t(pbit),bits+1u);
+}
+
+//! `value` is in [0,255], `pbit` is negative when the mode has none
+inline uint32_t quantizeBC7(double value, uint32_t bits, int32_t pbit)
+{
+	const uint32_t totalBits = bits+(pbit<0 ? 0u:1u);
+	const double scaled = std::clamp(value,0.0,255.0)*double((0x1u<<totalBits)-1u)/255.0;
+	const int32_t guess = static_cast<int32_t>(std::floor(pbit<0 ? (scaled+0.5):((scaled-double(pbit))*0.5+0.5)));
+	// the bit replication makes the mapping a little nonlinear, so check the neighbours
+	uint32_t best = 0u;
+	double bestError = std::numeric_limits<double>::max();
+	for (int32_t candidate=guess-1; candidate<=guess+1; candidate++)
+	{
+		const uint32_t q = static_cast<uint32_t>(std::clamp(candidate,0,int32_t((0x1u<<bits)-1u)));
+		const double error = std::abs(double(dequantizeBC7(q,bits,pbit))-value);
+		if (error<bestError)
+		{
+			bestError = error;
+			best = q;
+		}
+	}
+	return best;
+}
+
+SBC7Endpoints quantizeBC7Endpoints(const double (&e0)[4], const double (&e1)[4], const SBC7SubsetParams& params)
+{
+	const uint32_t endChannel = params.firstChannel+params.channelCount;
+	auto quantizeEndpoint = [&](const double (&e)[4], int32_t pbit, SBC7Endpoints& out, uint32_t j) -> double
+	{
+		double error = 0.0;
+		for (uint32_t c=params.firstChannel; c<endChannel; c++)
+		{
+			const uint32_t bits = params.getBits(c);
+			out.quantized[j][c] = quantizeBC7(e[c],bits,pbit);
+			out.decoded[j][c] = dequantizeBC7(out.quantized[j][c],bits,pbit);
+			const double d = double(out.decoded[j][c])-e[c];
+			error += d*d;
+		}
+		out.pbits[j] = std::max(pbit,0);
+		return error;
+	};
+
+	SBC7Endpoints retval;
+	switch (params.pbits)
+	{
+		case EBP_NONE:
+			quantizeEndpoint(e0,-1,retval,0u);
+			quantizeEndpoint(e1,-1,retval,1u);
+			break;
+		case EBP_SHARED:
+		{
+			SBC7Endpoints other;
+			const double error = quantizeEndpoint(e0,0,retval,0u)+quantizeEndpoint(e1,0,retval,1u);
+			if (quantizeEndpoint(e0,1,other,0u)+quantizeEndpoint(e1,1,other,1u)<error)
+				retval = other;
+			break;
+		}
+		case EBP_UNIQUE:
+			for (uint32_t j=0u; j<2u; j++)
+			{
+				SBC7Endpoints other;
+				const double (&e)[4] = j ? e1:e0;
+				const double error = quantizeEndpoint(e,0,retval,j);
+				if (quantizeEndpoint(e,1,other,j)<error)
+				{
+					std::copy_n(other.quantized[j],4u,retval.quantized[j]);
+					std::copy_n(other.decoded[j],4u,retval.decoded[j]);
+					retval.pbits[j] = other.pbits[j];
+				}
+			}
+			break;
+	}
+	return retval;
+}
+
+//! Writes the indices of the masked texels and returns their squared error
+double evaluateBC7Subset(const block_texels_t& texels, uint32_t mask, const SBC7Endpoints& endpoints, const SBC7SubsetParams& params, uint8_t (&indices)[BlockTexelCount])
+{
+	const uint32_t endChannel = params.firstChannel+params.channelCount;
+	const uint32_t entryCount = 0x1u<<params.indexBits;
+	const uint8_t* weights = getBC7Weights(params.indexBits);
+
+	double palette[16][4];
+	for (uint32_t k=0u; k<entryCount; k++)
+	for (uint32_t c=params.firstChannel; c<endChannel; c++)
+		palette[k][c] = double(((64u-weights[k])*endpoints.decoded[0][c]+weights[k]*endpoints.decoded[1][c]+32u)>>6u);
+
+	double error = 0.0;
+	for (uint32_t i=0u; i<BlockTexelCount; i++)
+	if (isInMask(mask,i))
+	{
+		double bestDistance = std::numeric_limits<double>::max();
+		for (uint32_t k=0u; k<entryCount; k++)
+		{
+			double distance = 0.0;
+			for (uint32_t c=params.firstChannel; c<endChannel; c++)
+			{
+				const double d = palette[k][c]-texels[i][c];
+				distance += d*d;
+			}
+			if (distance<bestDistance)
+			{
+				bestDistance = distance;
+				indices[i] = k;
+			}
+		}
+		error += bestDistance;
+	}
+	return error;
+}
+
+double fitBC7Subset(
+	const block_texels_t& texels, uint32_t mask, const SBC7SubsetParams& params, E_BLOCK_COMPRESSION_QUALITY quality,
+	SBC7Endpoints& endpoints, uint8_t (&indices)[BlockTexelCount]
+)
+{
+	if (!mask)
+		return 0.0;
+
+	double e0[4],e1[4];
+	fitLine(texels,params.firstChannel,params.channelCount,mask).getEndpoints(e0,e1);
+	endpoints = quantizeBC7Endpoints(e0,e1,params);
+	double bestError = evaluateBC7Subset(texels,mask,endpoints,params,indices);
+	if (quality==EBCQ_HIGH)
+	{
+		double weights[16];
+		const uint8_t* integerWeights = getBC7Weights(params.indexBits);
+		for (uint32_t k=0u; k<(0x1u<<params.indexBits); k++)
+			weights[k] = double(integerWeights[k])/64.0;
+
+		for (uint32_t iteration=0u; iteration<2u; iteration++)
+		{
+			if (!refineEndpoints(texels,params.firstChannel,params.channelCount,mask,indices,weights,e0,e1))
+				break;
+			const SBC7Endpoints candidate = quantizeBC7Endpoints(e0,e1,params);
+			uint8_t candidateIndices[BlockTexelCount];
+			std::copy_n(indices,BlockTexelCount,candidateIndices);
+			const double error = evaluateBC7Subset(texels,mask,candidate,params,candidateIndices);
+			if (error>=bestError)
+				break;
+			bestError = error;
+			endpoints = candidate;
+			std::copy_n(candidateIndices,BlockTexelCount,indices);
+		}
+	}
+	return bestError;
+}
+
+//! The anchor texel's index is stored without its MSB, so it has to be in the lower half of the palette
+void fixBC7Anchor(uint32_t mask, uint32_t anchor, uint32_t indexBits, SBC7Endpoints& endpoints, uint8_t (&indices)[BlockTexelCount])
+{
+	const uint32_t maxIndex = (0x1u<<indexBits)-1u;
+	if (indices[anchor]<=(maxIndex>>1u))
+		return;
+
+	std::swap(endpoints.quantized[0],endpoints.quantized[1]);
+	std::swap(endpoints.decoded[0],endpoints.decoded[1]);
+	std::swap(endpoints.pbits[0],endpoints.pbits[1]);
+	for (uint32_t i=0u; i<BlockTexelCount; i++)
+	if (isInMask(mask,i))
+		indices[i] = maxIndex-indices[i];
+}
+
+double encodeBC7Mode6(const block_texels_t& texels, E_BLOCK_COMPRESSION_QUALITY quality, uint8_t* out)
+{
+	const SBC7SubsetParams params = {0u,4u,7u,7u,EBP_UNIQUE,4u};
+
+	SBC7Endpoints endpoints;
+	uint8_t indices[BlockTexelCount] = {};
+	const double error = fitBC7Subset(texels,FullBlockMask,params,quality,endpoints,indices);
+	fixBC7Anchor(FullBlockMask,0u,params.indexBits,endpoints,indices);
+
+	CBitWriter writer(out,16u);
+	writer.write(0x1u<<6u,7u);
+	for (uint32_t c=0u; c<4u; c++)
+	for (uint32_t j=0u; j<2u; j++)
+		writer.write(endpoints.quantized[j][c],7u);
+	writer.write(endpoints.pbits[0],1u);
+	writer.write(endpoints.pbits[1],1u);
+	for (uint32_t i=0u; i<BlockTexelCount; i++)
+		writer.write(indices[i],i ? 4u:3u);
+	return error;
+}
+
+//! `rotation` swaps alpha with one of the color channels, so that channel gets its own indices
+double encodeBC7Mode5(const block_texels_t& texels, uint32_t rotation, E_BLOCK_COMPRESSION_QUALITY quality, uint8_t* out)
+{
+	const SBC7SubsetParams colorParams = {0u,3u,7u,8u,EBP_NONE,2u};
+	const SBC7SubsetParams alphaParams = {3u,1u,7u,8u,EBP_NONE,2u};
+
+	block_texels_t rotated;
+	memcpy(rotated,texels,sizeof(rotated));
+	if (rotation)
+	for (uint32_t i=0u; i<BlockTexelCount; i++)
+		std::swap(rotated[i][rotation-1u],rotated[i][3]);
+
+	SBC7Endpoints colorEndpoints,alphaEndpoints;
+	uint8_t colorIndices[BlockTexelCount] = {};
+	uint8_t alphaIndices[BlockTexelCount] = {};
+	const double error = fitBC7Subset(rotated,FullBlockMask,colorParams,quality,colorEndpoints,colorIndices)+
+		fitBC7Subset(rotated,FullBlockMask,alphaParams,quality,alphaEndpoints,alphaIndices);
+	fixBC7Anchor(FullBlockMask,0u,colorParams.indexBits,colorEndpoints,colorIndices);
+	fixBC7Anchor(FullBlockMask,0u,alphaParams.indexBits,alphaEndpoints,alphaIndices);
+
+	CBitWriter writer(out,16u);
+	writer.write(0x1u<<5u,6u);
+	writer.write(rotation,2u);
+	for (uint32_t c=0u; c<3u; c++)
+	for (uint32_t j=0u; j<2u; j++)
+		writer.write(colorEndpoints.quantized[j][c],7u);
+	for (uint32_t j=0u; j<2u; j++)
+		writer.write(alphaEndpoints.quantized[j][3],8u);
+	for (uint32_t i=0u; i<BlockTexelCount; i++)
+		writer.write(colorIndices[i],i ? 2u:1u);
+	for (uint32_t i=0u; i<BlockTexelCount; i++)
+		writer.write(alphaIndices[i],i ? 2u:1u);
+	return error;
+}
+
+//! Modes 1 and 3, both are two subset RGB modes with an implicit opaque alpha
+double encodeBC7TwoSubsets(const block_texels_t& texels, uint32_t mode, uint32_t partition, E_BLOCK_COMPRESSION_QUALITY quality, uint8_t* out)
+{
+	const SBC7SubsetParams params = mode==1u ? SBC7SubsetParams{0u,3u,6u,0u,EBP_SHARED,3u}:SBC7SubsetParams{0u,3u,7u,0u,EBP_UNIQUE,2u};
+	const uint32_t masks[2] = {(~uint32_t(BC7Partitions2[partition]))&FullBlockMask,BC7Partitions2[partition]};
+	const uint32_t anchors[2] = {0u,BC7Anchors2[partition]};
+
+	SBC7Endpoints endpoints[2];
+	uint8_t indices[BlockTexelCount] = {};
+	double error = 0.0;
+	for (uint32_t s=0u; s<2u; s++)
+	{
+		error += fitBC7Subset(texels,masks[s],params,quality,endpoints[s],indices);
+		fixBC7Anchor(masks[s],anchors[s],params.indexBits,endpoints[s],indices);
+	}
+	for (uint32_t i=0u; i<BlockTexelCount; i++)
+	{
+		const double d = 255.0-texels[i][3];
+		error += d*d;
+	}
+
+	CBitWriter writer(out,16u);
+	writer.write(0x1u<<mode,mode+1u);
+	writer.write(partition,6u);
+	for (uint32_t c=0u; c<3u; c++)
+	for (uint32_t s=0u; s<2u; s++)
+	for (uint32_t j=0u; j<2u; j++)
+		writer.write(endpoints[s].quantized[j][c],params.colorBits);
+	for (uint32_t s=0u; s<2u; s++)
+	{
+		writer.write(endpoints[s].pbits[0],1u);
+		if (params.pbits==EBP_UNIQUE)
+			writer.write(endpoints[s].pbits[1],1u);
+	}
+	for (uint32_t i=0u; i<BlockTexelCount; i++)
+		writer.write(indices[i],params.indexBits-(i==anchors[0]||i==anchors[1] ? 1u:0u));
+	return error;
+}
+
+//! `texels` are in [0,255]
+void encodeBC7(const block_texels_t& texels, E_BLOCK_COMPRESSION_QUALITY quality, uint8_t* out)
+{
+	double bestError = encodeBC7Mode6(texels,quality,out);
+	if (quality!=EBCQ_HIGH)
+		return;
+
+	uint8_t candidate[16];
+	auto consider = [&](double error) -> void
+	{
+		if (error<bestError)
+		{
+			bestError = error;
+			memcpy(out,candidate,sizeof(candidate));
+		}
+	};
+	for (uint32_t rotation=0u; rotation<4u; rotation++)
+		consider(encodeBC7Mode5(texels,rotation,quality,candidate));
+
+	// the two subset modes can't store alpha
+	for (uint32_t i=0u; i<BlockTexelCount; i++)
+	if (texels[i][3]<254.5)
+		return;
+
+	// only fully encode the partitions where two lines fit the colors best
+	constexpr uint32_t PartitionCandidates = 6u;
+	std::pair<double,uint32_t> partitions[64];
+	for (uint32_t p=0u; p<64u; p++)
+	{
+		const uint32_t secondSubset = BC7Partitions2[p];
+		partitions[p] = {fitLine(texels,0u,3u,(~secondSubset)&FullBlockMask).residual+fitLine(texels,0u,3u,secondSubset).residual,p};
+	}
+	std::partial_sort(partitions,partitions+PartitionCandidates,partitions+64u);
+	for (uint32_t p=0u; p<PartitionCandidates; p++)
+	{
+		consider(encodeBC7TwoSubsets(texels,1u,partitions[p].second,quality,candidate));
+		consider(encodeBC7TwoSubsets(texels,3u,partitions[p].second,quality,candidate));
+	}
+}
+
+
+// BC6H, only the single region modes
+inline int32_t dequantizeBC6H(int32_t value, uint32_t bits, bool isSigned)
+{
+	if (!isSigned)
+	{
+		if (bits>=15u || value==0)
+			return value;
+		if (value==int32_t((0x1u<<bits)-1u))
+			return 0xffff;
+		return ((value<<16)+0x8000)>>bits;
+	}
+
+	if (bits>=16u)
+		return value;
+	const int32_t magnitude = std::abs(value);
+	int32_t retval;
+	if (magnitude==0)
+		retval = 0;
+	else if (magnitude>=int32_t((0x1u<<(bits-1u))-1u))
+		retval = 0x7fff;
+	else
+		retval = ((magnitude<<15)+0x4000)>>(bits-1u);
+	return value<0 ? -retval:retval;
+}
+
+inline int32_t quantizeBC6H(double value, uint32_t bits, bool isSigned)
+{
+	const int32_t maxValue = isSigned ? int32_t((0x1u<<(bits-1u))-1u):int32_t((0x1u<<bits)-1u);
+	const int32_t minValue = isSigned ? -maxValue:0;
+	const double scale = isSigned ? double(0x1u<<(bits-1u))/32768.0:double(0x1u<<bits)/65536.0;
+	const int32_t guess = static_cast<int32_t>(std::floor(value*scale));
+
+	int32_t best = 0;
+	double bestError = std::numeric_limits<double>::max();
+	for (int32_t candidate=guess-1; candidate<=guess+1; candidate++)
+	{
+		const int32_t q = std::clamp(candidate,minValue,maxValue);
+		const double error = std::abs(double(dequantizeBC6H(q,bits,isSigned))-value);
+		if (error<bestError)
+		{
+			bestError = error;
+			best = q;
+		}
+	}
+	return best;
+}
+
+//! Maps a value to the space BC6H interpolates in, which is the half float bit pattern before the final 31/64 (or 31/32) scale
+inline double toBC6HSpace(double value, bool isSigned)
+{
+	if (std::isnan(value))
+		value = 0.0;
+	value = std::clamp(value,isSigned ? -65504.0:0.0,65504.0);
+	const uint16_t half = core::Float16Compressor::compress(static_cast<float>(value));
+	const int32_t magnitude = std::min<int32_t>(half&0x7fff,0x7bff);
+	if (!isSigned)
+		return double(magnitude<<6)/31.0;
+	const double retval = double(magnitude<<5)/31.0;
+	return (half&0x8000) ? -retval:retval;
+}
+
+void encodeBC6H(const block_texels_t& texels, bool isSigned, E_BLOCK_COMPRESSION_QUALITY quality, uint8_t* out)
+{
+	block_texels_t mapped = {};
+	for (uint32_t i=0u; i<BlockTexelCount; i++)
+	for (uint32_t c=0u; c<3u; c++)
+		mapped[i][c] = toBC6HSpace(texels[i][c],isSigned);
+
+	struct SCandidate
+	{
+		uint32_t mode;
+		int32_t endpoints[2][3];
+		uint8_t indices[BlockTexelCount];
+		double error = std::numeric_limits<double>::max();
+	} best;
+	// mode 11 stores both endpoints with 10 bits, mode 12 has an 11 bit base with 9 bit signed deltas
+	auto tryMode = [&](uint32_t mode, const double (&e0)[4], const double (&e1)[4]) -> void
+	{
+		const uint32_t bits = mode==11u ? 10u:11u;
+
+		SCandidate candidate;
+		candidate.mode = mode;
+		int32_t dequantized[2][3];
+		for (uint32_t c=0u; c<3u; c++)
+		{
+			candidate.endpoints[0][c] = quantizeBC6H(e0[c],bits,isSigned);
+			candidate.endpoints[1][c] = quantizeBC6H(e1[c],bits,isSigned);
+			dequantized[0][c] = dequantizeBC6H(candidate.endpoints[0][c],bits,isSigned);
+			dequantized[1][c] = dequantizeBC6H(candidate.endpoints[1][c],bits,isSigned);
+		}
+
+		double palette[16][3];
+		for (uint32_t k=0u; k<16u; k++)
+		for (uint32_t c=0u; c<3u; c++)
+			palette[k][c] = double(((64-int32_t(BC7Weights4[k]))*dequantized[0][c]+int32_t(BC7Weights4[k])*dequantized[1][c]+32)>>6);
+		candidate.error = 0.0;
+		for (uint32_t i=0u; i<BlockTexelCount; i++)
+		{
+			double bestDistance = std::numeric_limits<double>::max();
+			for (uint32_t k=0u; k<16u; k++)
+			{
+				double distance = 0.0;
+				for (uint32_t c=0u; c<3u; c++)
+				{
+					const double d = palette[k][c]-mapped[i][c];
+					distance += d*d;
+				}
+				if (distance<bestDistance)
+				{
+					bestDistance = distance;
+					candidate.indices[i] = k;
+				}
+			}
+			candidate.error += bestDistance;
+		}
+
+		// anchor index has an implicit zero MSB, the weights are symmetric so swapping keeps the palette
+		if (candidate.indices[0]>=8u)
+		{
+			std::swap(candidate.endpoints[0],candidate.endpoints[1]);
+			for (uint32_t i=0u; i<BlockTexelCount; i++)
+				candidate.indices[i] = 15u-candidate.indices[i];
+		}
+		if (mode==12u)
+		for (uint32_t c=0u; c<3u; c++)
+		{
+			const int32_t delta = candidate.endpoints[1][c]-candidate.endpoints[0][c];
+			if (delta<-256 || delta>255)
+				return;
+		}
+
+		if (candidate.error<best.error)
+			best = candidate;
+	};
+
+	double e0[4],e1[4];
+	fitLine(mapped,0u,3u,FullBlockMask).getEndpoints(e0,e1);
+	tryMode(11u,e0,e1);
+	if (quality==EBCQ_HIGH)
+	{
+		tryMode(12u,e0,e1);
+
+		double weights[16];
+		for (uint32_t k=0u; k<16u; k++)
+			weights[k] = double(BC7Weights4[k])/64.0;
+		for (uint32_t iteration=0u; iteration<2u; iteration++)
+		{
+			if (!refineEndpoints(mapped,0u,3u,FullBlockMask,best.indices,weights,e0,e1))
+				break;
+			tryMode(11u,e0,e1);
+			tryMode(12u,e0,e1);
+		}
+	}
+
+	CBitWriter writer(out,16u);
+	if (best.mode==11u)
+	{
+		writer.write(0x03u,5u);
+		for (uint32_t j=0u; j<2u; j++)
+		for (uint32_t c=0u; c<3u; c++)
+			writer.write(uint32_t(best.endpoints[j][c])&0x3ffu,10u);
+	}
+	else
+	{
+		writer.write(0x07u,5u);
+		for (uint32_t c=0u; c<3u; c++)
+			writer.write(uint32_t(best.endpoints[0][c])&0x3ffu,10u);
+		for (uint32_t c=0u; c<3u; c++)
+		{
+			writer.write(uint32_t(best.endpoints[1][c]-best.endpoints[0][c])&0x1ffu,9u);
+			writer.write((uint32_t(best.endpoints[0][c])>>10u)&0x1u,1u);
+		}
+	}
+	for (uint32_t i=0u; i<BlockTexelCount; i++)
+		writer.write(best.indices[i],i ? 4u:3u);
+}
+
+}
+
+bool isBlockCompressionEncodable(E_FORMAT _fmt)
+{
+	switch (_fmt)
+	{
+		case EF_BC1_RGB_UNORM_BLOCK:
+		case EF_BC1_RGB_SRGB_BLOCK:
+		case EF_BC1_RGBA_UNORM_BLOCK:
+		case EF_BC1_RGBA_SRGB_BLOCK:
+		case EF_BC2_UNORM_BLOCK:
+		case EF_BC2_SRGB_BLOCK:
+		case EF_BC3_UNORM_BLOCK:
+		case EF_BC3_SRGB_BLOCK:
+		case EF_BC4_UNORM_BLOCK:
+		case EF_BC4_SNORM_BLOCK:
+		case EF_BC5_UNORM_BLOCK:
+		case EF_BC5_SNORM_BLOCK:
+		case EF_BC6H_UFLOAT_BLOCK:
+		case EF_BC6H_SFLOAT_BLOCK:
+		case EF_BC7_UNORM_BLOCK:
+		case EF_BC7_SRGB_BLOCK:
+			return true;
+		default:
+			return false;
+	}
+}
+
+bool encodeBlockCompressed(E_FORMAT _fmt, void* _block, const double* _texels, E_BLOCK_COMPRESSION_QUALITY _quality)
+{
+	if (!isBlockCompressionEncodable(_fmt))
+		return false;
+
+	uint8_t* const out = reinterpret_cast<uint8_t*>(_block);
+	block_texels_t texels;
+	memcpy(texels,_texels,sizeof(texels));
+	if (_fmt==EF_BC6H_UFLOAT_BLOCK || _fmt==EF_BC6H_SFLOAT_BLOCK)
+	{
+		encodeBC6H(texels,_fmt==EF_BC6H_SFLOAT_BLOCK,_quality,out);
+		return true;
+	}
+
+	const bool isSigned = isSignedFormat(_fmt);
+	for (uint32_t i=0u; i<BlockTexelCount; i++)
+	for (uint32_t c=0u; c<4u; c++)
+	{
+		double& value = texels[i][c];
+		value = std::clamp(std::isnan(value) ? 0.0:value,isSigned ? -1.0:0.0,1.0);
+		if (c<3u && isSRGBFormat(_fmt))
+			value = core::lin2srgb(value);
+	}
+
+	auto encodeBC4 = [&](uint32_t channel, uint8_t* block) -> void
+	{
+		double values[BlockTexelCount];
+		for (uint32_t i=0u; i<BlockTexelCount; i++)
+			values[i] = texels[i][channel]*(isSigned ? 127.0:255.0);
+		encodeBC4Channel(values,isSigned,_quality,block);
+	};
+	switch (_fmt)
+	{
+		case EF_BC1_RGB_UNORM_BLOCK:
+		case EF_BC1_RGB_SRGB_BLOCK:
+			encodeBC1Color(texels,0u,_quality,out);
+			break;
+		case EF_BC1_RGBA_UNORM_BLOCK:
+		case EF_BC1_RGBA_SRGB_BLOCK:
+		{
+			uint32_t transparentMask = 0u;
+			for (uint32_t i=0u; i<BlockTexelCount; i++)
+			if (texels[i][3]<0.5)
+				transparentMask |= 0x1u<<i;
+			encodeBC1Color(texels,transparentMask,_quality,out);
+			break;
+		}
+		case EF_BC2_UNORM_BLOCK:
+		case EF_BC2_SRGB_BLOCK:
+			memset(out,0,8u);
+			for (uint32_t i=0u; i<BlockTexelCount; i++)
+				out[i>>1u] |= static_cast<uint8_t>(static_cast<uint32_t>(texels[i][3]*15.0+0.5)<<(4u*(i&0x1u)));
+			encodeBC1Color(texels,0u,_quality,out+8);
+			break;
+		case EF_BC3_UNORM_BLOCK:
+		case EF_BC3_SRGB_BLOCK:
+			encodeBC4(3u,out);
+			encodeBC1Color(texels,0u,_quality,out+8);
+			break;
+		case EF_BC4_UNORM_BLOCK:
+		case EF_BC4_SNORM_BLOCK:
+			encodeBC4(0u,out);
+			break;
+		case EF_BC5_UNORM_BLOCK:
+		case EF_BC5_SNORM_BLOCK:
+			encodeBC4(0u,out);
+			encodeBC4(1u,out+8);
+			break;
+		default: // BC7
+			for (uint32_t i=0u; i<BlockTexelCount; i++)
+			for (uint32_t c=0u; c<4u; c++)
+				texels[i][c] *= 255.0;
+			encodeBC7(texels,_quality,out);
+			break;
+	}
+	return true;
+}
+
+}
+}
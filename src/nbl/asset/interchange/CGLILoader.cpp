@@ -39,12 +39,72 @@ namespace nbl
 		static inline std::pair<E_FORMAT, ICPUImageView::SComponentMapping> getTranslatedGLIFormat(const gli::texture& texture, const gli::gl& glVersion);
 		static inline void assignGLIDataToRegion(void* regionData, const gli::texture& texture, const uint16_t layer, const uint16_t face, const uint16_t level, const uint64_t sizeOfData);
 		static inline bool performLoadingAsIReadFile(gli::texture& texture, io::IReadFile* file);
+		static inline E_FORMAT getTranslatedDXGIFormat(const uint32_t dxgiFormat);
+		static inline E_FORMAT getTranslatedGLInternalFormat(const uint32_t glInternalFormat);
+		static inline VkExtent3D getMipLevelExtent(const VkExtent3D& extent, const uint32_t mipLevel);
+		static inline uint64_t getMipLevelByteSize(const E_FORMAT format, const VkExtent3D& extent, const uint32_t mipLevel);
+		static inline std::pair<uint32_t, uint32_t> getRequestedMipRange(const IAssetLoader::SAssetLoadParams& params, const uint32_t mipLevels);
+		static inline core::smart_refctd_ptr<ICPUImageView> createImageView(core::smart_refctd_ptr<ICPUImage>&& image, const IImageView<ICPUImage>::E_TYPE viewType, const ICPUImageView::SComponentMapping& components);
+
+		//! What the DDS or KTX header says about the image, the texel data itself stays in the file
+		struct CGLILoader::SParsedTexture
+		{
+			//! texel data of one region, in the order of appearance in the file
+			struct SPayload
+			{
+				uint64_t fileOffset;
+				uint32_t mipLevel;
+				uint32_t baseArrayLayer;
+				uint32_t layerCount;
+			};
+
+			E_FORMAT format = EF_UNKNOWN;
+			IImage::E_TYPE imageType;
+			IImageView<ICPUImage>::E_TYPE viewType;
+			VkExtent3D extent;
+			uint32_t mipLevels;
+			uint32_t arrayLayers;
+			core::vector<SPayload> payloads;
+		};
+
+		//! Keeps a memory mapped file open for as long as a buffer adopting its mapping lives
+		class CMappedFileAllocator
+		{
+			public:
+				using value_type = uint8_t;
+				using pointer = uint8_t*;
+
+				CMappedFileAllocator(io::IReadFile* _file) : file(core::smart_refctd_ptr<io::IReadFile>(_file)) {}
+
+				inline void deallocate(pointer, size_t)
+				{
+					file = nullptr;
+				}
+
+			private:
+				core::smart_refctd_ptr<io::IReadFile> file;
+		};
 
 		asset::SAssetBundle CGLILoader::loadAsset(io::IReadFile* _file, const asset::IAssetLoader::SAssetLoadParams& _params, asset::IAssetLoader::IAssetLoaderOverride* _override, uint32_t _hierarchyLevel)
 		{
 			if (!_file)
 				return {};
 
+			// the common DDS and KTX files get loaded without gli, which would need the whole file in memory and make two more copies of it
+			{
+				const auto& fileName = _file->getFileName();
+				SParsedTexture parsedTexture;
+				bool parsed = false;
+				if (core::hasFileExtension(fileName, "dds"))
+					parsed = parseDDSHeader(parsedTexture, _file);
+				else if (core::hasFileExtension(fileName, "ktx"))
+					parsed = parseKTXHeader(parsedTexture, _file);
+
+				if (parsed)
+					return loadParsedTexture(_file, parsedTexture, _params);
+				_file->seek(0u);
+			}
+
 			gli::texture texture;
 
 			if (!performLoadingAsIReadFile(texture, _file))
@@ -116,18 +176,17 @@ namespace nbl
 
 			const auto texelBlockDimension = asset::getBlockDimensions(format.first);
 			const auto texelBlockByteSize = asset::getTexelOrBlockBytesize(format.first);
-			auto texelBuffer = core::make_smart_refctd_ptr<ICPUBuffer>(texture.size());
-			auto data = reinterpret_cast<uint8_t*>(texelBuffer->getPointer());
+			const auto mipRange = getRequestedMipRange(_params, texture.levels());
 
 			ICPUImage::SCreationParams imageInfo;
 			imageInfo.format = format.first;
 			imageInfo.type = imageType;
 			imageInfo.flags = isItACubemap ? ICPUImage::E_CREATE_FLAGS::ECF_CUBE_COMPATIBLE_BIT : static_cast<ICPUImage::E_CREATE_FLAGS>(0u);
 			imageInfo.samples = ICPUImage::ESCF_1_BIT;
-			imageInfo.extent.width = texture.extent().x;
-			imageInfo.extent.height = texture.extent().y;
-			imageInfo.extent.depth = texture.extent().z;
-			imageInfo.mipLevels = texture.levels();
+			imageInfo.extent.width = texture.extent(mipRange.first).x;
+			imageInfo.extent.height = texture.extent(mipRange.first).y;
+			imageInfo.extent.depth = texture.extent(mipRange.first).z;
+			imageInfo.mipLevels = mipRange.second;
 			imageInfo.arrayLayers = texture.faces() * texture.layers();
 
 			auto image = ICPUImage::create(std::move(imageInfo));
@@ -144,14 +203,20 @@ namespace nbl
 				return texture.size(mipLevel);
 			};
 
+			uint64_t texelDataSize = {};
+			for (uint16_t mipLevel = 0; mipLevel < imageInfo.mipLevels; ++mipLevel)
+				texelDataSize += getFullSizeOfRegion(mipRange.first + mipLevel);
+			auto texelBuffer = interm_createBuffer(_params, texelDataSize);
+			auto data = reinterpret_cast<uint8_t*>(texelBuffer->getPointer());
+
 			{
 				uint16_t regionIndex = {};
 				uint64_t offset = {};
 				for (auto region = regions->begin(); region != regions->end(); ++region)
 				{
-					region->imageExtent.width = texture.extent(regionIndex).x;
-					region->imageExtent.height = texture.extent(regionIndex).y;
-					region->imageExtent.depth = texture.extent(regionIndex).z;
+					region->imageExtent.width = texture.extent(mipRange.first + regionIndex).x;
+					region->imageExtent.height = texture.extent(mipRange.first + regionIndex).y;
+					region->imageExtent.depth = texture.extent(mipRange.first + regionIndex).z;
 					region->bufferRowLength = region->imageExtent.width;
 					region->bufferImageHeight = 0u;
 					region->imageSubresource.mipLevel = regionIndex;
@@ -159,7 +224,7 @@ namespace nbl
 					region->imageSubresource.baseArrayLayer = 0;
 					region->bufferOffset = offset;
 
-					offset += getFullSizeOfRegion(regionIndex);
+					offset += getFullSizeOfRegion(mipRange.first + regionIndex);
 					++regionIndex;
 				}
 			}
@@ -189,16 +254,17 @@ namespace nbl
 			uint64_t tmpDataSizePerRegionSum = {};
 			for (uint16_t mipLevel = 0; mipLevel < imageInfo.mipLevels; ++mipLevel)
 			{
-				const auto layerSize = getFullSizeOfLayer(mipLevel);
+				const uint16_t gliLevel = mipRange.first + mipLevel;
+				const auto layerSize = getFullSizeOfLayer(gliLevel);
 				for (uint16_t layer = 0; layer < imageInfo.arrayLayers; ++layer)
 				{
 					const auto layersData = getCurrentGliLayerAndFace(layer);
 					const auto gliLayer = layersData.first;
 					const auto gliFace = layersData.second;
 
-					assignGLIDataToRegion((reinterpret_cast<uint8_t*>(data) + tmpDataSizePerRegionSum + (layer * layerSize)), texture, gliLayer, gliFace, mipLevel, layerSize);
+					assignGLIDataToRegion((reinterpret_cast<uint8_t*>(data) + tmpDataSizePerRegionSum + (layer * layerSize)), texture, gliLayer, gliFace, gliLevel, layerSize);
 				}
-				tmpDataSizePerRegionSum += getFullSizeOfRegion(mipLevel);
+				tmpDataSizePerRegionSum += getFullSizeOfRegion(gliLevel);
 			}
 
 			image->setBufferAndRegions(std::move(texelBuffer), regions);
@@ -206,35 +272,22 @@ namespace nbl
 			if (imageInfo.format == asset::EF_R8_SRGB)
 				image = IImageAssetHandlerBase::convertR8ToR8G8B8Image(image);
 
-			ICPUImageView::SCreationParams imageViewInfo;
-			imageViewInfo.image = std::move(image);
-			imageViewInfo.format = imageViewInfo.image->getCreationParameters().format;
-			imageViewInfo.viewType = imageViewType;
-			imageViewInfo.components = format.second;
-			imageViewInfo.flags = static_cast<ICPUImageView::E_CREATE_FLAGS>(0u);
-			imageViewInfo.subresourceRange.baseArrayLayer = 0u;
-			imageViewInfo.subresourceRange.baseMipLevel = 0u;
-			imageViewInfo.subresourceRange.layerCount = imageInfo.arrayLayers;
-			imageViewInfo.subresourceRange.levelCount = imageInfo.mipLevels;
-
-			auto imageView = ICPUImageView::create(std::move(imageViewInfo));
-
-			return SAssetBundle(nullptr,{std::move(imageView)});
+			return SAssetBundle(nullptr,{createImageView(std::move(image), imageViewType, format.second)});
 		}
 
 		bool performLoadingAsIReadFile(gli::texture& texture, io::IReadFile* file)
 		{
-			const auto fileName = std::string(file->getFileName().c_str());
+			const auto& fileName = file->getFileName();
 			std::vector<char> memory(file->getSize());
 			const auto sizeOfData = memory.size();
 
 			file->read(memory.data(), sizeOfData);
 
-			if (fileName.rfind(".dds") != std::string::npos)
+			if (core::hasFileExtension(fileName, "dds"))
 				texture = gli::load_dds(memory.data(), sizeOfData);
-			else if (fileName.rfind(".kmg") != std::string::npos)
+			else if (core::hasFileExtension(fileName, "kmg"))
 				texture = gli::load_kmg(memory.data(), sizeOfData);
-			else if (fileName.rfind(".ktx") != std::string::npos)
+			else if (core::hasFileExtension(fileName, "ktx"))
 				texture = gli::load_ktx(memory.data(), sizeOfData);
 
 			if (!texture.empty())
@@ -246,16 +299,521 @@ namespace nbl
 			}
 		}
 
+		bool CGLILoader::parseDDSHeader(SParsedTexture& texture, io::IReadFile* file)
+		{
+			constexpr uint32_t ddsMagic = 0x20534444u;
+			constexpr uint32_t DDSD_MIPMAPCOUNT = 0x20000u;
+			constexpr uint32_t DDPF_ALPHAPIXELS = 0x1u;
+			constexpr uint32_t DDPF_FOURCC = 0x4u;
+			constexpr uint32_t DDPF_RGB = 0x40u;
+			constexpr uint32_t DDSCAPS2_CUBEMAP = 0x200u;
+			constexpr uint32_t DDSCAPS2_CUBEMAP_ALLFACES = 0xfc00u;
+			constexpr uint32_t DDSCAPS2_VOLUME = 0x200000u;
+			constexpr uint32_t DDS_RESOURCE_MISC_TEXTURECUBE = 0x4u;
+			enum E_RESOURCE_DIMENSION : uint32_t
+			{
+				ERD_TEXTURE1D = 2u,
+				ERD_TEXTURE2D = 3u,
+				ERD_TEXTURE3D = 4u
+			};
+
+			struct SHeader
+			{
+				uint32_t magic;
+				uint32_t size;
+				uint32_t flags;
+				uint32_t height;
+				uint32_t width;
+				uint32_t pitchOrLinearSize;
+				uint32_t depth;
+				uint32_t mipMapCount;
+				uint32_t reserved1[11];
+				struct
+				{
+					uint32_t size;
+					uint32_t flags;
+					uint32_t fourCC;
+					uint32_t rgbBitCount;
+					uint32_t masks[4];
+				} pixelFormat;
+				uint32_t caps[4];
+				uint32_t reserved2;
+			} header;
+			static_assert(sizeof(SHeader) == 128u);
+			struct SHeaderDX10
+			{
+				uint32_t dxgiFormat;
+				uint32_t resourceDimension;
+				uint32_t miscFlag;
+				uint32_t arraySize;
+				uint32_t miscFlags2;
+			} headerDX10;
+
+			file->seek(0u);
+			if (file->read(&header, sizeof(header)) != sizeof(header) || header.magic != ddsMagic || header.size != 124u || header.pixelFormat.size != 32u)
+				return false;
+
+			auto makeFourCC = [](const char* code) -> uint32_t
+			{
+				return uint32_t(code[0]) | (uint32_t(code[1]) << 8u) | (uint32_t(code[2]) << 16u) | (uint32_t(code[3]) << 24u);
+			};
+
+			uint64_t offset = sizeof(header);
+			uint32_t resourceDimension = (header.caps[1] & DDSCAPS2_VOLUME) ? ERD_TEXTURE3D : ERD_TEXTURE2D;
+			uint32_t layers = 1u;
+			bool isItACubemap = false;
+			const auto& pixelFormat = header.pixelFormat;
+			if ((pixelFormat.flags & DDPF_FOURCC) && pixelFormat.fourCC == makeFourCC("DX10"))
+			{
+				if (file->read(&headerDX10, sizeof(headerDX10)) != sizeof(headerDX10))
+					return false;
+				offset += sizeof(headerDX10);
+
+				texture.format = getTranslatedDXGIFormat(headerDX10.dxgiFormat);
+				resourceDimension = headerDX10.resourceDimension;
+				layers = core::max(headerDX10.arraySize, 1u);
+				isItACubemap = headerDX10.miscFlag & DDS_RESOURCE_MISC_TEXTURECUBE;
+			}
+			else
+			{
+				if (pixelFormat.flags & DDPF_FOURCC)
+				{
+					// D3DFMT values for the float formats are stored in place of a FourCC
+					switch (pixelFormat.fourCC)
+					{
+						case 36u: texture.format = EF_R16G16B16A16_UNORM; break;
+						case 111u: texture.format = EF_R16_SFLOAT; break;
+						case 112u: texture.format = EF_R16G16_SFLOAT; break;
+						case 113u: texture.format = EF_R16G16B16A16_SFLOAT; break;
+						case 114u: texture.format = EF_R32_SFLOAT; break;
+						case 115u: texture.format = EF_R32G32_SFLOAT; break;
+						case 116u: texture.format = EF_R32G32B32A32_SFLOAT; break;
+						default:
+						{
+							if (pixelFormat.fourCC == makeFourCC("DXT1"))
+								texture.format = EF_BC1_RGBA_UNORM_BLOCK;
+							else if (pixelFormat.fourCC == makeFourCC("DXT2") || pixelFormat.fourCC == makeFourCC("DXT3"))
+								texture.format = EF_BC2_UNORM_BLOCK;
+							else if (pixelFormat.fourCC == makeFourCC("DXT4") || pixelFormat.fourCC == makeFourCC("DXT5"))
+								texture.format = EF_BC3_UNORM_BLOCK;
+							else if (pixelFormat.fourCC == makeFourCC("ATI1") || pixelFormat.fourCC == makeFourCC("BC4U"))
+								texture.format = EF_BC4_UNORM_BLOCK;
+							else if (pixelFormat.fourCC == makeFourCC("BC4S"))
+								texture.format = EF_BC4_SNORM_BLOCK;
+							else if (pixelFormat.fourCC == makeFourCC("ATI2") || pixelFormat.fourCC == makeFourCC("BC5U"))
+								texture.format = EF_BC5_UNORM_BLOCK;
+							else if (pixelFormat.fourCC == makeFourCC("BC5S"))
+								texture.format = EF_BC5_SNORM_BLOCK;
+							break;
+						}
+					}
+				}
+				else if ((pixelFormat.flags & DDPF_RGB) && (pixelFormat.flags & DDPF_ALPHAPIXELS) && pixelFormat.rgbBitCount == 32u)
+				{
+					// without an alpha channel the view would need a swizzle, gli does that
+					if (pixelFormat.masks[0] == 0x000000ffu && pixelFormat.masks[1] == 0x0000ff00u && pixelFormat.masks[2] == 0x00ff0000u && pixelFormat.masks[3] == 0xff000000u)
+						texture.format = EF_R8G8B8A8_UNORM;
+					else if (pixelFormat.masks[0] == 0x00ff0000u && pixelFormat.masks[1] == 0x0000ff00u && pixelFormat.masks[2] == 0x000000ffu && pixelFormat.masks[3] == 0xff000000u)
+						texture.format = EF_B8G8R8A8_UNORM;
+				}
+
+				if (header.caps[1] & DDSCAPS2_CUBEMAP)
+				{
+					// cubemaps with some faces missing are left to gli
+					if ((header.caps[1] & DDSCAPS2_CUBEMAP_ALLFACES) != DDSCAPS2_CUBEMAP_ALLFACES)
+						return false;
+					isItACubemap = true;
+				}
+			}
+			if (texture.format == EF_UNKNOWN)
+				return false;
+
+			const uint32_t faces = isItACubemap ? 6u : 1u;
+			switch (resourceDimension)
+			{
+				case ERD_TEXTURE1D:
+				{
+					texture.imageType = IImage::ET_1D;
+					texture.viewType = layers > 1u ? ICPUImageView::ET_1D_ARRAY : ICPUImageView::ET_1D;
+					texture.extent = { header.width, 1u, 1u };
+					break;
+				}
+				case ERD_TEXTURE2D:
+				{
+					texture.imageType = IImage::ET_2D;
+					if (isItACubemap)
+						texture.viewType = layers > 1u ? ICPUImageView::ET_CUBE_MAP_ARRAY : ICPUImageView::ET_CUBE_MAP;
+					else
+						texture.viewType = layers > 1u ? ICPUImageView::ET_2D_ARRAY : ICPUImageView::ET_2D;
+					texture.extent = { header.width, core::max(header.height, 1u), 1u };
+					break;
+				}
+				case ERD_TEXTURE3D:
+				{
+					texture.imageType = IImage::ET_3D;
+					texture.viewType = ICPUImageView::ET_3D;
+					texture.extent = { header.width, core::max(header.height, 1u), core::max(header.depth, 1u) };
+					break;
+				}
+				default:
+					return false;
+			}
+			if (texture.extent.width == 0u || (isItACubemap && (resourceDimension != ERD_TEXTURE2D || texture.extent.width != texture.extent.height)) || (resourceDimension == ERD_TEXTURE3D && layers != 1u))
+				return false;
+
+			texture.mipLevels = (header.flags & DDSD_MIPMAPCOUNT) ? core::max(header.mipMapCount, 1u) : 1u;
+			if (texture.mipLevels > 32u || (texture.extent.width | texture.extent.height | texture.extent.depth) >> (texture.mipLevels - 1u) == 0u)
+				return false;
+			texture.arrayLayers = layers * faces;
+
+			// every face of every layer has its whole mip chain, before the next one starts
+			texture.payloads.reserve(texture.arrayLayers * texture.mipLevels);
+			for (uint32_t layer = 0u; layer < texture.arrayLayers; ++layer)
+			for (uint32_t mipLevel = 0u; mipLevel < texture.mipLevels; ++mipLevel)
+			{
+				texture.payloads.push_back({ offset, mipLevel, layer, 1u });
+				offset += getMipLevelByteSize(texture.format, texture.extent, mipLevel);
+			}
+			return offset <= file->getSize();
+		}
+
+		bool CGLILoader::parseKTXHeader(SParsedTexture& texture, io::IReadFile* file)
+		{
+			constexpr uint8_t ktxIdentifier[12] = { 0xABu, 'K', 'T', 'X', ' ', '1', '1', 0xBBu, '\r', '\n', 0x1Au, '\n' };
+			constexpr uint32_t ktxNativeEndianness = 0x04030201u;
+
+			struct SHeader
+			{
+				uint8_t identifier[12];
+				uint32_t endianness;
+				uint32_t glType;
+				uint32_t glTypeSize;
+				uint32_t glFormat;
+				uint32_t glInternalFormat;
+				uint32_t glBaseInternalFormat;
+				uint32_t pixelWidth;
+				uint32_t pixelHeight;
+				uint32_t pixelDepth;
+				uint32_t numberOfArrayElements;
+				uint32_t numberOfFaces;
+				uint32_t numberOfMipmapLevels;
+				uint32_t bytesOfKeyValueData;
+			} header;
+			static_assert(sizeof(SHeader) == 64u);
+
+			file->seek(0u);
+			// files written with the other endianness need byteswapping, which gli does
+			if (file->read(&header, sizeof(header)) != sizeof(header) || memcmp(header.identifier, ktxIdentifier, sizeof(ktxIdentifier)) != 0 || header.endianness != ktxNativeEndianness)
+				return false;
+
+			texture.format = getTranslatedGLInternalFormat(header.glInternalFormat);
+			if (texture.format == EF_UNKNOWN || header.pixelWidth == 0u || (header.numberOfFaces != 1u && header.numberOfFaces != 6u))
+				return false;
+
+			const bool isItACubemap = header.numberOfFaces == 6u;
+			const bool layersFlag = header.numberOfArrayElements != 0u;
+			if (header.pixelDepth > 1u)
+			{
+				if (isItACubemap || layersFlag)
+					return false;
+				texture.imageType = IImage::ET_3D;
+				texture.viewType = ICPUImageView::ET_3D;
+			}
+			else if (header.pixelHeight == 0u)
+			{
+				if (isItACubemap)
+					return false;
+				texture.imageType = IImage::ET_1D;
+				texture.viewType = layersFlag ? ICPUImageView::ET_1D_ARRAY : ICPUImageView::ET_1D;
+			}
+			else
+			{
+				texture.imageType = IImage::ET_2D;
+				if (isItACubemap)
+					texture.viewType = layersFlag ? ICPUImageView::ET_CUBE_MAP_ARRAY : ICPUImageView::ET_CUBE_MAP;
+				else
+					texture.viewType = layersFlag ? ICPUImageView::ET_2D_ARRAY : ICPUImageView::ET_2D;
+			}
+			texture.extent = { header.pixelWidth, core::max(header.pixelHeight, 1u), core::max(header.pixelDepth, 1u) };
+			// zero mip levels asks for them to be generated, only the first one is in the file then
+			texture.mipLevels = core::max(header.numberOfMipmapLevels, 1u);
+			if (texture.mipLevels > 32u || (texture.extent.width | texture.extent.height | texture.extent.depth) >> (texture.mipLevels - 1u) == 0u)
+				return false;
+			texture.arrayLayers = core::max(header.numberOfArrayElements, 1u) * header.numberOfFaces;
+
+			const auto blockDimensions = getBlockDimensions(texture.format);
+			const auto texelOrBlockByteSize = getTexelOrBlockBytesize(texture.format);
+			uint64_t offset = sizeof(header) + header.bytesOfKeyValueData;
+			texture.payloads.reserve(texture.mipLevels);
+			for (uint32_t mipLevel = 0u; mipLevel < texture.mipLevels; ++mipLevel)
+			{
+				uint32_t imageSize;
+				file->seek(offset);
+				if (file->read(&imageSize, sizeof(imageSize)) != sizeof(imageSize))
+					return false;
+				offset += sizeof(imageSize);
+
+				// rows and cube faces get padded to 4 bytes, a tightly packed region can't skip that padding
+				const uint64_t rowSize = uint64_t((getMipLevelExtent(texture.extent, mipLevel).width + blockDimensions[0] - 1u) / blockDimensions[0]) * texelOrBlockByteSize;
+				const uint64_t faceSize = getMipLevelByteSize(texture.format, texture.extent, mipLevel);
+				if (rowSize % 4u || faceSize % 4u)
+					return false;
+				// non-array cubemaps store the size of a single face
+				if (imageSize != (isItACubemap && !layersFlag ? faceSize : faceSize * texture.arrayLayers))
+					return false;
+
+				texture.payloads.push_back({ offset, mipLevel, 0u, texture.arrayLayers });
+				offset += faceSize * texture.arrayLayers;
+			}
+			return offset <= file->getSize();
+		}
+
+		asset::SAssetBundle CGLILoader::loadParsedTexture(io::IReadFile* file, const SParsedTexture& texture, const asset::IAssetLoader::SAssetLoadParams& params)
+		{
+			const auto mipRange = getRequestedMipRange(params, texture.mipLevels);
+			auto isPayloadRequested = [&](const SParsedTexture::SPayload& payload) -> bool
+			{
+				return payload.mipLevel >= mipRange.first && payload.mipLevel - mipRange.first < mipRange.second;
+			};
+			auto getPayloadSize = [&](const SParsedTexture::SPayload& payload) -> uint64_t
+			{
+				return getMipLevelByteSize(texture.format, texture.extent, payload.mipLevel) * payload.layerCount;
+			};
+
+			ICPUImage::SCreationParams imageInfo;
+			imageInfo.format = texture.format;
+			imageInfo.type = texture.imageType;
+			imageInfo.flags = doesItHaveFaces(texture.viewType) ? ICPUImage::E_CREATE_FLAGS::ECF_CUBE_COMPATIBLE_BIT : static_cast<ICPUImage::E_CREATE_FLAGS>(0u);
+			imageInfo.samples = ICPUImage::ESCF_1_BIT;
+			imageInfo.extent = getMipLevelExtent(texture.extent, mipRange.first);
+			imageInfo.mipLevels = mipRange.second;
+			imageInfo.arrayLayers = texture.arrayLayers;
+
+			auto image = ICPUImage::create(std::move(imageInfo));
+			if (!image)
+				return {};
+
+			uint32_t regionCount = 0u;
+			uint64_t texelDataSize = 0ull;
+			for (const auto& payload : texture.payloads)
+			if (isPayloadRequested(payload))
+			{
+				regionCount++;
+				texelDataSize += getPayloadSize(payload);
+			}
+
+			// when allowed the buffer is the file's mapping itself, otherwise only the requested mip levels get read into it
+			const auto* mappedFile = (params.loaderFlags & IAssetLoader::ELPF_ADOPT_MAPPED_FILES) ? reinterpret_cast<const uint8_t*>(file->getMappedPointer()) : nullptr;
+			core::smart_refctd_ptr<ICPUBuffer> texelBuffer;
+			if (mappedFile)
+				texelBuffer = core::make_smart_refctd_ptr<CCustomAllocatorCPUBuffer<CMappedFileAllocator>>(file->getSize(), const_cast<uint8_t*>(mappedFile), core::adopt_memory, CMappedFileAllocator(file));
+			else
+				texelBuffer = interm_createBuffer(params, texelDataSize);
+			auto data = reinterpret_cast<uint8_t*>(texelBuffer->getPointer());
+
+			auto readFileRange = [file](uint8_t* dst, const uint64_t fileOffset, uint64_t size) -> bool
+			{
+				if (const auto* fileData = reinterpret_cast<const uint8_t*>(file->getMappedPointer()))
+				{
+					memcpy(dst, fileData + fileOffset, size);
+					return true;
+				}
+
+				file->seek(fileOffset);
+				while (size)
+				{
+					const uint32_t chunkSize = core::min<uint64_t>(size, 0x1u << 30u);
+					if (file->read(dst, chunkSize) != int32_t(chunkSize))
+					{
+						os::Printer::log("LOAD GLI: failed to read the texel data", file->getFileName().c_str(), ELL_ERROR);
+						return false;
+					}
+					dst += chunkSize;
+					size -= chunkSize;
+				}
+				return true;
+			};
+
+			auto regions = core::make_refctd_dynamic_array<core::smart_refctd_dynamic_array<ICPUImage::SBufferCopy>>(regionCount);
+			{
+				auto region = regions->begin();
+				uint64_t bufferOffset = 0ull;
+				// payloads which follow each other in the file get read at once
+				uint64_t pendingFileOffset = 0ull, pendingSize = 0ull;
+				uint8_t* pendingData = nullptr;
+				for (const auto& payload : texture.payloads)
+				{
+					if (!isPayloadRequested(payload))
+						continue;
+
+					const uint64_t payloadSize = getPayloadSize(payload);
+					region->imageExtent = getMipLevelExtent(texture.extent, payload.mipLevel);
+					region->bufferRowLength = region->imageExtent.width;
+					region->bufferImageHeight = 0u;
+					region->imageSubresource.mipLevel = payload.mipLevel - mipRange.first;
+					region->imageSubresource.baseArrayLayer = payload.baseArrayLayer;
+					region->imageSubresource.layerCount = payload.layerCount;
+					region->imageOffset = { 0u, 0u, 0u };
+					region->bufferOffset = mappedFile ? payload.fileOffset : bufferOffset;
+					++region;
+
+					if (mappedFile)
+						continue;
+					if (pendingSize && pendingFileOffset + pendingSize != payload.fileOffset)
+					{
+						if (!readFileRange(pendingData, pendingFileOffset, pendingSize))
+							return {};
+						pendingSize = 0ull;
+					}
+					if (!pendingSize)
+					{
+						pendingFileOffset = payload.fileOffset;
+						pendingData = data + bufferOffset;
+					}
+					pendingSize += payloadSize;
+					bufferOffset += payloadSize;
+				}
+				if (pendingSize && !readFileRange(pendingData, pendingFileOffset, pendingSize))
+					return {};
+			}
+
+			image->setBufferAndRegions(std::move(texelBuffer), regions);
+
+			return SAssetBundle(nullptr, { createImageView(std::move(image), texture.viewType, {}) });
+		}
+
+		inline E_FORMAT getTranslatedDXGIFormat(const uint32_t dxgiFormat)
+		{
+			switch (dxgiFormat)
+			{
+				case 2u: return EF_R32G32B32A32_SFLOAT;
+				case 10u: return EF_R16G16B16A16_SFLOAT;
+				case 11u: return EF_R16G16B16A16_UNORM;
+				case 16u: return EF_R32G32_SFLOAT;
+				case 24u: return EF_A2B10G10R10_UNORM_PACK32;
+				case 26u: return EF_B10G11R11_UFLOAT_PACK32;
+				case 28u: return EF_R8G8B8A8_UNORM;
+				case 29u: return EF_R8G8B8A8_SRGB;
+				case 34u: return EF_R16G16_SFLOAT;
+				case 35u: return EF_R16G16_UNORM;
+				case 41u: return EF_R32_SFLOAT;
+				case 49u: return EF_R8G8_UNORM;
+				case 54u: return EF_R16_SFLOAT;
+				case 56u: return EF_R16_UNORM;
+				case 61u: return EF_R8_UNORM;
+				case 67u: return EF_E5B9G9R9_UFLOAT_PACK32;
+				case 71u: return EF_BC1_RGBA_UNORM_BLOCK;
+				case 72u: return EF_BC1_RGBA_SRGB_BLOCK;
+				case 74u: return EF_BC2_UNORM_BLOCK;
+				case 75u: return EF_BC2_SRGB_BLOCK;
+				case 77u: return EF_BC3_UNORM_BLOCK;
+				case 78u: return EF_BC3_SRGB_BLOCK;
+				case 80u: return EF_BC4_UNORM_BLOCK;
+				case 81u: return EF_BC4_SNORM_BLOCK;
+				case 83u: return EF_BC5_UNORM_BLOCK;
+				case 84u: return EF_BC5_SNORM_BLOCK;
+				case 87u: return EF_B8G8R8A8_UNORM;
+				case 91u: return EF_B8G8R8A8_SRGB;
+				case 95u: return EF_BC6H_UFLOAT_BLOCK;
+				case 96u: return EF_BC6H_SFLOAT_BLOCK;
+				case 98u: return EF_BC7_UNORM_BLOCK;
+				case 99u: return EF_BC7_SRGB_BLOCK;
+				default: return EF_UNKNOWN;
+			}
+		}
+
+		inline E_FORMAT getTranslatedGLInternalFormat(const uint32_t glInternalFormat)
+		{
+			switch (glInternalFormat)
+			{
+				case 0x8229u: return EF_R8_UNORM;						// GL_R8
+				case 0x822Bu: return EF_R8G8_UNORM;						// GL_RG8
+				case 0x8058u: return EF_R8G8B8A8_UNORM;					// GL_RGBA8
+				case 0x8C43u: return EF_R8G8B8A8_SRGB;					// GL_SRGB8_ALPHA8
+				case 0x822Au: return EF_R16_UNORM;						// GL_R16
+				case 0x822Cu: return EF_R16G16_UNORM;					// GL_RG16
+				case 0x805Bu: return EF_R16G16B16A16_UNORM;				// GL_RGBA16
+				case 0x822Du: return EF_R16_SFLOAT;						// GL_R16F
+				case 0x822Fu: return EF_R16G16_SFLOAT;					// GL_RG16F
+				case 0x881Au: return EF_R16G16B16A16_SFLOAT;			// GL_RGBA16F
+				case 0x822Eu: return EF_R32_SFLOAT;						// GL_R32F
+				case 0x8230u: return EF_R32G32_SFLOAT;					// GL_RG32F
+				case 0x8814u: return EF_R32G32B32A32_SFLOAT;			// GL_RGBA32F
+				case 0x8C3Au: return EF_B10G11R11_UFLOAT_PACK32;		// GL_R11F_G11F_B10F
+				case 0x8C3Du: return EF_E5B9G9R9_UFLOAT_PACK32;			// GL_RGB9_E5
+				case 0x83F0u: return EF_BC1_RGB_UNORM_BLOCK;			// GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+				case 0x83F1u: return EF_BC1_RGBA_UNORM_BLOCK;			// GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+				case 0x83F2u: return EF_BC2_UNORM_BLOCK;				// GL_COMPRESSED_RGBA_S3TC_DXT3_EXT
+				case 0x83F3u: return EF_BC3_UNORM_BLOCK;				// GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+				case 0x8C4Cu: return EF_BC1_RGB_SRGB_BLOCK;				// GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+				case 0x8C4Du: return EF_BC1_RGBA_SRGB_BLOCK;			// GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+				case 0x8C4Eu: return EF_BC2_SRGB_BLOCK;					// GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT
+				case 0x8C4Fu: return EF_BC3_SRGB_BLOCK;					// GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+				case 0x8DBBu: return EF_BC4_UNORM_BLOCK;				// GL_COMPRESSED_RED_RGTC1
+				case 0x8DBCu: return EF_BC4_SNORM_BLOCK;				// GL_COMPRESSED_SIGNED_RED_RGTC1
+				case 0x8DBDu: return EF_BC5_UNORM_BLOCK;				// GL_COMPRESSED_RG_RGTC2
+				case 0x8DBEu: return EF_BC5_SNORM_BLOCK;				// GL_COMPRESSED_SIGNED_RG_RGTC2
+				case 0x8E8Cu: return EF_BC7_UNORM_BLOCK;				// GL_COMPRESSED_RGBA_BPTC_UNORM
+				case 0x8E8Du: return EF_BC7_SRGB_BLOCK;					// GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM
+				case 0x8E8Eu: return EF_BC6H_SFLOAT_BLOCK;				// GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT
+				case 0x8E8Fu: return EF_BC6H_UFLOAT_BLOCK;				// GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT
+				case 0x9274u: return EF_ETC2_R8G8B8_UNORM_BLOCK;		// GL_COMPRESSED_RGB8_ETC2
+				case 0x9275u: return EF_ETC2_R8G8B8_SRGB_BLOCK;			// GL_COMPRESSED_SRGB8_ETC2
+				case 0x9278u: return EF_ETC2_R8G8B8A8_UNORM_BLOCK;		// GL_COMPRESSED_RGBA8_ETC2_EAC
+				case 0x9279u: return EF_ETC2_R8G8B8A8_SRGB_BLOCK;		// GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC
+				case 0x93B0u: return EF_ASTC_4x4_UNORM_BLOCK;			// GL_COMPRESSED_RGBA_ASTC_4x4_KHR
+				case 0x93D0u: return EF_ASTC_4x4_SRGB_BLOCK;			// GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR
+				default: return EF_UNKNOWN;
+			}
+		}
+
+		inline VkExtent3D getMipLevelExtent(const VkExtent3D& extent, const uint32_t mipLevel)
+		{
+			return { core::max(extent.width >> mipLevel, 1u), core::max(extent.height >> mipLevel, 1u), core::max(extent.depth >> mipLevel, 1u) };
+		}
+
+		inline uint64_t getMipLevelByteSize(const E_FORMAT format, const VkExtent3D& extent, const uint32_t mipLevel)
+		{
+			const auto mipExtent = getMipLevelExtent(extent, mipLevel);
+			const auto blockDimensions = getBlockDimensions(format);
+			const uint64_t blockCount = uint64_t((mipExtent.width + blockDimensions[0] - 1u) / blockDimensions[0]) * ((mipExtent.height + blockDimensions[1] - 1u) / blockDimensions[1]) * ((mipExtent.depth + blockDimensions[2] - 1u) / blockDimensions[2]);
+			return blockCount * getTexelOrBlockBytesize(format);
+		}
+
+		inline std::pair<uint32_t, uint32_t> getRequestedMipRange(const IAssetLoader::SAssetLoadParams& params, const uint32_t mipLevels)
+		{
+			const uint32_t baseMipLevel = core::min(params.imageBaseMipLevel, mipLevels - 1u);
+			return { baseMipLevel, core::max(core::min(params.imageMipLevelCount, mipLevels - baseMipLevel), 1u) };
+		}
+
+		inline core::smart_refctd_ptr<ICPUImageView> createImageView(core::smart_refctd_ptr<ICPUImage>&& image, const IImageView<ICPUImage>::E_TYPE viewType, const ICPUImageView::SComponentMapping& components)
+		{
+			const auto& imageInfo = image->getCreationParameters();
+
+			ICPUImageView::SCreationParams imageViewInfo;
+			imageViewInfo.format = imageInfo.format;
+			imageViewInfo.viewType = viewType;
+			imageViewInfo.components = components;
+			imageViewInfo.flags = static_cast<ICPUImageView::E_CREATE_FLAGS>(0u);
+			imageViewInfo.subresourceRange.baseArrayLayer = 0u;
+			imageViewInfo.subresourceRange.baseMipLevel = 0u;
+			imageViewInfo.subresourceRange.layerCount = imageInfo.arrayLayers;
+			imageViewInfo.subresourceRange.levelCount = imageInfo.mipLevels;
+			imageViewInfo.image = std::move(image);
+
+			return ICPUImageView::create(std::move(imageViewInfo));
+		}
+
 		bool CGLILoader::isALoadableFileFormat(io::IReadFile* _file) const
 		{
-			const auto fileName = std::string(_file->getFileName().c_str());
+			const auto& fileName = _file->getFileName();
 			const auto beginningOfFile = _file->getPos();
 
 			constexpr auto ddsMagic = 0x20534444;
 			constexpr std::array<uint8_t, 12> ktxMagic = { '', 'K', 'T', 'X', ' ', '1', '1', '', '\r', '\n', '\x1A', '\n' };
 			constexpr std::array<uint8_t, 16> kmgMagic = { 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55 };
 
-			if (fileName.rfind(".dds") != std::string::npos)
+			if (core::hasFileExtension(fileName, "dds"))
 			{
 				std::remove_const<decltype(ddsMagic)>::type tmpBuffer;
 				_file->read(&tmpBuffer, sizeof(ddsMagic));
@@ -267,7 +825,7 @@ namespace nbl
 				else
 					os::Printer::log("LOAD GLI: Invalid (non-DDS) file!", ELL_ERROR);
 			}
-			else if (fileName.rfind(".kmg") != std::string::npos)
+			else if (core::hasFileExtension(fileName, "kmg"))
 			{
 				std::remove_const<decltype(kmgMagic)>::type tmpBuffer;
 				_file->read(tmpBuffer.data(), sizeof(kmgMagic[0]) * kmgMagic.size());
@@ -279,7 +837,7 @@ namespace nbl
 				else
 					os::Printer::log("LOAD GLI: Invalid (non-KMG) file!", ELL_ERROR);
 			}
-			else if (fileName.rfind(".ktx") != std::string::npos)
+			else if (core::hasFileExtension(fileName, "ktx"))
 			{
 				std::remove_const<decltype(ktxMagic)>::type tmpBuffer;
 				_file->read(tmpBuffer.data(), sizeof(ktxMagic[0]) * ktxMagic.size());
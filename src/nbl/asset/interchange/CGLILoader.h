@@ -59,6 +59,12 @@ class CGLILoader final : public asset::IAssetLoader
 				default: return false;
 			}
 		}		
+
+		//! DDS and KTX headers get parsed without gli, so the texel data can be read straight into the image's buffer (or not be copied at all)
+		struct SParsedTexture;
+		static bool parseDDSHeader(SParsedTexture& texture, io::IReadFile* file);
+		static bool parseKTXHeader(SParsedTexture& texture, io::IReadFile* file);
+		static asset::SAssetBundle loadParsedTexture(io::IReadFile* file, const SParsedTexture& texture, const asset::IAssetLoader::SAssetLoadParams& params);
 };
 
 }
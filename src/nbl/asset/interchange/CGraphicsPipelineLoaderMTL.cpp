@@ -124,6 +124,8 @@ SAssetBundle CGraphicsPipelineLoaderMTL::loadAsset(io::IReadFile* _file, const I
 	}();
 
     auto materials = readMaterials(_file);
+    // every texture of every material without a cached descriptor set loads in parallel while we create the pipelines
+    startLoadingImages(fullName,relPath,materials,ctx);
 
     // because one for UV and one without UV
     constexpr uint32_t PIPELINE_PERMUTATION_COUNT = 2u;
@@ -141,7 +143,7 @@ SAssetBundle CGraphicsPipelineLoaderMTL::loadAsset(io::IReadFile* _file, const I
             core::smart_refctd_ptr<ICPUDescriptorSet> ds3;
             if (hasUV)
             {
-                const std::string dsCacheKey = fullName + "?" + material.name + "?_ds";
+                const std::string dsCacheKey = getDescSetCacheKey(fullName,material);
                 const uint32_t ds3HLevel = _hierarchyLevel+ICPUMesh::DESC_SET_HIERARCHYLEVELS_BELOW;
                 ds3 = _override->findDefaultAsset<ICPUDescriptorSet>(dsCacheKey,ctx.inner,ds3HLevel).first;
                 if (!ds3)
@@ -161,6 +163,9 @@ SAssetBundle CGraphicsPipelineLoaderMTL::loadAsset(io::IReadFile* _file, const I
         createPplnDescAndMeta(false);
         createPplnDescAndMeta(true);
     }
+    // a descriptor set could have been cached by another load in the meantime, we can't leave before the textures started for it finish
+    for (auto& load : ctx.imageLoads)
+        finishLoadingImage(load.second);
     
     if (materials.empty())
         return SAssetBundle(nullptr, {});
@@ -512,6 +517,65 @@ const char* CGraphicsPipelineLoaderMTL::readTexture(const char* _bufPtr, const c
     return _bufPtr;
 }
 
+std::string CGraphicsPipelineLoaderMTL::getDescSetCacheKey(const std::string& fullName, const SMtl& _mtl)
+{
+    return fullName + "?" + _mtl.name + "?_ds";
+}
+
+std::string CGraphicsPipelineLoaderMTL::getImageLoadKey(const std::string& relDir, const SMtl& _mtl, const uint32_t _mapType)
+{
+    std::string key = relDir+_mtl.maps[_mapType];
+    if (_mapType == CMTLMetadata::CRenderpassIndependentPipeline::EMP_BUMP)
+        key += "?bump";
+    return key;
+}
+
+CGraphicsPipelineLoaderMTL::SContext::SImageLoad& CGraphicsPipelineLoaderMTL::startLoadingImage(const std::string& relDir, const SMtl& _mtl, const uint32_t _mapType, SContext& _ctx)
+{
+    auto& load = _ctx.imageLoads[getImageLoadKey(relDir,_mtl,_mapType)];
+    if (!load.path.empty())
+        return load;
+    load.path = relDir+_mtl.maps[_mapType];
+
+    const uint32_t hierarchyLevel = _ctx.topHierarchyLevel + ICPURenderpassIndependentPipeline::IMAGE_HIERARCHYLEVELS_BELOW; // this is weird actually, we're not sure if we're loading image or image view
+    SAssetLoadParams lp = _ctx.inner.params;
+    if (_mapType == CMTLMetadata::CRenderpassIndependentPipeline::EMP_BUMP)
+    {
+        // we need bumpmap restored to create derivative map from it
+        const uint32_t restoreLevels = 3u; // 2 in case of image (image, texel buffer) and 3 in case of image view (view, image, texel buffer)
+        lp.restoreLevels = std::max(lp.restoreLevels, hierarchyLevel + restoreLevels);
+    }
+    load.future = interm_getAssetInHierarchyAsync(m_assetMgr, load.path, lp, hierarchyLevel, _ctx.loaderOverride);
+    return load;
+}
+
+void CGraphicsPipelineLoaderMTL::startLoadingImages(const std::string& fullName, const std::string& relDir, const core::vector<SMtl>& _materials, SContext& _ctx)
+{
+    const uint32_t ds3HLevel = _ctx.topHierarchyLevel+ICPUMesh::DESC_SET_HIERARCHYLEVELS_BELOW;
+    for (const auto& mtl : _materials)
+    {
+        // textures are only needed to create the descriptor set
+        if (_ctx.loaderOverride->findDefaultAsset<ICPUDescriptorSet>(getDescSetCacheKey(fullName,mtl),_ctx.inner,ds3HLevel).first)
+            continue;
+
+        for (uint32_t i = 0u; i < CMTLMetadata::CRenderpassIndependentPipeline::EMP_COUNT; ++i)
+        if (!mtl.maps[i].empty())
+            startLoadingImage(relDir,mtl,i,_ctx);
+    }
+}
+
+const SAssetBundle& CGraphicsPipelineLoaderMTL::finishLoadingImage(SContext::SImageLoad& _load) const
+{
+    // same texture can be used by many materials, but the future can only be consumed once
+    if (_load.future.valid())
+    {
+        _load.bundle = _load.future.get();
+        if (_load.bundle.getContents().empty())
+            os::Printer::log("MTL loader: could not load texture", _load.path, ELL_ERROR);
+    }
+    return _load.bundle;
+}
+
 CGraphicsPipelineLoaderMTL::image_views_set_t CGraphicsPipelineLoaderMTL::loadImages(const std::string& relDir, const SMtl& _mtl, SContext& _ctx)
 {
     images_set_t images;
@@ -519,20 +583,10 @@ CGraphicsPipelineLoaderMTL::image_views_set_t CGraphicsPipelineLoaderMTL::loadIm
 
     for (uint32_t i = 0u; i < images.size(); ++i)
     {
-        SAssetLoadParams lp = _ctx.inner.params;
         if (_mtl.maps[i].size() )
         {
-            const uint32_t hierarchyLevel = _ctx.topHierarchyLevel + ICPURenderpassIndependentPipeline::IMAGE_HIERARCHYLEVELS_BELOW; // this is weird actually, we're not sure if we're loading image or image view
-            SAssetBundle bundle;
-            if (i != CMTLMetadata::CRenderpassIndependentPipeline::EMP_BUMP)
-                bundle = interm_getAssetInHierarchy(m_assetMgr, relDir+_mtl.maps[i], lp, hierarchyLevel, _ctx.loaderOverride);
-            else
-            {
-                // we need bumpmap restored to create derivative map from it
-                const uint32_t restoreLevels = 3u; // 2 in case of image (image, texel buffer) and 3 in case of image view (view, image, texel buffer)
-                lp.restoreLevels = std::max(lp.restoreLevels, hierarchyLevel + restoreLevels);
-                bundle = interm_getAssetInHierarchy(m_assetMgr, relDir+_mtl.maps[i], lp, hierarchyLevel, _ctx.loaderOverride);
-            }
+            // a load which was not started ahead of time (descriptor set was cached when we started) runs inline on the wait
+            const SAssetBundle& bundle = finishLoadingImage(startLoadingImage(relDir,_mtl,i,_ctx));
             auto asset = _ctx.loaderOverride->chooseDefaultAsset(bundle,_ctx.inner);
             if (asset)
             switch (bundle.getAssetType())
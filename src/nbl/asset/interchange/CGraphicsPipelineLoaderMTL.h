@@ -36,6 +36,15 @@ class CGraphicsPipelineLoaderMTL final : public asset::IRenderpassIndependentPip
             IAssetLoader::SAssetLoadContext inner;
             uint32_t topHierarchyLevel;
             IAssetLoader::IAssetLoaderOverride* loaderOverride;
+
+            struct SImageLoad
+            {
+                std::string path;
+                core::CThreadPool::future_t<SAssetBundle> future;
+                SAssetBundle bundle;
+            };
+            //! texture loads started ahead of time, keyed by path (with a suffix for bumpmaps which load with different params)
+            core::unordered_map<std::string,SImageLoad> imageLoads;
         };
 
 	public:
@@ -62,6 +71,11 @@ class CGraphicsPipelineLoaderMTL final : public asset::IRenderpassIndependentPip
 
         using images_set_t = std::array<core::smart_refctd_ptr<ICPUImage>, CMTLMetadata::CRenderpassIndependentPipeline::EMP_COUNT>;
         using image_views_set_t = std::array<core::smart_refctd_ptr<ICPUImageView>, CMTLMetadata::CRenderpassIndependentPipeline::EMP_REFL_POSX + 1u>;
+        static std::string getDescSetCacheKey(const std::string& fullName, const SMtl& _mtl);
+        static std::string getImageLoadKey(const std::string& relDir, const SMtl& _mtl, const uint32_t _mapType);
+        SContext::SImageLoad& startLoadingImage(const std::string& relDir, const SMtl& _mtl, const uint32_t _mapType, SContext& _ctx);
+        void startLoadingImages(const std::string& fullName, const std::string& relDir, const core::vector<SMtl>& _materials, SContext& _ctx);
+        const SAssetBundle& finishLoadingImage(SContext::SImageLoad& _load) const;
         image_views_set_t loadImages(const std::string& relDir, const SMtl& _mtl, SContext& _ctx);
         core::smart_refctd_ptr<ICPUDescriptorSet> makeDescSet(image_views_set_t&& _views, ICPUDescriptorSetLayout* _dsLayout, SContext& _ctx);
 };
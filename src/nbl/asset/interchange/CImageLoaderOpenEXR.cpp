@@ -18,8 +18,10 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <string>
+#include <thread>
 #include <unordered_map>
 
 #include "nbl/asset/IAssetManager.h"
@@ -27,7 +29,6 @@ SOFTWARE.
 
 #ifdef _NBL_COMPILE_WITH_OPENEXR_LOADER_
 
-#include "nbl/asset/filters/CRegionBlockFunctorFilter.h"
 #include "nbl/asset/metadata/COpenEXRMetadata.h"
 
 #include "CImageLoaderOpenEXR.h"
@@ -35,11 +36,17 @@ SOFTWARE.
 #include "os.h"
 
 #include "openexr/IlmBase/Imath/ImathBox.h"
-#include "openexr/OpenEXR/IlmImf/ImfRgbaFile.h"
+#include "openexr/IlmBase/Half/half.h"
 #include "openexr/OpenEXR/IlmImf/ImfInputFile.h"
+#include "openexr/OpenEXR/IlmImf/ImfMultiPartInputFile.h"
+#include "openexr/OpenEXR/IlmImf/ImfInputPart.h"
+#include "openexr/OpenEXR/IlmImf/ImfPartType.h"
+#include "openexr/OpenEXR/IlmImf/ImfThreading.h"
+#include "openexr/OpenEXR/IlmImf/ImfVersion.h"
 #include "openexr/OpenEXR/IlmImf/ImfChannelList.h"
 #include "openexr/OpenEXR/IlmImf/ImfChannelListAttribute.h"
 #include "openexr/OpenEXR/IlmImf/ImfStringAttribute.h"
+#include "openexr/OpenEXR/IlmImf/ImfIntAttribute.h"
 #include "openexr/OpenEXR/IlmImf/ImfMatrixAttribute.h"
 #include "openexr/OpenEXR/IlmImf/ImfArray.h"
 
@@ -60,9 +67,8 @@ namespace nbl
 
 		class SContext;
 		bool readVersionField(io::IReadFile* _file, SContext& ctx);
-		bool readHeader(const char fileName[], SContext& ctx);
-		template<typename rgbaFormat>
-		void readRgba(InputFile& file, std::array<Array2D<rgbaFormat>, 4>& pixelRgbaMapArray, int& width, int& height, E_FORMAT& format, const suffixOfChannelBundle suffixOfChannels);
+		bool readHeader(const Header& header, const int part, SContext& ctx);
+		void insertChannels(FrameBuffer& frameBuffer, const suffixOfChannelBundle& suffixOfChannels, const E_FORMAT format, char* texels, const Box2i& dataWindow, const size_t texelByteSize, const size_t rowPitch);
 		E_FORMAT specifyIrrlichtEndFormat(const mapOfChannels& mapOfChannels, const suffixOfChannelBundle suffixName, const std::string fileName);
 
 		//! A helpful struct for handling OpenEXR layout
@@ -112,7 +118,7 @@ namespace nbl
 			{
 				// The header of every OpenEXR file must contain at least the following attributes
 				//according to https://www.openexr.com/documentation/openexrfilelayout.pdf (page 8)
-				const Channel* channels = nullptr;
+				const ChannelList* channels = nullptr;
 				const Compression* compression = nullptr;
 				const Box2i* dataWindow = nullptr;
 				const Box2i* displayWindow = nullptr;
@@ -139,7 +145,8 @@ namespace nbl
 				// Others not required that can be used by metadata
 				// - none at the moment
 
-			} attributes;
+			};
+			core::vector<Attributes> attributes; // one per part
 
 			// core::smart_refctd_dynamic_array<uint32_t> offsetTable; 
 
@@ -147,46 +154,11 @@ namespace nbl
 		};
 
 		constexpr uint8_t availableChannels = 4;
-		struct PerImageData
-		{
-			ICPUImage::SCreationParams params;
-			std::array<Array2D<half>, availableChannels> halfPixelMapArray;
-			std::array<Array2D<float>, availableChannels> fullFloatPixelMapArray;
-			std::array<Array2D<uint32_t>, availableChannels> uint32_tPixelMapArray;
-		};
-		template<typename IlmType>
-		struct ReadTexels
-		{
-				ReadTexels(ICPUImage* image, const std::array<Array2D<IlmType>, availableChannels>& _pixelMapArray) :
-					data(reinterpret_cast<uint8_t*>(image->getBuffer()->getPointer())), pixelMapArray(_pixelMapArray)
-				{
-					using StreamFromEXR = CRegionBlockFunctorFilter<ReadTexels<IlmType>,false>;
-					StreamFromEXR::state_type state(*this,image,image->getRegions().begin());
-					StreamFromEXR::execute(&state);
-				}
-
-				inline void operator()(uint32_t ptrOffset, const core::vectorSIMDu32& texelCoord)
-				{
-					assert(texelCoord.w==0u && texelCoord.z==0u);
-
-					uint8_t* texelPtr = data+ptrOffset;
-					for (auto channelIndex=0; channelIndex<availableChannels; channelIndex++)
-					{
-						const auto& element = pixelMapArray[channelIndex][texelCoord.y][texelCoord.x];
-						reinterpret_cast<std::decay<decltype(element)>::type*>(texelPtr)[channelIndex] = element;
-					}
-				}
-
-			private:
-				uint8_t* const data;
-				const std::array<Array2D<IlmType>, availableChannels>& pixelMapArray;
-		};
-
-		auto getChannels(const InputFile& file)
+		auto getChannels(const Header& header)
 		{
 			std::unordered_map<suffixOfChannelBundle, mapOfChannels> irrChannels;		    // example: G, albedo.R, color.space.B
 			{
-				auto channels = file.header().channels();
+				const auto& channels = header.channels();
 				for (auto mapItr = channels.begin(); mapItr != channels.end(); ++mapItr)
 				{
 					std::string fetchedChannelName = mapItr.name();
@@ -226,84 +198,109 @@ namespace nbl
 			const auto& fileName = _file->getFileName().c_str();
 
 			SContext ctx;
-			InputFile file = fileName;
 
 			if (!readVersionField(_file, ctx))
 				return {};
 
-			if (!readHeader(fileName, ctx))
-				return {};
+			// blocks of scanlines or tiles get decompressed on OpenEXR's global thread pool, the file only decides how many of them are in flight
+			const int threadCount = _params.workerThreadCount ? _params.workerThreadCount : core::max(std::thread::hardware_concurrency(), 1u);
+			if (globalThreadCount() < threadCount)
+				setGlobalThreadCount(threadCount);
+			MultiPartInputFile file(fileName, threadCount);
+
+			ctx.attributes.resize(file.parts());
+			for (int part = 0; part < file.parts(); ++part)
+				if (!readHeader(file.header(part), part, ctx))
+					return {};
+
+			// every channel bundle of every part becomes a separate image
+			core::vector<std::unordered_map<suffixOfChannelBundle, mapOfChannels>> channelsOfParts(file.parts());
+			uint32_t imageCount = 0u;
+			for (int part = 0; part < file.parts(); ++part)
+			{
+				const auto& header = file.header(part);
+				if (header.hasType() && isDeepData(header.type()))
+				{
+					os::Printer::log("LOAD EXR: skipping a part with not supported deep data", fileName, ELL_ERROR);
+					continue;
+				}
+				channelsOfParts[part] = getChannels(header);
+				imageCount += channelsOfParts[part].size();
+			}
 
 			core::vector<core::smart_refctd_ptr<ICPUImage>> images;
-			const auto channelsData = getChannels(file);
-			auto meta = core::make_smart_refctd_ptr<COpenEXRMetadata>(channelsData.size());
+			auto meta = core::make_smart_refctd_ptr<COpenEXRMetadata>(imageCount);
 			{
 				uint32_t metaOffset = 0u;
-				for (const auto& data : channelsData)
+				for (int part = 0; part < file.parts(); ++part)
 				{
-					const auto suffixOfChannels = data.first;
-					const auto mapOfChannels = data.second;
-					PerImageData perImageData;
-
-					int width;
-					int height;
-
-					auto params = perImageData.params;
-					params.format = specifyIrrlichtEndFormat(mapOfChannels, suffixOfChannels, file.fileName());
-					params.type = ICPUImage::ET_2D;;
-					params.flags = static_cast<ICPUImage::E_CREATE_FLAGS>(0u);
-					params.samples = ICPUImage::ESCF_1_BIT;
-					params.extent.depth = 1u;
-					params.mipLevels = 1u;
-					params.arrayLayers = 1u;
-
-					if (params.format == EF_UNKNOWN)
-					{
-						os::Printer::log("LOAD EXR: incorrect format specified for " + suffixOfChannels + " channels - skipping the file", file.fileName(), ELL_INFORMATION);
+					if (channelsOfParts[part].empty())
 						continue;
-					}
 
-					if (params.format == EF_R16G16B16A16_SFLOAT)
-						readRgba(file, perImageData.halfPixelMapArray, width, height, params.format, suffixOfChannels);
-					else if (params.format == EF_R32G32B32A32_SFLOAT)
-						readRgba(file, perImageData.fullFloatPixelMapArray, width, height, params.format, suffixOfChannels);
-					else if (params.format == EF_R32G32B32A32_UINT)
-						readRgba(file, perImageData.uint32_tPixelMapArray, width, height, params.format, suffixOfChannels);
-
-					params.extent.width = width;
-					params.extent.height = height;
-
-					auto image = ICPUImage::create(std::move(params));
-					{ // create image and buffer that backs it
-						const uint32_t texelFormatByteSize = getTexelOrBlockBytesize(image->getCreationParameters().format);
-						auto texelBuffer = core::make_smart_refctd_ptr<ICPUBuffer>(image->getImageDataSizeInBytes());
-						auto regions = core::make_refctd_dynamic_array<core::smart_refctd_dynamic_array<ICPUImage::SBufferCopy>>(1u);
-						ICPUImage::SBufferCopy& region = regions->front();
-						//region.imageSubresource.aspectMask = ...; // waits for Vulkan
-						region.imageSubresource.mipLevel = 0u;
-						region.imageSubresource.baseArrayLayer = 0u;
-						region.imageSubresource.layerCount = 1u;
-						region.bufferOffset = 0u;
-						region.bufferRowLength = calcPitchInBlocks(width, texelFormatByteSize);
-						region.bufferImageHeight = 0u;
-						region.imageOffset = { 0u, 0u, 0u };
-						region.imageExtent = image->getCreationParameters().extent;
-
-						image->setBufferAndRegions(std::move(texelBuffer), regions);
-					}
+					InputPart inputPart(file, part);
+					const auto& header = inputPart.header();
+					const Box2i dataWindow = header.dataWindow();
+					const int width = dataWindow.max.x - dataWindow.min.x + 1;
+					const int height = dataWindow.max.y - dataWindow.min.y + 1;
+					const std::string partName = file.parts() > 1 && header.hasName() ? header.name() : "";
 
-					if (params.format == EF_R16G16B16A16_SFLOAT)
-						ReadTexels(image.get(),perImageData.halfPixelMapArray);
-					else if (params.format == EF_R32G32B32A32_SFLOAT)
-						ReadTexels(image.get(), perImageData.fullFloatPixelMapArray);
-					else if (params.format == EF_R32G32B32A32_UINT)
-						ReadTexels(image.get(), perImageData.uint32_tPixelMapArray);
-
-					meta->placeMeta(metaOffset++,image.get(),std::string(suffixOfChannels),IImageMetadata::ColorSemantic{ ECP_SRGB,EOTF_IDENTITY });
+					// channel bundles of a part get read together, so every block is only decompressed once
+					FrameBuffer frameBuffer;
+					for (const auto& data : channelsOfParts[part])
+					{
+						const auto& suffixOfChannels = data.first;
+						const auto& mapOfChannels = data.second;
+
+						ICPUImage::SCreationParams params;
+						params.format = specifyIrrlichtEndFormat(mapOfChannels, suffixOfChannels, fileName);
+						params.type = ICPUImage::ET_2D;
+						params.flags = static_cast<ICPUImage::E_CREATE_FLAGS>(0u);
+						params.samples = ICPUImage::ESCF_1_BIT;
+						params.extent.width = width;
+						params.extent.height = height;
+						params.extent.depth = 1u;
+						params.mipLevels = 1u;
+						params.arrayLayers = 1u;
+
+						if (params.format == EF_UNKNOWN)
+						{
+							os::Printer::log("LOAD EXR: incorrect format specified for " + suffixOfChannels + " channels - skipping the file", fileName, ELL_INFORMATION);
+							continue;
+						}
+
+						auto image = ICPUImage::create(std::move(params));
+						{ // create image and buffer that backs it
+							const auto format = image->getCreationParameters().format;
+							const uint32_t texelFormatByteSize = getTexelOrBlockBytesize(format);
+							auto texelBuffer = interm_createBuffer(_params, image->getImageDataSizeInBytes());
+							auto regions = core::make_refctd_dynamic_array<core::smart_refctd_dynamic_array<ICPUImage::SBufferCopy>>(1u);
+							ICPUImage::SBufferCopy& region = regions->front();
+							//region.imageSubresource.aspectMask = ...; // waits for Vulkan
+							region.imageSubresource.mipLevel = 0u;
+							region.imageSubresource.baseArrayLayer = 0u;
+							region.imageSubresource.layerCount = 1u;
+							region.bufferOffset = 0u;
+							region.bufferRowLength = calcPitchInBlocks(width, texelFormatByteSize);
+							region.bufferImageHeight = 0u;
+							region.imageOffset = { 0u, 0u, 0u };
+							region.imageExtent = image->getCreationParameters().extent;
+
+							// OpenEXR decodes the channels straight into the interleaved texels
+							insertChannels(frameBuffer, suffixOfChannels, format, reinterpret_cast<char*>(texelBuffer->getPointer()), dataWindow, texelFormatByteSize, size_t(region.bufferRowLength) * texelFormatByteSize);
+
+							image->setBufferAndRegions(std::move(texelBuffer), regions);
+						}
+
+						std::string imageName = partName.empty() ? suffixOfChannels : (suffixOfChannels.empty() ? partName : partName + "." + suffixOfChannels);
+						meta->placeMeta(metaOffset++, image.get(), std::move(imageName), IImageMetadata::ColorSemantic{ ECP_SRGB,EOTF_IDENTITY });
+
+						images.push_back(std::move(image));
+					}
 
-					images.push_back(std::move(image));
+					inputPart.setFrameBuffer(frameBuffer);
+					inputPart.readPixels(dataWindow.min.y, dataWindow.max.y);
 				}
-			}	
+			}
 
 			return SAssetBundle(std::move(meta),std::move(images));
 		}
@@ -320,27 +317,31 @@ namespace nbl
 			return isImfMagic(magicNumberBuffer);
 		}
 
-		template<typename rgbaFormat>
-		void readRgba(InputFile& file, std::array<Array2D<rgbaFormat>, 4>& pixelRgbaMapArray, int& width, int& height, E_FORMAT& format, const suffixOfChannelBundle suffixOfChannels)
+		void insertChannels(FrameBuffer& frameBuffer, const suffixOfChannelBundle& suffixOfChannels, const E_FORMAT format, char* texels, const Box2i& dataWindow, const size_t texelByteSize, const size_t rowPitch)
 		{
-			Box2i dw = file.header().dataWindow();
-			width = dw.max.x - dw.min.x + 1;
-			height = dw.max.y - dw.min.y + 1;
-
 			constexpr const char* rgbaSignatureAsText[] = {"R", "G", "B", "A"};
-			for (auto& pixelChannelBuffer : pixelRgbaMapArray)
-				pixelChannelBuffer.resizeErase(height, width);
 
-			FrameBuffer frameBuffer;
 			PixelType pixelType;
-
+			size_t channelByteSize;
 			if (format == EF_R16G16B16A16_SFLOAT)
+			{
 				pixelType = PixelType::HALF;
+				channelByteSize = sizeof(half);
+			}
 			else if (format == EF_R32G32B32A32_SFLOAT)
+			{
 				pixelType = PixelType::FLOAT;
-			else if (format == EF_R32G32B32A32_UINT)
+				channelByteSize = sizeof(float);
+			}
+			else
+			{
+				assert(format == EF_R32G32B32A32_UINT);
 				pixelType = PixelType::UINT;
+				channelByteSize = sizeof(uint32_t);
+			}
 
+			// slices are addressed with the data window coordinates, which don't have to start at 0
+			char* const base = texels - ptrdiff_t(dataWindow.min.x) * ptrdiff_t(texelByteSize) - ptrdiff_t(dataWindow.min.y) * ptrdiff_t(rowPitch);
 			for (uint8_t rgbaChannelIndex = 0; rgbaChannelIndex < availableChannels; ++rgbaChannelIndex)
 			{
 				std::string name = suffixOfChannels.empty() ? rgbaSignatureAsText[rgbaChannelIndex] : suffixOfChannels + "." + rgbaSignatureAsText[rgbaChannelIndex];
@@ -348,16 +349,13 @@ namespace nbl
 				(
 					name.c_str(),																					// name
 					Slice(pixelType,																				// type
-					(char*)(&(pixelRgbaMapArray[rgbaChannelIndex])[0][0] - dw.min.x - dw.min.y * width),			// base
-						sizeof((pixelRgbaMapArray[rgbaChannelIndex])[0][0]) * 1,                                    // xStride
-						sizeof((pixelRgbaMapArray[rgbaChannelIndex])[0][0]) * width,                                // yStride
+					base + rgbaChannelIndex * channelByteSize,														// base
+						texelByteSize,																				// xStride
+						rowPitch,																					// yStride
 						1, 1,                                                                                       // x/y sampling
 						rgbaChannelIndex == 3 ? 1 : 0                                                               // default fillValue for channels that aren't present in file - 1 for alpha, otherwise 0
 					));
 			}
-
-			file.setFrameBuffer(frameBuffer);
-			file.readPixels(dw.min.y, dw.max.y);
 		}
 
 		E_FORMAT specifyIrrlichtEndFormat(const mapOfChannels& mapOfChannels, const suffixOfChannelBundle suffixName, const std::string fileName)
@@ -402,92 +400,89 @@ namespace nbl
 
 		bool readVersionField(io::IReadFile* _file, SContext& ctx)
 		{
-			RgbaInputFile file(_file->getFileName().c_str());
 			auto& versionField = ctx.versionField;
-			
-			versionField.mainDataRegisterField = file.version();
 
-			auto isTheBitActive = [&](uint16_t bitToCheck)
-			{
-				return (versionField.mainDataRegisterField & (1 << (bitToCheck - 1)));
-			};
+			// the version field directly follows the magic number
+			const size_t begginingOfFile = _file->getPos();
+			_file->seek(sizeof(SContext::magicNumber));
+			const bool wasRead = _file->read(&versionField.mainDataRegisterField, sizeof(versionField.mainDataRegisterField)) == sizeof(versionField.mainDataRegisterField);
+			_file->seek(begginingOfFile);
+			if (!wasRead)
+				return false;
 
-			versionField.fileFormatVersionNumber |= isTheBitActive(1) | isTheBitActive(2) | isTheBitActive(3) | isTheBitActive(4) | isTheBitActive(5) | isTheBitActive(6) | isTheBitActive(7) | isTheBitActive(8);
+			const int version = versionField.mainDataRegisterField;
+			versionField.fileFormatVersionNumber = getVersion(version);
+			versionField.doesFileContainLongNames = version & LONG_NAMES_FLAG;
+			versionField.doesItSupportDeepData = version & NON_IMAGE_FLAG;
 
-			if (!isTheBitActive(11) && !isTheBitActive(12))
+			if (version & MULTI_PART_FILE_FLAG)
+			{
+				// deep parts get skipped when loading
+				versionField.Compoment.type = SContext::VersionField::Compoment::MULTI_PART_FILE;
+				versionField.Compoment.singlePartFileCompomentSubTypes = SContext::VersionField::Compoment::SCAN_LINES_OR_TILES;
+			}
+			else
 			{
 				versionField.Compoment.type = SContext::VersionField::Compoment::SINGLE_PART_FILE;
-
-				if (isTheBitActive(9))
+				if (versionField.doesItSupportDeepData)
 				{
-					versionField.Compoment.singlePartFileCompomentSubTypes = SContext::VersionField::Compoment::TILES;
-					os::Printer::log("LOAD EXR: the file consist of not supported tiles", file.fileName(), ELL_ERROR);
+					os::Printer::log("LOAD EXR: the file consist of not supported deep data", _file->getFileName().c_str(), ELL_ERROR);
 					return false;
 				}
+
+				if (version & TILED_FLAG)
+					versionField.Compoment.singlePartFileCompomentSubTypes = SContext::VersionField::Compoment::TILES;
 				else
 					versionField.Compoment.singlePartFileCompomentSubTypes = SContext::VersionField::Compoment::SCAN_LINES;
 			}
-			else if (!isTheBitActive(9) && !isTheBitActive(11) && isTheBitActive(12))
-			{
-				versionField.Compoment.type = SContext::VersionField::Compoment::MULTI_PART_FILE;
-				versionField.Compoment.singlePartFileCompomentSubTypes = SContext::VersionField::Compoment::SCAN_LINES_OR_TILES;
-				os::Printer::log("LOAD EXR: the file is a not supported multi part file", file.fileName(), ELL_ERROR);
-				return false;
-			}
-
-			if (!isTheBitActive(9) && isTheBitActive(11) && isTheBitActive(12))
-			{
-				versionField.doesItSupportDeepData = true;
-				os::Printer::log("LOAD EXR: the file consist of not supported deep data", file.fileName(), ELL_ERROR);
-				return false;
-			}
-			else
-				versionField.doesItSupportDeepData = false;
-
-			if (isTheBitActive(10))
-				versionField.doesFileContainLongNames = true;
-			else
-				versionField.doesFileContainLongNames = false;
 
 			return true;
 		}
 
-		bool readHeader(const char fileName[], SContext& ctx)
+		//! `Header::findTypedAttribute` relies on a `dynamic_cast` which doesn't work reliably across the OpenEXR library boundary, comparing type names does
+		template<typename T>
+		const T* findAttributeValue(const Header& header, const char name[])
 		{
-			RgbaInputFile file(fileName);
-			auto& attribs = ctx.attributes;
-			auto& versionField = ctx.versionField;
-
-			/*
-
-			// There is an OpenEXR library implementation error associated with dynamic_cast<> probably
-			// Since OpenEXR loader only cares about RGB and RGBA, there is no need for bellow at the moment
-
-			attribs.channels = file.header().findTypedAttribute<Channel>("channels");
-			attribs.compression = file.header().findTypedAttribute<Compression>("compression");
-			attribs.dataWindow = file.header().findTypedAttribute<Box2i>("dataWindow");
-			attribs.displayWindow = file.header().findTypedAttribute<Box2i>("displayWindow");
-			attribs.lineOrder = file.header().findTypedAttribute<LineOrder>("lineOrder");
-			attribs.pixelAspectRatio = file.header().findTypedAttribute<float>("pixelAspectRatio");
-			attribs.screenWindowCenter = file.header().findTypedAttribute<V2f>("screenWindowCenter");
-			attribs.screenWindowWidth = file.header().findTypedAttribute<float>("screenWindowWidth");
-
-			if (versionField.Compoment.singlePartFileCompomentSubTypes == SContext::VersionField::Compoment::TILES)
-				attribs.tiles = file.header().findTypedAttribute<TileDescription>("tiles");
-
-			if (versionField.Compoment.type == SContext::VersionField::Compoment::MULTI_PART_FILE)
-				attribs.view = file.header().findTypedAttribute<std::string>("view");
+			using attribute_t = TypedAttribute<T>;
+			auto found = header.find(name);
+			if (found == header.end() || strcmp(found.attribute().typeName(), attribute_t::staticTypeName()) != 0)
+				return nullptr;
+			return &static_cast<const attribute_t&>(found.attribute()).value();
+		}
 
-			if (versionField.Compoment.type == SContext::VersionField::Compoment::MULTI_PART_FILE || versionField.doesItSupportDeepData)
+		bool readHeader(const Header& header, const int part, SContext& ctx)
+		{
+			auto& attribs = ctx.attributes[part];
+			const auto& versionField = ctx.versionField;
+
+			// attributes every header has (the library fills in defaults if the file lacks them)
+			attribs.channels = &header.channels();
+			attribs.compression = &header.compression();
+			attribs.dataWindow = &header.dataWindow();
+			attribs.displayWindow = &header.displayWindow();
+			attribs.lineOrder = &header.lineOrder();
+			attribs.pixelAspectRatio = &header.pixelAspectRatio();
+			attribs.screenWindowCenter = &header.screenWindowCenter();
+			attribs.screenWindowWidth = &header.screenWindowWidth();
+
+			if (header.hasTileDescription())
+				attribs.tiles = &header.tileDescription();
+			else if (versionField.Compoment.type == SContext::VersionField::Compoment::SINGLE_PART_FILE && versionField.Compoment.singlePartFileCompomentSubTypes == SContext::VersionField::Compoment::TILES)
 			{
-				attribs.name = file.header().findTypedAttribute<std::string>("name");
-				attribs.type = file.header().findTypedAttribute<std::string>("type");
-				attribs.version = file.header().findTypedAttribute<int>("version");
-				attribs.chunkCount = file.header().findTypedAttribute<int>("chunkCount");
-				attribs.maxSamplesPerPixel = file.header().findTypedAttribute<int>("maxSamplesPerPixel");
+				os::Printer::log("LOAD EXR: tiled file without a tile description", ELL_ERROR);
+				return false;
 			}
 
-			*/
+			if (header.hasName())
+				attribs.name = &header.name();
+			if (header.hasType())
+				attribs.type = &header.type();
+			if (header.hasVersion())
+				attribs.version = &header.version();
+			if (header.hasChunkCount())
+				attribs.chunkCount = &header.chunkCount();
+			attribs.maxSamplesPerPixel = findAttributeValue<int>(header, "maxSamplesPerPixel");
+			attribs.view = findAttributeValue<std::string>(header, "view");
 
 			return true;
 		}
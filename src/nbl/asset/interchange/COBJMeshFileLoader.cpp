@@ -18,6 +18,8 @@
 #include "COBJMeshFileLoader.h"
 
 #include <filesystem>
+#include <cfloat>
+#include <cstdlib>
 
 
 namespace nbl
@@ -66,13 +68,10 @@ asset::SAssetBundle COBJMeshFileLoader::loadAsset(io::IReadFile* _file, const as
 
 	CQuantNormalCache* const quantNormalCache = _params.meshManipulatorOverride->getQuantNormalCache();
 
-	const long filesize = _file->getSize();
+	const size_t filesize = _file->getSize();
 	if (!filesize)
         return {};
 
-	const uint32_t WORD_BUFFER_LENGTH = 512u;
-    char tmpbuf[WORD_BUFFER_LENGTH]{};
-
 	uint32_t smoothingGroup=0;
 
 	const std::string fullName = _file->getFileName().c_str();
@@ -102,39 +101,25 @@ asset::SAssetBundle COBJMeshFileLoader::loadAsset(io::IReadFile* _file, const as
 	};
     core::unordered_multiset<pipeline_meta_pair_t,hash_t,key_equal_t> pipelines;
 
-    std::string fileContents;
-    fileContents.resize(filesize);
-	char* const buf = fileContents.data();
-	_file->read(buf, filesize);
-	const char* const bufEnd = buf+filesize;
-
-	// Process obj information
-	const char* bufPtr = buf;
 	std::string grpName, mtlName;
 
+	const bool rightHanded = _params.loaderFlags & E_LOADER_PARAMETER_FLAGS::ELPF_RIGHT_HANDED_MESHES;
 	auto performActionBasedOnOrientationSystem = [&](auto performOnRightHanded, auto performOnLeftHanded)
 	{
-		if (_params.loaderFlags & E_LOADER_PARAMETER_FLAGS::ELPF_RIGHT_HANDED_MESHES)
+		if (rightHanded)
 			performOnRightHanded();
 		else
 			performOnLeftHanded();
 	};
 
-
-    struct vec3 {
-        float data[3];
-    };
-    struct vec2 {
-        float data[2];
-    };
     core::vector<vec3> vertexBuffer;
-    core::vector<vec3> normalsBuffer;
+    core::vector<CQuantNormalCache::value_type_t<EF_A2B10G10R10_SNORM_PACK32>> normalsBuffer; // quantized once per `vn` instead of once per face corner
     core::vector<vec2> textureCoordBuffer;
 
     core::vector<core::smart_refctd_ptr<ICPUMeshBuffer>> submeshes;
     core::vector<core::vector<uint32_t>> indices;
     core::vector<SObjVertex> vertices;
-    core::map<SObjVertex, uint32_t> map_vtx2ix;
+    core::unordered_map<SObjVertexKey,uint32_t,SObjVertexKey::hash> map_vtx2ix;
     core::vector<bool> recalcNormals;
     core::vector<bool> submeshWasLoadedFromCache;
     core::vector<std::string> submeshCacheKeys;
@@ -144,235 +129,277 @@ asset::SAssetBundle COBJMeshFileLoader::loadAsset(io::IReadFile* _file, const as
 	constexpr const char* NO_MATERIAL_MTL_NAME = "#";
 	bool noMaterial = true;
 	bool dummyMaterialCreated = false;
-	while(bufPtr != bufEnd)
+	core::vector<uint32_t> faceCorners;
+	// statements get applied strictly in file order, only the tokenizing and float parsing happens in parallel
+	auto mergeParsedLines = [&](const SParsedLines& parsed) -> void
 	{
-		switch(bufPtr[0])
-		{
-		case 'm':	// mtllib (material)
+		const uint32_t positionBase = vertexBuffer.size();
+		const uint32_t uvBase = textureCoordBuffer.size();
+		const uint32_t normalBase = normalsBuffer.size();
+		vertexBuffer.insert(vertexBuffer.end(),parsed.positions.begin(),parsed.positions.end());
+		textureCoordBuffer.insert(textureCoordBuffer.end(),parsed.uvs.begin(),parsed.uvs.end());
+		for (const auto& normal : parsed.normals)
 		{
-			if (ctx.useMaterials)
-			{
-				bufPtr = goAndCopyNextWord(tmpbuf, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-				#ifdef _NBL_DEBUG_OBJ_LOADER_
-					os::Printer::log("Reading material _file",tmpbuf);
-				#endif
-
-                std::string mtllib = relPath+tmpbuf;
-                std::replace(mtllib.begin(), mtllib.end(), '\\', '/');
-                SAssetLoadParams loadParams;
-                auto bundle = interm_getAssetInHierarchy(AssetManager, mtllib, loadParams, _hierarchyLevel+ICPUMesh::PIPELINE_HIERARCHYLEVELS_BELOW, _override);
-				auto meta = bundle.getMetadata()->selfCast<const CMTLMetadata>();
-				if (bundle.getAssetType()==IAsset::ET_RENDERPASS_INDEPENDENT_PIPELINE)
-				for (auto ass : bundle.getContents())
-                {
-                    auto ppln = core::smart_refctd_ptr_static_cast<ICPURenderpassIndependentPipeline>(ass);
-					const auto pplnMeta = meta->getAssetSpecificMetadata(ppln.get());
-					if (!pplnMeta)
-						continue;
-
-                    pipelines.emplace(std::move(ppln),pplnMeta);
-                }
-			}
+			core::vectorSIMDf simdNormal(normal.data[0],normal.data[1],normal.data[2]);
+			simdNormal.makeSafe3D();
+			normalsBuffer.push_back(quantNormalCache->quantize<EF_A2B10G10R10_SNORM_PACK32>(simdNormal));
 		}
-			break;
 
-		case 'v':               // v, vn, vt
-			//reset flags
-			noMaterial = true;
-			dummyMaterialCreated = false;
-			switch(bufPtr[1])
-			{
-			case ' ':          // vertex
-				{
-					vec3 vec;
-					bufPtr = readVec3(bufPtr, vec.data, bufEnd);
-					performActionBasedOnOrientationSystem([&]() {vec.data[0] = -vec.data[0];}, [&]() {});
-					vertexBuffer.push_back(vec);
-				}
+		for (const auto& statement : parsed.statements)
+		switch (statement.type)
+		{
+			case SParsedLines::ES_VERTEX_DATA:
+				//reset flags
+				noMaterial = true;
+				dummyMaterialCreated = false;
 				break;
-
-			case 'n':       // normal
+			case SParsedLines::ES_MTLLIB:
+				if (ctx.useMaterials)
 				{
-					vec3 vec;
-					bufPtr = readVec3(bufPtr, vec.data, bufEnd);
-					performActionBasedOnOrientationSystem([&]() {vec.data[0] = -vec.data[0]; }, [&]() {});
-					normalsBuffer.push_back(vec);
-				}
-				break;
+					const std::string mtlFileName(statement.argument,statement.argumentLength);
+					#ifdef _NBL_DEBUG_OBJ_LOADER_
+						os::Printer::log("Reading material _file",mtlFileName);
+					#endif
+
+					std::string mtllib = relPath+mtlFileName;
+					std::replace(mtllib.begin(), mtllib.end(), '\\', '/');
+					SAssetLoadParams loadParams;
+					auto bundle = interm_getAssetInHierarchy(AssetManager, mtllib, loadParams, _hierarchyLevel+ICPUMesh::PIPELINE_HIERARCHYLEVELS_BELOW, _override);
+					auto meta = bundle.getMetadata()->selfCast<const CMTLMetadata>();
+					if (bundle.getAssetType()==IAsset::ET_RENDERPASS_INDEPENDENT_PIPELINE)
+					for (auto ass : bundle.getContents())
+					{
+						auto ppln = core::smart_refctd_ptr_static_cast<ICPURenderpassIndependentPipeline>(ass);
+						const auto pplnMeta = meta->getAssetSpecificMetadata(ppln.get());
+						if (!pplnMeta)
+							continue;
 
-			case 't':       // texcoord
-				{
-					vec2 vec;
-					bufPtr = readUV(bufPtr, vec.data, bufEnd);
-					textureCoordBuffer.push_back(vec);
+						pipelines.emplace(std::move(ppln),pplnMeta);
+					}
 				}
 				break;
-			}
-			break;
-
-		case 'g': // group name
-            bufPtr = goAndCopyNextWord(tmpbuf, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-            grpName = tmpbuf;
-			break;
-		case 's': // smoothing can be a group or off (equiv. to 0)
-			{
-				bufPtr = goAndCopyNextWord(tmpbuf, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
+			case SParsedLines::ES_GROUP: // group name
+				grpName.assign(statement.argument,statement.argumentLength);
+				break;
+			case SParsedLines::ES_SMOOTHING: // smoothing can be a group or off (equiv. to 0)
+				{
+					const std::string smoothing(statement.argument,statement.argumentLength);
 #ifdef _NBL_DEBUG_OBJ_LOADER_
-	os::Printer::log("Loaded smoothing group start",tmpbuf, ELL_DEBUG);
+	os::Printer::log("Loaded smoothing group start",smoothing, ELL_DEBUG);
 #endif
-				if (strcmp("off", tmpbuf)==0)
-					smoothingGroup=0u;
-				else
-                    sscanf(tmpbuf,"%u",&smoothingGroup);
-			}
-			break;
-
-		case 'u': // usemtl
-			// get name of material
-			{
-				noMaterial = false;
-				bufPtr = goAndCopyNextWord(tmpbuf, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
+					if (smoothing=="off")
+						smoothingGroup=0u;
+					else
+						sscanf(smoothing.c_str(),"%u",&smoothingGroup);
+				}
+				break;
+			case SParsedLines::ES_USEMTL: // get name of material
+				{
+					noMaterial = false;
+					mtlName.assign(statement.argument,statement.argumentLength);
 #ifdef _NBL_DEBUG_OBJ_LOADER_
-	os::Printer::log("Loaded material start",tmpbuf, ELL_DEBUG);
+	os::Printer::log("Loaded material start",mtlName, ELL_DEBUG);
 #endif
-				mtlName=tmpbuf;
-
-                if (ctx.useMaterials && !ctx.useGroups)
-                {
-                    asset::IAsset::E_TYPE types[] {asset::IAsset::ET_SUB_MESH, (asset::IAsset::E_TYPE)0u };
-                    auto mb_bundle = _override->findCachedAsset(genKeyForMeshBuf(ctx, _file->getFileName().c_str(), mtlName, grpName), types, ctx.inner, _hierarchyLevel+ICPUMesh::MESHBUFFER_HIERARCHYLEVELS_BELOW);
-                    auto mbs = mb_bundle.getContents();
-					bool notempty = mbs.size()!=0ull;
-                    {
-                        auto mb = notempty ? core::smart_refctd_ptr_static_cast<ICPUMeshBuffer>(*mbs.begin()) : core::make_smart_refctd_ptr<ICPUMeshBuffer>();
-						if (notempty)
-							mb->setNormalAttributeIx(NORMAL);
-                        submeshes.push_back(std::move(mb));
-                    }
-                    indices.emplace_back();
-                    recalcNormals.push_back(false);
-                    submeshWasLoadedFromCache.push_back(notempty);
-                    //if submesh was loaded from cache - insert empty "cache key" (submesh loaded from cache won't be added to cache again)
-                    submeshCacheKeys.push_back(submeshWasLoadedFromCache.back() ? "" : genKeyForMeshBuf(ctx, _file->getFileName().c_str(), mtlName, grpName));
-                    submeshMaterialNames.push_back(mtlName);
-                }
-			}
-			break;
-		case 'f':               // face
-		{
-			if (noMaterial && !dummyMaterialCreated)
-			{
-				dummyMaterialCreated = true;
-
-				submeshes.push_back(core::make_smart_refctd_ptr<ICPUMeshBuffer>());
-				submeshes.back()->setNormalAttributeIx(NORMAL);
-				indices.emplace_back();
-				recalcNormals.push_back(false);
-				submeshWasLoadedFromCache.push_back(false);
-				submeshCacheKeys.push_back(genKeyForMeshBuf(ctx, _file->getFileName().c_str(), NO_MATERIAL_MTL_NAME, grpName));
-				submeshMaterialNames.push_back(NO_MATERIAL_MTL_NAME);
-			}
+					if (ctx.useMaterials && !ctx.useGroups)
+					{
+						asset::IAsset::E_TYPE types[] {asset::IAsset::ET_SUB_MESH, (asset::IAsset::E_TYPE)0u };
+						auto mb_bundle = _override->findCachedAsset(genKeyForMeshBuf(ctx, _file->getFileName().c_str(), mtlName, grpName), types, ctx.inner, _hierarchyLevel+ICPUMesh::MESHBUFFER_HIERARCHYLEVELS_BELOW);
+						auto mbs = mb_bundle.getContents();
+						bool notempty = mbs.size()!=0ull;
+						{
+							auto mb = notempty ? core::smart_refctd_ptr_static_cast<ICPUMeshBuffer>(*mbs.begin()) : core::make_smart_refctd_ptr<ICPUMeshBuffer>();
+							if (notempty)
+								mb->setNormalAttributeIx(NORMAL);
+							submeshes.push_back(std::move(mb));
+						}
+						indices.emplace_back();
+						recalcNormals.push_back(false);
+						submeshWasLoadedFromCache.push_back(notempty);
+						//if submesh was loaded from cache - insert empty "cache key" (submesh loaded from cache won't be added to cache again)
+						submeshCacheKeys.push_back(submeshWasLoadedFromCache.back() ? "" : genKeyForMeshBuf(ctx, _file->getFileName().c_str(), mtlName, grpName));
+						submeshMaterialNames.push_back(mtlName);
+					}
+				}
+				break;
+			case SParsedLines::ES_FACE:
+				{
+					if (noMaterial && !dummyMaterialCreated)
+					{
+						dummyMaterialCreated = true;
+
+						submeshes.push_back(core::make_smart_refctd_ptr<ICPUMeshBuffer>());
+						submeshes.back()->setNormalAttributeIx(NORMAL);
+						indices.emplace_back();
+						recalcNormals.push_back(false);
+						submeshWasLoadedFromCache.push_back(false);
+						submeshCacheKeys.push_back(genKeyForMeshBuf(ctx, _file->getFileName().c_str(), NO_MATERIAL_MTL_NAME, grpName));
+						submeshMaterialNames.push_back(NO_MATERIAL_MTL_NAME);
+					}
 
-			SObjVertex v;
+					// convert obj's 1-based and relative indices to 0-based ones, -1 if not present
+					auto resolveIndex = [](const int32_t idx, const uint32_t countSoFar) -> int64_t
+					{
+						return idx<0 ? int64_t(countSoFar)+idx:int64_t(idx)-1ll;
+					};
+					const uint32_t positionCount = positionBase+statement.positionCount;
+					const uint32_t uvCount = uvBase+statement.uvCount;
+					const uint32_t normalCount = normalBase+statement.normalCount;
+
+					faceCorners.clear();
+					const int32_t* corner = parsed.faceCorners.data()+statement.firstCorner*3u;
+					for (uint32_t i=0u; i<statement.cornerCount; i++,corner+=3)
+					{
+						const int64_t Idx[3] = {resolveIndex(corner[0],positionCount),resolveIndex(corner[1],uvCount),resolveIndex(corner[2],normalCount)};
+						if (Idx[0]<0ll || Idx[0]>=int64_t(positionCount))
+						{
+							os::Printer::log("OBJ face references a vertex position which doesn't exist, skipping the face", fullName, ELL_ERROR);
+							faceCorners.clear();
+							break;
+						}
+
+						SObjVertexKey key;
+						SObjVertex& v = key.vertex;
+						key.smoothingGroup = smoothingGroup;
+						v.pos[0] = vertexBuffer[Idx[0]].data[0];
+						v.pos[1] = vertexBuffer[Idx[0]].data[1];
+						v.pos[2] = vertexBuffer[Idx[0]].data[2];
+						//set texcoord
+						if (Idx[1]>=0ll && Idx[1]<int64_t(uvCount))
+						{
+							v.uv[0] = textureCoordBuffer[Idx[1]].data[0];
+							v.uv[1] = textureCoordBuffer[Idx[1]].data[1];
+						}
+						else
+						{
+							v.uv[0] = core::nan<float>();
+							v.uv[1] = core::nan<float>();
+						}
+						//set normal
+						if (Idx[2]>=0ll && Idx[2]<int64_t(normalCount))
+							v.normal32bit = normalsBuffer[Idx[2]];
+						else
+						{
+							v.normal32bit = core::vectorSIMDu32(0u);
+							recalcNormals.back() = true;
+						}
+
+						const auto found = map_vtx2ix.emplace(key,static_cast<uint32_t>(vertices.size()));
+						if (found.second)
+						{
+							vertices.push_back(v);
+							vtxSmoothGrp.push_back(smoothingGroup);
+						}
+						faceCorners.push_back(found.first->second);
+					}
 
-			// get all vertices data in this face (current line of obj _file)
-			const core::stringc wordBuffer = copyLine(bufPtr, bufEnd);
-			const char* linePtr = wordBuffer.c_str();
-			const char* const endPtr = linePtr+wordBuffer.size();
+					// triangulate the face
+					for (uint32_t i = 1u; i+1u < faceCorners.size(); ++i)
+					{
+						// Add a triangle
+						performActionBasedOnOrientationSystem
+						(
+						[&]()
+						{
+							indices.back().push_back(faceCorners[0]);
+							indices.back().push_back(faceCorners[i]);
+							indices.back().push_back(faceCorners[i + 1]);
+						},
+						[&]()
+						{
+							indices.back().push_back(faceCorners[i + 1]);
+							indices.back().push_back(faceCorners[i]);
+							indices.back().push_back(faceCorners[0]);
+						}
+						);
+					}
+				}
+				break;
+		}
+	};
 
-			core::vector<uint32_t> faceCorners;
-			faceCorners.reserve(32ull);
+	// Process obj information
+	// the file gets streamed in chunks of whole lines instead of being read all at once, big chunks get split into ranges which are tokenized in parallel
+	// mapped files are parsed in place, their chunks are just windows into the mapping
+	constexpr size_t ChunkSize = 0x1ull<<24u;
+	constexpr size_t MinParallelRangeSize = 0x1ull<<18u;
+	const char* const mappedFile = static_cast<const char*>(_file->getMappedPointer());
+	core::vector<char> chunk(mappedFile ? 0ull:core::min<size_t>(ChunkSize,filesize));
+	core::vector<SParsedLines> parsedRanges;
+	core::vector<const char*> rangeBounds;
+	size_t bytesRead = 0ull, bytesCarried = 0ull, mappedChunkSize = ChunkSize;
+	while (true)
+	{
+		const char* buf;
+		size_t chunkSize;
+		bool lastChunk;
+		if (mappedFile)
+		{
+			buf = mappedFile+bytesRead;
+			chunkSize = core::min<size_t>(mappedChunkSize,filesize-bytesRead);
+			lastChunk = bytesRead+chunkSize>=filesize;
+		}
+		else
+		{
+			const size_t bytesToRead = core::min<size_t>(chunk.size()-bytesCarried,filesize-bytesRead);
+			chunkSize = bytesCarried+_file->read(chunk.data()+bytesCarried,static_cast<uint32_t>(bytesToRead));
+			bytesRead += chunkSize-bytesCarried;
+			lastChunk = bytesRead>=filesize || chunkSize==bytesCarried;
+			buf = chunk.data();
+		}
 
-			// read in all vertices
-			linePtr = goNextWord(linePtr, endPtr);
-			while (0 != linePtr[0])
+		// only whole lines get parsed, the remainder gets carried over to the next chunk
+		const char* bufEnd = buf+chunkSize;
+		if (!lastChunk)
+		{
+			while (bufEnd!=buf && bufEnd[-1]!='\n')
+				--bufEnd;
+			// a single line longer than the whole chunk
+			if (bufEnd==buf)
 			{
-				// Array to communicate with retrieveVertexIndices()
-				// sends the buffer sizes and gets the actual indices
-				// if index not set returns -1
-				int32_t Idx[3];
-				Idx[1] = Idx[2] = -1;
-
-				// read in next vertex's data
-				uint32_t wlength = copyWord(tmpbuf, linePtr, WORD_BUFFER_LENGTH, endPtr);
-				// this function will also convert obj's 1-based index to c++'s 0-based index
-				retrieveVertexIndices(tmpbuf, Idx, tmpbuf+wlength+1, vertexBuffer.size(), textureCoordBuffer.size(), normalsBuffer.size());
-				v.pos[0] = vertexBuffer[Idx[0]].data[0];
-				v.pos[1] = vertexBuffer[Idx[0]].data[1];
-				v.pos[2] = vertexBuffer[Idx[0]].data[2];
-				//set texcoord
-				if ( -1 != Idx[1] )
-                {
-					v.uv[0] = textureCoordBuffer[Idx[1]].data[0];
-					v.uv[1] = textureCoordBuffer[Idx[1]].data[1];
-                }
-				else
-                {
-					v.uv[0] = core::nan<float>();
-					v.uv[1] = core::nan<float>();
-                }
-                //set normal
-				if ( -1 != Idx[2] )
-                {
-					core::vectorSIMDf simdNormal;
-					simdNormal.set(normalsBuffer[Idx[2]].data);
-                    simdNormal.makeSafe3D();
-					v.normal32bit = quantNormalCache->quantize<EF_A2B10G10R10_SNORM_PACK32>(simdNormal);
-                }
+				if (mappedFile)
+					mappedChunkSize *= 2ull;
 				else
 				{
-					v.normal32bit = core::vectorSIMDu32(0u);
-                    recalcNormals.back() = true;
+					bytesCarried = chunkSize;
+					chunk.resize(chunk.size()*2ull);
 				}
-
-				uint32_t ix;
-				auto vtx_ix = map_vtx2ix.find(v);
-				if (vtx_ix != map_vtx2ix.end() && smoothingGroup==vtxSmoothGrp[vtx_ix->second])
-					ix = vtx_ix->second;
-				else
-				{
-					ix = vertices.size();
-					vertices.push_back(v);
-                    vtxSmoothGrp.push_back(smoothingGroup);
-					map_vtx2ix.insert({v, ix});
-				}
-
-				faceCorners.push_back(ix);
-
-				// go to next vertex
-				linePtr = goNextWord(linePtr, endPtr);
+				continue;
 			}
+		}
 
-            // triangulate the face
-            for (uint32_t i = 1u; i < faceCorners.size()-1u; ++i)
-            {
-                // Add a triangle
-                performActionBasedOnOrientationSystem
-                (
-                [&]()
-                {
-                    indices.back().push_back(faceCorners[0]);
-                    indices.back().push_back(faceCorners[i]);
-                    indices.back().push_back(faceCorners[i + 1]);
-                },
-                [&]()
-                {
-                    indices.back().push_back(faceCorners[i + 1]);
-                    indices.back().push_back(faceCorners[i]);
-                    indices.back().push_back(faceCorners[0]);
-                }
-                );
-            }
+		const size_t parseSize = bufEnd-buf;
+		uint32_t rangeCount = 1u;
+		if (parseSize>=MinParallelRangeSize*2ull)
+			rangeCount = core::min<size_t>(AssetManager->getThreadPool()->getThreadCount(),parseSize/MinParallelRangeSize);
+		rangeBounds.resize(rangeCount+1u);
+		rangeBounds[0] = buf;
+		for (uint32_t i=1u; i<rangeCount; i++)
+		{
+			const char* bound = std::max<const char*>(buf+parseSize*i/rangeCount,rangeBounds[i-1u]);
+			while (bound!=bufEnd && *(bound++)!='\n') {}
+			rangeBounds[i] = bound;
 		}
-		break;
+		rangeBounds[rangeCount] = bufEnd;
+		if (parsedRanges.size()<rangeCount)
+			parsedRanges.resize(rangeCount);
 
-		case '#': // comment
-		default:
+		if (rangeCount>1u)
+			AssetManager->getThreadPool()->parallelFor(rangeCount,[&](const size_t i) -> void {parseLines(rangeBounds[i],rangeBounds[i+1u],rightHanded,parsedRanges[i]);},1ull);
+		else
+			parseLines(buf,bufEnd,rightHanded,parsedRanges[0]);
+		for (uint32_t i=0u; i<rangeCount; i++)
+			mergeParsedLines(parsedRanges[i]);
+
+		if (lastChunk)
 			break;
-		}	// end switch(bufPtr[0])
-		// eat up rest of line
-		bufPtr = goNextLine(bufPtr, bufEnd);
-	}	// end while(bufPtr && (bufPtr-buf<filesize))
+		if (mappedFile)
+			bytesRead += parseSize;
+		else
+		{
+			bytesCarried = chunkSize-parseSize;
+			memmove(chunk.data(),bufEnd,bytesCarried);
+		}
+	}
 	
     core::unordered_set<pipeline_meta_pair_t,hash_t,key_equal_t> usedPipelines;
     {
@@ -449,10 +476,10 @@ asset::SAssetBundle COBJMeshFileLoader::loadAsset(io::IReadFile* _file, const as
 			submeshes[i]->setPipeline(std::move(pipeline.first));
         }
 
-        core::smart_refctd_ptr<ICPUBuffer> vtxBuf = core::make_smart_refctd_ptr<ICPUBuffer>(vertices.size() * sizeof(SObjVertex));
+        core::smart_refctd_ptr<ICPUBuffer> vtxBuf = interm_createBuffer(_params,vertices.size() * sizeof(SObjVertex));
         memcpy(vtxBuf->getPointer(), vertices.data(), vtxBuf->getSize());
 
-        auto ixBuf = core::make_smart_refctd_ptr<ICPUBuffer>(ixBufOffset);
+        auto ixBuf = interm_createBuffer(_params,ixBufOffset);
         for (size_t i = 0ull; i < submeshes.size(); ++i)
         {
             if (submeshWasLoadedFromCache[i])
@@ -508,18 +535,113 @@ asset::SAssetBundle COBJMeshFileLoader::loadAsset(io::IReadFile* _file, const as
 }
 
 
+//! from_chars style parsing of a float without copying the word out or going through the locale
+/*
+	Decimal numbers with up to 19 significant digits and a small enough exponent are computed exactly in double precision
+	(both the mantissa and the power of ten are exactly representable), which gives the same float as `strtof` unless the
+	double lands exactly halfway between two floats. That case, denormals and anything else unusual (inf, nan, hex) go to `strtof`.
+*/
+static const char* parseFloat(const char* const buf, const char* const bufEnd, float& out)
+{
+	constexpr double PowersOf10[] = {1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,1e11,1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22};
+	constexpr int32_t MaxExactPower = sizeof(PowersOf10)/sizeof(double)-1;
+
+	const char* p = buf;
+	bool negative = false;
+	if (p!=bufEnd && (*p=='-'||*p=='+'))
+		negative = *(p++)=='-';
+
+	uint64_t mantissa = 0ull;
+	int32_t exponent = 0;
+	uint32_t significantDigits = 0u;
+	bool anyDigits = false;
+	auto addDigit = [&](const char c, const int32_t exponentChange) -> void
+	{
+		anyDigits = true;
+		if (significantDigits<19u)
+		{
+			mantissa = mantissa*10ull+uint64_t(c-'0');
+			if (mantissa)
+				significantDigits++;
+			exponent += exponentChange;
+		}
+		else // can't be exact anymore
+			significantDigits = ~0u;
+	};
+	for (; p!=bufEnd && core::isdigit(*p); p++)
+		addDigit(*p,0);
+	if (p!=bufEnd && *p=='.')
+	for (p++; p!=bufEnd && core::isdigit(*p); p++)
+		addDigit(*p,-1);
+	if (p!=bufEnd && (*p=='e'||*p=='E'))
+	{
+		const char* expPtr = p+1;
+		bool negativeExp = false;
+		if (expPtr!=bufEnd && (*expPtr=='-'||*expPtr=='+'))
+			negativeExp = *(expPtr++)=='-';
+		if (expPtr!=bufEnd && core::isdigit(*expPtr))
+		{
+			int32_t exp10 = 0;
+			for (; expPtr!=bufEnd && core::isdigit(*expPtr); expPtr++)
+				exp10 = core::min(exp10*10+(*expPtr-'0'),1000000);
+			exponent += negativeExp ? -exp10:exp10;
+			p = expPtr;
+		}
+		else
+			anyDigits = false;
+	}
+
+	// anything else glued to the number (like a hex prefix) means it wasn't plain decimal
+	const bool wholeWord = p==bufEnd || core::isspace(*p);
+	if (anyDigits && wholeWord && significantDigits<=19u && (mantissa>>53ull)==0ull && exponent>=-MaxExactPower && exponent<=MaxExactPower)
+	{
+		const double value = exponent<0 ? double(mantissa)/PowersOf10[-exponent]:double(mantissa)*PowersOf10[exponent];
+		uint64_t bits;
+		memcpy(&bits,&value,sizeof(bits));
+		// the 29 mantissa bits a float doesn't have being exactly one half would get rounded twice
+		const bool tie = (bits&0x1fffffffull)==0x10000000ull;
+		if (value==0.0 || !tie && value>=double(FLT_MIN) && value<=double(FLT_MAX))
+		{
+			out = negative ? -float(value):float(value);
+			return p;
+		}
+	}
+
+	char word[64];
+	uint32_t length = 0u;
+	for (const char* c=buf; c!=bufEnd && !core::isspace(*c) && length<sizeof(word)-1u; c++)
+		word[length++] = *c;
+	word[length] = 0;
+	char* wordEnd;
+	out = std::strtof(word,&wordEnd);
+	return buf+(wordEnd-word);
+}
+
+//! same as above for a plain decimal integer, leaves `out` untouched if there are no digits
+static const char* parseInt(const char* p, const char* const bufEnd, int32_t& out)
+{
+	bool negative = false;
+	if (p!=bufEnd && (*p=='-'||*p=='+'))
+		negative = *(p++)=='-';
+	if (p==bufEnd || !core::isdigit(*p))
+		return p;
+
+	int64_t value = 0;
+	for (; p!=bufEnd && core::isdigit(*p); p++)
+		value = core::min<int64_t>(value*10+(*p-'0'),INT32_MAX);
+	out = static_cast<int32_t>(negative ? -value:value);
+	return p;
+}
+
+
 //! Read 3d vector of floats
 const char* COBJMeshFileLoader::readVec3(const char* bufPtr, float vec[3], const char* const bufEnd)
 {
-	const uint32_t WORD_BUFFER_LENGTH = 256;
-	char wordBuffer[WORD_BUFFER_LENGTH];
-
-	bufPtr = goAndCopyNextWord(wordBuffer, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-	sscanf(wordBuffer,"%f",vec);
-	bufPtr = goAndCopyNextWord(wordBuffer, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-	sscanf(wordBuffer,"%f",vec+1);
-	bufPtr = goAndCopyNextWord(wordBuffer, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-	sscanf(wordBuffer,"%f",vec+2);
+	for (auto i=0; i<3; i++)
+	{
+		bufPtr = goNextWord(bufPtr, bufEnd, false);
+		parseFloat(bufPtr, bufEnd, vec[i]);
+	}
 
     vec[0] = -vec[0]; // change handedness
 	return bufPtr;
@@ -529,13 +651,11 @@ const char* COBJMeshFileLoader::readVec3(const char* bufPtr, float vec[3], const
 //! Read 2d vector of floats
 const char* COBJMeshFileLoader::readUV(const char* bufPtr, float vec[2], const char* const bufEnd)
 {
-	const uint32_t WORD_BUFFER_LENGTH = 256;
-	char wordBuffer[WORD_BUFFER_LENGTH];
-
-	bufPtr = goAndCopyNextWord(wordBuffer, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-	sscanf(wordBuffer,"%f",vec);
-	bufPtr = goAndCopyNextWord(wordBuffer, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-	sscanf(wordBuffer,"%f",vec+1);
+	for (auto i=0; i<2; i++)
+	{
+		bufPtr = goNextWord(bufPtr, bufEnd, false);
+		parseFloat(bufPtr, bufEnd, vec[i]);
+	}
 
 	vec[1] = 1.f-vec[1]; // change handedness
 	return bufPtr;
@@ -621,97 +741,133 @@ uint32_t COBJMeshFileLoader::copyWord(char* outBuf, const char* const inBuf, uin
 }
 
 
-core::stringc COBJMeshFileLoader::copyLine(const char* inBuf, const char* bufEnd)
+const char* COBJMeshFileLoader::goAndCopyNextWord(char* outBuf, const char* inBuf, uint32_t outBufLength, const char* bufEnd)
 {
-	if (!inBuf)
-		return core::stringc();
+	inBuf = goNextWord(inBuf, bufEnd, false);
+	copyWord(outBuf, inBuf, outBufLength, bufEnd);
+	return inBuf;
+}
+
 
-	const char* ptr = inBuf;
-	while (ptr<bufEnd)
+const char* COBJMeshFileLoader::readFaceCorner(const char* bufPtr, int32_t idx[3], const char* const bufEnd)
+{
+	idx[0] = idx[1] = idx[2] = 0;
+	// `v`, `v/vt`, `v//vn` or `v/vt/vn`
+	for (uint32_t i=0u; i<3u; i++)
 	{
-		if (*ptr=='\n' || *ptr=='\r')
+		bufPtr = parseInt(bufPtr, bufEnd, idx[i]);
+		if (bufPtr==bufEnd || *bufPtr!='/')
 			break;
-		++ptr;
+		++bufPtr;
 	}
-	// we must avoid the +1 in case the array is used up
-	return core::stringc(inBuf, (uint32_t)(ptr-inBuf+((ptr < bufEnd) ? 1 : 0)));
+	return bufPtr;
 }
 
 
-const char* COBJMeshFileLoader::goAndCopyNextWord(char* outBuf, const char* inBuf, uint32_t outBufLength, const char* bufEnd)
+void COBJMeshFileLoader::parseLines(const char* buf, const char* const bufEnd, bool rightHanded, SParsedLines& out)
 {
-	inBuf = goNextWord(inBuf, bufEnd, false);
-	copyWord(outBuf, inBuf, outBufLength, bufEnd);
-	return inBuf;
-}
-
+	out.positions.clear();
+	out.normals.clear();
+	out.uvs.clear();
+	out.faceCorners.clear();
+	out.statements.clear();
 
-bool COBJMeshFileLoader::retrieveVertexIndices(char* vertexData, int32_t* idx, const char* bufEnd, uint32_t vbsize, uint32_t vtsize, uint32_t vnsize)
-{
-	char word[16] = "";
-	const char* p = goFirstWord(vertexData, bufEnd);
-	uint32_t idxType = 0;	// 0 = posIdx, 1 = texcoordIdx, 2 = normalIdx
+	auto addStatement = [&out](const SParsedLines::E_STATEMENT type) -> SParsedLines::SStatement&
+	{
+		SParsedLines::SStatement statement = {};
+		statement.type = type;
+		statement.positionCount = out.positions.size();
+		statement.uvCount = out.uvs.size();
+		statement.normalCount = out.normals.size();
+		out.statements.push_back(statement);
+		return out.statements.back();
+	};
+	auto addArgumentStatement = [&](const SParsedLines::E_STATEMENT type, const char* bufPtr) -> void
+	{
+		const char* argument = goNextWord(bufPtr, bufEnd, false);
+		const char* argumentEnd = argument;
+		while (argumentEnd!=bufEnd && !core::isspace(*argumentEnd))
+			++argumentEnd;
+
+		auto& statement = addStatement(type);
+		statement.argument = argument;
+		statement.argumentLength = argumentEnd-argument;
+	};
 
-	uint32_t i = 0;
-	while ( p != bufEnd )
+	const char* bufPtr = goFirstWord(buf, bufEnd);
+	while (bufPtr != bufEnd)
 	{
-		if ( ( core::isdigit(*p)) || (*p == '-') )
+		switch (bufPtr[0])
 		{
-			// build up the number
-			word[i++] = *p;
-		}
-		else if ( *p == '/' || *p == ' ' || *p == '\0' )
-		{
-			// number is completed. Convert and store it
-			word[i] = '\0';
-			// if no number was found index will become 0 and later on -1 by decrement
-			sscanf(word,"%d",idx+idxType);
-			if (idx[idxType]<0)
-			{
-				switch (idxType)
+			case 'm':	// mtllib (material)
+				addArgumentStatement(SParsedLines::ES_MTLLIB, bufPtr);
+				break;
+			case 'v':	// v, vn, vt
+				if (out.statements.empty() || out.statements.back().type!=SParsedLines::ES_VERTEX_DATA)
+					addStatement(SParsedLines::ES_VERTEX_DATA);
+				switch (bufPtr[1])
 				{
-					case 0:
-						idx[idxType] += vbsize;
+					case ' ':	// vertex
+						{
+							vec3 vec;
+							readVec3(bufPtr, vec.data, bufEnd);
+							if (rightHanded)
+								vec.data[0] = -vec.data[0];
+							out.positions.push_back(vec);
+						}
 						break;
-					case 1:
-						idx[idxType] += vtsize;
+					case 'n':	// normal
+						{
+							vec3 vec;
+							readVec3(bufPtr, vec.data, bufEnd);
+							if (rightHanded)
+								vec.data[0] = -vec.data[0];
+							out.normals.push_back(vec);
+						}
 						break;
-					case 2:
-						idx[idxType] += vnsize;
+					case 't':	// texcoord
+						{
+							vec2 vec;
+							readUV(bufPtr, vec.data, bufEnd);
+							out.uvs.push_back(vec);
+						}
 						break;
 				}
-			}
-			else
-				idx[idxType]-=1;
-
-			// reset the word
-			word[0] = '\0';
-			i = 0;
-
-			// go to the next kind of index type
-			if (*p == '/')
-			{
-				if ( ++idxType > 2 )
+				break;
+			case 'g':	// group name
+				addArgumentStatement(SParsedLines::ES_GROUP, bufPtr);
+				break;
+			case 's':	// smoothing group
+				addArgumentStatement(SParsedLines::ES_SMOOTHING, bufPtr);
+				break;
+			case 'u':	// usemtl
+				addArgumentStatement(SParsedLines::ES_USEMTL, bufPtr);
+				break;
+			case 'f':	// face
 				{
-					// error checking, shouldn't reach here unless file is wrong
-					idxType = 0;
+					const uint32_t firstCorner = out.faceCorners.size()/3u;
+					// read in all vertices of the face
+					const char* linePtr = goNextWord(bufPtr, bufEnd, false);
+					while (linePtr!=bufEnd && *linePtr!='\n' && *linePtr!='\r')
+					{
+						int32_t idx[3];
+						readFaceCorner(linePtr, idx, bufEnd);
+						out.faceCorners.insert(out.faceCorners.end(),idx,idx+3);
+						linePtr = goNextWord(linePtr, bufEnd, false);
+					}
+
+					auto& statement = addStatement(SParsedLines::ES_FACE);
+					statement.firstCorner = firstCorner;
+					statement.cornerCount = out.faceCorners.size()/3u-firstCorner;
 				}
-			}
-			else
-			{
-				// set all missing values to disable (=-1)
-				while (++idxType < 3)
-					idx[idxType]=-1;
-				++p;
-				break; // while
-			}
+				break;
+			case '#':	// comment
+			default:
+				break;
 		}
-
-		// go to the next char
-		++p;
+		// eat up rest of line
+		bufPtr = goNextLine(bufPtr, bufEnd);
 	}
-
-	return true;
 }
 
 std::string COBJMeshFileLoader::genKeyForMeshBuf(const SContext& _ctx, const std::string& _baseKey, const std::string& _mtlName, const std::string& _grpName) const
@@ -59,6 +59,59 @@ public:
 } PACK_STRUCT;
 #include "nbl/nblunpack.h"
 
+//! Key for the hashed deduplication of face corners, vertices only get merged within the same smoothing group
+struct SObjVertexKey
+{
+    SObjVertex vertex;
+    uint32_t smoothingGroup;
+
+    // `==` on the floats so that signed zeroes compare equal, but the UVs of corners without texcoords are NaN
+    inline bool operator==(const SObjVertexKey& other) const
+    {
+        auto floatEqual = [](const float a, const float b) -> bool {return a==b || core::isnan(a)&&core::isnan(b);};
+        for (auto i=0; i<3; i++)
+        if (!floatEqual(vertex.pos[i],other.vertex.pos[i]))
+            return false;
+        for (auto i=0; i<2; i++)
+        if (!floatEqual(vertex.uv[i],other.vertex.uv[i]))
+            return false;
+        return vertex.normal32bit==other.vertex.normal32bit && smoothingGroup==other.smoothingGroup;
+    }
+
+    struct hash
+    {
+        inline size_t operator()(const SObjVertexKey& key) const
+        {
+            // all zeroes and all NaNs need to hash the same, as they compare equal
+            auto floatBits = [](const float f) -> uint32_t
+            {
+                if (f==0.f)
+                    return 0u;
+                if (core::isnan(f))
+                    return 0x7fc00000u;
+                uint32_t bits;
+                memcpy(&bits,&f,sizeof(bits));
+                return bits;
+            };
+            uint64_t retval = 0xcbf29ce484222325ull;
+            auto combine = [&retval](const uint32_t value) -> void
+            {
+                retval = (retval^value)*0x100000001b3ull;
+                retval ^= retval>>29u;
+            };
+            for (auto i=0; i<3; i++)
+                combine(floatBits(key.vertex.pos[i]));
+            for (auto i=0; i<2; i++)
+                combine(floatBits(key.vertex.uv[i]));
+            uint32_t normal;
+            memcpy(&normal,&key.vertex.normal32bit,sizeof(normal));
+            combine(normal);
+            combine(key.smoothingGroup);
+            return static_cast<size_t>(retval);
+        }
+    };
+};
+
 //! Meshloader capable of loading obj meshes.
 class COBJMeshFileLoader : public asset::IAssetLoader
 {
@@ -75,6 +128,44 @@ class COBJMeshFileLoader : public asset::IAssetLoader
         const bool useMaterials = true;
     };
 
+    struct vec3 {
+        float data[3];
+    };
+    struct vec2 {
+        float data[2];
+    };
+
+    //! Result of tokenizing a range of whole lines, ranges of a file can be parsed independently of each other
+    struct SParsedLines
+    {
+        enum E_STATEMENT : uint8_t
+        {
+            ES_VERTEX_DATA, // a run of `v`, `vn` and `vt` lines, only recorded because they end the implicit no-material submesh
+            ES_FACE,
+            ES_MTLLIB,
+            ES_USEMTL,
+            ES_GROUP,
+            ES_SMOOTHING
+        };
+        struct SStatement
+        {
+            E_STATEMENT type;
+            // number of positions, uvs and normals in this range before the statement, needed to resolve relative indices
+            uint32_t positionCount, uvCount, normalCount;
+            // for faces the range of `faceCorners`, for the rest the argument as a pointer into the parsed lines
+            uint32_t firstCorner, cornerCount;
+            const char* argument;
+            uint32_t argumentLength;
+        };
+
+        core::vector<vec3> positions;
+        core::vector<vec3> normals;
+        core::vector<vec2> uvs;
+        // 3 indices per corner exactly as in the file (1-based, negative for relative, 0 if not present)
+        core::vector<int32_t> faceCorners;
+        core::vector<SStatement> statements;
+    };
+
 protected:
 	//! destructor
 	virtual ~COBJMeshFileLoader();
@@ -113,9 +204,6 @@ private:
 	const char* goNextLine(const char* buf, const char* const bufEnd);
 	// copies the current word from the inBuf to the outBuf
 	uint32_t copyWord(char* outBuf, const char* inBuf, uint32_t outBufLength, const char* const pBufEnd);
-	// copies the current line from the inBuf to the outBuf
-	core::stringc copyLine(const char* inBuf, const char* const bufEnd);
-
 	// combination of goNextWord followed by copyWord
 	const char* goAndCopyNextWord(char* outBuf, const char* inBuf, uint32_t outBufLength, const char* const pBufEnd);
 
@@ -125,11 +213,11 @@ private:
 	const char* readUV(const char* bufPtr, float vec[2], const char* const pBufEnd);
 	//! Read boolean value represented as 'on' or 'off'
 	const char* readBool(const char* bufPtr, bool& tf, const char* const bufEnd);
+	//! Read the `v/vt/vn` indices of a face corner as they're written in the file, 0 for indices which are not present
+	const char* readFaceCorner(const char* bufPtr, int32_t idx[3], const char* const bufEnd);
 
-	// reads and convert to integer the vertex indices in a line of obj file's face statement
-	// -1 for the index if it doesn't exist
-	// indices are changed to 0-based index instead of 1-based from the obj file
-	bool retrieveVertexIndices(char* vertexData, int32_t* idx, const char* bufEnd, uint32_t vbsize, uint32_t vtsize, uint32_t vnsize);
+	//! Tokenizes the whole lines in `[buf,bufEnd)`, doesn't touch any loader state so many ranges can be parsed at once
+	void parseLines(const char* buf, const char* const bufEnd, bool rightHanded, SParsedLines& out);
 
     std::string genKeyForMeshBuf(const SContext& _ctx, const std::string& _baseKey, const std::string& _mtlName, const std::string& _grpName) const;
 
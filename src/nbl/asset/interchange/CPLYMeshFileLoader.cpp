@@ -375,7 +375,7 @@ asset::SAssetBundle CPLYMeshFileLoader::loadAsset(io::IReadFile* _file, const as
 							if (!attributes[ET_POS].buffer)
 							{
 								attributes[ET_POS].offset = 0u;
-								attributes[ET_POS].buffer = core::make_smart_refctd_ptr<asset::ICPUBuffer>(asset::getTexelOrBlockBytesize(EF_R32G32B32_SFLOAT) * plyVertexElement.Count);
+								attributes[ET_POS].buffer = interm_createBuffer(_params,asset::getTexelOrBlockBytesize(EF_R32G32B32_SFLOAT) * plyVertexElement.Count);
 							}
 						}
 						else if(propertyName == "nx" || propertyName == "ny" || propertyName == "nz")
@@ -383,7 +383,7 @@ asset::SAssetBundle CPLYMeshFileLoader::loadAsset(io::IReadFile* _file, const as
 							if (!attributes[ET_NORM].buffer)
 							{
 								attributes[ET_NORM].offset = 0u;
-								attributes[ET_NORM].buffer = core::make_smart_refctd_ptr<asset::ICPUBuffer>(asset::getTexelOrBlockBytesize(EF_R32G32B32_SFLOAT) * plyVertexElement.Count);
+								attributes[ET_NORM].buffer = interm_createBuffer(_params,asset::getTexelOrBlockBytesize(EF_R32G32B32_SFLOAT) * plyVertexElement.Count);
 							}
 						}
 						else if (propertyName == "u" || propertyName == "s" || propertyName == "v" || propertyName == "t")
@@ -391,7 +391,7 @@ asset::SAssetBundle CPLYMeshFileLoader::loadAsset(io::IReadFile* _file, const as
 							if (!attributes[ET_UV].buffer)
 							{
 								attributes[ET_UV].offset = 0u;
-								attributes[ET_UV].buffer = core::make_smart_refctd_ptr<asset::ICPUBuffer>(asset::getTexelOrBlockBytesize(EF_R32G32_SFLOAT) * plyVertexElement.Count);
+								attributes[ET_UV].buffer = interm_createBuffer(_params,asset::getTexelOrBlockBytesize(EF_R32G32_SFLOAT) * plyVertexElement.Count);
 							}
 						}
 						else if (propertyName == "red" || propertyName == "green" || propertyName == "blue" || propertyName == "alpha")
@@ -399,7 +399,7 @@ asset::SAssetBundle CPLYMeshFileLoader::loadAsset(io::IReadFile* _file, const as
 							if (!attributes[ET_COL].buffer)
 							{
 								attributes[ET_COL].offset = 0u;
-								attributes[ET_COL].buffer = core::make_smart_refctd_ptr<asset::ICPUBuffer>(asset::getTexelOrBlockBytesize(EF_R32G32B32A32_SFLOAT) * plyVertexElement.Count);
+								attributes[ET_COL].buffer = interm_createBuffer(_params,asset::getTexelOrBlockBytesize(EF_R32G32B32A32_SFLOAT) * plyVertexElement.Count);
 							}
 						}			
 					}
@@ -428,7 +428,7 @@ asset::SAssetBundle CPLYMeshFileLoader::loadAsset(io::IReadFile* _file, const as
 
             if (indices.size())
             {
-				asset::SBufferBinding<ICPUBuffer> indexBinding = { 0, core::make_smart_refctd_ptr<asset::ICPUBuffer>(indices.size() * sizeof(uint32_t)) };
+				asset::SBufferBinding<ICPUBuffer> indexBinding = { 0, interm_createBuffer(_params,indices.size() * sizeof(uint32_t)) };
 				memcpy(indexBinding.buffer->getPointer(), indices.data(), indexBinding.buffer->getSize());
 				
 				mb->setIndexCount(indices.size());
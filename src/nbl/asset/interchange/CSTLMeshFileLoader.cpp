@@ -138,6 +138,31 @@ SAssetBundle CSTLMeshFileLoader::loadAsset(IReadFile* _file, const IAssetLoader:
 	if (filesize < 6ull) // we need a header
 		return {};
 
+	// parse from memory, in place if the file is mapped and from a single bulk read otherwise
+	core::vector<char> fileContents;
+	size_t contentsSize = filesize;
+	const char* const fileBegin = [&]() -> const char*
+	{
+		if (const void* mapped = _file->getMappedPointer())
+			return static_cast<const char*>(mapped);
+
+		fileContents.resize(filesize);
+		_file->seek(0u);
+		for (size_t bytesRead = 0ull; bytesRead < filesize;)
+		{
+			const int32_t read = _file->read(fileContents.data() + bytesRead, static_cast<uint32_t>(core::min<size_t>(filesize - bytesRead, 0x1ull << 30ull)));
+			if (read <= 0)
+			{
+				contentsSize = bytesRead;
+				break;
+			}
+			bytesRead += read;
+		}
+		return fileContents.data();
+	}();
+	const char* const fileEnd = fileBegin + contentsSize;
+	const char* cursor = fileBegin;
+
 	bool hasColor = false;
 
 	auto mesh = core::make_smart_refctd_ptr<ICPUMesh>();
@@ -146,49 +171,54 @@ SAssetBundle CSTLMeshFileLoader::loadAsset(IReadFile* _file, const IAssetLoader:
 	meshbuffer->setNormalAttributeIx(NORMAL_ATTRIBUTE);
 
 	bool binary = false;
-	core::stringc token;
-	if (getNextToken(_file, token) != "solid")
+	if (getNextToken(cursor, fileEnd) != "solid")
 		binary = hasColor = true;
 
 	core::vector<core::vectorSIMDf> positions, normals;
 	core::vector<uint32_t> colors;
+	constexpr size_t STL_TRI_SZ = 50u;
 	if (binary)
 	{
-		if (_file->getSize() < 80)
+		if (fileEnd - fileBegin < 84)
 			return {};
 
-		_file->seek(80); // skip header
-		uint32_t vtxCnt = 0u;
-		_file->read(&vtxCnt, 4);
-		positions.reserve(3 * vtxCnt);
-		normals.reserve(vtxCnt);
-		colors.reserve(vtxCnt);
+		cursor = fileBegin + 80; // skip header
+		uint32_t triCnt = 0u;
+		memcpy(&triCnt, cursor, 4);
+		cursor += 4;
+		// don't trust the header with the reservation
+		triCnt = static_cast<uint32_t>(core::min<size_t>(triCnt, (fileEnd - cursor) / STL_TRI_SZ));
+		positions.reserve(3 * triCnt);
+		normals.reserve(triCnt);
+		colors.reserve(triCnt);
 	}
 	else
-		goNextLine(_file); // skip header
+		goNextLine(cursor, fileEnd); // skip header
 
 
 	uint16_t attrib = 0u;
-	token.reserve(32);
-	while (_file->getPos() < filesize)
+	while (cursor < fileEnd)
 	{
 		if (!binary)
 		{
-			if (getNextToken(_file, token) != "facet")
+			const std::string_view token = getNextToken(cursor, fileEnd);
+			if (token != "facet")
 			{
 				if (token == "endsolid")
 					break;
 				return {};
 			}
-			if (getNextToken(_file, token) != "normal")
+			if (getNextToken(cursor, fileEnd) != "normal")
 			{
 				return {};
 			}
 		}
+		else if (static_cast<size_t>(fileEnd - cursor) < STL_TRI_SZ)
+			break;
 
 		{
 			core::vectorSIMDf n;
-			getNextVector(_file, n, binary);
+			getNextVector(cursor, fileEnd, n, binary);
 			if(_params.loaderFlags & E_LOADER_PARAMETER_FLAGS::ELPF_RIGHT_HANDED_MESHES)
 				performActionBasedOnOrientationSystem<float>(n.x, [](float& varToFlip) {varToFlip = -varToFlip;});
 			normals.push_back(core::normalize(n));
@@ -196,7 +226,7 @@ SAssetBundle CSTLMeshFileLoader::loadAsset(IReadFile* _file, const IAssetLoader:
 
 		if (!binary)
 		{
-			if (getNextToken(_file, token) != "outer" || getNextToken(_file, token) != "loop")
+			if (getNextToken(cursor, fileEnd) != "outer" || getNextToken(cursor, fileEnd) != "loop")
 				return {};
 		}
 
@@ -206,10 +236,10 @@ SAssetBundle CSTLMeshFileLoader::loadAsset(IReadFile* _file, const IAssetLoader:
 			{
 				if (!binary)
 				{
-					if (getNextToken(_file, token) != "vertex")
+					if (getNextToken(cursor, fileEnd) != "vertex")
 						return {};
 				}
-				getNextVector(_file, p[i], binary);
+				getNextVector(cursor, fileEnd, p[i], binary);
 				if (_params.loaderFlags & E_LOADER_PARAMETER_FLAGS::ELPF_RIGHT_HANDED_MESHES)
 					performActionBasedOnOrientationSystem<float>(p[i].x, [](float& varToFlip){varToFlip = -varToFlip; });
 			}
@@ -219,12 +249,13 @@ SAssetBundle CSTLMeshFileLoader::loadAsset(IReadFile* _file, const IAssetLoader:
 
 		if (!binary)
 		{
-			if (getNextToken(_file, token) != "endloop" || getNextToken(_file, token) != "endfacet")
+			if (getNextToken(cursor, fileEnd) != "endloop" || getNextToken(cursor, fileEnd) != "endfacet")
 				return {};
 		}
 		else
 		{
-			_file->read(&attrib, 2);
+			memcpy(&attrib, cursor, 2);
+			cursor += 2;
 		}
 
 		if (hasColor && (attrib & 0x8000u)) // assuming VisCam/SolidView non-standard trick to store color in 2 bytes of extra attribute
@@ -249,7 +280,7 @@ SAssetBundle CSTLMeshFileLoader::loadAsset(IReadFile* _file, const IAssetLoader:
 					*(positions.rbegin() + 0)).getNormal()
 			);
 		}
-	} // end while (_file->getPos() < filesize)
+	} // end while (cursor < fileEnd)
 
 	const size_t vtxSize = hasColor ? (3 * sizeof(float) + 4 + 4) : (3 * sizeof(float) + 4);
 	auto vertexBuf = core::make_smart_refctd_ptr<asset::ICPUBuffer>(vtxSize * positions.size());
@@ -324,72 +355,62 @@ bool CSTLMeshFileLoader::isALoadableFileFormat(io::IReadFile* _file) const
 }
 
 //! Read 3d vector of floats
-void CSTLMeshFileLoader::getNextVector(io::IReadFile* file, core::vectorSIMDf& vec, bool binary) const
+void CSTLMeshFileLoader::getNextVector(const char*& cursor, const char* const end, core::vectorSIMDf& vec, bool binary)
 {
 	if (binary)
 	{
-		file->read(&vec.X, 4);
-		file->read(&vec.Y, 4);
-		file->read(&vec.Z, 4);
+		// the caller made sure a whole triangle is left
+		memcpy(&vec.X, cursor, 12);
+		cursor += 12;
 	}
 	else
 	{
-		goNextWord(file);
-		core::stringc tmp;
-
-		getNextToken(file, tmp);
-		sscanf(tmp.c_str(), "%f", &vec.X);
-		getNextToken(file, tmp);
-		sscanf(tmp.c_str(), "%f", &vec.Y);
-		getNextToken(file, tmp);
-		sscanf(tmp.c_str(), "%f", &vec.Z);
+		goNextWord(cursor, end);
+		float* const components[3] = { &vec.X, &vec.Y, &vec.Z };
+		for (auto component : components)
+		{
+			// the file isn't null terminated
+			char tmp[64];
+			const std::string_view token = getNextToken(cursor, end);
+			const size_t length = core::min<size_t>(token.size(), sizeof(tmp) - 1u);
+			memcpy(tmp, token.data(), length);
+			tmp[length] = 0;
+			sscanf(tmp, "%f", component);
+		}
 	}
 	vec.X = -vec.X;
 }
 
 
 //! Read next word
-const core::stringc& CSTLMeshFileLoader::getNextToken(io::IReadFile* file, core::stringc& token) const
+std::string_view CSTLMeshFileLoader::getNextToken(const char*& cursor, const char* const end)
 {
-	goNextWord(file);
-	uint8_t c;
-	token = "";
-	while (file->getPos() != file->getSize())
-	{
-		file->read(&c, 1);
-		// found it, so leave
-		if (core::isspace(c))
-			break;
-		token.append(c);
-	}
+	goNextWord(cursor, end);
+	const char* const tokenBegin = cursor;
+	while (cursor != end && !core::isspace(*cursor))
+		cursor++;
+	const std::string_view token(tokenBegin, cursor - tokenBegin);
+	// consume the space which ended the token
+	if (cursor != end)
+		cursor++;
 	return token;
 }
 
 //! skip to next word
-void CSTLMeshFileLoader::goNextWord(io::IReadFile* file) const
+void CSTLMeshFileLoader::goNextWord(const char*& cursor, const char* const end)
 {
-	uint8_t c;
-	while (file->getPos() != file->getSize())
-	{
-		file->read(&c, 1);
-		// found it, so leave
-		if (!core::isspace(c))
-		{
-			file->seek(-1, true);
-			break;
-		}
-	}
+	while (cursor != end && core::isspace(*cursor))
+		cursor++;
 }
 
 
 //! Read until line break is reached and stop at the next non-space character
-void CSTLMeshFileLoader::goNextLine(io::IReadFile* file) const
+void CSTLMeshFileLoader::goNextLine(const char*& cursor, const char* const end)
 {
-	uint8_t c;
 	// look for newline characters
-	while (file->getPos() != file->getSize())
+	while (cursor != end)
 	{
-		file->read(&c, 1);
+		const char c = *(cursor++);
 		// found it, so leave
 		if (c == '\n' || c == '\r')
 			break;
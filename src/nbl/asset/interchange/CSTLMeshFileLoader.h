@@ -39,14 +39,16 @@ class CSTLMeshFileLoader final : public IAssetLoader, public IRenderpassIndepend
 
 		const std::string_view getPipelineCacheKey(bool withColorAttribute) { return withColorAttribute ? "nbl/builtin/pipeline/loader/STL/color_attribute" : "nbl/builtin/pipeline/loader/STL/no_color_attribute"; }
 
+		// the file gets parsed from memory, `cursor` is the current position and `end` is one past the last byte of the file
+
 		// skips to the first non-space character available
-		void goNextWord(io::IReadFile* file) const;
-		// returns the next word
-		const core::stringc& getNextToken(io::IReadFile* file, core::stringc& token) const;
+		static void goNextWord(const char*& cursor, const char* const end);
+		// returns the next word, it points into the file contents
+		static std::string_view getNextToken(const char*& cursor, const char* const end);
 		// skip to next printable character after the first line break
-		void goNextLine(io::IReadFile* file) const;
+		static void goNextLine(const char*& cursor, const char* const end);
 		//! Read 3d vector of floats
-		void getNextVector(io::IReadFile* file, core::vectorSIMDf& vec, bool binary) const;
+		static void getNextVector(const char*& cursor, const char* const end, core::vectorSIMDf& vec, bool binary);
 
 		template<typename aType>
 		static inline void performActionBasedOnOrientationSystem(aType& varToHandle, void (*performOnCertainOrientation)(aType& varToHandle))
@@ -82,6 +82,162 @@ namespace material_compiler
 		core::unordered_map<const IR::INode*, id_t> m_cache;
 	};
 
+	//! Hash-consing of IR subtrees, two subtrees get the same ID iff they have the same nodes, parameters, textures and children in the same order
+	class CStructuralHasher
+	{
+	public:
+		using id_t = uint32_t;
+
+		id_t get_id(const IR::INode* _node)
+		{
+			if (auto found = m_cache.find(_node); found != m_cache.end())
+				return found->second;
+
+			// children get their IDs first, so the key only needs to hold the IDs and not whole subtrees
+			key_t key;
+			key.push_back(_node->symbol);
+			key.push_back(_node->children.count);
+			for (const IR::INode* child : _node->children)
+				key.push_back(get_id(child));
+			if (!appendLocalData(key, _node))
+				key.push_back(reinterpret_cast<uintptr_t>(_node));
+
+			const id_t id = m_ids.insert({ std::move(key),static_cast<id_t>(m_ids.size()) }).first->second;
+			m_cache.insert({ _node, id });
+
+			return id;
+		}
+
+	private:
+		using key_t = core::vector<uint64_t>;
+		struct key_hash
+		{
+			std::size_t operator()(const key_t& _key) const
+			{
+				std::size_t h = _key.size();
+				for (uint64_t w : _key)
+					h ^= std::hash<uint64_t>{}(w) + 0x9e3779b97f4a7c15ull + (h<<6) + (h>>2);
+				return h;
+			}
+		};
+
+		static void appendFloat(key_t& _key, float _f)
+		{
+			_key.push_back(core::floatBitsToUint(_f));
+		}
+		static void appendColor(key_t& _key, const IR::INode::color_t& _c)
+		{
+			for (uint32_t i = 0u; i < 3u; ++i)
+				appendFloat(_key, _c.pointer[i]);
+		}
+		static void appendTexture(key_t& _key, const IR::INode::STextureSource& _tex)
+		{
+			_key.push_back(reinterpret_cast<uintptr_t>(_tex.image.get()));
+			_key.push_back(reinterpret_cast<uintptr_t>(_tex.sampler.get()));
+			appendFloat(_key, _tex.scale);
+		}
+		static void appendParam(key_t& _key, const IR::INode::SParameter<float>& _p)
+		{
+			_key.push_back(_p.source);
+			if (_p.source == IR::INode::EPS_TEXTURE)
+				appendTexture(_key, _p.value.texture);
+			else
+				appendFloat(_key, _p.value.constant);
+		}
+		static void appendParam(key_t& _key, const IR::INode::SParameter<IR::INode::color_t>& _p)
+		{
+			_key.push_back(_p.source);
+			if (_p.source == IR::INode::EPS_TEXTURE)
+				appendTexture(_key, _p.value.texture);
+			else
+				appendColor(_key, _p.value.constant);
+		}
+
+		//! @returns false for nodes it does not know, those never compare equal to another node
+		static bool appendLocalData(key_t& _key, const IR::INode* _node)
+		{
+			switch (_node->symbol)
+			{
+			case IR::INode::ES_GEOM_MODIFIER:
+			{
+				auto* node = static_cast<const IR::CGeomModifierNode*>(_node);
+				_key.push_back(node->type);
+				appendTexture(_key, node->texture);
+			}
+			return true;
+			case IR::INode::ES_EMISSION:
+				appendColor(_key, static_cast<const IR::CEmissionNode*>(_node)->intensity);
+				return true;
+			case IR::INode::ES_OPACITY:
+				appendParam(_key, static_cast<const IR::COpacityNode*>(_node)->opacity);
+				return true;
+			case IR::INode::ES_BSDF_COMBINER:
+			{
+				auto* node = static_cast<const IR::CBSDFCombinerNode*>(_node);
+				_key.push_back(node->type);
+				switch (node->type)
+				{
+				case IR::CBSDFCombinerNode::ET_WEIGHT_BLEND:
+					appendParam(_key, static_cast<const IR::CBSDFBlendNode*>(node)->weight);
+					return true;
+				case IR::CBSDFCombinerNode::ET_MIX:
+					for (uint32_t i = 0u; i < node->children.count; ++i)
+						appendFloat(_key, static_cast<const IR::CBSDFMixNode*>(node)->weights[i]);
+					return true;
+				default:
+					return false;
+				}
+			}
+			case IR::INode::ES_BSDF:
+			{
+				auto* node = static_cast<const IR::CBSDFNode*>(_node);
+				_key.push_back(node->type);
+				appendColor(_key, node->eta);
+				appendColor(_key, node->etaK);
+				switch (node->type)
+				{
+				case IR::CBSDFNode::ET_MICROFACET_SPECULAR: [[fallthrough]];
+				case IR::CBSDFNode::ET_MICROFACET_COATING: [[fallthrough]];
+				case IR::CBSDFNode::ET_MICROFACET_DIELECTRIC:
+				{
+					auto* specular = static_cast<const IR::CMicrofacetSpecularBSDFNode*>(node);
+					_key.push_back(specular->ndf);
+					_key.push_back(specular->shadowing);
+					appendParam(_key, specular->alpha_u);
+					appendParam(_key, specular->alpha_v);
+					if (node->type == IR::CBSDFNode::ET_MICROFACET_COATING)
+						appendParam(_key, static_cast<const IR::CMicrofacetCoatingBSDFNode*>(node)->thicknessSigmaA);
+					else if (node->type == IR::CBSDFNode::ET_MICROFACET_DIELECTRIC)
+						_key.push_back(static_cast<const IR::CMicrofacetDielectricBSDFNode*>(node)->thin);
+				}
+				return true;
+				case IR::CBSDFNode::ET_MICROFACET_DIFFUSE: [[fallthrough]];
+				case IR::CBSDFNode::ET_MICROFACET_DIFFTRANS:
+				{
+					auto* diffuse = static_cast<const IR::CMicrofacetDiffuseBxDFBase*>(node);
+					appendParam(_key, diffuse->alpha_u);
+					appendParam(_key, diffuse->alpha_v);
+					if (node->type == IR::CBSDFNode::ET_MICROFACET_DIFFUSE)
+						appendParam(_key, static_cast<const IR::CMicrofacetDiffuseBSDFNode*>(node)->reflectance);
+					else
+						appendParam(_key, static_cast<const IR::CMicrofacetDifftransBSDFNode*>(node)->transmittance);
+				}
+				return true;
+				case IR::CBSDFNode::ET_DELTA_TRANSMISSION:
+					return true;
+				default:
+					return false;
+				}
+			}
+			default:
+				return false;
+			}
+		}
+
+		core::unordered_map<key_t, id_t, key_hash> m_ids;
+		core::unordered_map<const IR::INode*, id_t> m_cache;
+	};
+
 	template <typename stack_el_t>
 	class ITraversalGenerator
 	{
@@ -1153,8 +1309,20 @@ auto CMaterialCompilerGLSLBackendCommon::compile(SContext* _ctx, IR* _ir, bool _
 	res.usedRegisterCount = 0u;
 	res.globalPrefetchRegCountFlags = 0u;
 
+	// materials which only differ in the objects they're applied to have structurally identical trees and would compile to identical streams,
+	// so only the first root of each structure gets compiled and the rest share its instruction ranges, prefetch stream and BSDF data
+	CStructuralHasher structuralHasher;
+	core::unordered_map<CStructuralHasher::id_t, const IR::INode*> uniqueRoots;
+	core::vector<const IR::INode*> duplicateRoots;
 	for (const IR::INode* root : _ir->roots)
 	{
+		if (auto found = uniqueRoots.insert({ structuralHasher.get_id(root),root }); !found.second)
+		{
+			if (found.first->second != root)
+				duplicateRoots.push_back(root);
+			continue;
+		}
+
 		uint32_t registerPool = instr_stream::MAX_REGISTER_COUNT;
 
 		const size_t interm_bsdf_data_begin_ix = _ctx->bsdfData.size();
@@ -1273,6 +1441,10 @@ auto CMaterialCompilerGLSLBackendCommon::compile(SContext* _ctx, IR* _ir, bool _
 		res.usedRegisterCount = std::max(res.usedRegisterCount, instr_stream::MAX_REGISTER_COUNT-registerPool);
 	}
 
+	res.uniqueRootCount = res.streams.size();
+	for (const IR::INode* root : duplicateRoots)
+		res.streams.insert({ root,res.streams[uniqueRoots[structuralHasher.get_id(root)]] });
+
 	_ir->deinitTmpNodes();
 
 	auto isAniso = [&res](instr_t _i) -> bool {
@@ -1304,9 +1476,9 @@ auto CMaterialCompilerGLSLBackendCommon::compile(SContext* _ctx, IR* _ir, bool _
 
 	res.allIsotropic = true;
 	res.noBSDF = true;
-	for (const auto& e : res.streams)
+	for (const auto& e : uniqueRoots)
 	{
-		const result_t::instr_streams_t& streams = e.second;
+		const result_t::instr_streams_t& streams = res.streams[e.second];
 		auto rem_and_pdf = streams.get_rem_and_pdf();
 		for (uint32_t i = 0u; i < rem_and_pdf.count; ++i) 
 		{
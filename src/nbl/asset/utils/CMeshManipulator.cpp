@@ -3,7 +3,9 @@
 // For conditions of distribution and use, see copyright notice in nabla.h
 
 #include <vector>
+#include <array>
 #include <numeric>
+#include <execution>
 #include <functional>
 #include <algorithm>
 #include <unordered_map>
@@ -479,6 +481,122 @@ static bool cmpVertices(ICPUMeshBuffer* _inbuf, const void* _va, const void* _vb
     return true;
 }
 
+// Used by createMeshBufferWelded only
+/**
+    Finds for every vertex the lowest index of another vertex it compares equal to (or its own index if there's none), same as comparing all pairs would.
+    The candidates come from a spatial hash over a floating point attribute compared with EEM_POSITIONS (preferably the position),
+    its cells are a hair bigger than the epsilon so vertices which can compare equal always land in the same or neighbouring cells.
+*/
+static void findWeldRedirects(ICPUMeshBuffer* _inbuf, const uint8_t* _vertices, size_t _vsize, uint32_t _vertexCount, const IMeshManipulator::SErrorMetric* _errMetrics, uint32_t* _redirects)
+{
+    constexpr uint32_t MAX_ATTRIBS = ICPUMeshBuffer::MAX_VERTEX_ATTRIB_COUNT;
+
+    uint32_t hashAttr = MAX_ATTRIBS;
+    {
+        auto isHashable = [&](uint32_t i) -> bool {
+            const auto format = _inbuf->getAttribFormat(i);
+            return _inbuf->isAttributeEnabled(i) && !isIntegerFormat(format) && !isScaledFormat(format) && _errMetrics[i].method==IMeshManipulator::EEM_POSITIONS;
+        };
+        const uint32_t posAttr = _inbuf->getPositionAttributeIx();
+        if (posAttr<MAX_ATTRIBS && isHashable(posAttr))
+            hashAttr = posAttr;
+        else
+        for (uint32_t i=0u; i<MAX_ATTRIBS; i++)
+        if (isHashable(i))
+        {
+            hashAttr = i;
+            break;
+        }
+    }
+
+    // without anything to hash all vertices share one cell, which degenerates to comparing all pairs
+    uint32_t hashComponents = 0u;
+    size_t hashAttrOffset = 0u;
+    double invCellSize[3] = {0.0,0.0,0.0};
+    if (hashAttr<MAX_ATTRIBS)
+    {
+        for (uint32_t i=0u; i<hashAttr; i++)
+        if (_inbuf->isAttributeEnabled(i))
+            hashAttrOffset += getTexelOrBlockBytesize(_inbuf->getAttribFormat(i));
+
+        hashComponents = core::min(getFormatChannelCount(_inbuf->getAttribFormat(hashAttr)),3u);
+        for (uint32_t c=0u; c<hashComponents; c++)
+        {
+            // with no tolerance only identical values weld and those share a cell whatever its size
+            const double eps = _errMetrics[hashAttr].epsilon.pointer[c];
+            invCellSize[c] = 1.0/((eps>0.0 ? eps:1.525e-5)*1.00001);
+        }
+    }
+
+    using cell_t = std::array<int64_t,3>;
+    const uint32_t hashTableSize = core::roundUpToPoT(_vertexCount);
+    auto cellHash = [hashTableSize](const cell_t& cell) -> uint32_t
+    {
+        return static_cast<uint32_t>(((cell[0]*73856093ull)^(cell[1]*19349663ull)^(cell[2]*83492791ull))&(hashTableSize-1u));
+    };
+
+    core::vector<cell_t> cells(_vertexCount);
+    core::vector<uint32_t> hashes(_vertexCount);
+    // not `par_unseq`, decoding the attribute calls into the mesh buffer
+    std::for_each(std::execution::par,hashes.begin(),hashes.end(),[&](uint32_t& hash) -> void
+    {
+        const uint32_t i = &hash-hashes.data();
+        core::vectorSIMDf value;
+        if (hashComponents)
+            ICPUMeshBuffer::getAttribute(value,_vertices+i*_vsize+hashAttrOffset,_inbuf->getAttribFormat(hashAttr));
+        for (uint32_t c=0u; c<3u; c++)
+        {
+            const double coord = c<hashComponents ? std::floor(double(value.pointer[c])*invCellSize[c]):0.0;
+            // NaNs and huge values only cost extra comparisons, they just must not overflow
+            cells[i][c] = coord==coord ? static_cast<int64_t>(core::clamp(coord,-4.0e18,4.0e18)):0ll;
+        }
+        hash = cellHash(cells[i]);
+    });
+
+    // counting sort into buckets, stable so every bucket lists its vertices in increasing order
+    core::vector<uint32_t> bucketBegin(hashTableSize+1u,0u);
+    for (const auto hash : hashes)
+        bucketBegin[hash+1u]++;
+    std::partial_sum(bucketBegin.begin(),bucketBegin.end(),bucketBegin.begin());
+    core::vector<uint32_t> bucketed(_vertexCount);
+    {
+        core::vector<uint32_t> cursor(bucketBegin.begin(),bucketBegin.end()-1u);
+        for (uint32_t i=0u; i<_vertexCount; i++)
+            bucketed[cursor[hashes[i]]++] = i;
+    }
+
+    std::for_each(std::execution::par,hashes.begin(),hashes.end(),[&](const uint32_t& hash) -> void
+    {
+        const uint32_t i = &hash-hashes.data();
+        const int64_t range[3] = {hashComponents>0u ? 1ll:0ll,hashComponents>1u ? 1ll:0ll,hashComponents>2u ? 1ll:0ll};
+
+        // neighbouring cells can collide in the hash table, don't search the same bucket twice
+        uint32_t buckets[27];
+        uint32_t bucketCount = 0u;
+        for (int64_t z=-range[2]; z<=range[2]; z++)
+        for (int64_t y=-range[1]; y<=range[1]; y++)
+        for (int64_t x=-range[0]; x<=range[0]; x++)
+            buckets[bucketCount++] = cellHash({cells[i][0]+x,cells[i][1]+y,cells[i][2]+z});
+        std::sort(buckets,buckets+bucketCount);
+        bucketCount = std::unique(buckets,buckets+bucketCount)-buckets;
+
+        uint32_t redirect = ~0u;
+        for (uint32_t b=0u; b<bucketCount; b++)
+        for (uint32_t k=bucketBegin[buckets[b]]; k<bucketBegin[buckets[b]+1u]; k++)
+        {
+            const uint32_t j = bucketed[k];
+            if (j>=redirect)
+                break;
+            if (j!=i && cmpVertices(_inbuf,_vertices+_vsize*i,_vertices+_vsize*j,_vsize,_errMetrics))
+            {
+                redirect = j;
+                break;
+            }
+        }
+        _redirects[i] = redirect!=~0u ? redirect:i;
+    });
+}
+
 //! Creates a copy of a mesh, which will have identical vertices welded together
 core::smart_refctd_ptr<ICPUMeshBuffer> IMeshManipulator::createMeshBufferWelded(ICPUMeshBuffer *inbuffer, const SErrorMetric* _errMetrics, const bool& optimIndexType, const bool& makeNewMesh)
 {
@@ -503,10 +621,6 @@ core::smart_refctd_ptr<ICPUMeshBuffer> IMeshManipulator::createMeshBufferWelded(
         }
     }
 
-    auto cmpfunc = [&, inbuffer, vertexSize, _errMetrics](const void* _va, const void* _vb) {
-        return cmpVertices(inbuffer, _va, _vb, vertexSize, _errMetrics);
-    };
-
     const uint32_t vertexCount = IMeshManipulator::upperBoundVertexID(inbuffer);
     const E_INDEX_TYPE oldIndexType = inbuffer->getIndexType();
 
@@ -534,25 +648,9 @@ core::smart_refctd_ptr<ICPUMeshBuffer> IMeshManipulator::createMeshBufferWelded(
         }
     }
 
-    for (auto i=0u; i<vertexCount; i++)
-    {
-        uint32_t redir = i;
-        for (auto j=0u; j<vertexCount; ++j) // TODO: Use spatial hash for this like in the smooth normal computation @Przemog
-        {
-            if (i == j)
-                continue;
-            if (cmpfunc(epicData+vertexSize*i, epicData+vertexSize*j))
-            {
-                redir = j;
-                break;
-            }
-        }
-
-        redirects[i] = redir;
-        if (redir>maxRedirect)
-            maxRedirect = redir;
-    }
+    findWeldRedirects(inbuffer, epicData, vertexSize, vertexCount, _errMetrics, redirects);
     _NBL_ALIGNED_FREE(epicData);
+    maxRedirect = *std::max_element(redirects, redirects+vertexCount);
 
     void* oldIndices = inbuffer->getIndices();
     core::smart_refctd_ptr<ICPUMeshBuffer> clone;
@@ -1378,77 +1476,67 @@ bool CMeshManipulator::calcMaxQuantizationError(const SAttribTypeChoice& _srcTyp
 {
     using namespace video;
 
-	using QuantF_t = core::vectorSIMDf(*)(const core::vectorSIMDf&, E_FORMAT, E_FORMAT, CQuantNormalCache & _cache);
-
-	QuantF_t quantFunc = nullptr;
-
 	if (_errMetric.method == EEM_ANGLES)
 	{
+		// quantize the whole attribute at once, so the cache can spread the best fit searches across threads
+		core::vector<core::vectorSIMDf> quantized(_srcData.size());
+		auto quantizeAll = [&](auto cacheFormat, E_FORMAT decodeFormat) -> void
+		{
+			constexpr E_FORMAT CacheFormat = decltype(cacheFormat)::value;
+			core::vector<CQuantNormalCache::value_type_t<CacheFormat>> packed(_srcData.size());
+			_cache.quantize<CacheFormat>(std::execution::par,_srcData.data(),_srcData.size(),packed.data());
+			for (size_t i=0u; i<packed.size(); i++)
+			{
+				uint8_t buf[32];
+				((CQuantNormalCache::value_type_t<CacheFormat>*)buf)[0] = packed[i];
+				ICPUMeshBuffer::getAttribute(quantized[i], buf, decodeFormat);
+				quantized[i].w = 1.f;
+			}
+		};
+
 		switch (_dstType.type)
 		{
 		case EF_R8_SNORM:
         case EF_R8G8_SNORM:
         case EF_R8G8B8_SNORM:
         case EF_R8G8B8A8_SNORM:
-			quantFunc = [](const core::vectorSIMDf& _in, E_FORMAT, E_FORMAT, CQuantNormalCache& _cache) -> core::vectorSIMDf {
-				uint8_t buf[32];
-				((CQuantNormalCache::value_type_t<EF_R8G8B8_SNORM>*)buf)[0] = _cache.quantize<EF_R8G8B8_SNORM>(_in);
-
-				core::vectorSIMDf retval;
-				ICPUMeshBuffer::getAttribute(retval, buf, EF_R8G8B8A8_SNORM);
-				retval.w = 1.f;
-				return retval;
-			};
+			quantizeAll(std::integral_constant<E_FORMAT,EF_R8G8B8_SNORM>(), EF_R8G8B8A8_SNORM);
 			break;
 		case EF_A2R10G10B10_SNORM_PACK32:
 		case EF_A2B10G10R10_SNORM_PACK32: // bgra
-			quantFunc = [](const core::vectorSIMDf& _in, E_FORMAT, E_FORMAT, CQuantNormalCache& _cache) -> core::vectorSIMDf {
-				uint8_t buf[32];
-				((CQuantNormalCache::value_type_t<EF_A2B10G10R10_SNORM_PACK32>*)buf)[0] = _cache.quantize<EF_A2B10G10R10_SNORM_PACK32>(_in);
-
-				core::vectorSIMDf retval;
-				ICPUMeshBuffer::getAttribute(retval, buf, EF_A2R10G10B10_SNORM_PACK32);
-				retval.w = 1.f;
-				return retval;
-			};
+			quantizeAll(std::integral_constant<E_FORMAT,EF_A2B10G10R10_SNORM_PACK32>(), EF_A2R10G10B10_SNORM_PACK32);
 			break;
         case EF_R16_SNORM:
         case EF_R16G16_SNORM:
         case EF_R16G16B16_SNORM:
         case EF_R16G16B16A16_SNORM:
-			quantFunc = [](const core::vectorSIMDf& _in, E_FORMAT, E_FORMAT, CQuantNormalCache& _cache) -> core::vectorSIMDf {
-				uint8_t buf[32];
-				((CQuantNormalCache::value_type_t<EF_R16G16B16_SNORM>*)buf)[0] = _cache.quantize<EF_R16G16B16_SNORM>(_in);
-
-				core::vectorSIMDf retval;
-				ICPUMeshBuffer::getAttribute(retval, buf, EF_R16G16B16A16_SNORM);
-				retval.w = 1.f;
-				return retval;
-			};
+			quantizeAll(std::integral_constant<E_FORMAT,EF_R16G16B16_SNORM>(), EF_R16G16B16A16_SNORM);
 			break;
-        default: 
-            quantFunc = nullptr;
-            break;
+        default:
+			_NBL_DEBUG_BREAK_IF(true);
+            return false;
 		}
+
+		for (size_t i=0u; i<_srcData.size(); i++)
+        if (!compareFloatingPointAttribute(_srcData[i], quantized[i], getFormatChannelCount(_srcType.type), _errMetric))
+            return false;
+		return true;
 	}
-	else
-	{
-		quantFunc = [](const core::vectorSIMDf& _in, E_FORMAT _inType, E_FORMAT _outType, CQuantNormalCache& _cache) -> core::vectorSIMDf {
-			uint8_t buf[32];
-			ICPUMeshBuffer::setAttribute(_in, buf, _outType);
-			core::vectorSIMDf out(0.f, 0.f, 0.f, 1.f);
-			ICPUMeshBuffer::getAttribute(out, buf, _outType);
-			return out;
-		};
-	}
 
-	_NBL_DEBUG_BREAK_IF(!quantFunc)
-	if (!quantFunc)
-		return false;
+	using QuantF_t = core::vectorSIMDf(*)(const core::vectorSIMDf&, E_FORMAT, E_FORMAT);
+
+	const QuantF_t quantFunc = [](const core::vectorSIMDf& _in, E_FORMAT _inType, E_FORMAT _outType) -> core::vectorSIMDf {
+		uint8_t buf[32];
+		ICPUMeshBuffer::setAttribute(_in, buf, _outType);
+		core::vectorSIMDf out(0.f, 0.f, 0.f, 1.f);
+		ICPUMeshBuffer::getAttribute(out, buf, _outType);
+		return out;
+	};
+
 
 	for (const core::vectorSIMDf& d : _srcData)
 	{
-		const core::vectorSIMDf quantized = quantFunc(d, _srcType.type, _dstType.type, _cache);
+		const core::vectorSIMDf quantized = quantFunc(d, _srcType.type, _dstType.type);
         if (!compareFloatingPointAttribute(d, quantized, getFormatChannelCount(_srcType.type), _errMetric))
             return false;
 	}
@@ -0,0 +1,257 @@
+// Copyright (C) 2018-2021 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+
+#include "nbl/asset/utils/CSPIRVCache.h"
+
+#include "os.h"
+
+namespace nbl
+{
+namespace asset
+{
+
+namespace impl
+{
+	// bump whenever the compiler setup (shaderc version, target SPIR-V version, etc.) changes the output for the same input
+	static constexpr uint32_t SPIRV_CACHE_VERSION = 1u;
+	static constexpr char SPIRV_CACHE_MAGIC[8] = {'N','B','L','S','P','V','C','\0'};
+
+	struct SSPIRVCacheFileHeader
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t entryCount;
+	};
+	struct SSPIRVCacheFileEntry
+	{
+		CSPIRVCache::SKey key;
+		uint64_t lastUse;
+		double compileMilliseconds;
+		uint64_t size;
+	};
+}
+
+CSPIRVCache::SKey CSPIRVCache::createKey(const char* _glslCode, ISpecializedShader::E_SHADER_STAGE _stage, const char* _entryPoint, bool _genDebugInfo, const ISPIRVOptimizer* _opt)
+{
+	// everything gets serialized into one blob, the strings keep their null terminators so they can't run into each other
+	core::vector<uint8_t> blob;
+	auto append = [&blob](const void* data, size_t size) -> void
+	{
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+		blob.insert(blob.end(),bytes,bytes+size);
+	};
+
+	const uint32_t version = impl::SPIRV_CACHE_VERSION;
+	append(&version,sizeof(version));
+	const uint32_t stage = _stage;
+	append(&stage,sizeof(stage));
+	const uint8_t debugInfo = _genDebugInfo ? 1u:0u;
+	append(&debugInfo,sizeof(debugInfo));
+	if (_opt)
+	{
+		const auto& passes = _opt->getPasses();
+		const uint32_t passCount = passes.size();
+		append(&passCount,sizeof(passCount));
+		append(passes.data(),passes.size()*sizeof(ISPIRVOptimizer::E_OPTIMIZER_PASS));
+	}
+	else
+	{
+		// distinct from an optimizer with no passes, which still runs the code through spirv-opt
+		const uint32_t noOptimizer = ~0u;
+		append(&noOptimizer,sizeof(noOptimizer));
+	}
+	append(_entryPoint,strlen(_entryPoint)+1ull);
+	append(_glslCode,strlen(_glslCode)+1ull);
+
+	SKey key;
+	core::XXHash_256(blob.data(),blob.size(),key.hash);
+	return key;
+}
+
+core::smart_refctd_ptr<ICPUBuffer> CSPIRVCache::find(const SKey& key)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto found = m_entries.find(key);
+	if (found==m_entries.end())
+	{
+		m_stats.misses++;
+		return nullptr;
+	}
+
+	auto& entry = found->second;
+	m_useOrder.erase(entry.lastUse);
+	entry.lastUse = m_useCounter++;
+	m_useOrder.emplace(entry.lastUse,key);
+
+	m_stats.hits++;
+	m_stats.compileMillisecondsSaved += entry.compileMilliseconds;
+
+	auto retval = core::make_smart_refctd_ptr<ICPUBuffer>(entry.spirv.size());
+	memcpy(retval->getPointer(),entry.spirv.data(),entry.spirv.size());
+	return retval;
+}
+
+void CSPIRVCache::insert(const SKey& key, const ICPUBuffer* spirv, double compileMilliseconds)
+{
+	if (!spirv)
+		return;
+
+	SEntry entry;
+	const uint8_t* data = reinterpret_cast<const uint8_t*>(spirv->getPointer());
+	entry.spirv.assign(data,data+spirv->getSize());
+	entry.compileMilliseconds = compileMilliseconds;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_stats.compileMillisecondsSpent += compileMilliseconds;
+	entry.lastUse = m_useCounter++;
+	insert_impl(key,std::move(entry));
+	evict_impl();
+}
+
+void CSPIRVCache::clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_entries.clear();
+	m_useOrder.clear();
+	m_size = 0ull;
+}
+
+bool CSPIRVCache::loadFromFile(io::IReadFile* file)
+{
+	if (!file)
+		return false;
+
+	impl::SSPIRVCacheFileHeader header;
+	if (file->read(&header,sizeof(header))!=sizeof(header) || memcmp(header.magic,impl::SPIRV_CACHE_MAGIC,sizeof(header.magic))!=0)
+	{
+		os::Printer::log("Not a SPIR-V cache file", file->getFileName().c_str(), ELL_ERROR);
+		return false;
+	}
+	// every entry would be stale anyway
+	if (header.version!=impl::SPIRV_CACHE_VERSION)
+	{
+		os::Printer::log("Ignoring SPIR-V cache from a different version of the engine", file->getFileName().c_str(), ELL_INFORMATION);
+		return false;
+	}
+
+	// don't trust the count with the allocation size, every entry needs at least its fixed-size part in the file
+	if (header.entryCount>(file->getSize()-file->getPos())/sizeof(impl::SSPIRVCacheFileEntry))
+	{
+		os::Printer::log("SPIR-V cache file is truncated", file->getFileName().c_str(), ELL_ERROR);
+		return false;
+	}
+	// read everything before touching the cache, so a truncated file doesn't leave us half-merged
+	core::vector<std::pair<SKey,SEntry>> loaded(header.entryCount);
+	for (auto& item : loaded)
+	{
+		impl::SSPIRVCacheFileEntry fileEntry;
+		if (file->read(&fileEntry,sizeof(fileEntry))!=sizeof(fileEntry) || fileEntry.size>file->getSize()-file->getPos())
+		{
+			os::Printer::log("SPIR-V cache file is truncated", file->getFileName().c_str(), ELL_ERROR);
+			return false;
+		}
+		item.first = fileEntry.key;
+		item.second.lastUse = fileEntry.lastUse;
+		item.second.compileMilliseconds = fileEntry.compileMilliseconds;
+		item.second.spirv.resize(fileEntry.size);
+		if (file->read(item.second.spirv.data(),static_cast<uint32_t>(fileEntry.size))!=static_cast<int32_t>(fileEntry.size))
+		{
+			os::Printer::log("SPIR-V cache file is truncated", file->getFileName().c_str(), ELL_ERROR);
+			return false;
+		}
+	}
+	// the file's use order comes first, whatever got used in this run so far is more recent
+	std::sort(loaded.begin(),loaded.end(),[](const auto& lhs, const auto& rhs) {return lhs.second.lastUse<rhs.second.lastUse;});
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	core::vector<std::pair<SKey,SEntry>> current;
+	current.reserve(m_entries.size());
+	for (const auto& item : m_useOrder)
+	{
+		auto found = m_entries.find(item.second);
+		current.emplace_back(found->first,std::move(found->second));
+	}
+	m_entries.clear();
+	m_useOrder.clear();
+	m_size = 0ull;
+	m_useCounter = 0ull;
+	for (auto* items : {&loaded,&current})
+	for (auto& item : *items)
+	{
+		item.second.lastUse = m_useCounter++;
+		insert_impl(item.first,std::move(item.second));
+	}
+	evict_impl();
+	return true;
+}
+
+bool CSPIRVCache::saveToFile(io::IWriteFile* file) const
+{
+	if (!file)
+		return false;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	impl::SSPIRVCacheFileHeader header;
+	memcpy(header.magic,impl::SPIRV_CACHE_MAGIC,sizeof(header.magic));
+	header.version = impl::SPIRV_CACHE_VERSION;
+	header.entryCount = m_entries.size();
+	if (file->write(&header,sizeof(header))!=sizeof(header))
+		return false;
+
+	for (const auto& item : m_useOrder)
+	{
+		const auto& entry = m_entries.find(item.second)->second;
+
+		impl::SSPIRVCacheFileEntry fileEntry;
+		fileEntry.key = item.second;
+		fileEntry.lastUse = entry.lastUse;
+		fileEntry.compileMilliseconds = entry.compileMilliseconds;
+		fileEntry.size = entry.spirv.size();
+		if (file->write(&fileEntry,sizeof(fileEntry))!=sizeof(fileEntry))
+			return false;
+		if (file->write(entry.spirv.data(),static_cast<uint32_t>(entry.spirv.size()))!=static_cast<int32_t>(entry.spirv.size()))
+			return false;
+	}
+	return true;
+}
+
+void CSPIRVCache::setMaxSize(size_t maxSize)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_maxSize = maxSize;
+	evict_impl();
+}
+
+void CSPIRVCache::insert_impl(const SKey& key, SEntry&& entry)
+{
+	auto found = m_entries.find(key);
+	if (found!=m_entries.end())
+	{
+		m_useOrder.erase(found->second.lastUse);
+		m_size -= found->second.spirv.size();
+		m_entries.erase(found);
+	}
+
+	m_size += entry.spirv.size();
+	m_useOrder.emplace(entry.lastUse,key);
+	m_entries.emplace(key,std::move(entry));
+}
+
+void CSPIRVCache::evict_impl()
+{
+	while (m_size>m_maxSize && !m_useOrder.empty())
+	{
+		auto oldest = m_useOrder.begin();
+		auto found = m_entries.find(oldest->second);
+		m_size -= found->second.spirv.size();
+		m_entries.erase(found);
+		m_useOrder.erase(oldest);
+		m_stats.evictions++;
+	}
+}
+
+}
+}
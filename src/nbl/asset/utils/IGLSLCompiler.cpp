@@ -3,6 +3,7 @@
 // For conditions of distribution and use, see copyright notice in nabla.h
 
 #include <sstream>
+#include <chrono>
 #include <regex>
 #include <iterator>
 
@@ -64,12 +65,29 @@ core::smart_refctd_ptr<ICPUBuffer> IGLSLCompiler::compileSPIRVFromGLSL(const cha
 
 core::smart_refctd_ptr<ICPUShader> IGLSLCompiler::createSPIRVFromGLSL(const char* _glslCode, ISpecializedShader::E_SHADER_STAGE _stage, const char* _entryPoint, const char* _compilationId, const ISPIRVOptimizer* _opt, bool _genDebugInfo, std::string* _outAssembly) const
 {
+    // the assembly isn't cached, so asking for it means compiling
+    const bool useCache = m_spirvCache && !_outAssembly;
+    CSPIRVCache::SKey cacheKey;
+    if (useCache)
+    {
+        cacheKey = CSPIRVCache::createKey(_glslCode,_stage,_entryPoint,_genDebugInfo,_opt);
+        if (auto cached = m_spirvCache->find(cacheKey))
+            return core::make_smart_refctd_ptr<asset::ICPUShader>(std::move(cached));
+    }
+
+    const auto start = std::chrono::high_resolution_clock::now();
     auto spirvBuffer = compileSPIRVFromGLSL(_glslCode,_stage,_entryPoint,_compilationId,_genDebugInfo,_outAssembly);
 	if (!spirvBuffer)
 		return nullptr;
     if (_opt)
         spirvBuffer = _opt->optimize(spirvBuffer.get());
 
+    if (useCache && spirvBuffer)
+    {
+        const auto end = std::chrono::high_resolution_clock::now();
+        m_spirvCache->insert(cacheKey,spirvBuffer.get(),std::chrono::duration<double,std::milli>(end-start).count());
+    }
+
     return core::make_smart_refctd_ptr<asset::ICPUShader>(std::move(spirvBuffer));
 }
 
@@ -6,6 +6,7 @@
 #include "os.h"
 
 #include <cwchar>
+#include <chrono>
 
 #include "nbl/ext/MitsubaLoader/CMitsubaLoader.h"
 #include "nbl/ext/MitsubaLoader/ParserUtil.h"
@@ -341,6 +342,112 @@ static core::smart_refctd_ptr<asset::ICPUImage> createBlendWeightImage(const ass
 	return outImg;
 }
 
+static std::string bitmapViewCacheKey(const CElementTexture* bitmap)
+{
+	std::string cacheKey = SContext::imageViewCacheKey(bitmap->bitmap.filename.svalue);
+	switch (bitmap->bitmap.channel)
+	{
+	case CElementTexture::Bitmap::CHANNEL::R:
+		cacheKey += "?r";
+		break;
+	case CElementTexture::Bitmap::CHANNEL::G:
+		cacheKey += "?g";
+		break;
+	case CElementTexture::Bitmap::CHANNEL::B:
+		cacheKey += "?b";
+		break;
+	case CElementTexture::Bitmap::CHANNEL::A:
+		cacheKey += "?a";
+		break;
+	default:
+		break;
+	}
+	return cacheKey;
+}
+
+//! Visits every texture a BSDF tree samples, bumpmaps and blend weights (with the scales unrolled) also get passed to `bumpmap` and `blendWeight` because they need a derived image
+template<typename TextureF, typename BumpmapF, typename BlendWeightF>
+static void traverseBSDFtreeTextures(const CElementBSDF* _bsdf, TextureF&& texture, BumpmapF&& bumpmap, BlendWeightF&& blendWeight)
+{
+	auto visitPropertyTexture = [&](const auto& const_or_tex) {
+		bool is_tex = (const_or_tex.value.type == SPropertyElementData::INVALID);
+		if (is_tex)
+			texture(const_or_tex.texture);
+
+		return is_tex;
+	};
+	auto unrollScales = [](const CElementTexture* tex)
+	{
+		while (tex->type == CElementTexture::SCALE)
+			tex = tex->scale.texture;
+		return tex;
+	};
+
+	core::stack<const CElementBSDF*> stack;
+	stack.push(_bsdf);
+
+	while (!stack.empty())
+	{
+		auto* bsdf = stack.top();
+		stack.pop();
+		switch (bsdf->type)
+		{
+		case CElementBSDF::COATING:
+		case CElementBSDF::ROUGHCOATING:
+		case CElementBSDF::BUMPMAP:
+		case CElementBSDF::BLEND_BSDF:
+		case CElementBSDF::MIXTURE_BSDF:
+		case CElementBSDF::MASK:
+		case CElementBSDF::TWO_SIDED:
+			for (uint32_t i = 0u; i < bsdf->meta_common.childCount; ++i)
+				stack.push(bsdf->meta_common.bsdf[i]);
+		default: break;
+		}
+
+		switch (bsdf->type)
+		{
+		case CElementBSDF::DIFFUSE:
+		case CElementBSDF::ROUGHDIFFUSE:
+			visitPropertyTexture(bsdf->diffuse.reflectance);
+			visitPropertyTexture(bsdf->diffuse.alpha);
+			break;
+		case CElementBSDF::DIFFUSE_TRANSMITTER:
+			visitPropertyTexture(bsdf->difftrans.transmittance);
+			break;
+		case CElementBSDF::DIELECTRIC:
+		case CElementBSDF::THINDIELECTRIC:
+		case CElementBSDF::ROUGHDIELECTRIC:
+			visitPropertyTexture(bsdf->dielectric.alphaU);
+			if (bsdf->dielectric.distribution == CElementBSDF::RoughSpecularBase::ASHIKHMIN_SHIRLEY)
+				visitPropertyTexture(bsdf->dielectric.alphaV);
+			break;
+		case CElementBSDF::CONDUCTOR:
+			visitPropertyTexture(bsdf->conductor.alphaU);
+			if (bsdf->conductor.distribution == CElementBSDF::RoughSpecularBase::ASHIKHMIN_SHIRLEY)
+				visitPropertyTexture(bsdf->conductor.alphaV);
+			break;
+		case CElementBSDF::PLASTIC:
+		case CElementBSDF::ROUGHPLASTIC:
+			visitPropertyTexture(bsdf->plastic.diffuseReflectance);
+			visitPropertyTexture(bsdf->plastic.alphaU);
+			if (bsdf->plastic.distribution == CElementBSDF::RoughSpecularBase::ASHIKHMIN_SHIRLEY)
+				visitPropertyTexture(bsdf->plastic.alphaV);
+			break;
+		case CElementBSDF::BUMPMAP:
+			bumpmap(unrollScales(bsdf->bumpmap.texture));
+			break;
+		case CElementBSDF::BLEND_BSDF:
+			if (visitPropertyTexture(bsdf->blendbsdf.weight))
+				blendWeight(unrollScales(bsdf->blendbsdf.weight.texture));
+			break;
+		case CElementBSDF::MASK:
+			visitPropertyTexture(bsdf->mask.opacity);
+			break;
+		default: break;
+		}
+	}
+}
+
 core::smart_refctd_ptr<asset::ICPUPipelineLayout> CMitsubaLoader::createPipelineLayout(asset::IAssetManager* _manager, asset::ICPUVirtualTexture* _vt)
 {
 	core::smart_refctd_ptr<ICPUDescriptorSetLayout> ds0layout;
@@ -388,7 +495,8 @@ core::smart_refctd_ptr<asset::ICPUPipelineLayout> CMitsubaLoader::createPipeline
 	return core::make_smart_refctd_ptr<asset::ICPUPipelineLayout>(nullptr, nullptr, std::move(ds0layout), std::move(ds1layout), nullptr, nullptr);
 }
 
-CMitsubaLoader::CMitsubaLoader(asset::IAssetManager* _manager, io::IFileSystem* _fs) : asset::IRenderpassIndependentPipelineLoader(_manager), m_filesystem(_fs)
+CMitsubaLoader::CMitsubaLoader(asset::IAssetManager* _manager, io::IFileSystem* _fs) : asset::IRenderpassIndependentPipelineLoader(_manager), m_filesystem(_fs),
+	m_serializedLoader(core::make_smart_refctd_ptr<CSerializedLoader>(_manager))
 {
 #ifdef _NBL_DEBUG
 	setDebugName("CMitsubaLoader");
@@ -487,7 +595,11 @@ asset::SAssetBundle CMitsubaLoader::loadAsset(io::IReadFile* _file, const asset:
 			createAndCacheVertexShader(m_assetMgr, DUMMY_VERTEX_SHADER);
 		}
 
-		core::map<core::smart_refctd_ptr<asset::ICPUMesh>,std::pair<std::string,CElementShape::Type>> meshes;
+		prepareScene(ctx, _hierarchyLevel, parserManager.shapegroups);
+
+		// kept in the order the scene references them, so the metadata and instance data don't depend on where the meshes got allocated
+		core::vector<std::pair<core::smart_refctd_ptr<asset::ICPUMesh>,std::pair<std::string,CElementShape::Type>>> meshes;
+		core::unordered_set<const asset::ICPUMesh*> uniqueMeshes;
 		for (auto& shapepair : parserManager.shapegroups)
 		{
 			auto* shapedef = shapepair.first;
@@ -500,9 +612,8 @@ asset::SAssetBundle CMitsubaLoader::loadAsset(io::IReadFile* _file, const asset:
 				if (!mesh)
 					continue;
 
-				auto found = meshes.find(mesh);
-				if (found == meshes.end())
-					meshes.emplace(std::move(mesh),std::pair<std::string,CElementShape::Type>(std::move(shapepair.second),shapedef->type));
+				if (uniqueMeshes.insert(mesh.get()).second)
+					meshes.emplace_back(std::move(mesh),std::pair<std::string,CElementShape::Type>(shapepair.second,shapedef->type));
 			}
 		}
 
@@ -517,7 +628,13 @@ asset::SAssetBundle CMitsubaLoader::loadAsset(io::IReadFile* _file, const asset:
 				mb->setInstanceCount(instanceCount);
 		}
 
+		const auto compileStart = std::chrono::steady_clock::now();
 		auto compResult = ctx.backend.compile(&ctx.backend_ctx, ctx.ir.get());
+		{
+			const auto compileTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now()-compileStart).count();
+			os::Printer::log("Mitsuba XML Loader: material compiler built "+std::to_string(compResult.instructions.size())+" instructions and "+std::to_string(compResult.prefetch_stream.size())+" texture prefetches for "+
+				std::to_string(compResult.uniqueRootCount)+" unique out of "+std::to_string(compResult.streams.size())+" BSDFs in "+std::to_string(compileTime)+"ms", ELL_INFORMATION);
+		}
 		ctx.backend_ctx.vt.commitAll();
 		auto pipelineLayout = createPipelineLayout(m_assetMgr, ctx.backend_ctx.vt.vt.get());
 		auto fragShader = createFragmentShader(compResult, ctx.backend_ctx.vt.vt->getFloatViews().size());
@@ -570,6 +687,204 @@ asset::SAssetBundle CMitsubaLoader::loadAsset(io::IReadFile* _file, const asset:
 	}
 }
 
+void CMitsubaLoader::prepareScene(SContext& ctx, uint32_t hierarchyLevel, const core::vector<std::pair<CElementShape*,std::string> >& shapes)
+{
+	// Everything expensive about a scene is independent per model file, per texture and per shape, so it gets done here up front as a few
+	// waves of tasks and put into the caches. The serial walk in `loadAsset` afterwards only compiles the BSDFs and records the instances,
+	// it finds everything else cached, which keeps the IR, metadata and descriptor set contents in the same order no matter how the tasks ran.
+	auto runAll = [this](core::vector<std::function<void()> >& tasks) -> void
+	{
+		if (m_parallelInstantiation)
+			m_assetMgr->getThreadPool()->parallelFor(tasks.size(),[&tasks](size_t i) -> void {tasks[i]();},1ull);
+		else
+		for (auto& task : tasks)
+			task();
+		tasks.clear();
+	};
+
+	// gather the shapes in the same order as `getMesh` and `loadShapeGroup` will visit them, whenever two elements produce the same cache entry the first one has to win
+	core::vector<CElementShape*> basicShapes;
+	{
+		core::unordered_set<const CElementShape*> visited;
+		auto addShape = [&](CElementShape* shape) -> void
+		{
+			if (visited.insert(shape).second)
+				basicShapes.push_back(shape);
+		};
+		auto gatherShapeGroup = [&](const CElementShape::ShapeGroup* shapegroup, auto& self) -> void
+		{
+			for (auto i=0u; i<shapegroup->childCount; i++)
+			{
+				auto child = shapegroup->children[i];
+				if (!child)
+					continue;
+				if (child->type==CElementShape::Type::SHAPEGROUP)
+					self(&child->shapegroup,self);
+				else
+					addShape(child);
+			}
+		};
+		for (const auto& shapepair : shapes)
+		{
+			auto* shape = shapepair.first;
+			if (shape->type==CElementShape::Type::SHAPEGROUP)
+				continue;
+			if (shape->type!=CElementShape::Type::INSTANCE)
+				addShape(shape);
+			else if (shape->instance.parent)
+				gatherShapeGroup(&shape->instance.parent->shapegroup,gatherShapeGroup);
+		}
+	}
+
+	// shapes loaded from the same file share meshbuffers which get modified in place, so they have to be processed by one task in scene order
+	struct SModelFile
+	{
+		std::string filename;
+		uint32_t shapeTask;
+		bool serialized = false;
+		//! `.serialized` files often hold thousands of shapes of which a scene uses a few
+		core::vector<uint32_t> shapeIndices;
+		SAssetBundle bundle;
+	};
+	core::vector<SModelFile> modelFiles;
+	core::vector<core::vector<uint32_t> > shapeTasks;
+	{
+		core::unordered_map<std::string,uint32_t> fileIx;
+		for (uint32_t i=0u; i<basicShapes.size(); i++)
+		{
+			const auto* shape = basicShapes[i];
+			const SPropertyElementData* filename = nullptr;
+			switch (shape->type)
+			{
+				case CElementShape::Type::OBJ:
+					filename = &shape->obj.filename;
+					break;
+				case CElementShape::Type::PLY:
+					filename = &shape->ply.filename;
+					break;
+				case CElementShape::Type::SERIALIZED:
+					filename = &shape->serialized.filename;
+					break;
+				default:
+					break;
+			}
+			if (!filename)
+			{
+				shapeTasks.push_back({i});
+				continue;
+			}
+
+			auto found = fileIx.find(filename->svalue);
+			if (found==fileIx.end())
+			{
+				found = fileIx.emplace(filename->svalue,modelFiles.size()).first;
+				modelFiles.emplace_back();
+				modelFiles.back().filename = filename->svalue;
+				modelFiles.back().shapeTask = shapeTasks.size();
+				shapeTasks.emplace_back();
+			}
+			auto& file = modelFiles[found->second];
+			shapeTasks[file.shapeTask].push_back(i);
+			if (shape->type==CElementShape::Type::SERIALIZED)
+			{
+				file.serialized = true;
+				file.shapeIndices.push_back(core::max(shape->serialized.shapeIndex,0));
+			}
+		}
+	}
+
+	// textures, again the first element to map onto a cache key wins
+	core::vector<const CElementTexture*> textures, textureViews, bumpmaps, blendWeights;
+	{
+		core::unordered_set<const CElementBSDF*> visitedBSDFs;
+		core::unordered_set<const CElementTexture*> visitedTextures;
+		core::unordered_set<std::string> viewKeys, derivMapKeys, blendWeightKeys;
+		auto addTexture = [&](const CElementTexture* tex) -> void
+		{
+			if (!tex || !visitedTextures.insert(tex).second)
+				return;
+			textures.push_back(tex);
+			while (tex->type==CElementTexture::SCALE)
+				tex = tex->scale.texture;
+			if (tex->type==CElementTexture::BITMAP && viewKeys.insert(bitmapViewCacheKey(tex)).second)
+				textureViews.push_back(tex);
+		};
+		for (const auto* shape : basicShapes)
+		if (shape->bsdf && visitedBSDFs.insert(shape->bsdf).second)
+		{
+			traverseBSDFtreeTextures(shape->bsdf,addTexture,
+				[&](const CElementTexture* bumpmap) -> void
+				{
+					addTexture(bumpmap);
+					if (derivMapKeys.insert(SContext::derivMapCacheKey(bumpmap)).second)
+						bumpmaps.push_back(bumpmap);
+				},
+				[&](const CElementTexture* weight) -> void
+				{
+					if (blendWeightKeys.insert(SContext::blendWeightImageCacheKey(weight)).second)
+						blendWeights.push_back(weight);
+				}
+			);
+		}
+	}
+
+	core::vector<std::function<void()> > tasks;
+	// first wave: model files and image views
+	{
+		auto loadParams = ctx.inner.params;
+		loadParams.loaderFlags = static_cast<IAssetLoader::E_LOADER_PARAMETER_FLAGS>(loadParams.loaderFlags | IAssetLoader::ELPF_RIGHT_HANDED_MESHES);
+		for (auto& file : modelFiles)
+		tasks.push_back([&,loadParams]() -> void
+		{
+			if (file.serialized)
+			{
+				std::string filename = file.filename;
+				ctx.override_->getLoadFilename(filename, ctx.inner, hierarchyLevel);
+				auto readFile = core::smart_refctd_ptr<io::IReadFile>(m_filesystem->createAndOpenFile(filename.c_str()),core::dont_grab);
+				// anything out of the ordinary gets left to the asset manager, and so does a file somebody already loaded whole
+				if (readFile && m_serializedLoader->isALoadableFileFormat(readFile.get()) && m_assetMgr->findAssets(readFile->getFileName().c_str())->size()==0u)
+				{
+					std::sort(file.shapeIndices.begin(),file.shapeIndices.end());
+					file.shapeIndices.erase(std::unique(file.shapeIndices.begin(),file.shapeIndices.end()),file.shapeIndices.end());
+					file.bundle = m_serializedLoader->loadShapes(readFile.get(),core::SRange<const uint32_t>(file.shapeIndices.data(),file.shapeIndices.data()+file.shapeIndices.size()),loadParams,ctx.override_,hierarchyLevel);
+					if (!file.bundle.getContents().empty())
+						return;
+				}
+			}
+			file.bundle = interm_getAssetInHierarchy(m_assetMgr, file.filename, loadParams, hierarchyLevel/*+ICPUScene::MESH_HIERARCHY_LEVELS_BELOW*/, ctx.override_);
+		});
+		for (const auto* tex : textureViews)
+			tasks.push_back([&ctx,tex,this]() -> void {cacheTextureView(ctx,0u,tex);});
+		runAll(tasks);
+	}
+	for (auto& file : modelFiles)
+	if (!file.bundle.getContents().empty())
+		ctx.modelCache.emplace(std::move(file.filename),std::move(file.bundle));
+	// samplers are cheap, but they need to get created in scene order
+	for (const auto* tex : textures)
+		cacheTexture(ctx,0u,tex);
+
+	// second wave: images derived from the textures and the per-shape mesh processing
+	core::vector<SContext::shape_ass_type> meshes(basicShapes.size());
+	{
+		for (const auto* bumpmap : bumpmaps)
+			tasks.push_back([&ctx,bumpmap,this]() -> void {cacheDerivMap(ctx,bumpmap);});
+		for (const auto* weight : blendWeights)
+			tasks.push_back([&ctx,weight,this]() -> void {cacheBlendWeightImage(ctx,weight);});
+		for (const auto& shapeTask : shapeTasks)
+		tasks.push_back([&,this]() -> void
+		{
+			for (const auto i : shapeTask)
+				meshes[i] = createShapeMesh(ctx,hierarchyLevel,basicShapes[i]);
+		});
+		runAll(tasks);
+	}
+	// the ones which failed get another go (and their errors logged) in the serial walk
+	for (uint32_t i=0u; i<basicShapes.size(); i++)
+	if (meshes[i])
+		ctx.shapeCache.insert({basicShapes[i],std::move(meshes[i])});
+}
+
 core::vector<SContext::shape_ass_type> CMitsubaLoader::getMesh(SContext& ctx, uint32_t hierarchyLevel, CElementShape* shape)
 {
 	if (!shape)
@@ -651,8 +966,6 @@ static core::smart_refctd_ptr<ICPUMesh> createMeshFromGeomCreatorReturnType(IGeo
 
 SContext::shape_ass_type CMitsubaLoader::loadBasicShape(SContext& ctx, uint32_t hierarchyLevel, CElementShape* shape, const core::matrix3x4SIMD& relTform)
 {
-	constexpr uint32_t UV_ATTRIB_ID = 2U;
-
 	auto addInstance = [shape,&ctx,&relTform,this](SContext::shape_ass_type& mesh)
 	{
 		auto bsdf = getBSDFtreeTraversal(ctx, shape->bsdf);
@@ -676,29 +989,63 @@ SContext::shape_ass_type CMitsubaLoader::loadBasicShape(SContext& ctx, uint32_t
 		return found->second;
 	}
 
+	auto mesh = createShapeMesh(ctx, hierarchyLevel, shape);
+	if (!mesh)
+		return nullptr;
+
+	addInstance(mesh);
+	// cache and return
+	ctx.shapeCache.insert({ shape,mesh });
+	return mesh;
+}
+
+// doesn't touch anything in `ctx` but the caches which are thread-safe, so it can run for many shapes at once as long as they don't share a model file
+SContext::shape_ass_type CMitsubaLoader::createShapeMesh(SContext& ctx, uint32_t hierarchyLevel, CElementShape* shape)
+{
+	constexpr uint32_t UV_ATTRIB_ID = 2U;
+
 	auto loadModel = [&](const ext::MitsubaLoader::SPropertyElementData& filename, int64_t index=-1) -> core::smart_refctd_ptr<asset::ICPUMesh>
 	{
 		assert(filename.type==ext::MitsubaLoader::SPropertyElementData::Type::STRING);
-		auto loadParams = ctx.inner.params;
-		loadParams.loaderFlags = static_cast<IAssetLoader::E_LOADER_PARAMETER_FLAGS>(loadParams.loaderFlags | IAssetLoader::ELPF_RIGHT_HANDED_MESHES);
-		auto retval = interm_getAssetInHierarchy(m_assetMgr, filename.svalue, loadParams, hierarchyLevel/*+ICPUScene::MESH_HIERARCHY_LEVELS_BELOW*/, ctx.override_);
-		if (retval.getAssetType()!=asset::IAsset::ET_MESH)
-			return nullptr;
-		auto contentRange = retval.getContents();
-		auto serializedMeta = retval.getMetadata()->selfCast<CMitsubaSerializedMetadata>();
-		//
-		uint32_t actualIndex = 0;
-		if (index>=0ll && serializedMeta)
-		for (auto it=contentRange.begin(); it!=contentRange.end(); it++)
+		// returns the position of the requested shape in the bundle, or `~0u` if the bundle doesn't contain it
+		auto findShape = [index](const asset::SAssetBundle& bundle) -> uint32_t
 		{
-			auto meshMeta = static_cast<const CMitsubaSerializedMetadata::CMesh*>(serializedMeta->getAssetSpecificMetadata(IAsset::castDown<ICPUMesh>(*it).get()));
-			if (meshMeta->m_id!=static_cast<uint32_t>(index))
-				continue;
-			actualIndex = it-contentRange.begin();
-			break;
+			if (index<0ll)
+				return 0u;
+			auto contentRange = bundle.getContents();
+			const auto* meta = bundle.getMetadata();
+			auto serializedMeta = meta ? meta->selfCast<CMitsubaSerializedMetadata>():nullptr;
+			if (!serializedMeta)
+				return 0u;
+			for (auto it=contentRange.begin(); it!=contentRange.end(); it++)
+			{
+				auto meshMeta = static_cast<const CMitsubaSerializedMetadata::CMesh*>(serializedMeta->getAssetSpecificMetadata(IAsset::castDown<ICPUMesh>(*it).get()));
+				if (meshMeta && meshMeta->m_id==static_cast<uint32_t>(index))
+					return it-contentRange.begin();
+			}
+			return ~0u;
+		};
+		asset::SAssetBundle retval;
+		uint32_t actualIndex = ~0u;
+		auto prefetched = ctx.modelCache.find(filename.svalue);
+		if (prefetched!=ctx.modelCache.end() && prefetched->second.getAssetType()==asset::IAsset::ET_MESH)
+		{
+			retval = prefetched->second;
+			actualIndex = findShape(retval);
 		}
-		//
-		if (contentRange.begin()+actualIndex < contentRange.end())
+		// the prefetch only decoded the shapes it knew about, anything else needs the whole file
+		if (actualIndex==~0u)
+		{
+			auto loadParams = ctx.inner.params;
+			loadParams.loaderFlags = static_cast<IAssetLoader::E_LOADER_PARAMETER_FLAGS>(loadParams.loaderFlags | IAssetLoader::ELPF_RIGHT_HANDED_MESHES);
+			retval = interm_getAssetInHierarchy(m_assetMgr, filename.svalue, loadParams, hierarchyLevel/*+ICPUScene::MESH_HIERARCHY_LEVELS_BELOW*/, ctx.override_);
+			if (retval.getAssetType()!=asset::IAsset::ET_MESH)
+				return nullptr;
+			actualIndex = findShape(retval);
+		}
+		auto contentRange = retval.getContents();
+		// the whole file doesn't have the requested shape either, don't hand out some other one
+		if (actualIndex<contentRange.size())
 		{
 			auto asset = contentRange.begin()[actualIndex];
 			if (!asset)
@@ -883,12 +1230,181 @@ SContext::shape_ass_type CMitsubaLoader::loadBasicShape(SContext& ctx, uint32_t
 		newMesh->getMeshBufferVector().push_back(std::move(newMeshBuffer));
 	}
 	IMeshManipulator::recalculateBoundingBox(newMesh.get());
-	mesh = std::move(newMesh);
+	return newMesh;
+}
 
-	addInstance(mesh);
-	// cache and return
-	ctx.shapeCache.insert({ shape,mesh });
-	return mesh;
+// only ever writes to the cache under its own key, so different views can get created concurrently
+core::smart_refctd_ptr<asset::ICPUImageView> CMitsubaLoader::cacheTextureView(SContext& ctx, uint32_t hierarchyLevel, const CElementTexture* tex, bool _restore)
+{
+	const std::string cacheKey = bitmapViewCacheKey(tex);
+
+	core::smart_refctd_ptr<asset::ICPUImageView> view;
+	{
+		asset::SAssetBundle viewBundle;
+		const asset::IAsset::E_TYPE types[]{ asset::IAsset::ET_IMAGE_VIEW, static_cast<asset::IAsset::E_TYPE>(0) };
+		viewBundle = ctx.override_->findCachedAsset(cacheKey, types, ctx.inner, 0u);
+
+		auto contents = viewBundle.getContents();
+		if (!contents.empty())
+			view = core::smart_refctd_ptr_static_cast<asset::ICPUImageView>(contents.begin()[0]);
+		if (view)
+		{
+			auto& image = view->getCreationParameters().image;
+			if (_restore && image->isADummyObjectForCache())
+			{
+				auto loadParams = ctx.inner.params;
+				loadParams.restoreLevels = std::max(loadParams.restoreLevels, hierarchyLevel + 2u);
+				// this will restore the image being kept by found `view`
+				auto bundle = interm_getAssetInHierarchy(m_assetMgr, tex->bitmap.filename.svalue, loadParams, hierarchyLevel, ctx.override_);
+				if (bundle.getContents().empty() || image->isADummyObjectForCache())
+				{
+					// if for some reason restore failed, force recreating whole view
+					auto removeBundle = asset::SAssetBundle(nullptr, { view });
+					m_assetMgr->removeAssetFromCache(removeBundle);
+					view = nullptr;
+				}
+			}
+		}
+	}
+
+	core::smart_refctd_ptr<asset::ICPUImage> img;
+	if (!view)
+	{
+		ICPUImageView::SCreationParams viewParams;
+		viewParams.flags = static_cast<ICPUImageView::E_CREATE_FLAGS>(0);
+		viewParams.subresourceRange.aspectMask = static_cast<IImage::E_ASPECT_FLAGS>(0);
+		viewParams.subresourceRange.baseArrayLayer = 0u;
+		viewParams.subresourceRange.layerCount = 1u;
+		viewParams.subresourceRange.baseMipLevel = 0u;
+		viewParams.viewType = IImageView<ICPUImage>::ET_2D;
+
+		const uint32_t restoreLevels = _restore ? 2u : 0u;
+		auto loadParams = ctx.inner.params;
+		loadParams.restoreLevels = std::max(loadParams.restoreLevels, hierarchyLevel + restoreLevels);
+		asset::SAssetBundle imgBundle = interm_getAssetInHierarchy(m_assetMgr,tex->bitmap.filename.svalue,loadParams,hierarchyLevel,ctx.override_);
+		auto contentRange = imgBundle.getContents();
+		if (contentRange.begin() < contentRange.end())
+		{
+			auto asset = contentRange.begin()[0];
+			if (asset && asset->getAssetType() == asset::IAsset::ET_IMAGE)
+			{
+				img = core::smart_refctd_ptr_static_cast<asset::ICPUImage>(asset);
+
+				switch (tex->bitmap.channel)
+				{
+					// no GL_R8_SRGB support yet
+					case CElementTexture::Bitmap::CHANNEL::R:
+						{
+						constexpr auto RED = ICPUImageView::SComponentMapping::ES_R;
+						viewParams.components = {RED,RED,RED,RED};
+						}
+						break;
+					case CElementTexture::Bitmap::CHANNEL::G:
+						{
+						constexpr auto GREEN = ICPUImageView::SComponentMapping::ES_G;
+						viewParams.components = {GREEN,GREEN,GREEN,GREEN};
+						}
+						break;
+					case CElementTexture::Bitmap::CHANNEL::B:
+						{
+						constexpr auto BLUE = ICPUImageView::SComponentMapping::ES_B;
+						viewParams.components = {BLUE,BLUE,BLUE,BLUE};
+						}
+						break;
+					case CElementTexture::Bitmap::CHANNEL::A:
+						{
+						constexpr auto ALPHA = ICPUImageView::SComponentMapping::ES_A;
+						viewParams.components = {ALPHA,ALPHA,ALPHA,ALPHA};
+						}
+						break;
+					/* special conversions needed to CIE space
+					case CElementTexture::Bitmap::CHANNEL::X:
+					case CElementTexture::Bitmap::CHANNEL::Y:
+					case CElementTexture::Bitmap::CHANNEL::Z:*/
+					case CElementTexture::Bitmap::CHANNEL::INVALID:
+						[[fallthrough]];
+					default:
+						break;
+				}
+				viewParams.subresourceRange.levelCount = img->getCreationParameters().mipLevels;
+				viewParams.format = img->getCreationParameters().format;
+				viewParams.image = std::move(img);
+				//! TODO: this stuff (custom shader sampling code?)
+				_NBL_DEBUG_BREAK_IF(tex->bitmap.uoffset != 0.f);
+				_NBL_DEBUG_BREAK_IF(tex->bitmap.voffset != 0.f);
+				_NBL_DEBUG_BREAK_IF(tex->bitmap.uscale != 1.f);
+				_NBL_DEBUG_BREAK_IF(tex->bitmap.vscale != 1.f);
+			}
+
+			//in case of <channel>, extract one channel
+			if (viewParams.components.g != asset::ICPUImageView::SComponentMapping::ES_G)
+			{
+				auto get1ChannelFormat = [](uint32_t bytesPerChannel) -> asset::E_FORMAT {
+					switch (bytesPerChannel)
+					{
+					case 1u:
+						return asset::EF_R8_UNORM;
+					case 2u:
+						return asset::EF_R16_SFLOAT;
+					case 4u:
+						return asset::EF_R32_SFLOAT;
+					case 8u:
+						return asset::EF_R64_SFLOAT;
+					default:
+						return asset::EF_UNKNOWN;
+					}
+				};
+
+				auto outParams = viewParams.image->getCreationParameters();
+				asset::ICPUImage::SBufferCopy region;
+				const uint32_t bytesPerChannel = (getBytesPerPixel(outParams.format) * core::rational(1, getFormatChannelCount(outParams.format))).getIntegerApprox();
+				outParams.format = get1ChannelFormat(bytesPerChannel);
+				const size_t texelBytesz = asset::getTexelOrBlockBytesize(outParams.format);
+				region.bufferRowLength = asset::IImageAssetHandlerBase::calcPitchInBlocks(outParams.extent.width, texelBytesz);
+				auto buffer = core::make_smart_refctd_ptr<asset::ICPUBuffer>(texelBytesz * region.bufferRowLength * outParams.extent.height);
+				region.imageOffset = { 0,0,0 };
+				region.imageExtent = outParams.extent;
+				region.imageSubresource.baseArrayLayer = 0u;
+				region.imageSubresource.layerCount = 1u;
+				region.imageSubresource.mipLevel = 0u;
+				region.bufferImageHeight = 0u;
+				region.bufferOffset = 0u;
+				auto outImg = asset::ICPUImage::create(std::move(outParams));
+				outImg->setBufferAndRegions(std::move(buffer), core::make_refctd_dynamic_array<core::smart_refctd_dynamic_array<IImage::SBufferCopy>>(1ull, region));
+
+				using convert_filter_t = asset::CSwizzleAndConvertImageFilter<asset::EF_UNKNOWN, asset::EF_UNKNOWN>;
+				convert_filter_t::state_type conv;
+				conv.swizzle = viewParams.components;
+				conv.extent = viewParams.image->getCreationParameters().extent;
+				conv.layerCount = 1u;
+				conv.inMipLevel = 0u;
+				conv.outMipLevel = 0u;
+				conv.inBaseLayer = 0u;
+				conv.outBaseLayer = 0u;
+				conv.inOffset = { 0u,0u,0u };
+				conv.outOffset = { 0u,0u,0u };
+				conv.inImage = viewParams.image.get();
+				conv.outImage = outImg.get();
+
+				viewParams.components = asset::ICPUImageView::SComponentMapping{};
+				if (!convert_filter_t::execute(&conv))
+					_NBL_DEBUG_BREAK_IF(true);
+				viewParams.format = outImg->getCreationParameters().format;
+				viewParams.image = std::move(outImg);
+			}
+
+			view = ICPUImageView::create(std::move(viewParams));
+			asset::SAssetBundle viewBundle(nullptr,{ view });
+			ctx.override_->insertAssetIntoCache(std::move(viewBundle), cacheKey, ctx.inner, hierarchyLevel);
+		}
+
+		// adjust gamma on pixels (painful and long process)
+		if (!std::isnan(tex->bitmap.gamma))
+		{
+			_NBL_DEBUG_BREAK_IF(true); // TODO : use an image filter!
+		}
+	}
+	return view;
 }
 
 SContext::tex_ass_type CMitsubaLoader::cacheTexture(SContext& ctx, uint32_t hierarchyLevel, const CElementTexture* tex, bool _restore)
@@ -896,13 +1412,6 @@ SContext::tex_ass_type CMitsubaLoader::cacheTexture(SContext& ctx, uint32_t hier
 	if (!tex)
 		return {};
 
-	ICPUImageView::SCreationParams viewParams;
-	viewParams.flags = static_cast<ICPUImageView::E_CREATE_FLAGS>(0);
-	viewParams.subresourceRange.aspectMask = static_cast<IImage::E_ASPECT_FLAGS>(0);
-	viewParams.subresourceRange.baseArrayLayer = 0u;
-	viewParams.subresourceRange.layerCount = 1u;
-	viewParams.subresourceRange.baseMipLevel = 0u;
-	viewParams.viewType = IImageView<ICPUImage>::ET_2D;
 	ICPUSampler::SParams samplerParams;
 	samplerParams.AnisotropicFilter = core::max(core::findMSB(uint32_t(tex->bitmap.maxAnisotropy)),1);
 	samplerParams.LodBias = 0.f;
@@ -917,183 +1426,7 @@ SContext::tex_ass_type CMitsubaLoader::cacheTexture(SContext& ctx, uint32_t hier
 	{
 		case CElementTexture::Type::BITMAP:
 		{
-				std::string cacheKey = ctx.imageViewCacheKey(tex->bitmap.filename.svalue);
-				switch (tex->bitmap.channel)
-				{
-				case CElementTexture::Bitmap::CHANNEL::R:
-					cacheKey += "?r";
-					break;
-				case CElementTexture::Bitmap::CHANNEL::G:
-					cacheKey += "?g";
-					break;
-				case CElementTexture::Bitmap::CHANNEL::B:
-					cacheKey += "?b";
-					break;
-				case CElementTexture::Bitmap::CHANNEL::A:
-					cacheKey += "?a";
-					break;
-				default:
-					break;
-				}
-
-				core::smart_refctd_ptr<asset::ICPUImageView> view;
-				{
-					asset::SAssetBundle viewBundle;
-					const asset::IAsset::E_TYPE types[]{ asset::IAsset::ET_IMAGE_VIEW, static_cast<asset::IAsset::E_TYPE>(0) };
-					viewBundle = ctx.override_->findCachedAsset(cacheKey, types, ctx.inner, 0u);
-
-					auto contents = viewBundle.getContents();
-					if (!contents.empty())
-						view = core::smart_refctd_ptr_static_cast<asset::ICPUImageView>(contents.begin()[0]);
-					if (view)
-					{
-						auto& image = view->getCreationParameters().image;
-						if (_restore && image->isADummyObjectForCache())
-						{
-							auto loadParams = ctx.inner.params;
-							loadParams.restoreLevels = std::max(loadParams.restoreLevels, hierarchyLevel + 2u);
-							// this will restore the image being kept by found `view`
-							auto bundle = interm_getAssetInHierarchy(m_assetMgr, tex->bitmap.filename.svalue, loadParams, hierarchyLevel, ctx.override_);
-							if (bundle.getContents().empty() || image->isADummyObjectForCache())
-							{
-								// if for some reason restore failed, force recreating whole view
-								auto removeBundle = asset::SAssetBundle(nullptr, { view });
-								m_assetMgr->removeAssetFromCache(removeBundle);
-								view = nullptr;
-							}
-						}
-					}
-				}
-
-				core::smart_refctd_ptr<asset::ICPUImage> img;
-				if (!view)
-				{
-					const uint32_t restoreLevels = _restore ? 2u : 0u;
-					auto loadParams = ctx.inner.params;
-					loadParams.restoreLevels = std::max(loadParams.restoreLevels, hierarchyLevel + restoreLevels);
-					asset::SAssetBundle imgBundle = interm_getAssetInHierarchy(m_assetMgr,tex->bitmap.filename.svalue,loadParams,hierarchyLevel,ctx.override_);
-					auto contentRange = imgBundle.getContents();
-					if (contentRange.begin() < contentRange.end())
-					{
-						auto asset = contentRange.begin()[0];
-						if (asset && asset->getAssetType() == asset::IAsset::ET_IMAGE)
-						{
-							img = core::smart_refctd_ptr_static_cast<asset::ICPUImage>(asset);
-
-							switch (tex->bitmap.channel)
-							{
-								// no GL_R8_SRGB support yet
-								case CElementTexture::Bitmap::CHANNEL::R:
-									{
-									constexpr auto RED = ICPUImageView::SComponentMapping::ES_R;
-									viewParams.components = {RED,RED,RED,RED};
-									}
-									break;
-								case CElementTexture::Bitmap::CHANNEL::G:
-									{
-									constexpr auto GREEN = ICPUImageView::SComponentMapping::ES_G;
-									viewParams.components = {GREEN,GREEN,GREEN,GREEN};
-									}
-									break;
-								case CElementTexture::Bitmap::CHANNEL::B:
-									{
-									constexpr auto BLUE = ICPUImageView::SComponentMapping::ES_B;
-									viewParams.components = {BLUE,BLUE,BLUE,BLUE};
-									}
-									break;
-								case CElementTexture::Bitmap::CHANNEL::A:
-									{
-									constexpr auto ALPHA = ICPUImageView::SComponentMapping::ES_A;
-									viewParams.components = {ALPHA,ALPHA,ALPHA,ALPHA};
-									}
-									break;
-								/* special conversions needed to CIE space
-								case CElementTexture::Bitmap::CHANNEL::X:
-								case CElementTexture::Bitmap::CHANNEL::Y:
-								case CElementTexture::Bitmap::CHANNEL::Z:*/
-								case CElementTexture::Bitmap::CHANNEL::INVALID:
-									[[fallthrough]];
-								default:
-									break;
-							}
-							viewParams.subresourceRange.levelCount = img->getCreationParameters().mipLevels;
-							viewParams.format = img->getCreationParameters().format;
-							viewParams.image = std::move(img);
-							//! TODO: this stuff (custom shader sampling code?)
-							_NBL_DEBUG_BREAK_IF(tex->bitmap.uoffset != 0.f);
-							_NBL_DEBUG_BREAK_IF(tex->bitmap.voffset != 0.f);
-							_NBL_DEBUG_BREAK_IF(tex->bitmap.uscale != 1.f);
-							_NBL_DEBUG_BREAK_IF(tex->bitmap.vscale != 1.f);
-						}
-
-						//in case of <channel>, extract one channel
-						if (viewParams.components.g != asset::ICPUImageView::SComponentMapping::ES_G)
-						{
-							auto get1ChannelFormat = [](uint32_t bytesPerChannel) -> asset::E_FORMAT {
-								switch (bytesPerChannel)
-								{
-								case 1u:
-									return asset::EF_R8_UNORM;
-								case 2u:
-									return asset::EF_R16_SFLOAT;
-								case 4u:
-									return asset::EF_R32_SFLOAT;
-								case 8u:
-									return asset::EF_R64_SFLOAT;
-								default:
-									return asset::EF_UNKNOWN;
-								}
-							};
-
-							auto outParams = viewParams.image->getCreationParameters();
-							asset::ICPUImage::SBufferCopy region;
-							const uint32_t bytesPerChannel = (getBytesPerPixel(outParams.format) * core::rational(1, getFormatChannelCount(outParams.format))).getIntegerApprox();
-							outParams.format = get1ChannelFormat(bytesPerChannel);
-							const size_t texelBytesz = asset::getTexelOrBlockBytesize(outParams.format);
-							region.bufferRowLength = asset::IImageAssetHandlerBase::calcPitchInBlocks(outParams.extent.width, texelBytesz);
-							auto buffer = core::make_smart_refctd_ptr<asset::ICPUBuffer>(texelBytesz * region.bufferRowLength * outParams.extent.height);
-							region.imageOffset = { 0,0,0 };
-							region.imageExtent = outParams.extent;
-							region.imageSubresource.baseArrayLayer = 0u;
-							region.imageSubresource.layerCount = 1u;
-							region.imageSubresource.mipLevel = 0u;
-							region.bufferImageHeight = 0u;
-							region.bufferOffset = 0u;
-							auto outImg = asset::ICPUImage::create(std::move(outParams));
-							outImg->setBufferAndRegions(std::move(buffer), core::make_refctd_dynamic_array<core::smart_refctd_dynamic_array<IImage::SBufferCopy>>(1ull, region));
-
-							using convert_filter_t = asset::CSwizzleAndConvertImageFilter<asset::EF_UNKNOWN, asset::EF_UNKNOWN>;
-							convert_filter_t::state_type conv;
-							conv.swizzle = viewParams.components;
-							conv.extent = viewParams.image->getCreationParameters().extent;
-							conv.layerCount = 1u;
-							conv.inMipLevel = 0u;
-							conv.outMipLevel = 0u;
-							conv.inBaseLayer = 0u;
-							conv.outBaseLayer = 0u;
-							conv.inOffset = { 0u,0u,0u };
-							conv.outOffset = { 0u,0u,0u };
-							conv.inImage = viewParams.image.get();
-							conv.outImage = outImg.get();
-
-							viewParams.components = asset::ICPUImageView::SComponentMapping{};
-							if (!convert_filter_t::execute(&conv))
-								_NBL_DEBUG_BREAK_IF(true);
-							viewParams.format = outImg->getCreationParameters().format;
-							viewParams.image = std::move(outImg);
-						}
-
-						view = ICPUImageView::create(std::move(viewParams));
-						asset::SAssetBundle viewBundle(nullptr,{ view });
-						ctx.override_->insertAssetIntoCache(std::move(viewBundle), cacheKey, ctx.inner, hierarchyLevel);
-					}
-
-					// adjust gamma on pixels (painful and long process)
-					if (!std::isnan(tex->bitmap.gamma))
-					{
-						_NBL_DEBUG_BREAK_IF(true); // TODO : use an image filter!
-					}
-				}
+				auto view = cacheTextureView(ctx,hierarchyLevel,tex,_restore);
 
 				const std::string samplerCacheKey = ctx.samplerCacheKey(tex);
 				switch (tex->bitmap.filterType)
@@ -1185,122 +1518,49 @@ auto CMitsubaLoader::getBSDFtreeTraversal(SContext& ctx, const CElementBSDF* bsd
 
 auto CMitsubaLoader::genBSDFtreeTraversal(SContext& ctx, const CElementBSDF* _bsdf) -> SContext::bsdf_type
 {
-	{
-		auto cachePropertyTexture = [&](const auto& const_or_tex, SContext::tex_ass_type& out_img) {
-			bool is_tex = (const_or_tex.value.type == SPropertyElementData::INVALID);
-			if (const_or_tex.value.type == SPropertyElementData::INVALID)
-				out_img = cacheTexture(ctx, 0u, const_or_tex.texture);
-
-			return is_tex;
-		};
-		auto unrollScales = [](CElementTexture* tex)
-		{
-			while (tex->type == CElementTexture::SCALE)
-				tex = tex->scale.texture;
-			return tex;
-		};
-
-		core::stack<const CElementBSDF*> stack;
-		stack.push(_bsdf);
-
-		while (!stack.empty())
-		{
-			auto* bsdf = stack.top();
-			stack.pop();
-			switch (bsdf->type)
-			{
-			case CElementBSDF::COATING:
-			case CElementBSDF::ROUGHCOATING:
-			case CElementBSDF::BUMPMAP:
-			case CElementBSDF::BLEND_BSDF:
-			case CElementBSDF::MIXTURE_BSDF:
-			case CElementBSDF::MASK:
-			case CElementBSDF::TWO_SIDED:
-				for (uint32_t i = 0u; i < bsdf->meta_common.childCount; ++i)
-					stack.push(bsdf->meta_common.bsdf[i]);
-			default: break;
-			}
-
-			SContext::tex_ass_type tex;
-			switch (bsdf->type)
-			{
-			case CElementBSDF::DIFFUSE:
-			case CElementBSDF::ROUGHDIFFUSE:
-				cachePropertyTexture(bsdf->diffuse.reflectance, tex);
-				cachePropertyTexture(bsdf->diffuse.alpha, tex);
-				break;
-			case CElementBSDF::DIFFUSE_TRANSMITTER:
-				cachePropertyTexture(bsdf->difftrans.transmittance, tex);
-				break;
-			case CElementBSDF::DIELECTRIC:
-			case CElementBSDF::THINDIELECTRIC:
-			case CElementBSDF::ROUGHDIELECTRIC:
-				cachePropertyTexture(bsdf->dielectric.alphaU, tex);
-				if (bsdf->dielectric.distribution == CElementBSDF::RoughSpecularBase::ASHIKHMIN_SHIRLEY)
-					cachePropertyTexture(bsdf->dielectric.alphaV, tex);
-				break;
-			case CElementBSDF::CONDUCTOR:
-				cachePropertyTexture(bsdf->conductor.alphaU, tex);
-				if (bsdf->conductor.distribution == CElementBSDF::RoughSpecularBase::ASHIKHMIN_SHIRLEY)
-					cachePropertyTexture(bsdf->conductor.alphaV, tex);
-				break;
-			case CElementBSDF::PLASTIC:
-			case CElementBSDF::ROUGHPLASTIC:
-				cachePropertyTexture(bsdf->plastic.diffuseReflectance, tex);
-				cachePropertyTexture(bsdf->plastic.alphaU, tex);
-				if (bsdf->plastic.distribution == CElementBSDF::RoughSpecularBase::ASHIKHMIN_SHIRLEY)
-					cachePropertyTexture(bsdf->plastic.alphaV, tex);
-				break;
-			case CElementBSDF::BUMPMAP:
-			{
-				using namespace std::string_literals;
-
-				auto* bumpmap_element = unrollScales(bsdf->bumpmap.texture);
-				auto bm = cacheTexture(ctx, 0u, bumpmap_element);
-				// TODO check and restore if dummy (image and sampler)
-				auto bumpmap = std::get<0>(bm)->getCreationParameters().image;
-				auto sampler = std::get<1>(bm);
-				const std::string key = ctx.derivMapCacheKey(bumpmap_element);
+	traverseBSDFtreeTextures(_bsdf,
+		[&](const CElementTexture* tex) -> void {cacheTexture(ctx, 0u, tex);},
+		[&](const CElementTexture* bumpmap) -> void {cacheDerivMap(ctx, bumpmap);},
+		[&](const CElementTexture* weight) -> void {cacheBlendWeightImage(ctx, weight);}
+	);
 
-				if (!getBuiltinAsset<asset::ICPUImage, asset::IAsset::ET_IMAGE>(key.c_str(), m_assetMgr))
-				{
-					auto derivmap = createDerivMap(bumpmap.get(), sampler.get());
-					asset::SAssetBundle imgBundle(nullptr,{ derivmap });
-					ctx.override_->insertAssetIntoCache(std::move(imgBundle), key, ctx.inner, 0u);
-					auto derivmap_view = createImageView(std::move(derivmap));
-					asset::SAssetBundle viewBundle(nullptr,{ derivmap_view });
-					ctx.override_->insertAssetIntoCache(std::move(viewBundle), ctx.imageViewCacheKey(key), ctx.inner, 0u);
-				}
-			}
-				break;
-			case CElementBSDF::BLEND_BSDF:
-				if (cachePropertyTexture(bsdf->blendbsdf.weight, tex))
-				{
-					auto* weight_element = unrollScales(bsdf->blendbsdf.weight.texture);
-					const std::string key = ctx.blendWeightImageCacheKey(weight_element);
+	return ctx.frontend.compileToIRTree(ctx.ir.get(), _bsdf);
+}
 
-					if (!getBuiltinAsset<asset::ICPUImage, asset::IAsset::ET_IMAGE>(key.c_str(), m_assetMgr))
-					{
-						auto img = std::get<0>(tex)->getCreationParameters().image;
-
-						auto blendweight = createBlendWeightImage(img.get());
-						asset::SAssetBundle imgBundle(nullptr,{ blendweight });
-						ctx.override_->insertAssetIntoCache(std::move(imgBundle), key, ctx.inner, 0u);
-						auto blendweight_view = createImageView(std::move(blendweight));
-						asset::SAssetBundle viewBundle(nullptr,{ blendweight_view });
-						ctx.override_->insertAssetIntoCache(std::move(viewBundle), ctx.imageViewCacheKey(key), ctx.inner, 0u);
-					}
-				}
-				break;
-			case CElementBSDF::MASK:
-				cachePropertyTexture(bsdf->mask.opacity, tex);
-				break;
-			default: break;
-			}
-		}
-	}
+void CMitsubaLoader::cacheDerivMap(SContext& ctx, const CElementTexture* bumpmap_element)
+{
+	auto bm = cacheTexture(ctx, 0u, bumpmap_element);
+	const std::string key = ctx.derivMapCacheKey(bumpmap_element);
+	if (getBuiltinAsset<asset::ICPUImage, asset::IAsset::ET_IMAGE>(key.c_str(), m_assetMgr))
+		return;
+
+	// TODO check and restore if dummy (image and sampler)
+	auto bumpmap = std::get<0>(bm)->getCreationParameters().image;
+	auto sampler = std::get<1>(bm);
+
+	auto derivmap = createDerivMap(bumpmap.get(), sampler.get());
+	asset::SAssetBundle imgBundle(nullptr,{ derivmap });
+	ctx.override_->insertAssetIntoCache(std::move(imgBundle), key, ctx.inner, 0u);
+	auto derivmap_view = createImageView(std::move(derivmap));
+	asset::SAssetBundle viewBundle(nullptr,{ derivmap_view });
+	ctx.override_->insertAssetIntoCache(std::move(viewBundle), ctx.imageViewCacheKey(key), ctx.inner, 0u);
+}
 
-	return ctx.frontend.compileToIRTree(ctx.ir.get(), _bsdf);
+void CMitsubaLoader::cacheBlendWeightImage(SContext& ctx, const CElementTexture* weight_element)
+{
+	const std::string key = ctx.blendWeightImageCacheKey(weight_element);
+	if (getBuiltinAsset<asset::ICPUImage, asset::IAsset::ET_IMAGE>(key.c_str(), m_assetMgr))
+		return;
+
+	auto tex = cacheTexture(ctx, 0u, weight_element);
+	auto img = std::get<0>(tex)->getCreationParameters().image;
+
+	auto blendweight = createBlendWeightImage(img.get());
+	asset::SAssetBundle imgBundle(nullptr,{ blendweight });
+	ctx.override_->insertAssetIntoCache(std::move(imgBundle), key, ctx.inner, 0u);
+	auto blendweight_view = createImageView(std::move(blendweight));
+	asset::SAssetBundle viewBundle(nullptr,{ blendweight_view });
+	ctx.override_->insertAssetIntoCache(std::move(viewBundle), ctx.imageViewCacheKey(key), ctx.inner, 0u);
 }
 
 
@@ -2,6 +2,8 @@
 // This file is part of the "Nabla Engine".
 // For conditions of distribution and use, see copyright notice in nabla.h
 
+#include <numeric>
+
 #include "nbl/asset/compile_config.h"
 
 #include "nbl/core/core.h"
@@ -42,14 +44,6 @@ constexpr auto COLOR_ATTRIBUTE = 1;
 constexpr auto UV_ATTRIBUTE = 2;
 constexpr auto NORMAL_ATTRIBUTE = 3;
 
-// maybe move to core
-#define PAGE_SIZE 4096
-struct alignas(PAGE_SIZE) Page_t
-{
-	uint8_t data[PAGE_SIZE];
-};
-#undef PAGE_SIZE
-
 //! creates/loads an animated mesh from the file.
 asset::SAssetBundle CSerializedLoader::loadAsset(io::IReadFile* _file, const asset::IAssetLoader::SAssetLoadParams& _params, asset::IAssetLoader::IAssetLoaderOverride* _override, uint32_t _hierarchyLevel)
 {
@@ -61,220 +55,150 @@ asset::SAssetBundle CSerializedLoader::loadAsset(io::IReadFile* _file, const ass
 		0,
 		nullptr
 	};
-	size_t maxSize = 0u;
-	{
-		FileHeader header;
-		ctx.inner.mainFile->seek(0u);
-		ctx.inner.mainFile->read(&header, sizeof(header));
-		if (header!=FileHeader())
-		{
-			os::Printer::log("Not a valid `.serialized` file", ctx.inner.mainFile->getFileName().c_str(), ELL_ERROR);
-			return {};
-		}
+	if (!readOffsetTable(ctx))
+		return {};
 
-		size_t backPos = ctx.inner.mainFile->getSize() - sizeof(uint32_t);
-		ctx.inner.mainFile->seek(backPos);
-		ctx.inner.mainFile->read(&ctx.meshCount,sizeof(uint32_t));
-		if (ctx.meshCount==0u)
-			return {};
-
-		ctx.meshOffsets = core::make_refctd_dynamic_array<core::smart_refctd_dynamic_array<uint64_t> >(ctx.meshCount*2u);
-		backPos -= sizeof(uint64_t)*ctx.meshCount;
-		ctx.inner.mainFile->seek(backPos);
-		ctx.inner.mainFile->read(ctx.meshOffsets->data(),sizeof(uint64_t)*ctx.meshCount);
-		for (uint32_t i=0; i<ctx.meshCount; i++)
-		{
-			size_t localSize;
-			if (i == ctx.meshCount-1u)
-				localSize = backPos;
-			else
-				localSize = ctx.meshOffsets->operator[](i+1u);
-			localSize -= ctx.meshOffsets->operator[](i);
-			ctx.meshOffsets->operator[](i+ctx.meshCount) = localSize;
-			if (localSize > maxSize)
-				maxSize = localSize;
-		}
-	}
-	if (maxSize==0u)
+	core::vector<uint32_t> shapeIndices(ctx.meshCount);
+	std::iota(shapeIndices.begin(),shapeIndices.end(),0u);
+	return loadShapes_impl(ctx,shapeIndices,_override,_hierarchyLevel);
+}
+
+asset::SAssetBundle CSerializedLoader::loadShapes(io::IReadFile* _file, const core::SRange<const uint32_t>& _shapeIndices, const asset::IAssetLoader::SAssetLoadParams& _params, asset::IAssetLoader::IAssetLoaderOverride* _override, uint32_t _hierarchyLevel)
+{
+	if (!_file)
+        return {};
+
+	SContext ctx = {
+		IAssetLoader::SAssetLoadContext(_params,_file),
+		0,
+		nullptr
+	};
+	if (!readOffsetTable(ctx))
 		return {};
 
-	auto meta = core::make_smart_refctd_ptr<CMitsubaSerializedMetadata>(ctx.meshCount,core::smart_refctd_ptr(IRenderpassIndependentPipelineLoader::m_basicViewParamsSemantics));
-	core::vector<core::smart_refctd_ptr<ICPUMesh>> meshes; meshes.reserve(ctx.meshCount);
+	core::vector<uint32_t> shapeIndices;
+	shapeIndices.reserve(_shapeIndices.size());
+	for (const auto index : _shapeIndices)
+	if (index<ctx.meshCount)
+		shapeIndices.push_back(index);
+	else
+		os::Printer::log("Shape index "+std::to_string(index)+" out of range in", ctx.inner.mainFile->getFileName().c_str(), ELL_ERROR);
+	std::sort(shapeIndices.begin(),shapeIndices.end());
+	shapeIndices.erase(std::unique(shapeIndices.begin(),shapeIndices.end()),shapeIndices.end());
+	return loadShapes_impl(ctx,shapeIndices,_override,_hierarchyLevel);
+}
+
+bool CSerializedLoader::readOffsetTable(SContext& ctx) const
+{
+	FileHeader header;
+	ctx.inner.mainFile->seek(0u);
+	ctx.inner.mainFile->read(&header, sizeof(header));
+	if (header!=FileHeader())
+	{
+		os::Printer::log("Not a valid `.serialized` file", ctx.inner.mainFile->getFileName().c_str(), ELL_ERROR);
+		return false;
+	}
+
+	size_t backPos = ctx.inner.mainFile->getSize() - sizeof(uint32_t);
+	ctx.inner.mainFile->seek(backPos);
+	ctx.inner.mainFile->read(&ctx.meshCount,sizeof(uint32_t));
+	if (ctx.meshCount==0u || sizeof(uint64_t)*ctx.meshCount>backPos)
+		return false;
 
-	uint8_t* data = reinterpret_cast<uint8_t*>(_NBL_ALIGNED_MALLOC(maxSize,alignof(double)));
-	constexpr size_t CHUNK = 256ull*1024ull;
-	core::vector<Page_t> decompressed(CHUNK/sizeof(Page_t));
+	ctx.meshOffsets = core::make_refctd_dynamic_array<core::smart_refctd_dynamic_array<uint64_t> >(ctx.meshCount*2u);
+	backPos -= sizeof(uint64_t)*ctx.meshCount;
+	ctx.inner.mainFile->seek(backPos);
+	ctx.inner.mainFile->read(ctx.meshOffsets->data(),sizeof(uint64_t)*ctx.meshCount);
 	for (uint32_t i=0; i<ctx.meshCount; i++)
 	{
-		auto localSize = ctx.meshOffsets->operator[](i+ctx.meshCount);
-		ctx.inner.mainFile->seek(sizeof(FileHeader)+ctx.meshOffsets->operator[](i));
-		ctx.inner.mainFile->read(data,localSize);
-		// decompress
-		size_t decompressSize;
-		{
-			// Setup the inflate stream.
-			z_stream stream;
-			stream.next_in = (Bytef*)data;
-			stream.avail_in = (uInt)localSize;
-			stream.total_in = 0;
-			stream.next_out = (Bytef*)decompressed.data();
-			stream.avail_out = CHUNK;
-			stream.total_out = 0u;
-			stream.zalloc = (alloc_func)0;
-			stream.zfree = (free_func)0;
-
-			int32_t err = inflateInit(&stream, -MAX_WBITS);
-			if (err == Z_OK)
-			{
-				while (err == Z_OK && err != Z_STREAM_END)
-				{
-					err = inflate(&stream, Z_SYNC_FLUSH);
-					if (err!=Z_OK || err==Z_STREAM_END || stream.avail_out)
-						continue;
-
-					if (stream.total_out+CHUNK>decompressed.size()*sizeof(Page_t))
-						decompressed.resize(decompressed.size()+CHUNK/sizeof(Page_t));
-					stream.next_out = reinterpret_cast<Bytef*>(decompressed.data())+stream.total_out;
-					stream.avail_out = CHUNK;
-				}
-			}
-			decompressSize = stream.total_out;
-			int32_t err2 = inflateEnd(&stream);
+		// every mesh starts with its own copy of the file header
+		const uint64_t begin = ctx.meshOffsets->operator[](i)+sizeof(FileHeader);
+		const uint64_t end = i==ctx.meshCount-1u ? backPos:ctx.meshOffsets->operator[](i+1u);
+		ctx.meshOffsets->operator[](i) = begin;
+		ctx.meshOffsets->operator[](i+ctx.meshCount) = begin<end&&end<=backPos ? (end-begin):0ull;
+	}
+	return true;
+}
 
-			if (err == Z_OK || err == Z_STREAM_END)
-				err = err2;
-			if (err != Z_OK)
-			{
-				std::wstring msg(L"Error decompressing mesh ix ");
-				msg += std::to_wstring(i);
-				os::Printer::log(msg, ELL_ERROR);
-				continue;
-			}
-		}
-		// too small to hold anything
-		if (decompressSize < sizeof(uint8_t)+sizeof(uint64_t)*2ull)
-			continue;
+asset::SAssetBundle CSerializedLoader::loadShapes_impl(SContext& ctx, const core::vector<uint32_t>& shapeIndices, asset::IAssetLoader::IAssetLoaderOverride* _override, uint32_t _hierarchyLevel)
+{
+	const uint32_t meshCount = shapeIndices.size();
+	if (meshCount==0u)
+		return {};
 
-		// some tracking
-		uint8_t* ptr = reinterpret_cast<uint8_t*>(decompressed.data());
-		uint8_t* streamEnd = ptr+decompressSize;
-		// vertex size determination
-		auto flags = *(reinterpret_cast<uint32_t*&>(ptr)++);
-		size_t typeSize;
-		size_t vertexAttributeCount = 3u;
-		size_t vertexSize;
-		{
-			if (flags & MF_SINGLE_FLOAT)
-				typeSize = sizeof(float);
-			else if (flags & MF_DOUBLE_FLOAT)
-				typeSize = sizeof(double);
-			else
-				continue;
-
-			if ((flags & MF_PER_VERTEX_NORMALS) || (flags & MF_FACE_NORMALS))
-				vertexAttributeCount += 3ull;
-			if (flags & MF_TEXTURE_COORDINATES)
-				vertexAttributeCount += 2ull;
-			if (flags & MF_VERTEX_COLORS)
-				vertexAttributeCount += 3ull;
+	// the file handle can't be shared between threads, so unless it's mapped all the compressed data gets read up front (in file order)
+	core::vector<const uint8_t*> compressed(meshCount);
+	core::vector<uint8_t> compressedStorage;
+	if (auto mapped = reinterpret_cast<const uint8_t*>(ctx.inner.mainFile->getMappedPointer()))
+	{
+		for (uint32_t i=0u; i<meshCount; i++)
+			compressed[i] = mapped+ctx.meshOffsets->operator[](shapeIndices[i]);
+	}
+	else
+	{
+		size_t totalSize = 0ull;
+		for (const auto index : shapeIndices)
+			totalSize += ctx.meshOffsets->operator[](index+ctx.meshCount);
+		compressedStorage.resize(totalSize);
 
-			vertexSize = vertexAttributeCount*typeSize;
+		size_t offset = 0ull;
+		for (uint32_t i=0u; i<meshCount; i++)
+		{
+			const auto localSize = ctx.meshOffsets->operator[](shapeIndices[i]+ctx.meshCount);
+			compressed[i] = compressedStorage.data()+offset;
+			ctx.inner.mainFile->seek(ctx.meshOffsets->operator[](shapeIndices[i]));
+			ctx.inner.mainFile->read(compressedStorage.data()+offset,localSize);
+			offset += localSize;
 		}
+	}
 
-		// get name
-		char* stringPtr = reinterpret_cast<char*>(ptr);
-		while (ptr < streamEnd)
-		if (! *(ptr++))
-				break;
-		// name too long
-		size_t stringLen = reinterpret_cast<char*>(ptr)-stringPtr;
-		if (ptr+sizeof(uint64_t)*2ull > streamEnd)
-			continue;
+	// every mesh is a separate zlib stream, inflate them all in parallel
+	core::vector<SDecodedMesh> decoded(meshCount);
+	m_assetMgr->getThreadPool()->parallelFor(meshCount,[&](const size_t i) -> void
+	{
+		decoded[i] = decodeMesh(ctx.inner.params,compressed[i],ctx.meshOffsets->operator[](shapeIndices[i]+ctx.meshCount),shapeIndices[i]);
+	},1ull);
+	compressedStorage = {};
 
-		// 
-		uint64_t vertexCount = *(reinterpret_cast<uint64_t*&>(ptr)++);
-		if (vertexCount<3ull || vertexCount>0xFFFFFFFFull)
-			continue;
-		uint64_t triangleCount = *(reinterpret_cast<uint64_t*&>(ptr)++);
-		if (triangleCount<1ull)
-			continue;
-		size_t vertexDataSize = vertexCount*vertexSize;
-		if (ptr+vertexDataSize > streamEnd)
-			continue;
-		size_t indexDataSize = sizeof(uint32_t)*3ull*triangleCount;
-		size_t totalDataSize = vertexDataSize+indexDataSize;
-		if (ptr+totalDataSize > streamEnd)
-			continue;
+	// the asset manager's caches aren't touched from the worker threads, so the rest is serial
+	auto meta = core::make_smart_refctd_ptr<CMitsubaSerializedMetadata>(meshCount,core::smart_refctd_ptr(IRenderpassIndependentPipelineLoader::m_basicViewParamsSemantics));
+	core::vector<core::smart_refctd_ptr<ICPUMesh>> meshes; meshes.reserve(meshCount);
 
-		auto buf = core::make_smart_refctd_ptr<asset::ICPUBuffer>(totalDataSize);
-		void* outPtr = buf->getPointer();
-		auto readAttributes = [&](auto* outPtr, size_t attrOffset, auto* &inPtr, uint32_t attrCount, core::aabbox3df* aabb=nullptr) -> void
-		{
-			for (uint64_t j=0ull; j<vertexCount; j++)
-			{
-				if (aabb)
-				{
-					if (j)
-						aabb->addInternalPoint(inPtr[0],inPtr[1],inPtr[2]);
-					else
-						aabb->reset(inPtr[0],inPtr[1],inPtr[2]);
-				}
-				for (auto k=0u; k<attrCount; k++)
-					outPtr[j*vertexAttributeCount+attrOffset+k] = *(inPtr++);
-			}
-		};
+	auto mbPipelineLayout = _override->findDefaultAsset<ICPUPipelineLayout>("nbl/builtin/material/lambertian/no_texture/pipeline_layout",ctx.inner,_hierarchyLevel+ICPUMesh::PIPELINE_LAYOUT_HIERARCHYLEVELS_BELOW).first;
+	core::unordered_map<std::string,std::pair<core::smart_refctd_ptr<ICPUSpecializedShader>,core::smart_refctd_ptr<ICPUSpecializedShader>>> shaders;
+	for (uint32_t i=0u; i<meshCount; i++)
+	{
+		auto& mesh = decoded[i];
+		if (!mesh.buffer)
+			continue;
+		const auto flags = mesh.flags;
+		const auto typeSize = mesh.typeSize;
 
 		auto meshBuffer = core::make_smart_refctd_ptr<asset::ICPUMeshBuffer>();
 		meshBuffer->setPositionAttributeIx(POSITION_ATTRIBUTE);
 
-		auto makeAvailableAttributesVector = [&]()
+		auto chooseShaderPath = [&]() -> std::string
 		{
-			core::vector<uint8_t> vec;
-			vec.reserve(4);
-
-			vec.push_back(POSITION_ATTRIBUTE);
 			if (flags & MF_VERTEX_COLORS)
-				vec.push_back(COLOR_ATTRIBUTE);
+				return "nbl/builtin/material/debug/vertex_color/specialized_shader";
 			if (flags & MF_TEXTURE_COORDINATES)
-				vec.push_back(UV_ATTRIBUTE);
+				return "nbl/builtin/material/debug/vertex_uv/specialized_shader";
 			if (flags & MF_PER_VERTEX_NORMALS)
-				vec.push_back(NORMAL_ATTRIBUTE);
-			return vec;
-		};
-
-		const auto availableAttributes = makeAvailableAttributesVector();
-
-		auto chooseShaderPath = [&]() -> std::string
-		{
-			constexpr std::array<std::pair<uint8_t, std::string_view>, 3> avaiableOptionsForShaders
-			{
-				std::make_pair(COLOR_ATTRIBUTE, "nbl/builtin/material/debug/vertex_color/specialized_shader"),
-				std::make_pair(UV_ATTRIBUTE, "nbl/builtin/material/debug/vertex_uv/specialized_shader"),
-				std::make_pair(NORMAL_ATTRIBUTE, "nbl/builtin/material/debug/vertex_normal/specialized_shader")
-			};
-
-			for (auto& it : avaiableOptionsForShaders)
-			{
-				auto found = std::find(availableAttributes.begin(), availableAttributes.end(), it.first);
-				if (found != availableAttributes.end())
-					return it.second.data();
-			}
-
-			return avaiableOptionsForShaders[0].second.data(); // if only positions are present, shaders with debug vertex colors are assumed
+				return "nbl/builtin/material/debug/vertex_normal/specialized_shader";
+			return "nbl/builtin/material/debug/vertex_color/specialized_shader"; // if only positions are present, shaders with debug vertex colors are assumed
 		};
 		
-		core::smart_refctd_ptr<ICPUSpecializedShader> mbVertexShader;
-		core::smart_refctd_ptr<ICPUSpecializedShader> mbFragmentShader;
+		const std::string basepath = chooseShaderPath();
+		auto foundShaders = shaders.find(basepath);
+		if (foundShaders==shaders.end())
 		{
 			const IAsset::E_TYPE types[]{ IAsset::E_TYPE::ET_SPECIALIZED_SHADER, IAsset::E_TYPE::ET_SPECIALIZED_SHADER, static_cast<IAsset::E_TYPE>(0u) };
-			const std::string basepath = chooseShaderPath();
-
 			auto bundle = m_assetMgr->findAssets(basepath+".vert", types);
-			mbVertexShader = core::smart_refctd_ptr_static_cast<ICPUSpecializedShader>(bundle->begin()->getContents().begin()[0]);
+			auto vertexShader = core::smart_refctd_ptr_static_cast<ICPUSpecializedShader>(bundle->begin()->getContents().begin()[0]);
 			bundle = m_assetMgr->findAssets(basepath+".frag", types);
-			mbFragmentShader = core::smart_refctd_ptr_static_cast<ICPUSpecializedShader>(bundle->begin()->getContents().begin()[0]);
+			auto fragmentShader = core::smart_refctd_ptr_static_cast<ICPUSpecializedShader>(bundle->begin()->getContents().begin()[0]);
+			foundShaders = shaders.emplace(basepath,std::make_pair(std::move(vertexShader),std::move(fragmentShader))).first;
 		}
-		auto mbPipelineLayout = _override->findDefaultAsset<ICPUPipelineLayout>("nbl/builtin/material/lambertian/no_texture/pipeline_layout",ctx.inner,_hierarchyLevel+ICPUMesh::PIPELINE_LAYOUT_HIERARCHYLEVELS_BELOW).first;
 
 		asset::SBlendParams blendParams;
 		asset::SRasterizationParams rastarizationParams;
@@ -284,10 +208,10 @@ asset::SAssetBundle CSerializedLoader::loadAsset(io::IReadFile* _file, const ass
 		primitiveAssemblyParams.primitiveType = asset::EPT_TRIANGLE_LIST;
 		inputParams.enabledBindingFlags |= core::createBitmask({ 0 });
 		inputParams.bindings[0].inputRate = asset::EVIR_PER_VERTEX;
-		inputParams.bindings[0].stride = vertexSize;
+		inputParams.bindings[0].stride = mesh.vertexSize;
 
 		size_t attrOffset = 0ull;
-		auto readAttributeDispatch = [&](auto attrId, size_t attrCount, core::aabbox3df* aabb, bool read = true) -> void
+		auto addAttribute = [&](auto attrId, size_t attrCount) -> void
 		{
 			asset::E_FORMAT format = asset::EF_UNKNOWN;
 			switch (attrCount)
@@ -307,82 +231,198 @@ asset::SAssetBundle CSerializedLoader::loadAsset(io::IReadFile* _file, const ass
 			inputParams.attributes[attrId].binding = 0;
 			inputParams.attributes[attrId].format = format;
 			inputParams.attributes[attrId].relativeOffset = attrOffset * typeSize;
-			meshBuffer->setVertexBufferBinding({ 0, buf }, 0);
-	
-			if (read)
-			{
-				if (flags & MF_SINGLE_FLOAT)
-					readAttributes(reinterpret_cast<float*>(outPtr), attrOffset, reinterpret_cast<float*&>(ptr), attrCount, aabb);
-				else if (flags & MF_DOUBLE_FLOAT)
-					readAttributes(reinterpret_cast<double*>(outPtr), attrOffset, reinterpret_cast<double*&>(ptr), attrCount, aabb);
-			}
 			attrOffset += attrCount;
 		};
-
-		core::aabbox3df aabb;
-		readAttributeDispatch(POSITION_ATTRIBUTE, 3ull, &aabb);
-		meshBuffer->setBoundingBox(aabb);
+		addAttribute(POSITION_ATTRIBUTE, 3ull);
 		if ((flags & MF_PER_VERTEX_NORMALS) || (flags & MF_FACE_NORMALS))
-			readAttributeDispatch(NORMAL_ATTRIBUTE, 3ull, nullptr, flags&MF_PER_VERTEX_NORMALS); // TODO: normal quantization and optimization
+			addAttribute(NORMAL_ATTRIBUTE, 3ull); // TODO: normal quantization and optimization
 		if (flags & MF_TEXTURE_COORDINATES) // TODO: UV quantization and optimization
-			readAttributeDispatch(UV_ATTRIBUTE, 2ull, nullptr);
+			addAttribute(UV_ATTRIBUTE, 2ull);
 		if (flags & MF_VERTEX_COLORS) // TODO: quantize to 32bit format like RGB9E5
-			readAttributeDispatch(COLOR_ATTRIBUTE, 3ull, nullptr);
+			addAttribute(COLOR_ATTRIBUTE, 3ull);
 
-		auto mbPipeline = core::make_smart_refctd_ptr<asset::ICPURenderpassIndependentPipeline>(std::move(mbPipelineLayout), nullptr, nullptr, inputParams, blendParams, primitiveAssemblyParams, rastarizationParams);
-		mbPipeline->setShaderAtStage(asset::ISpecializedShader::E_SHADER_STAGE::ESS_VERTEX, mbVertexShader.get());
-		mbPipeline->setShaderAtStage(asset::ISpecializedShader::E_SHADER_STAGE::ESS_FRAGMENT, mbFragmentShader.get());
+		auto mbPipeline = core::make_smart_refctd_ptr<asset::ICPURenderpassIndependentPipeline>(core::smart_refctd_ptr(mbPipelineLayout), nullptr, nullptr, inputParams, blendParams, primitiveAssemblyParams, rastarizationParams);
+		mbPipeline->setShaderAtStage(asset::ISpecializedShader::E_SHADER_STAGE::ESS_VERTEX, foundShaders->second.first.get());
+		mbPipeline->setShaderAtStage(asset::ISpecializedShader::E_SHADER_STAGE::ESS_FRAGMENT, foundShaders->second.second.get());
 
-		meshBuffer->setIndexBufferBinding({ vertexDataSize, std::move(buf) });
-		meshBuffer->setIndexCount(triangleCount * 3u);
+		meshBuffer->setVertexBufferBinding({ 0, mesh.buffer }, 0);
+		meshBuffer->setIndexBufferBinding({ mesh.vertexCount*mesh.vertexSize, std::move(mesh.buffer) });
+		meshBuffer->setIndexCount(mesh.triangleCount * 3u);
 		meshBuffer->setIndexType(asset::EIT_32BIT);
+		meshBuffer->setBoundingBox(mesh.aabb);
 
-		// read indices and possibly create per-face normals
-		auto readIndices = [&]() -> bool
-		{
-			uint32_t* indexPtr = reinterpret_cast<uint32_t*>(outPtr)+vertexDataSize/sizeof(uint32_t);
-			for (uint64_t j=0ull; j<triangleCount; j++)
-			{
-				uint32_t* triangleIndices = indexPtr;
-				for (uint64_t k=0ull; k<3ull; k++)
-				{
-					triangleIndices[k] = *(reinterpret_cast<uint32_t*&>(ptr)++);
-					if (triangleIndices[k] >= static_cast<uint32_t>(vertexCount))
-						return false;
-				}
-				indexPtr += 3u;
-
-				if (flags & MF_FACE_NORMALS)
-				{
-					core::vectorSIMDf pos[3];
-					for (uint64_t k=0ull; k<3ull; k++)
-						pos[k] = meshBuffer->getPosition(triangleIndices[k]);
-					auto normal = core::cross(pos[1]-pos[0],pos[2]-pos[0]);
-					for (uint64_t k=0ull; k<3ull; k++)
-						meshBuffer->setAttribute(normal,NORMAL_ATTRIBUTE,k);
-				}
-			}
-			return true;
-		};
-		if (!readIndices())
-			continue;
-
+		auto cpumesh = core::make_smart_refctd_ptr<asset::ICPUMesh>();
 
-		auto mesh = core::make_smart_refctd_ptr<asset::ICPUMesh>();
-
-		meta->placeMeta(meshes.size(),mbPipeline.get(),mesh.get(),{std::string(stringPtr,stringLen),i});
+		meta->placeMeta(meshes.size(),mbPipeline.get(),cpumesh.get(),{std::move(mesh.name),shapeIndices[i]});
 
 		meshBuffer->setPipeline(std::move(mbPipeline));
 
-		mesh->setBoundingBox(meshBuffer->getBoundingBox());
-		mesh->getMeshBufferVector().emplace_back(std::move(meshBuffer));
-		meshes.push_back(std::move(mesh));
+		cpumesh->setBoundingBox(meshBuffer->getBoundingBox());
+		cpumesh->getMeshBufferVector().emplace_back(std::move(meshBuffer));
+		meshes.push_back(std::move(cpumesh));
 	}
-	_NBL_ALIGNED_FREE(data);
 
 	return SAssetBundle(std::move(meta),std::move(meshes));
 }
 
+CSerializedLoader::SDecodedMesh CSerializedLoader::decodeMesh(const asset::IAssetLoader::SAssetLoadParams& _params, const uint8_t* compressed, size_t compressedSize, uint32_t shapeIndex)
+{
+	SDecodedMesh retval = {};
+
+	z_stream stream = {};
+	stream.next_in = (Bytef*)compressed;
+	stream.avail_in = (uInt)compressedSize;
+	if (inflateInit(&stream)!=Z_OK)
+		return retval;
+
+	// the header tells us the exact sizes, so we only ever inflate as much as we're about to consume and nothing needs resizing
+	auto inflateExactly = [&stream](void* dst, size_t size) -> bool
+	{
+		uint8_t* out = reinterpret_cast<uint8_t*>(dst);
+		while (size)
+		{
+			const uInt chunk = static_cast<uInt>(core::min<size_t>(size,0x40000000ull));
+			stream.next_out = out;
+			stream.avail_out = chunk;
+			const int32_t err = inflate(&stream, Z_NO_FLUSH);
+			const size_t produced = chunk-stream.avail_out;
+			out += produced;
+			size -= produced;
+			if (size && (err!=Z_OK || produced==0ull))
+				return false;
+		}
+		return true;
+	};
+	auto fail = [&]() -> SDecodedMesh
+	{
+		inflateEnd(&stream);
+		os::Printer::log("Error decompressing mesh ix "+std::to_string(shapeIndex), ELL_ERROR);
+		return {};
+	};
+
+	// vertex size determination
+	uint32_t flags;
+	if (!inflateExactly(&flags,sizeof(flags)))
+		return fail();
+	size_t typeSize;
+	size_t vertexAttributeCount = 3u;
+	{
+		if (flags & MF_SINGLE_FLOAT)
+			typeSize = sizeof(float);
+		else if (flags & MF_DOUBLE_FLOAT)
+			typeSize = sizeof(double);
+		else
+			return fail();
+
+		if ((flags & MF_PER_VERTEX_NORMALS) || (flags & MF_FACE_NORMALS))
+			vertexAttributeCount += 3ull;
+		if (flags & MF_TEXTURE_COORDINATES)
+			vertexAttributeCount += 2ull;
+		if (flags & MF_VERTEX_COLORS)
+			vertexAttributeCount += 3ull;
+	}
+	const size_t vertexSize = vertexAttributeCount*typeSize;
+
+	// get name, names are short so going a byte at a time is fine
+	std::string name;
+	for (char c; true; name.push_back(c))
+	{
+		// name too long
+		if (name.size()>0xffffull || !inflateExactly(&c,1ull))
+			return fail();
+		if (c=='\0')
+			break;
+	}
+
+	// 
+	uint64_t counts[2];
+	if (!inflateExactly(counts,sizeof(counts)))
+		return fail();
+	const uint64_t vertexCount = counts[0];
+	if (vertexCount<3ull || vertexCount>0xFFFFFFFFull)
+		return fail();
+	const uint64_t triangleCount = counts[1];
+	if (triangleCount<1ull || triangleCount>0xFFFFFFFFull)
+		return fail();
+
+	const size_t vertexDataSize = vertexCount*vertexSize;
+	const size_t indexDataSize = sizeof(uint32_t)*3ull*triangleCount;
+	// the file stores the attributes one after the other, the buffer interleaves them
+	const bool generateNormals = (flags&MF_FACE_NORMALS) && !(flags&MF_PER_VERTEX_NORMALS);
+	core::vector<uint8_t> planar(vertexDataSize-(generateNormals ? (vertexCount*3ull*typeSize):0ull));
+	auto buf = interm_createBuffer(_params,vertexDataSize+indexDataSize);
+	uint8_t* const outPtr = reinterpret_cast<uint8_t*>(buf->getPointer());
+	uint32_t* const indexPtr = reinterpret_cast<uint32_t*>(outPtr+vertexDataSize);
+	// the indices need no conversion so they go straight into place
+	if (!inflateExactly(planar.data(),planar.size()) || !inflateExactly(indexPtr,indexDataSize))
+		return fail();
+	inflateEnd(&stream);
+
+	for (uint64_t j=0ull; j<triangleCount*3ull; j++)
+	if (indexPtr[j] >= static_cast<uint32_t>(vertexCount))
+		return fail();
+
+	auto interleave = [&](auto* out, const auto* in) -> void
+	{
+		size_t attrOffset = 0ull;
+		auto readAttributes = [&](uint32_t attrCount, core::aabbox3df* aabb=nullptr) -> void
+		{
+			for (uint64_t j=0ull; j<vertexCount; j++)
+			{
+				if (aabb)
+				{
+					if (j)
+						aabb->addInternalPoint(in[0],in[1],in[2]);
+					else
+						aabb->reset(in[0],in[1],in[2]);
+				}
+				for (auto k=0u; k<attrCount; k++)
+					out[j*vertexAttributeCount+attrOffset+k] = *(in++);
+			}
+			attrOffset += attrCount;
+		};
+
+		readAttributes(3u,&retval.aabb);
+		if (flags & MF_PER_VERTEX_NORMALS)
+			readAttributes(3u);
+		else if (generateNormals)
+		{
+			// create per-face normals
+			for (uint64_t j=0ull; j<triangleCount; j++)
+			{
+				const uint32_t* triangleIndices = indexPtr+j*3ull;
+				core::vectorSIMDf pos[3];
+				for (uint64_t k=0ull; k<3ull; k++)
+				{
+					const auto* position = out+triangleIndices[k]*vertexAttributeCount;
+					pos[k] = core::vectorSIMDf(position[0],position[1],position[2]);
+				}
+				const auto normal = core::cross(pos[1]-pos[0],pos[2]-pos[0]);
+				for (uint64_t k=0ull; k<3ull; k++)
+				for (uint32_t c=0u; c<3u; c++)
+					out[triangleIndices[k]*vertexAttributeCount+attrOffset+c] = normal.pointer[c];
+			}
+			attrOffset += 3ull;
+		}
+		if (flags & MF_TEXTURE_COORDINATES)
+			readAttributes(2u);
+		if (flags & MF_VERTEX_COLORS)
+			readAttributes(3u);
+	};
+	if (flags & MF_SINGLE_FLOAT)
+		interleave(reinterpret_cast<float*>(outPtr),reinterpret_cast<const float*>(planar.data()));
+	else
+		interleave(reinterpret_cast<double*>(outPtr),reinterpret_cast<const double*>(planar.data()));
+
+	retval.buffer = std::move(buf);
+	retval.name = std::move(name);
+	retval.flags = flags;
+	retval.typeSize = typeSize;
+	retval.vertexSize = vertexSize;
+	retval.vertexCount = vertexCount;
+	retval.triangleCount = triangleCount;
+	return retval;
+}
 
 }
 }
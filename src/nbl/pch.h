@@ -65,6 +65,7 @@
 #include "quaternion.h"
 #include "rect.h"
 #include "SAABoxCollider.h"
+#include "SBoundingVolumeHierarchy.h"
 #include "SCollisionEngine.h"
 #include "SColor.h"
 #include "SCompoundCollider.h"